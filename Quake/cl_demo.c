@@ -365,6 +365,10 @@ void CL_Record_f (void)
 
 		CL_WriteDemoMessage();
 
+		// the demo doesn't have the snapshots the server deltas from,
+		// ask for a full one to start from
+		cl.snapshot_ack = 0;
+
 		// restore net_message
 		net_message.data = data;
 		net_message.cursize = cursize;
@@ -391,6 +391,12 @@ void CL_SendMove (const usercmd_t *cmd)
 	MSG_WriteByte (&buf, in_impulse);
 	in_impulse = 0;
 
+//
+// acknowledge the last snapshot so the server can delta from it
+//
+	if (cl.protocol == PROTOCOL_DELTA)
+		MSG_WriteLong (&buf, cl.snapshot_ack);
+
 //
 // deliver the message
 //
@@ -80,12 +80,12 @@ const char *svc_strings[] =
 	"svc_spawnbaseline2", //42			// support for large modelindex, large framenum, alpha, using flags
 	"svc_spawnstatic2", // 43			// support for large modelindex, large framenum, alpha, using flags
 	"svc_spawnstaticsound2", //	44		// [coord3] [short] samp [byte] vol [byte] aten
-	"", // 44
-	"", // 45
+	"svc_snapshot", // 45				// [long] sequence [long] delta sequence, then entity deltas
 	"", // 46
 	"", // 47
 	"", // 48
 	"", // 49
+	"", // 50
 //johnfitz
 };
 
@@ -276,14 +276,17 @@ void CL_ParseServerInfo (void)
 // parse protocol version number
 	i = MSG_ReadLong ();
 	//johnfitz -- support multiple protocols
-	if (i != PROTOCOL_NETQUAKE && i != PROTOCOL_FITZQUAKE && i != PROTOCOL_RMQ) {
+	if (i != PROTOCOL_NETQUAKE && i != PROTOCOL_FITZQUAKE && i != PROTOCOL_RMQ && i != PROTOCOL_DELTA) {
 		Con_Printf ("\n"); //because there's no newline after serverinfo print
-		Host_Error ("Server returned version %i, not %i or %i or %i", i, PROTOCOL_NETQUAKE, PROTOCOL_FITZQUAKE, PROTOCOL_RMQ);
+		Host_Error ("Server returned version %i, not %i or %i or %i or %i", i, PROTOCOL_NETQUAKE, PROTOCOL_FITZQUAKE, PROTOCOL_RMQ, PROTOCOL_DELTA);
 	}
 	cl.protocol = i;
 	//johnfitz
 
-	if (cl.protocol == PROTOCOL_RMQ)
+	if (cl.protocol == PROTOCOL_DELTA)
+		cl.snapshots = (snapshot_t *) Hunk_AllocName (UPDATE_BACKUP*sizeof(snapshot_t), "snapshots");
+
+	if (cl.protocol == PROTOCOL_RMQ || cl.protocol == PROTOCOL_DELTA)
 	{
 		const unsigned int supportedflags = (PRFL_SHORTANGLE | PRFL_FLOATANGLE | PRFL_24BITCOORD | PRFL_FLOATCOORD | PRFL_EDICTSCALE | PRFL_INT32COORD);
 		
@@ -412,49 +415,21 @@ void CL_ParseServerInfo (void)
 
 /*
 ==================
-CL_ParseUpdate
+CL_SetEntityState
 
-Parse an entity update message from the server
+Applies a full network state to an entity.
 If an entities model or origin changes from frame to frame, it must be
 relinked.  Other attributes can change without relinking.
+lerpfinish is the U_LERPFINISH byte, or -1 if there is none.
 ==================
 */
-void CL_ParseUpdate (int bits)
+static void CL_SetEntityState (int num, const entity_state_t *state, qboolean step, int lerpfinish)
 {
 	int		i;
 	qmodel_t	*model;
 	int		modnum;
 	qboolean	forcelink;
 	entity_t	*ent;
-	int		num;
-	int		skin;
-
-	if (cls.signon == SIGNONS - 1)
-	{	// first update is the final signon stage
-		cls.signon = SIGNONS;
-		CL_SignonReply ();
-	}
-
-	if (bits & U_MOREBITS)
-	{
-		i = MSG_ReadByte ();
-		bits |= (i<<8);
-	}
-
-	//johnfitz -- PROTOCOL_FITZQUAKE
-	if (cl.protocol == PROTOCOL_FITZQUAKE || cl.protocol == PROTOCOL_RMQ)
-	{
-		if (bits & U_EXTEND1)
-			bits |= MSG_ReadByte() << 16;
-		if (bits & U_EXTEND2)
-			bits |= MSG_ReadByte() << 24;
-	}
-	//johnfitz
-
-	if (bits & U_LONGENTITY)
-		num = MSG_ReadShort ();
-	else
-		num = MSG_ReadByte ();
 
 	ent = CL_EntityNum (num);
 
@@ -470,24 +445,13 @@ void CL_ParseUpdate (int bits)
 
 	ent->msgtime = cl.mtime[0];
 
-	if (bits & U_MODEL)
-	{
-		modnum = MSG_ReadByte ();
-		if (modnum >= MAX_MODELS)
-			Host_Error ("CL_ParseModel: bad modnum");
-	}
-	else
-		modnum = ent->baseline.modelindex;
+	modnum = state->modelindex;
+	if (modnum >= MAX_MODELS)
+		Host_Error ("CL_ParseModel: bad modnum");
 
-	if (bits & U_FRAME)
-		ent->frame = MSG_ReadByte ();
-	else
-		ent->frame = ent->baseline.frame;
+	ent->frame = state->frame;
 
-	if (bits & U_COLORMAP)
-		i = MSG_ReadByte();
-	else
-		i = ent->baseline.colormap;
+	i = state->colormap;
 	if (!i)
 		ent->colormap = vid.colormap;
 	else
@@ -496,82 +460,154 @@ void CL_ParseUpdate (int bits)
 			Sys_Error ("i >= cl.maxclients");
 		ent->colormap = cl.scores[i-1].translations;
 	}
-	if (bits & U_SKIN)
-		skin = MSG_ReadByte();
-	else
-		skin = ent->baseline.skin;
-	if (skin != ent->skinnum)
+	if (state->skin != ent->skinnum)
 	{
-		ent->skinnum = skin;
+		ent->skinnum = state->skin;
 		if (num > 0 && num <= cl.maxclients)
 			R_TranslateNewPlayerSkin (num - 1); //johnfitz -- was R_TranslatePlayerSkin
 	}
-	if (bits & U_EFFECTS)
-		ent->effects = MSG_ReadByte();
-	else
-		ent->effects = ent->baseline.effects;
+	ent->effects = state->effects;
 
 // shift the known values for interpolation
 	VectorCopy (ent->msg_origins[0], ent->msg_origins[1]);
 	VectorCopy (ent->msg_angles[0], ent->msg_angles[1]);
+	VectorCopy (state->origin, ent->msg_origins[0]);
+	VectorCopy (state->angles, ent->msg_angles[0]);
 
-	if (bits & U_ORIGIN1)
-		ent->msg_origins[0][0] = MSG_ReadCoord (cl.protocolflags);
-	else
-		ent->msg_origins[0][0] = ent->baseline.origin[0];
-	if (bits & U_ANGLE1)
-		ent->msg_angles[0][0] = MSG_ReadAngle(cl.protocolflags);
+	//johnfitz -- lerping for movetype_step entities
+	if (step)
+	{
+		ent->lerpflags |= LERP_MOVESTEP;
+		ent->forcelink = true;
+	}
 	else
-		ent->msg_angles[0][0] = ent->baseline.angles[0];
+		ent->lerpflags &= ~LERP_MOVESTEP;
+	//johnfitz
 
-	if (bits & U_ORIGIN2)
-		ent->msg_origins[0][1] = MSG_ReadCoord (cl.protocolflags);
-	else
-		ent->msg_origins[0][1] = ent->baseline.origin[1];
-	if (bits & U_ANGLE2)
-		ent->msg_angles[0][1] = MSG_ReadAngle(cl.protocolflags);
-	else
-		ent->msg_angles[0][1] = ent->baseline.angles[1];
+	ent->alpha = state->alpha;
 
-	if (bits & U_ORIGIN3)
-		ent->msg_origins[0][2] = MSG_ReadCoord (cl.protocolflags);
-	else
-		ent->msg_origins[0][2] = ent->baseline.origin[2];
-	if (bits & U_ANGLE3)
-		ent->msg_angles[0][2] = MSG_ReadAngle(cl.protocolflags);
+	if (lerpfinish >= 0)
+	{
+		ent->lerpfinish = ent->msgtime + ((float)lerpfinish / 255);
+		ent->lerpflags |= LERP_FINISH;
+	}
 	else
-		ent->msg_angles[0][2] = ent->baseline.angles[2];
+		ent->lerpflags &= ~LERP_FINISH;
 
-	//johnfitz -- lerping for movetype_step entities
-	if (bits & U_STEP)
+	//johnfitz -- moved here from above
+	model = cl.model_precache[modnum];
+	if (model != ent->model)
 	{
-		ent->lerpflags |= LERP_MOVESTEP;
+		ent->model = model;
+	// automatic animation (torches, etc) can be either all together
+	// or randomized
+		if (model)
+		{
+			if (model->synctype == ST_RAND)
+				ent->syncbase = (float)(rand()&0x7fff) / 0x7fff;
+			else
+				ent->syncbase = 0.0;
+		}
+		else
+			forcelink = true;	// hack to make null model players work
+		if (num > 0 && num <= cl.maxclients)
+			R_TranslateNewPlayerSkin (num - 1); //johnfitz -- was R_TranslatePlayerSkin
+
+		ent->lerpflags |= LERP_RESETANIM; //johnfitz -- don't lerp animation across model changes
+	}
+	//johnfitz
+
+	if ( forcelink )
+	{	// didn't have an update last message
+		VectorCopy (ent->msg_origins[0], ent->msg_origins[1]);
+		VectorCopy (ent->msg_origins[0], ent->origin);
+		VectorCopy (ent->msg_angles[0], ent->msg_angles[1]);
+		VectorCopy (ent->msg_angles[0], ent->angles);
 		ent->forcelink = true;
 	}
-	else
-		ent->lerpflags &= ~LERP_MOVESTEP;
+}
+
+/*
+==================
+CL_ParseUpdate
+
+Parse an entity update message from the server
+==================
+*/
+void CL_ParseUpdate (int bits)
+{
+	int		i;
+	int		num;
+	int		lerpfinish;
+	entity_state_t	state;
+
+	if (cls.signon == SIGNONS - 1)
+	{	// first update is the final signon stage
+		cls.signon = SIGNONS;
+		CL_SignonReply ();
+	}
+
+	if (bits & U_MOREBITS)
+	{
+		i = MSG_ReadByte ();
+		bits |= (i<<8);
+	}
+
+	//johnfitz -- PROTOCOL_FITZQUAKE
+	if (cl.protocol == PROTOCOL_FITZQUAKE || cl.protocol == PROTOCOL_RMQ || cl.protocol == PROTOCOL_DELTA)
+	{
+		if (bits & U_EXTEND1)
+			bits |= MSG_ReadByte() << 16;
+		if (bits & U_EXTEND2)
+			bits |= MSG_ReadByte() << 24;
+	}
 	//johnfitz
 
+	if (bits & U_LONGENTITY)
+		num = MSG_ReadShort ();
+	else
+		num = MSG_ReadByte ();
+
+	state = CL_EntityNum (num)->baseline;
+	lerpfinish = -1;
+
+	if (bits & U_MODEL)
+		state.modelindex = MSG_ReadByte ();
+	if (bits & U_FRAME)
+		state.frame = MSG_ReadByte ();
+	if (bits & U_COLORMAP)
+		state.colormap = MSG_ReadByte();
+	if (bits & U_SKIN)
+		state.skin = MSG_ReadByte();
+	if (bits & U_EFFECTS)
+		state.effects = MSG_ReadByte();
+
+	if (bits & U_ORIGIN1)
+		state.origin[0] = MSG_ReadCoord (cl.protocolflags);
+	if (bits & U_ANGLE1)
+		state.angles[0] = MSG_ReadAngle(cl.protocolflags);
+	if (bits & U_ORIGIN2)
+		state.origin[1] = MSG_ReadCoord (cl.protocolflags);
+	if (bits & U_ANGLE2)
+		state.angles[1] = MSG_ReadAngle(cl.protocolflags);
+	if (bits & U_ORIGIN3)
+		state.origin[2] = MSG_ReadCoord (cl.protocolflags);
+	if (bits & U_ANGLE3)
+		state.angles[2] = MSG_ReadAngle(cl.protocolflags);
+
 	//johnfitz -- PROTOCOL_FITZQUAKE and PROTOCOL_NEHAHRA
-	if (cl.protocol == PROTOCOL_FITZQUAKE || cl.protocol == PROTOCOL_RMQ)
+	if (cl.protocol == PROTOCOL_FITZQUAKE || cl.protocol == PROTOCOL_RMQ || cl.protocol == PROTOCOL_DELTA)
 	{
 		if (bits & U_ALPHA)
-			ent->alpha = MSG_ReadByte();
-		else
-			ent->alpha = ent->baseline.alpha;
+			state.alpha = MSG_ReadByte();
 		if (bits & U_SCALE)
 			MSG_ReadByte(); // PROTOCOL_RMQ: currently ignored
 		if (bits & U_FRAME2)
-			ent->frame = (ent->frame & 0x00FF) | (MSG_ReadByte() << 8);
+			state.frame = (state.frame & 0x00FF) | (MSG_ReadByte() << 8);
 		if (bits & U_MODEL2)
-			modnum = (modnum & 0x00FF) | (MSG_ReadByte() << 8);
+			state.modelindex = (state.modelindex & 0x00FF) | (MSG_ReadByte() << 8);
 		if (bits & U_LERPFINISH)
-		{
-			ent->lerpfinish = ent->msgtime + ((float)(MSG_ReadByte()) / 255);
-			ent->lerpflags |= LERP_FINISH;
-		}
-		else
-			ent->lerpflags &= ~LERP_FINISH;
+			lerpfinish = MSG_ReadByte();
 	}
 	else if (cl.protocol == PROTOCOL_NETQUAKE)
 	{
@@ -590,44 +626,221 @@ void CL_ParseUpdate (int bits)
 			b = MSG_ReadFloat(); //alpha
 			if (a == 2)
 				MSG_ReadFloat(); //fullbright (not using this yet)
-			ent->alpha = ENTALPHA_ENCODE(b);
+			state.alpha = ENTALPHA_ENCODE(b);
 		}
-		else
-			ent->alpha = ent->baseline.alpha;
 	}
 	//johnfitz
 
-	//johnfitz -- moved here from above
-	model = cl.model_precache[modnum];
-	if (model != ent->model)
+	CL_SetEntityState (num, &state, (bits & U_STEP) != 0, lerpfinish);
+}
+
+/*
+==================
+CL_ParseSnapshotEntity
+
+Reads the changed fields of one svc_snapshot record into s
+==================
+*/
+static void CL_ParseSnapshotEntity (snapshot_entity_t *s)
+{
+	int		bits;
+
+	bits = MSG_ReadByte ();
+	if (bits & U_MOREBITS)
+		bits |= MSG_ReadByte () << 8;
+	if (bits & U_EXTEND1)
+		bits |= MSG_ReadByte () << 16;
+	if (bits & U_EXTEND2)
+		bits |= MSG_ReadByte () << 24;
+
+	if (bits & U_MODEL)
+		s->state.modelindex = MSG_ReadByte ();
+	if (bits & U_FRAME)
+		s->state.frame = MSG_ReadByte ();
+	if (bits & U_COLORMAP)
+		s->state.colormap = MSG_ReadByte ();
+	if (bits & U_SKIN)
+		s->state.skin = MSG_ReadByte ();
+	if (bits & U_EFFECTS)
+		s->state.effects = MSG_ReadByte ();
+	if (bits & U_ORIGIN1)
+		s->state.origin[0] = MSG_ReadCoord (cl.protocolflags);
+	if (bits & U_ANGLE1)
+		s->state.angles[0] = MSG_ReadAngle (cl.protocolflags);
+	if (bits & U_ORIGIN2)
+		s->state.origin[1] = MSG_ReadCoord (cl.protocolflags);
+	if (bits & U_ANGLE2)
+		s->state.angles[1] = MSG_ReadAngle (cl.protocolflags);
+	if (bits & U_ORIGIN3)
+		s->state.origin[2] = MSG_ReadCoord (cl.protocolflags);
+	if (bits & U_ANGLE3)
+		s->state.angles[2] = MSG_ReadAngle (cl.protocolflags);
+	if (bits & U_ALPHA)
+		s->state.alpha = MSG_ReadByte ();
+	if (bits & U_FRAME2)
+		s->state.frame = (s->state.frame & 0x00FF) | (MSG_ReadByte () << 8);
+	if (bits & U_MODEL2)
+		s->state.modelindex = (s->state.modelindex & 0x00FF) | (MSG_ReadByte () << 8);
+
+	s->flags = 0;
+	if (bits & U_STEP)
+		s->flags |= SNAPFL_STEP;
+	if (bits & U_LERPFINISH)
 	{
-		ent->model = model;
-	// automatic animation (torches, etc) can be either all together
-	// or randomized
-		if (model)
-		{
-			if (model->synctype == ST_RAND)
-				ent->syncbase = (float)(rand()&0x7fff) / 0x7fff;
-			else
-				ent->syncbase = 0.0;
-		}
+		s->flags |= SNAPFL_LERPFINISH;
+		s->lerpfinish = MSG_ReadByte ();
+	}
+}
+
+/*
+==================
+CL_AllocSnapshotEntity
+==================
+*/
+static snapshot_entity_t *CL_AllocSnapshotEntity (snapshot_t *frame)
+{
+	if (frame->num_entities == MAX_SNAPSHOT_ENTITIES)
+		Host_Error ("CL_ParseSnapshot: more than %i entities", MAX_SNAPSHOT_ENTITIES);
+	return &frame->entities[frame->num_entities++];
+}
+
+/*
+==================
+CL_KeepSnapshotEntity
+
+Carries an entity that wasn't sent over from the delta reference
+==================
+*/
+static void CL_KeepSnapshotEntity (snapshot_t *frame, const snapshot_entity_t *old)
+{
+	snapshot_entity_t	*s;
+
+	s = CL_AllocSnapshotEntity (frame);
+	*s = *old;
+	s->flags &= ~SNAPFL_LERPFINISH;
+}
+
+/*
+==================
+CL_SetSnapshotState
+
+repeat keeps the entities where they are, without the one-off step and lerp
+flags of the snapshot
+==================
+*/
+static void CL_SetSnapshotState (const snapshot_t *frame, qboolean repeat)
+{
+	const snapshot_entity_t	*s;
+	int		i;
+
+	for (i = 0, s = frame->entities ; i < frame->num_entities ; i++, s++)
+	{
+		if (repeat)
+			CL_SetEntityState (s->number, &s->state, false, -1);
 		else
-			forcelink = true;	// hack to make null model players work
-		if (num > 0 && num <= cl.maxclients)
-			R_TranslateNewPlayerSkin (num - 1); //johnfitz -- was R_TranslatePlayerSkin
+			CL_SetEntityState (s->number, &s->state, (s->flags & SNAPFL_STEP) != 0,
+				(s->flags & SNAPFL_LERPFINISH) ? s->lerpfinish : -1);
+	}
+}
 
-		ent->lerpflags |= LERP_RESETANIM; //johnfitz -- don't lerp animation across model changes
+/*
+==================
+CL_ParseSnapshot
+
+PROTOCOL_DELTA entity update, see SV_WriteSnapshotToClient.  The new
+snapshot is rebuilt from the one it was delta-compressed against, and
+then every entity in it is updated, changed or not.
+==================
+*/
+static void CL_ParseSnapshot (void)
+{
+	int		sequence, deltasequence, num, oldindex;
+	qboolean	remove, valid;
+	snapshot_t	*frame, *from;
+	snapshot_entity_t	*s, *old;
+
+	if (cls.signon == SIGNONS - 1)
+	{	// first update is the final signon stage
+		cls.signon = SIGNONS;
+		CL_SignonReply ();
 	}
-	//johnfitz
 
-	if ( forcelink )
-	{	// didn't have an update last message
-		VectorCopy (ent->msg_origins[0], ent->msg_origins[1]);
-		VectorCopy (ent->msg_origins[0], ent->origin);
-		VectorCopy (ent->msg_angles[0], ent->msg_angles[1]);
-		VectorCopy (ent->msg_angles[0], ent->angles);
-		ent->forcelink = true;
+	if (!cl.snapshots)
+		Host_Error ("CL_ParseSnapshot: svc_snapshot without PROTOCOL_DELTA");
+
+	sequence = MSG_ReadLong ();
+	deltasequence = MSG_ReadLong ();
+
+	valid = true;
+	from = NULL;
+	if (deltasequence)
+	{
+		from = &cl.snapshots[deltasequence & UPDATE_MASK];
+		if (from->sequence != deltasequence || sequence - deltasequence <= 0 || sequence - deltasequence >= UPDATE_BACKUP)
+		{	// the reference is gone, parse anyway to skip the data
+			from = NULL;
+			valid = false;
+		}
 	}
+
+	frame = &cl.snapshots[sequence & UPDATE_MASK];
+	frame->sequence = 0;
+	frame->num_entities = 0;
+
+	oldindex = 0;
+	while (1)
+	{
+		num = MSG_ReadShort () & 0xFFFF;
+		if (msg_badread)
+			Host_Error ("CL_ParseSnapshot: end of message");
+		if (!num)
+			break;
+		remove = (num & SNAP_REMOVE) != 0;
+		num &= ~SNAP_REMOVE;
+
+	// carry over the unchanged entities before this one
+		while (from && oldindex < from->num_entities && from->entities[oldindex].number < num)
+			CL_KeepSnapshotEntity (frame, &from->entities[oldindex++]);
+
+		old = NULL;
+		if (from && oldindex < from->num_entities && from->entities[oldindex].number == num)
+			old = &from->entities[oldindex++];
+
+		if (remove)
+			continue;
+
+		s = CL_AllocSnapshotEntity (frame);
+		if (old)
+			*s = *old;
+		else
+		{
+			s->number = num;
+			s->state = CL_EntityNum (num)->baseline;
+		}
+		CL_ParseSnapshotEntity (s);
+	}
+
+	while (from && oldindex < from->num_entities)
+		CL_KeepSnapshotEntity (frame, &from->entities[oldindex++]);
+
+	if (!valid)
+	{
+		cl.snapshot_ack = 0;	// ask for a full update
+	// entities that aren't updated this frame aren't drawn, keep the last
+	// snapshot until the full update arrives, or the baselines if it's gone
+		from = &cl.snapshots[cl.snapshot_shown & UPDATE_MASK];
+		if (cl.snapshot_shown && from->sequence == cl.snapshot_shown)
+			CL_SetSnapshotState (from, true);
+		else
+			CL_SetSnapshotState (frame, false);
+		return;
+	}
+
+	frame->sequence = sequence;
+	cl.snapshot_ack = sequence;
+	cl.snapshot_shown = sequence;
+
+	CL_SetSnapshotState (frame, false);
 }
 
 /*
@@ -1000,11 +1213,15 @@ void CL_ParseServerMessage (void)
 			CL_ParseClientdata (); //johnfitz -- removed bits parameter, we will read this inside CL_ParseClientdata()
 			break;
 
+		case svc_snapshot:
+			CL_ParseSnapshot ();
+			break;
+
 		case svc_version:
 			i = MSG_ReadLong ();
 			//johnfitz -- support multiple protocols
-			if (i != PROTOCOL_NETQUAKE && i != PROTOCOL_FITZQUAKE && i != PROTOCOL_RMQ)
-				Host_Error ("Server returned version %i, not %i or %i or %i", i, PROTOCOL_NETQUAKE, PROTOCOL_FITZQUAKE, PROTOCOL_RMQ);
+			if (i != PROTOCOL_NETQUAKE && i != PROTOCOL_FITZQUAKE && i != PROTOCOL_RMQ && i != PROTOCOL_DELTA)
+				Host_Error ("Server returned version %i, not %i or %i or %i or %i", i, PROTOCOL_NETQUAKE, PROTOCOL_FITZQUAKE, PROTOCOL_RMQ, PROTOCOL_DELTA);
 			cl.protocol = i;
 			//johnfitz
 			break;
@@ -231,6 +231,11 @@ typedef struct
 
 	unsigned	protocol; //johnfitz
 	unsigned	protocolflags;
+
+// PROTOCOL_DELTA entity snapshots
+	snapshot_t	*snapshots;		// [UPDATE_BACKUP]
+	int			snapshot_ack;	// last snapshot received intact, sent back with each move
+	int			snapshot_shown;	// last snapshot the entities were set from
 } client_state_t;
 
 
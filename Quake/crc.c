@@ -92,3 +92,37 @@ unsigned short CRC_Block (byte *start, int count)
 
 	return crc;
 }
+
+// the 32 bit, reflected CRC using the polynomial 0xedb88320 from zip and
+// png, for when 16 bits aren't enough to tell data apart
+
+static unsigned int crc32table[256];
+
+/*
+================
+CRC32_Block -- the table is filled in on the first call, which should
+happen on the main thread before any task workers need it
+================
+*/
+unsigned int CRC32_Block (const byte *start, int count)
+{
+	unsigned int	crc;
+	int				i, j;
+
+	if (!crc32table[255])
+	{
+		for (i = 0; i < 256; i++)
+		{
+			crc = i;
+			for (j = 0; j < 8; j++)
+				crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+			crc32table[i] = crc;
+		}
+	}
+
+	crc = 0xffffffff;
+	while (count--)
+		crc = (crc >> 8) ^ crc32table[(crc ^ *start++) & 0xff];
+
+	return crc ^ 0xffffffff;
+}
@@ -28,6 +28,7 @@ void CRC_Init(unsigned short *crcvalue);
 void CRC_ProcessByte(unsigned short *crcvalue, byte data);
 unsigned short CRC_Value(unsigned short crcvalue);
 unsigned short CRC_Block (byte *start, int count); //johnfitz -- texture crc
+unsigned int CRC32_Block (const byte *start, int count);
 
 #endif	/* _QUAKE_CRC_H */
 
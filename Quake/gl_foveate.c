@@ -0,0 +1,336 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+Copyright (C) 2010-2014 QuakeSpasm developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// gl_foveate.c -- fixed foveated rendering
+
+#include "quakedef.h"
+
+/*
+The lenses blur the edge of the eye image anyway, so the scene is shaded at a
+coarser rate away from the lens center: full rate inside r_foveated_inner, one
+fragment per 2x2 pixels up to r_foveated_outer and one per 4x4 beyond.  The lens
+center is where the eye's projection puts the forward axis, the radii are in
+half eye widths.
+
+r_foveated 1 uses VK_NV_shading_rate_image.  Every command buffer slot owns a
+rate image, rewritten from a staging slot when the lens parameters or the
+render size changed since that slot was last recorded.
+
+r_foveated 2, and 1 on devices without shading rate images, keeps the coarse
+pixels out with a depth mask drawn before the scene and copies each block's
+shaded pixel over the rest in a compute pass.  It only needs core Vulkan, so
+it also runs on software rasterizers.
+*/
+
+#define FOVEATION_OFF		0
+#define FOVEATION_RATE		1
+#define FOVEATION_MASK		2
+
+cvar_t r_foveated = {"r_foveated", "0", CVAR_ARCHIVE};	// 1 = shading rate image if supported, 2 = depth mask and fill
+cvar_t r_foveated_inner = {"r_foveated_inner", "0.5", CVAR_ARCHIVE};
+cvar_t r_foveated_outer = {"r_foveated_outer", "0.8", CVAR_ARCHIVE};
+
+qboolean foveation_mask;
+
+typedef struct
+{
+	VkImage			image;
+	VkImageView		view;
+	VkDeviceMemory	memory;
+	qboolean		valid;
+	float			lens_center[2];		// what the image was last built for
+	float			inner_radius;
+	float			outer_radius;
+	uint32_t		render_width;
+	uint32_t		render_height;
+} rateimage_t;
+
+static rateimage_t		rate_images[NUM_COMMAND_BUFFERS];
+static uint32_t			rate_width, rate_height;		// in texels of shading_rate_texel_size
+static VkBuffer			rate_staging_buffer;
+static VkDeviceMemory	rate_staging_memory;
+static byte				*rate_staging_data;
+
+// the eye being recorded, in pixels of the part of the eye buffer that is rendered to
+static float			lens_center[2];
+static float			inner_radius;
+static float			outer_radius;
+
+/*
+=================
+R_InitFoveation
+=================
+*/
+void R_InitFoveation (void)
+{
+	VkResult err;
+	int i;
+
+	Cvar_RegisterVariable (&r_foveated);
+	Cvar_RegisterVariable (&r_foveated_inner);
+	Cvar_RegisterVariable (&r_foveated_outer);
+
+	if (!vulkan_globals.shading_rate_image)
+		return;
+
+	rate_width = (vr.width + vulkan_globals.shading_rate_texel_size.width - 1) / vulkan_globals.shading_rate_texel_size.width;
+	rate_height = (vr.height + vulkan_globals.shading_rate_texel_size.height - 1) / vulkan_globals.shading_rate_texel_size.height;
+
+	for (i = 0; i < NUM_COMMAND_BUFFERS; ++i)
+	{
+		rateimage_t *rate = &rate_images[i];
+
+		VkImageCreateInfo image_create_info;
+		memset(&image_create_info, 0, sizeof(image_create_info));
+		image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		image_create_info.imageType = VK_IMAGE_TYPE_2D;
+		image_create_info.format = VK_FORMAT_R8_UINT;
+		image_create_info.extent.width = rate_width;
+		image_create_info.extent.height = rate_height;
+		image_create_info.extent.depth = 1;
+		image_create_info.mipLevels = 1;
+		image_create_info.arrayLayers = 1;
+		image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+		image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+		image_create_info.usage = VK_IMAGE_USAGE_SHADING_RATE_IMAGE_BIT_NV | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		err = vkCreateImage(vulkan_globals.device, &image_create_info, NULL, &rate->image);
+		if (err != VK_SUCCESS)
+			Sys_Error("vkCreateImage failed");
+
+		GL_SetObjectName((uint64_t)rate->image, VK_DEBUG_REPORT_OBJECT_TYPE_IMAGE_EXT, "Shading Rate Image");
+
+		VkMemoryRequirements memory_requirements;
+		vkGetImageMemoryRequirements(vulkan_globals.device, rate->image, &memory_requirements);
+
+		VkMemoryAllocateInfo memory_allocate_info;
+		memset(&memory_allocate_info, 0, sizeof(memory_allocate_info));
+		memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		memory_allocate_info.allocationSize = memory_requirements.size;
+		memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0);
+
+		num_vulkan_misc_allocations += 1;
+		err = vkAllocateMemory(vulkan_globals.device, &memory_allocate_info, NULL, &rate->memory);
+		if (err != VK_SUCCESS)
+			Sys_Error("vkAllocateMemory failed");
+
+		err = vkBindImageMemory(vulkan_globals.device, rate->image, rate->memory, 0);
+		if (err != VK_SUCCESS)
+			Sys_Error("vkBindImageMemory failed");
+
+		VkImageViewCreateInfo image_view_create_info;
+		memset(&image_view_create_info, 0, sizeof(image_view_create_info));
+		image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		image_view_create_info.format = VK_FORMAT_R8_UINT;
+		image_view_create_info.image = rate->image;
+		image_view_create_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		image_view_create_info.subresourceRange.baseMipLevel = 0;
+		image_view_create_info.subresourceRange.levelCount = 1;
+		image_view_create_info.subresourceRange.baseArrayLayer = 0;
+		image_view_create_info.subresourceRange.layerCount = 1;
+		image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+
+		err = vkCreateImageView(vulkan_globals.device, &image_view_create_info, NULL, &rate->view);
+		if (err != VK_SUCCESS)
+			Sys_Error("vkCreateImageView failed");
+	}
+
+	VkBufferCreateInfo buffer_create_info;
+	memset(&buffer_create_info, 0, sizeof(buffer_create_info));
+	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_create_info.size = NUM_COMMAND_BUFFERS * rate_width * rate_height;
+	buffer_create_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+	err = vkCreateBuffer(vulkan_globals.device, &buffer_create_info, NULL, &rate_staging_buffer);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkCreateBuffer failed");
+
+	GL_SetObjectName((uint64_t)rate_staging_buffer, VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Shading Rate Staging Buffer");
+
+	VkMemoryRequirements memory_requirements;
+	vkGetBufferMemoryRequirements(vulkan_globals.device, rate_staging_buffer, &memory_requirements);
+
+	VkMemoryAllocateInfo memory_allocate_info;
+	memset(&memory_allocate_info, 0, sizeof(memory_allocate_info));
+	memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memory_allocate_info.allocationSize = memory_requirements.size;
+	memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0);
+
+	num_vulkan_misc_allocations += 1;
+	err = vkAllocateMemory(vulkan_globals.device, &memory_allocate_info, NULL, &rate_staging_memory);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkAllocateMemory failed");
+
+	err = vkBindBufferMemory(vulkan_globals.device, rate_staging_buffer, rate_staging_memory, 0);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkBindBufferMemory failed");
+
+	void * data;
+	err = vkMapMemory(vulkan_globals.device, rate_staging_memory, 0, VK_WHOLE_SIZE, 0, &data);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkMapMemory failed");
+	rate_staging_data = (byte *)data;
+}
+
+/*
+=================
+R_UpdateRateImage -- the previous submission of this slot has finished, image and staging slot are free
+=================
+*/
+static void R_UpdateRateImage (int slot)
+{
+	rateimage_t *rate = &rate_images[slot];
+	const uint32_t texel_width = vulkan_globals.shading_rate_texel_size.width;
+	const uint32_t texel_height = vulkan_globals.shading_rate_texel_size.height;
+	byte *texels = rate_staging_data + slot * rate_width * rate_height;
+	uint32_t x, y;
+
+	if (rate->valid && rate->lens_center[0] == lens_center[0] && rate->lens_center[1] == lens_center[1]
+		&& rate->inner_radius == inner_radius && rate->outer_radius == outer_radius
+		&& rate->render_width == vr.render_width && rate->render_height == vr.render_height)
+		return;
+
+	rate->valid = true;
+	rate->lens_center[0] = lens_center[0];
+	rate->lens_center[1] = lens_center[1];
+	rate->inner_radius = inner_radius;
+	rate->outer_radius = outer_radius;
+	rate->render_width = vr.render_width;
+	rate->render_height = vr.render_height;
+
+	// palette indices, see the shading rate palette in R_CreatePipelines
+	for (y = 0; y < rate_height; ++y)
+	{
+		for (x = 0; x < rate_width; ++x)
+		{
+			float dx = (x + 0.5f) * texel_width - lens_center[0];
+			float dy = (y + 0.5f) * texel_height - lens_center[1];
+			float dist = sqrt(dx * dx + dy * dy);
+
+			texels[y * rate_width + x] = (dist < inner_radius) ? 0 : (dist < outer_radius) ? 1 : 2;
+		}
+	}
+
+	VkImageMemoryBarrier image_barrier;
+	image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	image_barrier.pNext = NULL;
+	image_barrier.srcAccessMask = 0;
+	image_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	image_barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	image_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_barrier.image = rate->image;
+	image_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	image_barrier.subresourceRange.baseMipLevel = 0;
+	image_barrier.subresourceRange.levelCount = 1;
+	image_barrier.subresourceRange.baseArrayLayer = 0;
+	image_barrier.subresourceRange.layerCount = 1;
+
+	vkCmdPipelineBarrier(vulkan_globals.command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &image_barrier);
+
+	VkBufferImageCopy region;
+	memset(&region, 0, sizeof(region));
+	region.bufferOffset = slot * rate_width * rate_height;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent.width = rate_width;
+	region.imageExtent.height = rate_height;
+	region.imageExtent.depth = 1;
+
+	vkCmdCopyBufferToImage(vulkan_globals.command_buffer, rate_staging_buffer, rate->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+	image_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	image_barrier.dstAccessMask = VK_ACCESS_SHADING_RATE_IMAGE_READ_BIT_NV;
+	image_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	image_barrier.newLayout = VK_IMAGE_LAYOUT_SHADING_RATE_OPTIMAL_NV;
+
+	vkCmdPipelineBarrier(vulkan_globals.command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_SHADING_RATE_IMAGE_BIT_NV, 0, 0, NULL, 0, NULL, 1, &image_barrier);
+}
+
+/*
+=================
+R_BeginFoveation -- call right after vkBeginCommandBuffer, outside any render pass
+=================
+*/
+void R_BeginFoveation (int slot)
+{
+	const float *projection = vr.eye[vr.current_eye].projection;
+	int mode = (int)r_foveated.value;
+
+	if (mode == FOVEATION_RATE && !vulkan_globals.shading_rate_image)
+		mode = FOVEATION_MASK;
+
+	// the forward axis lands at -projection[8], -projection[9] in clip space
+	lens_center[0] = (1.0f - projection[2 * 4 + 0]) * 0.5f * vr.render_width;
+	lens_center[1] = (1.0f - projection[2 * 4 + 1]) * 0.5f * vr.render_height;
+	inner_radius = q_max(r_foveated_inner.value, 0.0f) * 0.5f * vr.render_width;
+	outer_radius = q_max(r_foveated_outer.value, r_foveated_inner.value) * 0.5f * vr.render_width;
+
+	foveation_mask = (mode == FOVEATION_MASK);
+
+	if (!vulkan_globals.shading_rate_image)
+		return;
+
+	// the scene pipelines always read a rate image, a null view reads as 0, full rate
+	if (mode == FOVEATION_RATE)
+	{
+		R_UpdateRateImage(slot);
+		vulkan_globals.cmd_bind_shading_rate_image(vulkan_globals.command_buffer, rate_images[slot].view, VK_IMAGE_LAYOUT_SHADING_RATE_OPTIMAL_NV);
+	}
+	else
+		vulkan_globals.cmd_bind_shading_rate_image(vulkan_globals.command_buffer, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED);
+}
+
+/*
+=================
+R_DrawFoveationMask -- first thing in the main render pass, after the hidden area mesh
+=================
+*/
+void R_DrawFoveationMask (void)
+{
+	const float constants[4] = { lens_center[0], lens_center[1], inner_radius, outer_radius };
+
+	// overwrites the start of the matrix, R_SetupMatrix pushes it again
+	vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.foveation_mask_pipeline);
+	vkCmdPushConstants(vulkan_globals.command_buffer, vulkan_globals.basic_pipeline_layout, VK_SHADER_STAGE_ALL_GRAPHICS, 0, 4 * sizeof(float), constants);
+	vkCmdDraw(vulkan_globals.command_buffer, 3, 1, 0, 0);
+}
+
+/*
+=================
+R_FillFoveation -- GL_Set2D, the scene is readable in the warp input, the output is writable
+=================
+*/
+void R_FillFoveation (void)
+{
+	const uint32_t screen_size[2] = { vr.render_width, vr.render_height };
+	const float constants[4] = { lens_center[0], lens_center[1], inner_radius, outer_radius };
+
+	vkCmdPushConstants(vulkan_globals.command_buffer, vulkan_globals.foveation_fill_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, 2 * sizeof(uint32_t), screen_size);
+	vkCmdPushConstants(vulkan_globals.command_buffer, vulkan_globals.foveation_fill_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 2 * sizeof(uint32_t), 4 * sizeof(float), constants);
+
+	vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, vulkan_globals.foveation_fill_pipeline_layout, 0, 1, &vulkan_globals.screen_warp_desc_set, 0, NULL);
+	vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, vulkan_globals.foveation_fill_pipeline);
+	vkCmdDispatch(vulkan_globals.command_buffer, (vr.render_width + 7) / 8, (vr.render_height + 7) / 8, 1);
+}
@@ -449,7 +449,6 @@ void GL_MakeAliasModelDisplayLists_VBO (void)
 }
 
 #define NUMVERTEXNORMALS	 162
-extern	float	r_avertexnormals[NUMVERTEXNORMALS][3];
 
 /*
 ================
@@ -551,15 +550,10 @@ static void GLMesh_LoadVertexBuffer (qmodel_t *m, const aliashdr_t *hdr)
 			xyz[v].xyz[0] = trivert.v[0];
 			xyz[v].xyz[1] = trivert.v[1];
 			xyz[v].xyz[2] = trivert.v[2];
-			xyz[v].xyz[3] = 1;	// need w 1 for 4 byte vertex compression
-
-			// map the normal coordinates in [-1..1] to [-127..127] and store in an unsigned char.
-			// this introduces some error (less than 0.004), but the normals were very coarse
-			// to begin with
-			xyz[v].normal[0] = 127 * r_avertexnormals[trivert.lightnormalindex][0];
-			xyz[v].normal[1] = 127 * r_avertexnormals[trivert.lightnormalindex][1];
-			xyz[v].normal[2] = 127 * r_avertexnormals[trivert.lightnormalindex][2];
-			xyz[v].normal[3] = 0;	// unused; for 4-byte alignment
+
+			// keep the quantized normal as is, alias.vert has the same table.
+			// out of range indexes would read past the end of it
+			xyz[v].normalindex = (trivert.lightnormalindex < NUMVERTEXNORMALS) ? trivert.lightnormalindex : 0;
 		}
 	}
 
@@ -587,7 +581,7 @@ static void GLMesh_LoadVertexBuffer (qmodel_t *m, const aliashdr_t *hdr)
 		memset(&buffer_create_info, 0, sizeof(buffer_create_info));
 		buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 		buffer_create_info.size = totalvbosize;
-		buffer_create_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		buffer_create_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
 		err = vkCreateBuffer(vulkan_globals.device, &buffer_create_info, NULL, &m->vertex_buffer);
 		if (err != VK_SUCCESS)
 			Sys_Error("vkCreateBuffer failed");
@@ -619,6 +613,38 @@ static void GLMesh_LoadVertexBuffer (qmodel_t *m, const aliashdr_t *hdr)
 		vkCmdCopyBuffer(command_buffer, staging_buffer, m->vertex_buffer, 1, &region);
 	}
 
+	// Poses are fetched by pose offset + vertex index in alias.vert
+	{
+		VkDescriptorSetAllocateInfo descriptor_set_allocate_info;
+		memset(&descriptor_set_allocate_info, 0, sizeof(descriptor_set_allocate_info));
+		descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		descriptor_set_allocate_info.descriptorPool = vulkan_globals.descriptor_pool;
+		descriptor_set_allocate_info.descriptorSetCount = 1;
+		descriptor_set_allocate_info.pSetLayouts = &vulkan_globals.pose_set_layout;
+
+		err = vkAllocateDescriptorSets(vulkan_globals.device, &descriptor_set_allocate_info, &m->pose_descriptor_set);
+		if (err != VK_SUCCESS)
+			Sys_Error("vkAllocateDescriptorSets failed");
+
+		VkDescriptorBufferInfo buffer_info;
+		memset(&buffer_info, 0, sizeof(buffer_info));
+		buffer_info.buffer = m->vertex_buffer;
+		buffer_info.offset = m->vboxyzofs;
+		buffer_info.range = hdr->numposes * hdr->numverts_vbo * sizeof (meshxyz_t);
+
+		VkWriteDescriptorSet pose_write;
+		memset(&pose_write, 0, sizeof(pose_write));
+		pose_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		pose_write.dstSet = m->pose_descriptor_set;
+		pose_write.dstBinding = 0;
+		pose_write.dstArrayElement = 0;
+		pose_write.descriptorCount = 1;
+		pose_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		pose_write.pBufferInfo = &buffer_info;
+
+		vkUpdateDescriptorSets(vulkan_globals.device, 1, &pose_write, 0, NULL);
+	}
+
 	free (vbodata);
 }
 
@@ -665,12 +691,16 @@ void GLMesh_DeleteVertexBuffers (void)
 		if (!(m = cl.model_precache[j])) break;
 		if (m->type != mod_alias) continue;
 
+		if (m->pose_descriptor_set != VK_NULL_HANDLE)
+			vkFreeDescriptorSets(vulkan_globals.device, vulkan_globals.descriptor_pool, 1, &m->pose_descriptor_set);
+
 		vkDestroyBuffer(vulkan_globals.device, m->vertex_buffer, NULL);
 		GL_FreeFromHeaps(GEOMETRY_MAX_HEAPS, vertex_buffer_heaps, m->vertex_heap, m->vertex_heap_node, &num_vulkan_mesh_allocations);
 
 		vkDestroyBuffer(vulkan_globals.device, m->index_buffer, NULL);
 		GL_FreeFromHeaps(GEOMETRY_MAX_HEAPS, index_buffer_heaps, m->index_heap, m->index_heap_node, &num_vulkan_mesh_allocations);
 
+		m->pose_descriptor_set = VK_NULL_HANDLE;
 		m->vertex_buffer = VK_NULL_HANDLE;
 		m->vertex_heap = NULL;
 		m->vertex_heap_node = NULL;
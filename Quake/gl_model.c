@@ -52,7 +52,6 @@ Mod_Init
 */
 void Mod_Init (void)
 {
-	Cvar_RegisterVariable (&gl_subdivide_size);
 	Cvar_RegisterVariable (&external_ents);
 
 	memset (mod_novis, 0xff, sizeof(mod_novis));
@@ -398,10 +397,9 @@ void Mod_LoadTextures (lump_t *l)
 	char		texturename[64];
 	int			nummiptex;
 	src_offset_t		offset;
-	int			mark, fwidth, fheight;
+	qboolean	found;
 	char		filename[MAX_OSPATH], filename2[MAX_OSPATH], mapname[MAX_OSPATH];
-	byte		*data;
-	extern byte *hunk_base;
+	imagefile_t	file;
 //johnfitz
 
 	//johnfitz -- don't return early if no textures; still need to create dummy texture
@@ -422,6 +420,8 @@ void Mod_LoadTextures (lump_t *l)
 	loadmodel->numtextures = nummiptex + 2; //johnfitz -- need 2 dummy texture chains for missing textures
 	loadmodel->textures = (texture_t **) Hunk_AllocName (loadmodel->numtextures * sizeof(*loadmodel->textures) , loadname);
 
+	TexMgr_BeginBatch ();
+
 	for (i=0 ; i<nummiptex ; i++)
 	{
 		m->dataofs[i] = LittleLong(m->dataofs[i]);
@@ -457,8 +457,6 @@ void Mod_LoadTextures (lump_t *l)
 		}
 		memcpy ( tx+1, mt+1, pixels);
 
-		tx->update_warp = false; //johnfitz
-		tx->warpimage = NULL; //johnfitz
 		tx->fullbright = NULL; //johnfitz
 
 		//johnfitz -- lots of changes
@@ -469,38 +467,28 @@ void Mod_LoadTextures (lump_t *l)
 			else if (tx->name[0] == '*') //warping texture
 			{
 				//external textures -- first look in "textures/mapname/" then look in "textures/"
-				mark = Hunk_LowMark();
 				COM_StripExtension (loadmodel->name + 5, mapname, sizeof(mapname));
 				q_snprintf (filename, sizeof(filename), "textures/%s/#%s", mapname, tx->name+1); //this also replaces the '*' with a '#'
-				data = Image_LoadImage (filename, &fwidth, &fheight);
-				if (!data)
+				found = Image_FindImage (filename, &file);
+				if (!found)
 				{
 					q_snprintf (filename, sizeof(filename), "textures/#%s", tx->name+1);
-					data = Image_LoadImage (filename, &fwidth, &fheight);
+					found = Image_FindImage (filename, &file);
 				}
 
 				//now load whatever we found
-				if (data) //load external image
+				if (found) //load external image
 				{
 					q_strlcpy (texturename, filename, sizeof(texturename));
-					tx->gltexture = TexMgr_LoadImage (loadmodel, texturename, fwidth, fheight,
-						SRC_RGBA, data, filename, 0, TEXPREF_NONE);
+					tx->gltexture = TexMgr_QueueImageFile (loadmodel, texturename, &file, filename, TEXPREF_NONE);
 				}
 				else //use the texture from the bsp file
 				{
 					q_snprintf (texturename, sizeof(texturename), "%s:%s", loadmodel->name, tx->name);
 					offset = (src_offset_t)(mt+1) - (src_offset_t)mod_base;
-					tx->gltexture = TexMgr_LoadImage (loadmodel, texturename, tx->width, tx->height,
+					tx->gltexture = TexMgr_QueueImage (loadmodel, texturename, tx->width, tx->height,
 						SRC_INDEXED, (byte *)(tx+1), loadmodel->name, offset, TEXPREF_NONE);
 				}
-
-				//now create the warpimage, using dummy data from the hunk to create the initial image
-				Hunk_Alloc (WARPIMAGESIZE*WARPIMAGESIZE*4); //make sure hunk is big enough so we don't reach an illegal address
-				Hunk_FreeToLowMark (mark);
-				q_snprintf (texturename, sizeof(texturename), "%s_warp", texturename);
-				tx->warpimage = TexMgr_LoadImage (loadmodel, texturename, WARPIMAGESIZE,
-					WARPIMAGESIZE, SRC_RGBA, hunk_base, "", (src_offset_t)hunk_base, TEXPREF_NOPICMIP | TEXPREF_WARPIMAGE);
-				tx->update_warp = true;
 			}
 			else //regular texture
 			{
@@ -513,35 +501,31 @@ void Mod_LoadTextures (lump_t *l)
 				// ericw
 
 				//external textures -- first look in "textures/mapname/" then look in "textures/"
-				mark = Hunk_LowMark ();
 				COM_StripExtension (loadmodel->name + 5, mapname, sizeof(mapname));
 				q_snprintf (filename, sizeof(filename), "textures/%s/%s", mapname, tx->name);
-				data = Image_LoadImage (filename, &fwidth, &fheight);
-				if (!data)
+				found = Image_FindImage (filename, &file);
+				if (!found)
 				{
 					q_snprintf (filename, sizeof(filename), "textures/%s", tx->name);
-					data = Image_LoadImage (filename, &fwidth, &fheight);
+					found = Image_FindImage (filename, &file);
 				}
 
 				//now load whatever we found
-				if (data) //load external image
+				if (found) //load external image
 				{
-					tx->gltexture = TexMgr_LoadImage (loadmodel, filename, fwidth, fheight,
-						SRC_RGBA, data, filename, 0, TEXPREF_MIPMAP | extraflags );
+					tx->gltexture = TexMgr_QueueImageFile (loadmodel, filename, &file, filename, TEXPREF_MIPMAP | extraflags );
 
 					//now try to load glow/luma image from the same place
-					Hunk_FreeToLowMark (mark);
 					q_snprintf (filename2, sizeof(filename2), "%s_glow", filename);
-					data = Image_LoadImage (filename2, &fwidth, &fheight);
-					if (!data)
+					found = Image_FindImage (filename2, &file);
+					if (!found)
 					{
 						q_snprintf (filename2, sizeof(filename2), "%s_luma", filename);
-						data = Image_LoadImage (filename2, &fwidth, &fheight);
+						found = Image_FindImage (filename2, &file);
 					}
 
-					if (data)
-						tx->fullbright = TexMgr_LoadImage (loadmodel, filename2, fwidth, fheight,
-							SRC_RGBA, data, filename, 0, TEXPREF_MIPMAP | extraflags );
+					if (found)
+						tx->fullbright = TexMgr_QueueImageFile (loadmodel, filename2, &file, filename, TEXPREF_MIPMAP | extraflags );
 				}
 				else //use the texture from the bsp file
 				{
@@ -549,24 +533,25 @@ void Mod_LoadTextures (lump_t *l)
 					offset = (src_offset_t)(mt+1) - (src_offset_t)mod_base;
 					if (Mod_CheckFullbrights ((byte *)(tx+1), pixels))
 					{
-						tx->gltexture = TexMgr_LoadImage (loadmodel, texturename, tx->width, tx->height,
+						tx->gltexture = TexMgr_QueueImage (loadmodel, texturename, tx->width, tx->height,
 							SRC_INDEXED, (byte *)(tx+1), loadmodel->name, offset, TEXPREF_MIPMAP | TEXPREF_NOBRIGHT | extraflags);
 						q_snprintf (texturename, sizeof(texturename), "%s:%s_glow", loadmodel->name, tx->name);
-						tx->fullbright = TexMgr_LoadImage (loadmodel, texturename, tx->width, tx->height,
+						tx->fullbright = TexMgr_QueueImage (loadmodel, texturename, tx->width, tx->height,
 							SRC_INDEXED, (byte *)(tx+1), loadmodel->name, offset, TEXPREF_MIPMAP | TEXPREF_FULLBRIGHT | extraflags);
 					}
 					else
 					{
-						tx->gltexture = TexMgr_LoadImage (loadmodel, texturename, tx->width, tx->height,
+						tx->gltexture = TexMgr_QueueImage (loadmodel, texturename, tx->width, tx->height,
 							SRC_INDEXED, (byte *)(tx+1), loadmodel->name, offset, TEXPREF_MIPMAP | extraflags);
 					}
 				}
-				Hunk_FreeToLowMark (mark);
 			}
 		}
 		//johnfitz
 	}
 
+	TexMgr_EndBatch ();
+
 	//johnfitz -- last 2 slots in array should be filled with dummy textures
 	loadmodel->textures[loadmodel->numtextures-2] = r_notexture_mip; //for lightmapped surfs
 	loadmodel->textures[loadmodel->numtextures-1] = r_notexture_mip2; //for SURF_DRAWTILED surfs
@@ -1208,8 +1193,7 @@ void Mod_LoadFaces (lump_t *l, qboolean bsp2)
 				out->flags |= SURF_DRAWTELE;
 			else out->flags |= SURF_DRAWWATER;
 
-			Mod_PolyForUnlitSurface (out);
-			GL_SubdivideSurface (out);
+			Mod_PolyForUnlitSurface (out); //no more subdivision, world.frag warps per fragment
 		}
 		else if (out->texinfo->texture->name[0] == '{') // ericw -- fence textures
 		{
@@ -89,8 +89,6 @@ typedef struct texture_s
 	unsigned			width, height;
 	struct gltexture_s	*gltexture; //johnfitz -- pointer to gltexture
 	struct gltexture_s	*fullbright; //johnfitz -- fullbright mask texture
-	struct gltexture_s	*warpimage; //johnfitz -- for water animation
-	qboolean			update_warp; //johnfitz -- update warp this frame
 	struct msurface_s	*texturechains[2];	// for texture chains
 	int					anim_total;				// total tenths in sequence ( 0 = no)
 	int					anim_min, anim_max;		// time for this frame min <=time< max
@@ -295,10 +293,11 @@ typedef struct aliasmesh_s
 	unsigned short vertindex;
 } aliasmesh_t;
 
+// one vertex of one pose, read as a uint by alias.vert
 typedef struct meshxyz_s
 {
-	byte xyz[4];
-	signed char normal[4];
+	byte xyz[3];
+	byte normalindex; // into r_avertexnormals
 } meshxyz_t;
 
 typedef struct meshst_s
@@ -497,6 +496,7 @@ typedef struct qmodel_s
 	int				vboindexofs;    // offset in vbo of the hdr->numindexes unsigned shorts
 	int				vboxyzofs;      // offset in vbo of hdr->numposes*hdr->numverts_vbo meshxyz_t
 	int				vbostofs;       // offset in vbo of hdr->numverts_vbo meshst_t
+	VkDescriptorSet	pose_descriptor_set; // storage buffer view of the meshxyz_t poses
 
 //
 // additional model data
@@ -0,0 +1,264 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+Copyright (C) 2010-2014 QuakeSpasm developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// gl_profile.c -- gpu timestamp queries
+
+#include "quakedef.h"
+
+/*
+Every command buffer owns a range of timestamp queries.  The range is reset
+when recording starts and read back the next time the same command buffer is
+recorded, after its fence has been waited on, so results are one frame late
+and never stall.  A scope may be opened several times per frame, the times
+are summed.
+*/
+
+#define MAX_SCOPE_INSTANCES		32		// begin/end pairs per command buffer
+#define QUERIES_PER_CONTEXT		(MAX_SCOPE_INSTANCES * 2)
+
+cvar_t r_gpuprofile = {"r_gpuprofile", "0", CVAR_NONE};	// 1 = overlay, 2 = overlay and console log
+extern cvar_t vid_dynres;
+
+const char *gpu_scope_names[NUM_GPU_SCOPES] =
+{
+	"hiddenmsh",
+	"sky",
+	"world",
+	"entities",
+	"water",
+	"particles",
+	"viewmodel",
+	"2d",
+	"postproc",
+	"swapchain",
+};
+
+float	gpu_scope_ms[NUM_VR_EYES][NUM_GPU_SCOPES];
+float	gpu_total_ms[NUM_VR_EYES];
+
+typedef struct
+{
+	int			eye;
+	int			num_instances;
+	gpuscope_t	scopes[MAX_SCOPE_INSTANCES];
+} gpucontext_t;
+
+static VkQueryPool		query_pool = VK_NULL_HANDLE;
+static gpucontext_t		gpu_contexts[NUM_GPU_CONTEXTS];
+static int				current_context = -1;
+static VkCommandBuffer	current_command_buffer;
+static int				open_instance[NUM_GPU_SCOPES];
+static uint64_t			timestamp_mask;
+
+static double			log_time;
+static int				log_frames[NUM_VR_EYES];
+static float			log_scope_ms[NUM_VR_EYES][NUM_GPU_SCOPES];
+static float			log_total_ms[NUM_VR_EYES];
+
+/*
+=================
+GL_InitProfiler -- timestamp_valid_bits comes from the graphics queue family
+=================
+*/
+void GL_InitProfiler (uint32_t timestamp_valid_bits)
+{
+	VkQueryPoolCreateInfo query_pool_create_info;
+	VkResult err;
+
+	Cvar_RegisterVariable (&r_gpuprofile);
+
+	if (timestamp_valid_bits == 0 || vulkan_globals.device_properties.limits.timestampPeriod <= 0.0f)
+	{
+		Con_Printf ("GPU timestamps not supported, r_gpuprofile disabled\n");
+		return;
+	}
+
+	timestamp_mask = (timestamp_valid_bits >= 64) ? ~(uint64_t)0 : (((uint64_t)1 << timestamp_valid_bits) - 1);
+
+	memset (&query_pool_create_info, 0, sizeof(query_pool_create_info));
+	query_pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	query_pool_create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	query_pool_create_info.queryCount = NUM_GPU_CONTEXTS * QUERIES_PER_CONTEXT;
+
+	err = vkCreateQueryPool (vulkan_globals.device, &query_pool_create_info, NULL, &query_pool);
+	if (err != VK_SUCCESS)
+	{
+		Con_Printf ("vkCreateQueryPool failed, r_gpuprofile disabled\n");
+		query_pool = VK_NULL_HANDLE;
+		return;
+	}
+
+	GL_SetObjectName ((uint64_t)query_pool, VK_DEBUG_REPORT_OBJECT_TYPE_QUERY_POOL_EXT, "gpu profiler");
+}
+
+/*
+=================
+GL_ReadContext -- results of the last submission of a context, its fence has been waited on
+=================
+*/
+static void GL_ReadContext (int context)
+{
+	gpucontext_t *ctx = &gpu_contexts[context];
+	uint64_t results[QUERIES_PER_CONTEXT][2];	// value, availability
+	uint64_t first = 0, last = 0;
+	qboolean any = false;
+	qboolean swapchain = (context >= GPU_CONTEXT_SWAPCHAIN);
+	float ms_per_tick;
+	int i;
+
+	if (ctx->num_instances == 0)
+		return;
+
+	// VK_NOT_READY just means some scope wasn't closed, the availability words say which
+	vkGetQueryPoolResults (vulkan_globals.device, query_pool, context * QUERIES_PER_CONTEXT, ctx->num_instances * 2,
+		sizeof(results), results, 2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+	ms_per_tick = vulkan_globals.device_properties.limits.timestampPeriod / 1000000.0f;
+
+	// the swap chain blit is recorded into its own command buffer, it only owns its own scope
+	for (i = 0; i < NUM_GPU_SCOPES; ++i)
+		if ((i == GPU_SCOPE_SWAPCHAIN) == swapchain)
+			gpu_scope_ms[ctx->eye][i] = 0.0f;
+
+	for (i = 0; i < ctx->num_instances; ++i)
+	{
+		uint64_t begin = results[i * 2][0] & timestamp_mask;
+		uint64_t end = results[i * 2 + 1][0] & timestamp_mask;
+
+		if (!results[i * 2][1] || !results[i * 2 + 1][1])
+			continue;
+
+		gpu_scope_ms[ctx->eye][ctx->scopes[i]] += ((end - begin) & timestamp_mask) * ms_per_tick;
+		if (!any || begin < first)
+			first = begin;
+		if (!any || end > last)
+			last = end;
+		any = true;
+	}
+
+	if (any && !swapchain)
+		gpu_total_ms[ctx->eye] = ((last - first) & timestamp_mask) * ms_per_tick;
+
+	ctx->num_instances = 0;
+}
+
+/*
+=================
+GL_LogProfiler -- once a second, averaged over the frames since the last print
+=================
+*/
+static void GL_LogProfiler (int eye)
+{
+	int i, j;
+
+	for (i = 0; i < NUM_GPU_SCOPES; ++i)
+		log_scope_ms[eye][i] += gpu_scope_ms[eye][i];
+	log_total_ms[eye] += gpu_total_ms[eye];
+	log_frames[eye]++;
+
+	if (eye != NUM_VR_EYES - 1 || realtime - log_time < 1.0)
+		return;
+
+	log_time = realtime;
+
+	Con_Printf ("gpu ms:");
+	for (j = 0; j < NUM_VR_EYES; ++j)
+	{
+		if (!log_frames[j])
+			continue;
+		Con_Printf (" %s %.2f (", j == VR_EYE_LEFT ? "left" : "right", log_total_ms[j] / log_frames[j]);
+		for (i = 0; i < NUM_GPU_SCOPES; ++i)
+			Con_Printf ("%s%s %.2f", i ? " " : "", gpu_scope_names[i], log_scope_ms[j][i] / log_frames[j]);
+		Con_Printf (")");
+	}
+	Con_Printf ("\n");
+
+	memset (log_scope_ms, 0, sizeof(log_scope_ms));
+	memset (log_total_ms, 0, sizeof(log_total_ms));
+	memset (log_frames, 0, sizeof(log_frames));
+}
+
+/*
+=================
+GL_ProfilerBeginFrame -- call right after vkBeginCommandBuffer, outside any render pass
+=================
+*/
+void GL_ProfilerBeginFrame (VkCommandBuffer command_buffer, int context, int eye)
+{
+	int i;
+
+	current_context = -1;
+	if (query_pool == VK_NULL_HANDLE)
+		return;
+
+	GL_ReadContext (context);
+	if (context < GPU_CONTEXT_SWAPCHAIN && r_gpuprofile.value >= 2)
+		GL_LogProfiler (eye);
+
+	// dynamic resolution needs the timings even without the overlay
+	if (!r_gpuprofile.value && !vid_dynres.value)
+		return;
+
+	vkCmdResetQueryPool (command_buffer, query_pool, context * QUERIES_PER_CONTEXT, QUERIES_PER_CONTEXT);
+
+	gpu_contexts[context].eye = eye;
+	gpu_contexts[context].num_instances = 0;
+	current_context = context;
+	current_command_buffer = command_buffer;
+	for (i = 0; i < NUM_GPU_SCOPES; ++i)
+		open_instance[i] = -1;
+}
+
+/*
+=================
+GL_BeginGPUScope
+=================
+*/
+void GL_BeginGPUScope (gpuscope_t scope)
+{
+	gpucontext_t *ctx;
+
+	if (current_context < 0)
+		return;
+
+	ctx = &gpu_contexts[current_context];
+	if (ctx->num_instances == MAX_SCOPE_INSTANCES || open_instance[scope] >= 0)
+		return;
+
+	open_instance[scope] = ctx->num_instances;
+	ctx->scopes[ctx->num_instances] = scope;
+	vkCmdWriteTimestamp (current_command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, query_pool, current_context * QUERIES_PER_CONTEXT + ctx->num_instances * 2);
+	ctx->num_instances++;
+}
+
+/*
+=================
+GL_EndGPUScope
+=================
+*/
+void GL_EndGPUScope (gpuscope_t scope)
+{
+	if (current_context < 0 || open_instance[scope] < 0)
+		return;
+
+	vkCmdWriteTimestamp (current_command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, query_pool, current_context * QUERIES_PER_CONTEXT + open_instance[scope] * 2 + 1);
+	open_instance[scope] = -1;
+}
@@ -0,0 +1,217 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+Copyright (C) 2010-2014 QuakeSpasm developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// gl_rgraph.c -- frame graph: passes declare how they use the frame images
+
+#include "quakedef.h"
+
+/*
+An eye frame is the main pass, optionally the screen warp or foveation fill
+compute, and the ui pass.  Each of them declares the images it uses and how,
+and the barrier in front of it is derived from what last touched them: layout
+transitions only when the layout changes, execution only dependencies when a
+write follows reads, nothing at all between reads.  The state carries over from
+one command buffer to the next, they are submitted in the order they are
+recorded, so the next eye's main pass also waits for the last one's reads.
+
+Render passes don't transition the tracked images on the way in, their
+attachments start in the layout the graph already put them in.  The eye
+buffers aren't tracked, the compositor and the mirror read them outside of it,
+the external dependencies of the ui render pass order those reads.
+*/
+
+#define RG_WRITE_ACCESS		(VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT)
+
+typedef struct
+{
+	VkImageLayout			layout;			// during the pass, the render pass initialLayout for attachments
+	VkImageLayout			final_layout;	// after it, a render pass may leave the image in another one
+	VkPipelineStageFlags	stages;
+	VkAccessFlags			access;
+	qboolean				discard;		// the old contents aren't needed
+} rgusedef_t;
+
+static const rgusedef_t rg_use_defs[NUM_RG_USES] =
+{
+	// RG_USE_COLOR_ATTACHMENT_DISCARD
+	{ VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+		VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, true },
+	// RG_USE_DEPTH_ATTACHMENT_DISCARD
+	{ VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, true },
+	// RG_USE_UI_ATTACHMENT
+	{ VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_INPUT_ATTACHMENT_READ_BIT, false },
+	// RG_USE_COMPUTE_READ
+	{ VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_ACCESS_SHADER_READ_BIT, false },
+	// RG_USE_COMPUTE_WRITE_DISCARD
+	{ VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_ACCESS_SHADER_WRITE_BIT, true },
+};
+
+typedef struct
+{
+	VkImage					image;
+	VkImageAspectFlags		aspect;
+	VkImageLayout			layout;
+	VkPipelineStageFlags	stages;			// the last write, or the reads since then
+	VkAccessFlags			writes;			// not made available yet
+} rgimage_t;
+
+static rgimage_t	rg_images[NUM_RG_RESOURCES];
+
+/*
+=================
+R_GraphSetImage -- after the image has been (re)created, its contents are undefined
+=================
+*/
+void R_GraphSetImage (rgresource_t resource, VkImage image, VkImageAspectFlags aspect)
+{
+	rgimage_t *img = &rg_images[resource];
+
+	img->image = image;
+	img->aspect = aspect;
+	img->layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	img->stages = 0;
+	img->writes = 0;
+}
+
+/*
+=================
+R_GraphPass
+
+Records one barrier for all the uses of a pass, or none if nothing has to wait
+=================
+*/
+void R_GraphPass (VkCommandBuffer command_buffer, int num_uses, const rgpassuse_t *uses)
+{
+	VkImageMemoryBarrier barriers[NUM_RG_RESOURCES];
+	VkPipelineStageFlags src_stages = 0;
+	VkPipelineStageFlags dst_stages = 0;
+	int num_barriers = 0;
+	int i;
+
+	for (i = 0; i < num_uses; ++i)
+	{
+		rgimage_t *img = &rg_images[uses[i].resource];
+		const rgusedef_t *def = &rg_use_defs[uses[i].use];
+		VkAccessFlags writes = def->access & RG_WRITE_ACCESS;
+
+		if (img->image == VK_NULL_HANDLE)
+			continue;
+
+		if (img->layout == def->layout && !img->writes)
+		{
+			// reads don't have to wait for reads, a write only for them to finish
+			if (!writes)
+			{
+				img->stages |= def->stages;
+				continue;
+			}
+			if (img->stages)
+			{
+				src_stages |= img->stages;
+				dst_stages |= def->stages;
+			}
+		}
+		else
+		{
+			VkImageMemoryBarrier *barrier = &barriers[num_barriers++];
+			memset(barrier, 0, sizeof(*barrier));
+			barrier->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier->srcAccessMask = img->writes;
+			barrier->dstAccessMask = def->access;
+			barrier->oldLayout = def->discard ? VK_IMAGE_LAYOUT_UNDEFINED : img->layout;
+			barrier->newLayout = def->layout;
+			barrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier->image = img->image;
+			barrier->subresourceRange.aspectMask = img->aspect;
+			barrier->subresourceRange.levelCount = 1;
+			barrier->subresourceRange.layerCount = 1;
+
+			src_stages |= img->stages ? img->stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			dst_stages |= def->stages;
+		}
+
+		img->layout = def->final_layout;
+		img->stages = def->stages;
+		img->writes = writes;
+	}
+
+	if (src_stages)
+		vkCmdPipelineBarrier(command_buffer, src_stages, dst_stages, 0, 0, NULL, 0, NULL, num_barriers, barriers);
+}
+
+/*
+=================
+R_BeginMainRenderPass -- index 1 renders into the second color buffer, for the screen compute to read
+=================
+*/
+void R_BeginMainRenderPass (int index)
+{
+	rgpassuse_t uses[3];
+
+	uses[0].resource = RG_COLOR_BUFFER_0 + index;
+	uses[0].use = RG_USE_COLOR_ATTACHMENT_DISCARD;
+	uses[1].resource = RG_DEPTH_BUFFER;
+	uses[1].use = RG_USE_DEPTH_ATTACHMENT_DISCARD;
+	uses[2].resource = RG_MSAA_COLOR_BUFFER;
+	uses[2].use = RG_USE_COLOR_ATTACHMENT_DISCARD;
+	R_GraphPass(vulkan_globals.command_buffer, 3, uses);
+
+	render_pass_index = 0;
+	vkCmdBeginRenderPass(vulkan_globals.command_buffer, &vulkan_globals.main_render_pass_begin_infos[index], VK_SUBPASS_CONTENTS_INLINE);
+}
+
+/*
+=================
+R_BeginScreenCompute -- the screen warp or foveation fill, from the second color buffer into the first
+=================
+*/
+void R_BeginScreenCompute (void)
+{
+	rgpassuse_t uses[2];
+
+	uses[0].resource = RG_COLOR_BUFFER_1;
+	uses[0].use = RG_USE_COMPUTE_READ;
+	uses[1].resource = RG_COLOR_BUFFER_0;
+	uses[1].use = RG_USE_COMPUTE_WRITE_DISCARD;
+	R_GraphPass(vulkan_globals.command_buffer, 2, uses);
+}
+
+/*
+=================
+R_BeginUIRenderPass
+=================
+*/
+void R_BeginUIRenderPass (void)
+{
+	rgpassuse_t use;
+
+	use.resource = RG_COLOR_BUFFER_0;
+	use.use = RG_USE_UI_ATTACHMENT;
+	R_GraphPass(vulkan_globals.command_buffer, 1, &use);
+
+	vkCmdBeginRenderPass(vulkan_globals.command_buffer, &vulkan_globals.ui_render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+	render_pass_index = 1;
+}
@@ -72,6 +72,9 @@ cvar_t	r_shadows = {"r_shadows","0",CVAR_ARCHIVE};
 cvar_t	r_wateralpha = {"r_wateralpha","1",CVAR_ARCHIVE};
 cvar_t	r_dynamic = {"r_dynamic","1",CVAR_ARCHIVE};
 cvar_t	r_novis = {"r_novis","0",CVAR_ARCHIVE};
+cvar_t	r_latepose = {"r_latepose","1",CVAR_ARCHIVE};
+cvar_t	r_lateposemargin = {"r_lateposemargin","8",CVAR_ARCHIVE}; // degrees added to the culling fov
+cvar_t	r_hiddenareacull = {"r_hiddenareacull","1",CVAR_NONE};
 
 cvar_t	gl_finish = {"gl_finish","0",CVAR_NONE};
 cvar_t	gl_clear = {"gl_clear","0",CVAR_NONE};
@@ -278,6 +281,45 @@ void R_SetFrustum (float fovx, float fovy)
 	}
 }
 
+/*
+===============
+R_SetLensFrustum -- only what the hidden area mesh leaves visible, margin in degrees per side
+
+The eye projections are asymmetric, the edges come from the projection of the
+current eye.  At view space z = -1 clip space x = P[0] * x - P[8], the same
+for y with P[5] negative because clip space y points down.
+===============
+*/
+static void R_SetLensFrustum (float margin)
+{
+	const float *projection = vr.eye[vr.current_eye].projection;
+	const float *bounds = vr.eye[vr.current_eye].visible_bounds;
+	float left, right, bottom, top;
+	int i;
+
+	left = atan((bounds[0] + projection[2*4 + 0]) / projection[0]) / M_PI_DIV_180 - margin;
+	right = atan((bounds[2] + projection[2*4 + 0]) / projection[0]) / M_PI_DIV_180 + margin;
+	top = atan((bounds[1] + projection[2*4 + 1]) / projection[1*4 + 1]) / M_PI_DIV_180 + margin;
+	bottom = atan((bounds[3] + projection[2*4 + 1]) / projection[1*4 + 1]) / M_PI_DIV_180 - margin;
+
+	left = q_max(left, -89.0f);
+	right = q_min(right, 89.0f);
+	bottom = q_max(bottom, -89.0f);
+	top = q_min(top, 89.0f);
+
+	TurnVector(frustum[0].normal, vpn, vright, 90 + left); //left plane
+	TurnVector(frustum[1].normal, vpn, vright, right - 90); //right plane
+	TurnVector(frustum[2].normal, vpn, vup, 90 + bottom); //bottom plane
+	TurnVector(frustum[3].normal, vpn, vup, top - 90); //top plane
+
+	for (i=0 ; i<4 ; i++)
+	{
+		frustum[i].type = PLANE_ANYZ;
+		frustum[i].dist = DotProduct (r_origin, frustum[i].normal);
+		frustum[i].signbits = SignbitsForPlane (&frustum[i]);
+	}
+}
+
 /*
 =============
 GL_FrustumMatrix
@@ -308,6 +350,31 @@ static void GL_FrustumMatrix(float matrix[16], float fovx, float fovy)
 	matrix[3*4 + 2] = -(n * f) / (f - n);
 }
 
+static qboolean	latch_pending;		// the command buffer being recorded has a view that can be late latched
+static vec3_t	latch_angles;
+static float	latch_projection[16];
+static HmdMatrix34_t	latch_hmd_pose;	// what the compositor is told the eye was rendered with
+
+/*
+=============
+R_ViewRotationMatrix
+=============
+*/
+static void R_ViewRotationMatrix(float matrix[16], const vec3_t angles)
+{
+	float rotation_matrix[16];
+
+	RotationMatrix(matrix, -M_PI / 2.0f, 1.0f, 0.0f, 0.0f);
+	RotationMatrix(rotation_matrix,  M_PI / 2.0f, 0.0f, 0.0f, 1.0f);
+	MatrixMultiply(matrix, rotation_matrix);
+	RotationMatrix(rotation_matrix, DEG2RAD(-angles[2]), 1.0f, 0.0f, 0.0f);
+	MatrixMultiply(matrix, rotation_matrix);
+	RotationMatrix(rotation_matrix, DEG2RAD(-angles[0]), 0.0f, 1.0f, 0.0f);
+	MatrixMultiply(matrix, rotation_matrix);
+	RotationMatrix(rotation_matrix, DEG2RAD(-angles[1]), 0.0f, 0.0f, 1.0f);
+	MatrixMultiply(matrix, rotation_matrix);
+}
+
 /*
 =============
 R_SetupMatrix
@@ -333,16 +400,7 @@ void R_SetupMatrix (void)
 		VR_GetOrientation(vr.pose[k_unTrackedDeviceIndex_Hmd], &r_refdef.viewangles[PITCH], &r_refdef.viewangles[YAW], &r_refdef.viewangles[ROLL]);
 
 	// View matrix
-	float rotation_matrix[16];
-	RotationMatrix(vulkan_globals.view_matrix, -M_PI / 2.0f, 1.0f, 0.0f, 0.0f);
-	RotationMatrix(rotation_matrix,  M_PI / 2.0f, 0.0f, 0.0f, 1.0f);
-	MatrixMultiply(vulkan_globals.view_matrix, rotation_matrix);
-	RotationMatrix(rotation_matrix, DEG2RAD(-r_refdef.viewangles[2]), 1.0f, 0.0f, 0.0f);
-	MatrixMultiply(vulkan_globals.view_matrix, rotation_matrix);
-	RotationMatrix(rotation_matrix, DEG2RAD(-r_refdef.viewangles[0]), 0.0f, 1.0f, 0.0f);
-	MatrixMultiply(vulkan_globals.view_matrix, rotation_matrix);
-	RotationMatrix(rotation_matrix, DEG2RAD(-r_refdef.viewangles[1]), 0.0f, 0.0f, 1.0f);
-	MatrixMultiply(vulkan_globals.view_matrix, rotation_matrix);
+	R_ViewRotationMatrix(vulkan_globals.view_matrix, r_refdef.viewangles);
 	
 	float translation_matrix[16];
 	TranslationMatrix(translation_matrix, -r_refdef.vieworg[0], -r_refdef.vieworg[1], -r_refdef.vieworg[2]);
@@ -353,6 +411,69 @@ void R_SetupMatrix (void)
 	MatrixMultiply(vulkan_globals.view_projection_matrix, vulkan_globals.view_matrix);
 
 	vkCmdPushConstants(vulkan_globals.command_buffer, vulkan_globals.basic_pipeline_layout, VK_SHADER_STAGE_ALL_GRAPHICS, 0, 16 * sizeof(float), vulkan_globals.view_projection_matrix);
+
+	// Remember what the frame was recorded with, R_LatchPose corrects it
+	latch_pending = vr.pose[k_unTrackedDeviceIndex_Hmd].bPoseIsValid;
+	latch_hmd_pose = vr.pose[k_unTrackedDeviceIndex_Hmd].mDeviceToAbsoluteTracking;
+	VectorCopy(r_refdef.viewangles, latch_angles);
+	memcpy(latch_projection, vulkan_globals.projection_matrix, 16 * sizeof(float));
+}
+
+/*
+=============
+R_LatchPose
+
+Called right before the command buffer of the current eye is submitted.  Only
+the head rotation is latched, the view origin comes from the game and doesn't
+change.  With V = R * T the correction P * R' * R^-1 * P^-1 turns what the
+push constants produce into P * R' * T
+=============
+*/
+void R_LatchPose (void)
+{
+	TrackedDevicePose_t pose;
+	vec3_t angles;
+	float correction[16], rotation_matrix[16], old_rotation_matrix[16], inverse_projection[16];
+	int i, j;
+
+	if (!latch_pending)
+	{
+		VR_SetSubmitPose(NULL);
+		return;
+	}
+	latch_pending = false;
+
+	VR_SetSubmitPose(&latch_hmd_pose);
+
+	if (!r_latepose.value || !VR_GetLatePose(&pose))
+		return;
+
+	memcpy(inverse_projection, latch_projection, 16 * sizeof(float));
+	if (!InvertMatrix(inverse_projection))
+		return;
+
+	VR_GetOrientation(pose, &angles[PITCH], &angles[YAW], &angles[ROLL]);
+
+	// The inverse of a rotation is its transpose
+	R_ViewRotationMatrix(rotation_matrix, latch_angles);
+	for (i = 0; i < 4; ++i)
+		for (j = 0; j < 4; ++j)
+			old_rotation_matrix[i * 4 + j] = rotation_matrix[j * 4 + i];
+
+	R_ViewRotationMatrix(rotation_matrix, angles);
+
+	memcpy(correction, latch_projection, 16 * sizeof(float));
+	MatrixMultiply(correction, rotation_matrix);
+	MatrixMultiply(correction, old_rotation_matrix);
+	MatrixMultiply(correction, inverse_projection);
+
+	R_StoreLatchMatrix(correction);
+
+	// the rotation is the late one now, the position is still the frame's
+	for (i = 0; i < 3; ++i)
+		for (j = 0; j < 3; ++j)
+			latch_hmd_pose.m[i][j] = pose.mDeviceToAbsoluteTracking.m[i][j];
+	VR_SetSubmitPose(&latch_hmd_pose);
 }
 
 /*
@@ -362,10 +483,17 @@ R_SetupScene
 */
 void R_SetupScene (void)
 {
-	render_pass_index = 0;
-	vkCmdBeginRenderPass(vulkan_globals.command_buffer, &vulkan_globals.main_render_pass_begin_infos[render_warp ? 1 : 0], VK_SUBPASS_CONTENTS_INLINE);
+	// the foveation fill shares the warp's compute pass, so underwater the periphery stays at full rate
+	if (render_warp)
+		foveation_mask = false;
 
+	R_BeginMainRenderPass((render_warp || foveation_mask) ? 1 : 0);
+
+	GL_BeginGPUScope(GPU_SCOPE_HIDDEN_AREA_MESH);
 	VR_DrawHiddenAreaMesh();
+	if (foveation_mask)
+		R_DrawFoveationMask();
+	GL_EndGPUScope(GPU_SCOPE_HIDDEN_AREA_MESH);
 
 	R_AnimateLight ();
 	r_framecount++;
@@ -416,13 +544,26 @@ void R_SetupView (void)
 	}
 	//johnfitz
 
-	R_SetFrustum (r_fovx, r_fovy); //johnfitz -- use r_fov* vars
+	// the late latched view may turn a little past what was recorded, don't cull what it could show
+	if (r_latepose.value)
+	{
+		r_fovx = q_min(r_fovx + r_lateposemargin.value, 170.0f);
+		r_fovy = q_min(r_fovy + r_lateposemargin.value, 170.0f);
+	}
+
+	// surfaces and entities completely behind the hidden area mesh are never drawn
+	if (r_hiddenareacull.value)
+		R_SetLensFrustum (r_latepose.value ? r_lateposemargin.value * 0.5f : 0.0f);
+	else
+		R_SetFrustum (r_fovx, r_fovy); //johnfitz -- use r_fov* vars
 
 	R_MarkSurfaces (); //johnfitz -- create texture chains from PVS
 
 	R_CullSurfaces (); //johnfitz -- do after R_SetFrustum and R_MarkSurfaces
 
-	R_UpdateWarpTextures (); //johnfitz -- do this before R_Clear
+	GL_BeginGPUScope (GPU_SCOPE_PARTICLES);
+	R_UpdateGPUParticles (); // compute and copies can't run inside the render pass either
+	GL_EndGPUScope (GPU_SCOPE_PARTICLES);
 
 	//johnfitz -- cheat-protect some draw modes
 	r_drawflat_cheatsafe = r_fullbright_cheatsafe = r_lightmap_cheatsafe = false;
@@ -476,6 +617,9 @@ void R_DrawEntitiesOnList (qboolean alphapass) //johnfitz -- added parameter
 		{
 			case mod_alias:
 				R_DrawAliasModel (currententity);
+				// translucent entities blend in list order, no instancing
+				if (alphapass)
+					R_FlushAliasInstances ();
 				break;
 			case mod_brush:
 				R_DrawBrushModel (currententity);
@@ -485,6 +629,8 @@ void R_DrawEntitiesOnList (qboolean alphapass) //johnfitz -- added parameter
 				break;
 		}
 	}
+
+	R_FlushAliasInstances ();
 }
 
 /*
@@ -521,6 +667,7 @@ void R_DrawViewModel (void)
 // 	vkCmdSetViewport(vulkan_globals.command_buffer, 0, 1, &viewport);
 
 	R_DrawAliasModel (currententity);
+	R_FlushAliasInstances ();
 
 // 	viewport.minDepth = 0.0f;
 // 	viewport.maxDepth = 1.0f;
@@ -538,23 +685,37 @@ void R_RenderScene (void)
 
 	Fog_EnableGFog (); //johnfitz
 
+	GL_BeginGPUScope (GPU_SCOPE_SKY);
 	Sky_DrawSky (); //johnfitz
+	GL_EndGPUScope (GPU_SCOPE_SKY);
 
+	GL_BeginGPUScope (GPU_SCOPE_WORLD);
 	R_DrawWorld ();
+	GL_EndGPUScope (GPU_SCOPE_WORLD);
 
 	S_ExtraUpdate (); // don't let sound get messed up if going slow
 
+	GL_BeginGPUScope (GPU_SCOPE_ENTITIES);
 	R_DrawEntitiesOnList (false); //johnfitz -- false means this is the pass for nonalpha entities
+	GL_EndGPUScope (GPU_SCOPE_ENTITIES);
 
+	GL_BeginGPUScope (GPU_SCOPE_WATER);
 	R_DrawWorld_Water (); //johnfitz -- drawn here since they might have transparency
+	GL_EndGPUScope (GPU_SCOPE_WATER);
 
+	GL_BeginGPUScope (GPU_SCOPE_ENTITIES);
 	R_DrawEntitiesOnList (true); //johnfitz -- true means this is the pass for alpha entities
+	GL_EndGPUScope (GPU_SCOPE_ENTITIES);
 
+	GL_BeginGPUScope (GPU_SCOPE_PARTICLES);
 	R_DrawParticles ();
+	GL_EndGPUScope (GPU_SCOPE_PARTICLES);
 
 	Fog_DisableGFog (); //johnfitz
 
+	GL_BeginGPUScope (GPU_SCOPE_VIEW_MODEL);
 	R_DrawViewModel (); //johnfitz -- moved here from R_RenderView
+	GL_EndGPUScope (GPU_SCOPE_VIEW_MODEL);
 }
 
 /*
@@ -27,13 +27,16 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "quakedef.h"
 #include "float.h"
 
+extern cvar_t r_latepose;
+extern cvar_t r_lateposemargin;
+extern cvar_t r_hiddenareacull;
+
 //johnfitz -- new cvars
 extern cvar_t r_clearcolor;
 extern cvar_t r_drawflat;
 extern cvar_t r_flatlightstyles;
 extern cvar_t gl_fullbrights;
 extern cvar_t gl_farclip;
-extern cvar_t r_waterquality;
 extern cvar_t r_waterwarp;
 extern cvar_t r_oldskyleaf;
 extern cvar_t r_drawworld;
@@ -82,29 +85,53 @@ static int				current_staging_buffer = 0;
 /*
 ================
 Dynamic vertex/index & uniform buffer
+
+Every frame in flight owns a chain of blocks per buffer type.  Allocations are
+linear; when a block is full the next one in the chain is used, and a new block
+is added when the chain runs out.  A chain is only reset once the fence of its
+frame has been waited on, so blocks never need to be tracked individually.
+Blocks beyond the first that have been idle for a while are freed again.
 ================
 */
 #define DYNAMIC_VERTEX_BUFFER_SIZE_KB	2048
 #define DYNAMIC_INDEX_BUFFER_SIZE_KB	2048
-#define DYNAMIC_UNIFORM_BUFFER_SIZE_KB	512
-#define NUM_DYNAMIC_BUFFERS				2
+#define DYNAMIC_UNIFORM_BUFFER_SIZE_KB	1024
+#define NUM_DYNAMIC_BUFFERS				NUM_COMMAND_BUFFERS	// one chain per frame in flight
+#define MAX_DYNAMIC_UNIFORM_BLOCKS		8		// per frame, each one needs two descriptor sets
+#define DYNAMIC_BLOCK_IDLE_FRAMES		600		// swaps before an unused extra block is freed
 #define MAX_UNIFORM_ALLOC				2048
+#define MAX_STORAGE_ALLOC				(64 * 1024)
 
-typedef struct
+typedef struct dynblock_s
 {
 	VkBuffer			buffer;
+	VkDeviceMemory		memory;
+	uint32_t			size;
 	uint32_t			current_offset;
 	unsigned char *		data;
+	VkDescriptorSet		ubo_descriptor_set;		// uniform blocks only
+	VkDescriptorSet		storage_descriptor_set;
+	int					last_used;				// dyn_frame_count
+	struct dynblock_s *	next;
+} dynblock_t;
+
+typedef struct
+{
+	const char *		name;
+	VkBufferUsageFlags	usage;
+	uint32_t			block_size;		// size of the first block, and the smallest extra one
+	uint32_t			frame_usage;	// bytes handed out since the last swap
+	uint32_t			peak_usage;		// high water mark of frame_usage
+	int					num_blocks;
+	dynblock_t *		chains[NUM_DYNAMIC_BUFFERS];	// the first block of a chain is never freed
+	dynblock_t *		current;
 } dynbuffer_t;
 
-static VkDeviceMemory	dyn_vertex_buffer_memory;
-static VkDeviceMemory	dyn_index_buffer_memory;
-static VkDeviceMemory	dyn_uniform_buffer_memory;
-static dynbuffer_t		dyn_vertex_buffers[NUM_DYNAMIC_BUFFERS];
-static dynbuffer_t		dyn_index_buffers[NUM_DYNAMIC_BUFFERS];
-static dynbuffer_t		dyn_uniform_buffers[NUM_DYNAMIC_BUFFERS];
+static dynbuffer_t		dyn_vertex_buffer = {"Dynamic Vertex Buffer", VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, DYNAMIC_VERTEX_BUFFER_SIZE_KB * 1024}; // particle spawns get copied out of it
+static dynbuffer_t		dyn_index_buffer = {"Dynamic Index Buffer", VK_BUFFER_USAGE_INDEX_BUFFER_BIT, DYNAMIC_INDEX_BUFFER_SIZE_KB * 1024};
+static dynbuffer_t		dyn_uniform_buffer = {"Dynamic Uniform Buffer", VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, DYNAMIC_UNIFORM_BUFFER_SIZE_KB * 1024};
 static int				current_dyn_buffer_index = 0;
-static VkDescriptorSet	ubo_descriptor_sets[2];
+static int				dyn_frame_count = 0;
 
 void R_VulkanMemStats_f (void);
 
@@ -381,7 +408,9 @@ static void R_SubmitStagingBuffer(int index)
 	submit_info.commandBufferCount = 1;
 	submit_info.pCommandBuffers = &staging_buffers[index].command_buffer;
 	
+	GL_LockQueue();
 	vkQueueSubmit(vulkan_globals.queue, 1, &submit_info, staging_buffers[index].fence);
+	GL_UnlockQueue();
 
 	staging_buffers[index].submitted = true;
 	current_staging_buffer = (current_staging_buffer + 1) % NUM_STAGING_BUFFERS;
@@ -463,247 +492,250 @@ byte * R_StagingAllocate(int size, int alignment, VkCommandBuffer * command_buff
 
 /*
 ===============
-R_InitDynamicVertexBuffers
+R_CreateDynamicBlock
 ===============
 */
-static void R_InitDynamicVertexBuffers()
+static dynblock_t *R_CreateDynamicBlock(dynbuffer_t *dyn, uint32_t size)
 {
-	int i;
+	VkResult err;
+	dynblock_t *block;
 
-	Con_Printf("Initializing dynamic vertex buffers\n");
+	if (dyn == &dyn_uniform_buffer && dyn->num_blocks == NUM_DYNAMIC_BUFFERS * MAX_DYNAMIC_UNIFORM_BLOCKS)
+		Sys_Error("Out of dynamic uniform buffer blocks, increase MAX_DYNAMIC_UNIFORM_BLOCKS");
 
-	VkResult err;
+	block = (dynblock_t *) calloc(1, sizeof(dynblock_t));
+	if (!block)
+		Sys_Error("R_CreateDynamicBlock: out of memory");
+	block->size = size;
+	block->last_used = dyn_frame_count;
 
 	VkBufferCreateInfo buffer_create_info;
 	memset(&buffer_create_info, 0, sizeof(buffer_create_info));
 	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-	buffer_create_info.size = DYNAMIC_VERTEX_BUFFER_SIZE_KB * 1024;
-	buffer_create_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-
-	for (i = 0; i < NUM_DYNAMIC_BUFFERS; ++i)
-	{
-		dyn_vertex_buffers[i].current_offset = 0;
+	buffer_create_info.size = size;
+	buffer_create_info.usage = dyn->usage;
 
-		err = vkCreateBuffer(vulkan_globals.device, &buffer_create_info, NULL, &dyn_vertex_buffers[i].buffer);
-		if (err != VK_SUCCESS)
-			Sys_Error("vkCreateBuffer failed");
+	err = vkCreateBuffer(vulkan_globals.device, &buffer_create_info, NULL, &block->buffer);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkCreateBuffer failed");
 
-		GL_SetObjectName((uint64_t)dyn_vertex_buffers[i].buffer, VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Dynamic Vertex Buffer");
-	}
+	GL_SetObjectName((uint64_t)block->buffer, VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, dyn->name);
 
 	VkMemoryRequirements memory_requirements;
-	vkGetBufferMemoryRequirements(vulkan_globals.device, dyn_vertex_buffers[0].buffer, &memory_requirements);
-
-	const int align_mod = memory_requirements.size % memory_requirements.alignment;
-	const int aligned_size = ((memory_requirements.size % memory_requirements.alignment) == 0) 
-		? memory_requirements.size 
-		: (memory_requirements.size + memory_requirements.alignment - align_mod);
+	vkGetBufferMemoryRequirements(vulkan_globals.device, block->buffer, &memory_requirements);
 
 	VkMemoryAllocateInfo memory_allocate_info;
 	memset(&memory_allocate_info, 0, sizeof(memory_allocate_info));
 	memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memory_allocate_info.allocationSize = NUM_DYNAMIC_BUFFERS * aligned_size;
+	memory_allocate_info.allocationSize = memory_requirements.size;
 	memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
 
 	num_vulkan_dynbuf_allocations += 1;
-	err = vkAllocateMemory(vulkan_globals.device, &memory_allocate_info, NULL, &dyn_vertex_buffer_memory);
+	err = vkAllocateMemory(vulkan_globals.device, &memory_allocate_info, NULL, &block->memory);
 	if (err != VK_SUCCESS)
 		Sys_Error("vkAllocateMemory failed");
 
-	GL_SetObjectName((uint64_t)dyn_vertex_buffer_memory, VK_DEBUG_REPORT_OBJECT_TYPE_DEVICE_MEMORY_EXT, "Dynamic Vertex Buffers");
+	GL_SetObjectName((uint64_t)block->memory, VK_DEBUG_REPORT_OBJECT_TYPE_DEVICE_MEMORY_EXT, dyn->name);
 
-	for (i = 0; i < NUM_DYNAMIC_BUFFERS; ++i)
-	{
-		err = vkBindBufferMemory(vulkan_globals.device, dyn_vertex_buffers[i].buffer, dyn_vertex_buffer_memory, i * aligned_size);
-		if (err != VK_SUCCESS)
-			Sys_Error("vkBindBufferMemory failed");
-	}
+	err = vkBindBufferMemory(vulkan_globals.device, block->buffer, block->memory, 0);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkBindBufferMemory failed");
 
 	void * data;
-	err = vkMapMemory(vulkan_globals.device, dyn_vertex_buffer_memory, 0, NUM_DYNAMIC_BUFFERS * aligned_size, 0, &data);
+	err = vkMapMemory(vulkan_globals.device, block->memory, 0, VK_WHOLE_SIZE, 0, &data);
 	if (err != VK_SUCCESS)
 		Sys_Error("vkMapMemory failed");
+	block->data = (unsigned char *)data;
 
-	for (i = 0; i < NUM_DYNAMIC_BUFFERS; ++i)
-		dyn_vertex_buffers[i].data = (unsigned char *)data + (i * aligned_size);
+	if (dyn == &dyn_uniform_buffer)
+	{
+		VkDescriptorSetAllocateInfo descriptor_set_allocate_info;
+		memset(&descriptor_set_allocate_info, 0, sizeof(descriptor_set_allocate_info));
+		descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		descriptor_set_allocate_info.descriptorPool = vulkan_globals.descriptor_pool;
+		descriptor_set_allocate_info.descriptorSetCount = 1;
+
+		descriptor_set_allocate_info.pSetLayouts = &vulkan_globals.ubo_set_layout;
+		if (vkAllocateDescriptorSets(vulkan_globals.device, &descriptor_set_allocate_info, &block->ubo_descriptor_set) != VK_SUCCESS)
+			Sys_Error("vkAllocateDescriptorSets failed");
+
+		// Same buffer viewed as a storage buffer for per instance arrays that don't fit in a UBO
+		descriptor_set_allocate_info.pSetLayouts = &vulkan_globals.storage_set_layout;
+		if (vkAllocateDescriptorSets(vulkan_globals.device, &descriptor_set_allocate_info, &block->storage_descriptor_set) != VK_SUCCESS)
+			Sys_Error("vkAllocateDescriptorSets failed");
+
+		VkDescriptorBufferInfo buffer_info;
+		memset(&buffer_info, 0, sizeof(buffer_info));
+		buffer_info.buffer = block->buffer;
+		buffer_info.offset = 0;
+		buffer_info.range = MAX_UNIFORM_ALLOC;
+
+		VkWriteDescriptorSet ubo_write;
+		memset(&ubo_write, 0, sizeof(ubo_write));
+		ubo_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		ubo_write.dstBinding = 0;
+		ubo_write.dstArrayElement = 0;
+		ubo_write.descriptorCount = 1;
+		ubo_write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		ubo_write.pBufferInfo = &buffer_info;
+		ubo_write.dstSet = block->ubo_descriptor_set;
+		vkUpdateDescriptorSets(vulkan_globals.device, 1, &ubo_write, 0, NULL);
+
+		buffer_info.range = MAX_STORAGE_ALLOC;
+		ubo_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+		ubo_write.dstSet = block->storage_descriptor_set;
+		vkUpdateDescriptorSets(vulkan_globals.device, 1, &ubo_write, 0, NULL);
+	}
+
+	dyn->num_blocks++;
+
+	return block;
 }
 
 /*
 ===============
-R_InitDynamicIndexBuffers
+R_DestroyDynamicBlock -- the gpu must be done with the block
 ===============
 */
-static void R_InitDynamicIndexBuffers()
+static void R_DestroyDynamicBlock(dynbuffer_t *dyn, dynblock_t *block)
 {
-	int i;
-
-	Con_Printf("Initializing dynamic index buffers\n");
-
-	VkResult err;
-
-	VkBufferCreateInfo buffer_create_info;
-	memset(&buffer_create_info, 0, sizeof(buffer_create_info));
-	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-	buffer_create_info.size = DYNAMIC_INDEX_BUFFER_SIZE_KB * 1024;
-	buffer_create_info.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-
-	for (i = 0; i < NUM_DYNAMIC_BUFFERS; ++i)
-	{
-		dyn_index_buffers[i].current_offset = 0;
-
-		err = vkCreateBuffer(vulkan_globals.device, &buffer_create_info, NULL, &dyn_index_buffers[i].buffer);
-		if (err != VK_SUCCESS)
-			Sys_Error("vkCreateBuffer failed");
-
-		GL_SetObjectName((uint64_t)dyn_index_buffers[i].buffer, VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Dynamic Index Buffer");
-	}
-
-	VkMemoryRequirements memory_requirements;
-	vkGetBufferMemoryRequirements(vulkan_globals.device, dyn_index_buffers[0].buffer, &memory_requirements);
-
-	const int align_mod = memory_requirements.size % memory_requirements.alignment;
-	const int aligned_size = ((memory_requirements.size % memory_requirements.alignment) == 0) 
-		? memory_requirements.size 
-		: (memory_requirements.size + memory_requirements.alignment - align_mod);
-
-	VkMemoryAllocateInfo memory_allocate_info;
-	memset(&memory_allocate_info, 0, sizeof(memory_allocate_info));
-	memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memory_allocate_info.allocationSize = NUM_DYNAMIC_BUFFERS * aligned_size;
-	memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
-
-	num_vulkan_dynbuf_allocations += 1;
-	err = vkAllocateMemory(vulkan_globals.device, &memory_allocate_info, NULL, &dyn_index_buffer_memory);
-	if (err != VK_SUCCESS)
-		Sys_Error("vkAllocateMemory failed");
-
-	GL_SetObjectName((uint64_t)dyn_index_buffer_memory, VK_DEBUG_REPORT_OBJECT_TYPE_DEVICE_MEMORY_EXT, "Dynamic Index Buffers");
-
-	for (i = 0; i < NUM_DYNAMIC_BUFFERS; ++i)
+	if (block->ubo_descriptor_set != VK_NULL_HANDLE)
 	{
-		err = vkBindBufferMemory(vulkan_globals.device, dyn_index_buffers[i].buffer, dyn_index_buffer_memory, i * aligned_size);
-		if (err != VK_SUCCESS)
-			Sys_Error("vkBindBufferMemory failed");
+		vkFreeDescriptorSets(vulkan_globals.device, vulkan_globals.descriptor_pool, 1, &block->ubo_descriptor_set);
+		vkFreeDescriptorSets(vulkan_globals.device, vulkan_globals.descriptor_pool, 1, &block->storage_descriptor_set);
 	}
 
-	void * data;
-	err = vkMapMemory(vulkan_globals.device, dyn_index_buffer_memory, 0, NUM_DYNAMIC_BUFFERS * aligned_size, 0, &data);
-	if (err != VK_SUCCESS)
-		Sys_Error("vkMapMemory failed");
+	vkDestroyBuffer(vulkan_globals.device, block->buffer, NULL);
+	vkUnmapMemory(vulkan_globals.device, block->memory);
+	vkFreeMemory(vulkan_globals.device, block->memory, NULL);
+	num_vulkan_dynbuf_allocations -= 1;
 
-	for (i = 0; i < NUM_DYNAMIC_BUFFERS; ++i)
-		dyn_index_buffers[i].data = (unsigned char *)data + (i * aligned_size);
+	dyn->num_blocks--;
+	free(block);
 }
 
 /*
 ===============
-R_InitDynamicUniformBuffers
+R_InitDynamicBuffer
 ===============
 */
-static void R_InitDynamicUniformBuffers()
+static void R_InitDynamicBuffer(dynbuffer_t *dyn)
 {
-	int i;
+	// the other chains are created by R_ResetDynamicBuffer, -framesinflight decides how many get used
+	dyn->chains[current_dyn_buffer_index] = R_CreateDynamicBlock(dyn, dyn->block_size);
+	dyn->current = dyn->chains[current_dyn_buffer_index];
+}
 
-	Con_Printf("Initializing dynamic uniform buffers\n");
+/*
+===============
+R_ResetDynamicBuffer -- rewinds the chain of the new frame, freeing extra blocks that went idle
+===============
+*/
+static void R_ResetDynamicBuffer(dynbuffer_t *dyn)
+{
+	dynblock_t *block;
 
-	VkResult err;
+	dyn->peak_usage = q_max(dyn->peak_usage, dyn->frame_usage);
+	dyn->frame_usage = 0;
 
-	VkBufferCreateInfo buffer_create_info;
-	memset(&buffer_create_info, 0, sizeof(buffer_create_info));
-	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-	buffer_create_info.size = DYNAMIC_UNIFORM_BUFFER_SIZE_KB * 1024;
-	buffer_create_info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+	if (!dyn->chains[current_dyn_buffer_index])
+		dyn->chains[current_dyn_buffer_index] = R_CreateDynamicBlock(dyn, dyn->block_size);
 
-	for (i = 0; i < NUM_DYNAMIC_BUFFERS; ++i)
+	for (block = dyn->chains[current_dyn_buffer_index]; block; block = block->next)
 	{
-		dyn_uniform_buffers[i].current_offset = 0;
-
-		err = vkCreateBuffer(vulkan_globals.device, &buffer_create_info, NULL, &dyn_uniform_buffers[i].buffer);
-		if (err != VK_SUCCESS)
-			Sys_Error("vkCreateBuffer failed");
-
-		GL_SetObjectName((uint64_t)dyn_uniform_buffers[i].buffer, VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Dynamic Uniform Buffer");
+		// blocks are used in chain order, so everything after an idle block is idle too
+		while (block->next && (dyn_frame_count - block->next->last_used) > DYNAMIC_BLOCK_IDLE_FRAMES)
+		{
+			dynblock_t *idle = block->next;
+			block->next = idle->next;
+			R_DestroyDynamicBlock(dyn, idle);
+		}
+		block->current_offset = 0;
 	}
 
-	VkMemoryRequirements memory_requirements;
-	vkGetBufferMemoryRequirements(vulkan_globals.device, dyn_uniform_buffers[0].buffer, &memory_requirements);
-
-	const int align_mod = memory_requirements.size % memory_requirements.alignment;
-	const int aligned_size = ((memory_requirements.size % memory_requirements.alignment) == 0) 
-		? memory_requirements.size 
-		: (memory_requirements.size + memory_requirements.alignment - align_mod);
-
-	VkMemoryAllocateInfo memory_allocate_info;
-	memset(&memory_allocate_info, 0, sizeof(memory_allocate_info));
-	memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memory_allocate_info.allocationSize = NUM_DYNAMIC_BUFFERS * aligned_size;
-	memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+	dyn->current = dyn->chains[current_dyn_buffer_index];
+}
 
-	num_vulkan_dynbuf_allocations += 1;
-	err = vkAllocateMemory(vulkan_globals.device, &memory_allocate_info, NULL, &dyn_uniform_buffer_memory);
-	if (err != VK_SUCCESS)
-		Sys_Error("vkAllocateMemory failed");
+/*
+===============
+R_DynamicAllocate
 
-	GL_SetObjectName((uint64_t)dyn_uniform_buffer_memory, VK_DEBUG_REPORT_OBJECT_TYPE_DEVICE_MEMORY_EXT, "Dynamic Uniform Buffers");
+Returns the block and offset of size bytes.  reserve is how many bytes past the
+offset have to be inside the block, uniform and storage descriptors always
+cover their full range.
+===============
+*/
+static dynblock_t *R_DynamicAllocate(dynbuffer_t *dyn, uint32_t size, uint32_t alignment, uint32_t reserve, uint32_t *offset)
+{
+	dynblock_t *block = dyn->current;
+	uint32_t aligned_offset;
 
-	for (i = 0; i < NUM_DYNAMIC_BUFFERS; ++i)
+	for (;;)
 	{
-		err = vkBindBufferMemory(vulkan_globals.device, dyn_uniform_buffers[i].buffer, dyn_uniform_buffer_memory, i * aligned_size);
-		if (err != VK_SUCCESS)
-			Sys_Error("vkBindBufferMemory failed");
-	}
+		aligned_offset = (block->current_offset + alignment - 1) & ~(alignment - 1);
+		if (aligned_offset + reserve <= block->size)
+			break;
 
-	void * data;
-	err = vkMapMemory(vulkan_globals.device, dyn_uniform_buffer_memory, 0, NUM_DYNAMIC_BUFFERS * aligned_size, 0, &data);
-	if (err != VK_SUCCESS)
-		Sys_Error("vkMapMemory failed");
+		if (!block->next)
+		{
+			uint32_t new_size = q_max(dyn->block_size, (reserve + dyn->block_size - 1) / dyn->block_size * dyn->block_size);
+			block->next = R_CreateDynamicBlock(dyn, new_size);
+			Con_DPrintf("%s: added a %u KB block, %d in use\n", dyn->name, new_size / 1024, dyn->num_blocks);
+		}
+		block = block->next;
+		dyn->current = block;
+	}
 
-	for (i = 0; i < NUM_DYNAMIC_BUFFERS; ++i)
-		dyn_uniform_buffers[i].data = (unsigned char *)data + (i * aligned_size);
+	*offset = aligned_offset;
+	block->current_offset = aligned_offset + size;
+	block->last_used = dyn_frame_count;
+	dyn->frame_usage += size;
 
-	VkDescriptorSetAllocateInfo descriptor_set_allocate_info;
-	memset(&descriptor_set_allocate_info, 0, sizeof(descriptor_set_allocate_info));
-	descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	descriptor_set_allocate_info.descriptorPool = vulkan_globals.descriptor_pool;
-	descriptor_set_allocate_info.descriptorSetCount = 1;
-	descriptor_set_allocate_info.pSetLayouts = &vulkan_globals.ubo_set_layout;
+	return block;
+}
 
-	vkAllocateDescriptorSets(vulkan_globals.device, &descriptor_set_allocate_info, &ubo_descriptor_sets[0]);
-	vkAllocateDescriptorSets(vulkan_globals.device, &descriptor_set_allocate_info, &ubo_descriptor_sets[1]);
+/*
+===============
+R_SwapDynamicBuffers -- the gpu has to be done with the previous frame that used this index
+===============
+*/
+void R_SwapDynamicBuffers(int frame_index)
+{
+	current_dyn_buffer_index = frame_index % NUM_DYNAMIC_BUFFERS;
+	dyn_frame_count++;
 
-	VkDescriptorBufferInfo buffer_info;
-	memset(&buffer_info, 0, sizeof(buffer_info));
-	buffer_info.offset = 0;
-	buffer_info.range = MAX_UNIFORM_ALLOC;
-
-	VkWriteDescriptorSet ubo_write;
-	memset(&ubo_write, 0, sizeof(ubo_write));
-	ubo_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	ubo_write.dstBinding = 0;
-	ubo_write.dstArrayElement = 0;
-	ubo_write.descriptorCount = 1;
-	ubo_write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-	ubo_write.pBufferInfo = &buffer_info;
-
-	for (i = 0; i < NUM_DYNAMIC_BUFFERS; ++i)
-	{
-		buffer_info.buffer = dyn_uniform_buffers[i].buffer;
-		ubo_write.dstSet = ubo_descriptor_sets[i];
-		vkUpdateDescriptorSets(vulkan_globals.device, 1, &ubo_write, 0, NULL);
-	}
+	R_ResetDynamicBuffer(&dyn_vertex_buffer);
+	R_ResetDynamicBuffer(&dyn_index_buffer);
+	R_ResetDynamicBuffer(&dyn_uniform_buffer);
 }
 
 /*
 ===============
-R_SwapDynamicBuffers
+R_FlushDynamicBuffer
 ===============
 */
-void R_SwapDynamicBuffers()
+static int R_FlushDynamicBuffer(dynbuffer_t *dyn, VkMappedMemoryRange *ranges, int num_ranges)
 {
-	current_dyn_buffer_index = (current_dyn_buffer_index + 1) % NUM_DYNAMIC_BUFFERS;
-	dyn_vertex_buffers[current_dyn_buffer_index].current_offset = 0;
-	dyn_index_buffers[current_dyn_buffer_index].current_offset = 0;
-	dyn_uniform_buffers[current_dyn_buffer_index].current_offset = 0;
+	dynblock_t *block;
+
+	for (block = dyn->chains[current_dyn_buffer_index]; block; block = block->next)
+	{
+		if (block->current_offset == 0)
+			continue;	// skipped by an allocation that didn't fit, or not reached this frame
+		if (num_ranges == MAX_DYNAMIC_UNIFORM_BLOCKS * 3)
+		{
+			vkFlushMappedMemoryRanges(vulkan_globals.device, num_ranges, ranges);
+			num_ranges = 0;
+		}
+
+		memset(&ranges[num_ranges], 0, sizeof(VkMappedMemoryRange));
+		ranges[num_ranges].sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		ranges[num_ranges].memory = block->memory;
+		ranges[num_ranges].size = VK_WHOLE_SIZE;
+		num_ranges++;
+	}
+
+	return num_ranges;
 }
 
 /*
@@ -713,18 +745,14 @@ R_FlushDynamicBuffers
 */
 void R_FlushDynamicBuffers()
 {
-	VkMappedMemoryRange ranges[3];
-	memset(&ranges, 0, sizeof(ranges));
-	ranges[0].sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-    ranges[0].memory = dyn_vertex_buffer_memory;
-    ranges[0].size = VK_WHOLE_SIZE;
-	ranges[1].sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-    ranges[1].memory = dyn_index_buffer_memory;
-    ranges[1].size = VK_WHOLE_SIZE;
-	ranges[2].sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-    ranges[2].memory = dyn_uniform_buffer_memory;
-    ranges[2].size = VK_WHOLE_SIZE;
-	vkFlushMappedMemoryRanges(vulkan_globals.device, 3, ranges);
+	VkMappedMemoryRange ranges[MAX_DYNAMIC_UNIFORM_BLOCKS * 3];
+	int num_ranges = 0;
+
+	num_ranges = R_FlushDynamicBuffer(&dyn_vertex_buffer, ranges, num_ranges);
+	num_ranges = R_FlushDynamicBuffer(&dyn_index_buffer, ranges, num_ranges);
+	num_ranges = R_FlushDynamicBuffer(&dyn_uniform_buffer, ranges, num_ranges);
+	if (num_ranges > 0)
+		vkFlushMappedMemoryRanges(vulkan_globals.device, num_ranges, ranges);
 }
 
 /*
@@ -734,18 +762,13 @@ R_VertexAllocate
 */
 byte * R_VertexAllocate(int size, VkBuffer * buffer, VkDeviceSize * buffer_offset)
 {
-	dynbuffer_t *dyn_vb = &dyn_vertex_buffers[current_dyn_buffer_index];
-
-	if ((dyn_vb->current_offset + size) > (DYNAMIC_VERTEX_BUFFER_SIZE_KB * 1024))
-		Sys_Error("Out of dynamic vertex buffer space, increase DYNAMIC_VERTEX_BUFFER_SIZE_KB");
-
-	*buffer = dyn_vb->buffer;
-	*buffer_offset = dyn_vb->current_offset;
+	uint32_t offset;
+	dynblock_t *block = R_DynamicAllocate(&dyn_vertex_buffer, size, 1, size, &offset);
 
-	unsigned char *data = dyn_vb->data + dyn_vb->current_offset;
-	dyn_vb->current_offset += size;
+	*buffer = block->buffer;
+	*buffer_offset = offset;
 
-	return data;
+	return block->data + offset;
 }
 
 /*
@@ -755,18 +778,13 @@ R_IndexAllocate
 */
 byte * R_IndexAllocate(int size, VkBuffer * buffer, VkDeviceSize * buffer_offset)
 {
-	dynbuffer_t *dyn_ib = &dyn_index_buffers[current_dyn_buffer_index];
-
-	if ((dyn_ib->current_offset + size) > (DYNAMIC_INDEX_BUFFER_SIZE_KB * 1024))
-		Sys_Error("Out of dynamic index buffer space, increase DYNAMIC_INDEX_BUFFER_SIZE_KB");
+	uint32_t offset;
+	dynblock_t *block = R_DynamicAllocate(&dyn_index_buffer, size, 1, size, &offset);
 
-	*buffer = dyn_ib->buffer;
-	*buffer_offset = dyn_ib->current_offset;
+	*buffer = block->buffer;
+	*buffer_offset = offset;
 
-	unsigned char *data = dyn_ib->data + dyn_ib->current_offset;
-	dyn_ib->current_offset += size;
-
-	return data;
+	return block->data + offset;
 }
 
 /*
@@ -782,23 +800,33 @@ byte * R_UniformAllocate(int size, VkBuffer * buffer, uint32_t * buffer_offset,
 	if (size > MAX_UNIFORM_ALLOC)
 		Sys_Error("Increase MAX_UNIFORM_ALLOC");
 
-	const int align_mod = size % 256;
-	const int aligned_size = ((size % 256) == 0) ? size : (size + 256 - align_mod);
+	dynblock_t *block = R_DynamicAllocate(&dyn_uniform_buffer, size, 256, MAX_UNIFORM_ALLOC, buffer_offset);
 
-	dynbuffer_t *dyn_ub = &dyn_uniform_buffers[current_dyn_buffer_index];
+	*buffer = block->buffer;
+	*descriptor_set = block->ubo_descriptor_set;
 
-	if ((dyn_ub->current_offset + MAX_UNIFORM_ALLOC) > (DYNAMIC_UNIFORM_BUFFER_SIZE_KB * 1024))
-		Sys_Error("Out of dynamic uniform buffer space, increase DYNAMIC_UNIFORM_BUFFER_SIZE_KB");
+	return block->data + *buffer_offset;
+}
+
+/*
+===============
+R_StorageAllocate
 
-	*buffer = dyn_ub->buffer;
-	*buffer_offset = dyn_ub->current_offset;
+Like R_UniformAllocate, but for dynamic storage buffers of up to MAX_STORAGE_ALLOC
+bytes. Shares the dynamic uniform buffers and their 256 byte alignment
+===============
+*/
+byte * R_StorageAllocate(int size, VkBuffer * buffer, uint32_t * buffer_offset, VkDescriptorSet * descriptor_set)
+{
+	if (size > MAX_STORAGE_ALLOC)
+		Sys_Error("Increase MAX_STORAGE_ALLOC");
 
-	unsigned char *data = dyn_ub->data + dyn_ub->current_offset;
-	dyn_ub->current_offset += aligned_size;
+	dynblock_t *block = R_DynamicAllocate(&dyn_uniform_buffer, size, 256, MAX_STORAGE_ALLOC, buffer_offset);
 
-	*descriptor_set = ubo_descriptor_sets[current_dyn_buffer_index];
+	*buffer = block->buffer;
+	*descriptor_set = block->storage_descriptor_set;
 
-	return data;
+	return block->data + *buffer_offset;
 }
 
 /*
@@ -808,9 +836,154 @@ R_InitDynamicBuffers
 */
 void R_InitDynamicBuffers()
 {
-	R_InitDynamicVertexBuffers();
-	R_InitDynamicIndexBuffers();
-	R_InitDynamicUniformBuffers();
+	Con_Printf("Initializing dynamic buffers\n");
+
+	R_InitDynamicBuffer(&dyn_vertex_buffer);
+	R_InitDynamicBuffer(&dyn_index_buffer);
+	R_InitDynamicBuffer(&dyn_uniform_buffer);
+}
+
+/*
+================================================================================
+
+	LATE LATCH
+
+The 3D vertex shaders multiply by one more matrix that is read from a small
+host visible buffer at draw time.  It is written with a fresh head pose right
+before the command buffer is submitted and corrects the view that went into
+the push constants when the frame was recorded.  Every command buffer has its
+own slot, the last slot is the identity for head locked 2D drawing.
+
+================================================================================
+*/
+
+#define LATCH_SLOT_SIZE		256		// maximum minUniformBufferOffsetAlignment allowed by the spec
+#define NUM_LATCH_SLOTS		(NUM_COMMAND_BUFFERS + 1)
+#define LATCH_HEAD_LOCKED	NUM_COMMAND_BUFFERS
+
+static VkBuffer			latch_buffer;
+static VkDeviceMemory	latch_memory;
+static byte				*latch_data;
+static VkDescriptorSet	latch_descriptor_set;
+static int				latch_slot = LATCH_HEAD_LOCKED;
+
+/*
+===============
+R_InitLatchBuffer
+===============
+*/
+void R_InitLatchBuffer()
+{
+	VkResult err;
+	float identity[16];
+	int i;
+
+	VkBufferCreateInfo buffer_create_info;
+	memset(&buffer_create_info, 0, sizeof(buffer_create_info));
+	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_create_info.size = NUM_LATCH_SLOTS * LATCH_SLOT_SIZE;
+	buffer_create_info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+
+	err = vkCreateBuffer(vulkan_globals.device, &buffer_create_info, NULL, &latch_buffer);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkCreateBuffer failed");
+
+	GL_SetObjectName((uint64_t)latch_buffer, VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Late Latch Buffer");
+
+	VkMemoryRequirements memory_requirements;
+	vkGetBufferMemoryRequirements(vulkan_globals.device, latch_buffer, &memory_requirements);
+
+	// Coherent, so a write right before vkQueueSubmit needs no flush
+	VkMemoryAllocateInfo memory_allocate_info;
+	memset(&memory_allocate_info, 0, sizeof(memory_allocate_info));
+	memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memory_allocate_info.allocationSize = memory_requirements.size;
+	memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0);
+
+	num_vulkan_dynbuf_allocations += 1;
+	err = vkAllocateMemory(vulkan_globals.device, &memory_allocate_info, NULL, &latch_memory);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkAllocateMemory failed");
+
+	GL_SetObjectName((uint64_t)latch_memory, VK_DEBUG_REPORT_OBJECT_TYPE_DEVICE_MEMORY_EXT, "Late Latch Buffer");
+
+	err = vkBindBufferMemory(vulkan_globals.device, latch_buffer, latch_memory, 0);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkBindBufferMemory failed");
+
+	void * data;
+	err = vkMapMemory(vulkan_globals.device, latch_memory, 0, VK_WHOLE_SIZE, 0, &data);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkMapMemory failed");
+	latch_data = (byte *)data;
+
+	IdentityMatrix(identity);
+	for (i = 0; i < NUM_LATCH_SLOTS; ++i)
+		memcpy(latch_data + i * LATCH_SLOT_SIZE, identity, 16 * sizeof(float));
+
+	VkDescriptorSetAllocateInfo descriptor_set_allocate_info;
+	memset(&descriptor_set_allocate_info, 0, sizeof(descriptor_set_allocate_info));
+	descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptor_set_allocate_info.descriptorPool = vulkan_globals.descriptor_pool;
+	descriptor_set_allocate_info.descriptorSetCount = 1;
+	descriptor_set_allocate_info.pSetLayouts = &vulkan_globals.latch_set_layout;
+	if (vkAllocateDescriptorSets(vulkan_globals.device, &descriptor_set_allocate_info, &latch_descriptor_set) != VK_SUCCESS)
+		Sys_Error("vkAllocateDescriptorSets failed");
+
+	VkDescriptorBufferInfo buffer_info;
+	memset(&buffer_info, 0, sizeof(buffer_info));
+	buffer_info.buffer = latch_buffer;
+	buffer_info.offset = 0;
+	buffer_info.range = 16 * sizeof(float);
+
+	VkWriteDescriptorSet latch_write;
+	memset(&latch_write, 0, sizeof(latch_write));
+	latch_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	latch_write.dstSet = latch_descriptor_set;
+	latch_write.dstBinding = 0;
+	latch_write.descriptorCount = 1;
+	latch_write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	latch_write.pBufferInfo = &buffer_info;
+	vkUpdateDescriptorSets(vulkan_globals.device, 1, &latch_write, 0, NULL);
+}
+
+/*
+===============
+R_BeginLatch -- the gpu has to be done with the previous frame that used this slot
+===============
+*/
+void R_BeginLatch(int slot)
+{
+	float identity[16];
+
+	latch_slot = slot;
+	IdentityMatrix(identity);
+	R_StoreLatchMatrix(identity);
+}
+
+/*
+===============
+R_StoreLatchMatrix -- clip space correction for the command buffer being recorded
+===============
+*/
+void R_StoreLatchMatrix(const float matrix[16])
+{
+	memcpy(latch_data + latch_slot * LATCH_SLOT_SIZE, matrix, 16 * sizeof(float));
+}
+
+/*
+===============
+R_BindLatch
+
+Binding sets with a different pipeline layout disturbs the latch set, so this
+goes after every switch to a layout that has one
+===============
+*/
+void R_BindLatch(VkPipelineLayout layout, uint32_t set, qboolean head_locked)
+{
+	uint32_t offset = (head_locked ? LATCH_HEAD_LOCKED : latch_slot) * LATCH_SLOT_SIZE;
+
+	vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, set, 1, &latch_descriptor_set, 1, &offset);
 }
 
 /*
@@ -855,37 +1028,135 @@ void R_CreateDescriptorSetLayouts()
 	if (err != VK_SUCCESS)
 		Sys_Error("vkCreateDescriptorSetLayout failed");
 
-	VkDescriptorSetLayoutBinding input_attachment_layout_bindings;
-	memset(&input_attachment_layout_bindings, 0, sizeof(input_attachment_layout_bindings));
-	input_attachment_layout_bindings.binding = 0;
-	input_attachment_layout_bindings.descriptorCount = 1;
-	input_attachment_layout_bindings.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-	input_attachment_layout_bindings.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	VkDescriptorSetLayoutBinding storage_layout_bindings;
+	memset(&storage_layout_bindings, 0, sizeof(storage_layout_bindings));
+	storage_layout_bindings.binding = 0;
+	storage_layout_bindings.descriptorCount = 1;
+	storage_layout_bindings.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	storage_layout_bindings.stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS;
 
 	descriptor_set_layout_create_info.bindingCount = 1;
-	descriptor_set_layout_create_info.pBindings = &input_attachment_layout_bindings;
-	
-	err = vkCreateDescriptorSetLayout(vulkan_globals.device, &descriptor_set_layout_create_info, NULL, &vulkan_globals.input_attachment_set_layout);
+	descriptor_set_layout_create_info.pBindings = &storage_layout_bindings;
+
+	err = vkCreateDescriptorSetLayout(vulkan_globals.device, &descriptor_set_layout_create_info, NULL, &vulkan_globals.storage_set_layout);
 	if (err != VK_SUCCESS)
 		Sys_Error("vkCreateDescriptorSetLayout failed");
 
-	VkDescriptorSetLayoutBinding screen_warp_layout_bindings[2];
-	memset(&screen_warp_layout_bindings, 0, sizeof(screen_warp_layout_bindings));
-	screen_warp_layout_bindings[0].binding = 0;
-	screen_warp_layout_bindings[0].descriptorCount = 1;
-	screen_warp_layout_bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	screen_warp_layout_bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-	screen_warp_layout_bindings[1].binding = 1;
-	screen_warp_layout_bindings[1].descriptorCount = 1;
-	screen_warp_layout_bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-	screen_warp_layout_bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	VkDescriptorSetLayoutBinding pose_layout_bindings;
+	memset(&pose_layout_bindings, 0, sizeof(pose_layout_bindings));
+	pose_layout_bindings.binding = 0;
+	pose_layout_bindings.descriptorCount = 1;
+	pose_layout_bindings.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	pose_layout_bindings.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
-	descriptor_set_layout_create_info.bindingCount = 2;
-	descriptor_set_layout_create_info.pBindings = screen_warp_layout_bindings;
-	
-	err = vkCreateDescriptorSetLayout(vulkan_globals.device, &descriptor_set_layout_create_info, NULL, &vulkan_globals.screen_warp_set_layout);
+	descriptor_set_layout_create_info.bindingCount = 1;
+	descriptor_set_layout_create_info.pBindings = &pose_layout_bindings;
+
+	err = vkCreateDescriptorSetLayout(vulkan_globals.device, &descriptor_set_layout_create_info, NULL, &vulkan_globals.pose_set_layout);
 	if (err != VK_SUCCESS)
 		Sys_Error("vkCreateDescriptorSetLayout failed");
+
+	VkDescriptorSetLayoutBinding latch_layout_bindings;
+	memset(&latch_layout_bindings, 0, sizeof(latch_layout_bindings));
+	latch_layout_bindings.binding = 0;
+	latch_layout_bindings.descriptorCount = 1;
+	latch_layout_bindings.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	latch_layout_bindings.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+	descriptor_set_layout_create_info.bindingCount = 1;
+	descriptor_set_layout_create_info.pBindings = &latch_layout_bindings;
+
+	err = vkCreateDescriptorSetLayout(vulkan_globals.device, &descriptor_set_layout_create_info, NULL, &vulkan_globals.latch_set_layout);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkCreateDescriptorSetLayout failed");
+
+	VkDescriptorSetLayoutBinding particle_layout_bindings;
+	memset(&particle_layout_bindings, 0, sizeof(particle_layout_bindings));
+	particle_layout_bindings.binding = 0;
+	particle_layout_bindings.descriptorCount = 1;
+	particle_layout_bindings.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	particle_layout_bindings.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+
+	descriptor_set_layout_create_info.bindingCount = 1;
+	descriptor_set_layout_create_info.pBindings = &particle_layout_bindings;
+
+	err = vkCreateDescriptorSetLayout(vulkan_globals.device, &descriptor_set_layout_create_info, NULL, &vulkan_globals.particle_set_layout);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkCreateDescriptorSetLayout failed");
+
+	VkDescriptorSetLayoutBinding sky_box_layout_bindings;
+	memset(&sky_box_layout_bindings, 0, sizeof(sky_box_layout_bindings));
+	sky_box_layout_bindings.binding = 0;
+	sky_box_layout_bindings.descriptorCount = 6;
+	sky_box_layout_bindings.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	sky_box_layout_bindings.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	descriptor_set_layout_create_info.bindingCount = 1;
+	descriptor_set_layout_create_info.pBindings = &sky_box_layout_bindings;
+
+	err = vkCreateDescriptorSetLayout(vulkan_globals.device, &descriptor_set_layout_create_info, NULL, &vulkan_globals.sky_box_set_layout);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkCreateDescriptorSetLayout failed");
+
+	VkDescriptorSetLayoutBinding input_attachment_layout_bindings;
+	memset(&input_attachment_layout_bindings, 0, sizeof(input_attachment_layout_bindings));
+	input_attachment_layout_bindings.binding = 0;
+	input_attachment_layout_bindings.descriptorCount = 1;
+	input_attachment_layout_bindings.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+	input_attachment_layout_bindings.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	descriptor_set_layout_create_info.bindingCount = 1;
+	descriptor_set_layout_create_info.pBindings = &input_attachment_layout_bindings;
+	
+	err = vkCreateDescriptorSetLayout(vulkan_globals.device, &descriptor_set_layout_create_info, NULL, &vulkan_globals.input_attachment_set_layout);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkCreateDescriptorSetLayout failed");
+
+	VkDescriptorSetLayoutBinding screen_warp_layout_bindings[2];
+	memset(&screen_warp_layout_bindings, 0, sizeof(screen_warp_layout_bindings));
+	screen_warp_layout_bindings[0].binding = 0;
+	screen_warp_layout_bindings[0].descriptorCount = 1;
+	screen_warp_layout_bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	screen_warp_layout_bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	screen_warp_layout_bindings[1].binding = 1;
+	screen_warp_layout_bindings[1].descriptorCount = 1;
+	screen_warp_layout_bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	screen_warp_layout_bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	descriptor_set_layout_create_info.bindingCount = 2;
+	descriptor_set_layout_create_info.pBindings = screen_warp_layout_bindings;
+	
+	err = vkCreateDescriptorSetLayout(vulkan_globals.device, &descriptor_set_layout_create_info, NULL, &vulkan_globals.screen_warp_set_layout);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkCreateDescriptorSetLayout failed");
+
+	if (vulkan_globals.bindless)
+	{
+		// Slots of freed textures stay stale, and new textures get written while frames are in flight
+		VkDescriptorBindingFlagsEXT bindless_binding_flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfoEXT binding_flags_create_info;
+		memset(&binding_flags_create_info, 0, sizeof(binding_flags_create_info));
+		binding_flags_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+		binding_flags_create_info.bindingCount = 1;
+		binding_flags_create_info.pBindingFlags = &bindless_binding_flags;
+
+		VkDescriptorSetLayoutBinding bindless_layout_binding;
+		memset(&bindless_layout_binding, 0, sizeof(bindless_layout_binding));
+		bindless_layout_binding.binding = 0;
+		bindless_layout_binding.descriptorCount = MAX_GLTEXTURES;
+		bindless_layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		bindless_layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+		descriptor_set_layout_create_info.pNext = &binding_flags_create_info;
+		descriptor_set_layout_create_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+		descriptor_set_layout_create_info.bindingCount = 1;
+		descriptor_set_layout_create_info.pBindings = &bindless_layout_binding;
+
+		err = vkCreateDescriptorSetLayout(vulkan_globals.device, &descriptor_set_layout_create_info, NULL, &vulkan_globals.bindless_set_layout);
+		if (err != VK_SUCCESS)
+			Sys_Error("vkCreateDescriptorSetLayout failed");
+	}
 }
 
 /*
@@ -895,25 +1166,53 @@ R_CreateDescriptorPool
 */
 void R_CreateDescriptorPool()
 {
-	VkDescriptorPoolSize pool_sizes[4];
+	VkDescriptorPoolSize pool_sizes[6];
 	pool_sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	pool_sizes[0].descriptorCount = MAX_GLTEXTURES + 1;
+	pool_sizes[0].descriptorCount = MAX_GLTEXTURES + 1 + 6; // textures, screen warp & the skybox faces
 	pool_sizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-	pool_sizes[1].descriptorCount = 16;
+	pool_sizes[1].descriptorCount = NUM_DYNAMIC_BUFFERS * MAX_DYNAMIC_UNIFORM_BLOCKS + 1; // + the late latch buffer
 	pool_sizes[2].type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
 	pool_sizes[2].descriptorCount = 2;
 	pool_sizes[3].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
 	pool_sizes[3].descriptorCount = 1;
+	pool_sizes[4].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+	pool_sizes[4].descriptorCount = NUM_DYNAMIC_BUFFERS * MAX_DYNAMIC_UNIFORM_BLOCKS;
+	pool_sizes[5].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	pool_sizes[5].descriptorCount = MAX_MODELS + 1; // alias model poses & the particle buffer
 
 	VkDescriptorPoolCreateInfo descriptor_pool_create_info;
 	memset(&descriptor_pool_create_info, 0, sizeof(descriptor_pool_create_info));
 	descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	descriptor_pool_create_info.maxSets = MAX_GLTEXTURES + 32;
-	descriptor_pool_create_info.poolSizeCount = 4;
+	descriptor_pool_create_info.maxSets = MAX_GLTEXTURES + MAX_MODELS + 32 + 2 * NUM_DYNAMIC_BUFFERS * MAX_DYNAMIC_UNIFORM_BLOCKS;
+	descriptor_pool_create_info.poolSizeCount = 6;
 	descriptor_pool_create_info.pPoolSizes = pool_sizes;
 	descriptor_pool_create_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
 
 	vkCreateDescriptorPool(vulkan_globals.device, &descriptor_pool_create_info, NULL, &vulkan_globals.descriptor_pool);
+
+	if (vulkan_globals.bindless)
+	{
+		// Update after bind sets need a pool of their own
+		pool_sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		pool_sizes[0].descriptorCount = MAX_GLTEXTURES;
+
+		descriptor_pool_create_info.maxSets = 1;
+		descriptor_pool_create_info.poolSizeCount = 1;
+		descriptor_pool_create_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+
+		if (vkCreateDescriptorPool(vulkan_globals.device, &descriptor_pool_create_info, NULL, &vulkan_globals.bindless_descriptor_pool) != VK_SUCCESS)
+			Sys_Error("vkCreateDescriptorPool failed");
+
+		VkDescriptorSetAllocateInfo descriptor_set_allocate_info;
+		memset(&descriptor_set_allocate_info, 0, sizeof(descriptor_set_allocate_info));
+		descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		descriptor_set_allocate_info.descriptorPool = vulkan_globals.bindless_descriptor_pool;
+		descriptor_set_allocate_info.descriptorSetCount = 1;
+		descriptor_set_allocate_info.pSetLayouts = &vulkan_globals.bindless_set_layout;
+
+		if (vkAllocateDescriptorSets(vulkan_globals.device, &descriptor_set_allocate_info, &vulkan_globals.bindless_descriptor_set) != VK_SUCCESS)
+			Sys_Error("vkAllocateDescriptorSets failed");
+	}
 }
 
 /*
@@ -927,19 +1226,19 @@ void R_CreatePipelineLayouts()
 
 	VkResult err;
 
-	// Basic
-	VkDescriptorSetLayout basic_descriptor_set_layouts[1] = { vulkan_globals.single_texture_set_layout };
+	// Basic, set 1 is the late latch like the last set of every layout that draws the 3D view
+	VkDescriptorSetLayout basic_descriptor_set_layouts[2] = { vulkan_globals.single_texture_set_layout, vulkan_globals.latch_set_layout };
 	
 	VkPushConstantRange push_constant_range;
 	memset(&push_constant_range, 0, sizeof(push_constant_range));
 	push_constant_range.offset = 0;
-	push_constant_range.size = 21 * sizeof(float);
+	push_constant_range.size = 24 * sizeof(float); // the last 3 are texture indices for the bindless world pipelines
 	push_constant_range.stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS;
 
 	VkPipelineLayoutCreateInfo pipeline_layout_create_info;
 	memset(&pipeline_layout_create_info, 0, sizeof(pipeline_layout_create_info));
 	pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipeline_layout_create_info.setLayoutCount = 1;
+	pipeline_layout_create_info.setLayoutCount = 2;
 	pipeline_layout_create_info.pSetLayouts = basic_descriptor_set_layouts;
 	pipeline_layout_create_info.pushConstantRangeCount = 1;
 	pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
@@ -949,46 +1248,115 @@ void R_CreatePipelineLayouts()
 		Sys_Error("vkCreatePipelineLayout failed");
 
 	// World
-	VkDescriptorSetLayout world_descriptor_set_layouts[3] = {
+	VkDescriptorSetLayout world_descriptor_set_layouts[4] = {
 		vulkan_globals.single_texture_set_layout,
 		vulkan_globals.single_texture_set_layout,
-		vulkan_globals.single_texture_set_layout
+		vulkan_globals.single_texture_set_layout,
+		vulkan_globals.latch_set_layout
 	};
 
-	pipeline_layout_create_info.setLayoutCount = 3;
+	pipeline_layout_create_info.setLayoutCount = 4;
 	pipeline_layout_create_info.pSetLayouts = world_descriptor_set_layouts;
 
 	err = vkCreatePipelineLayout(vulkan_globals.device, &pipeline_layout_create_info, NULL, &vulkan_globals.world_pipeline_layout);
 	if (err != VK_SUCCESS)
 		Sys_Error("vkCreatePipelineLayout failed");
 
-	// Alias
-	VkDescriptorSetLayout alias_descriptor_set_layouts[3] = {
+	// Alias, set 2 holds the per instance array, set 3 the model's poses
+	VkDescriptorSetLayout alias_descriptor_set_layouts[5] = {
 		vulkan_globals.single_texture_set_layout,
 		vulkan_globals.single_texture_set_layout,
-		vulkan_globals.ubo_set_layout
+		vulkan_globals.storage_set_layout,
+		vulkan_globals.pose_set_layout,
+		vulkan_globals.latch_set_layout
 	};
 
-	pipeline_layout_create_info.setLayoutCount = 3;
+	pipeline_layout_create_info.setLayoutCount = 5;
 	pipeline_layout_create_info.pSetLayouts = alias_descriptor_set_layouts;
 
 	err = vkCreatePipelineLayout(vulkan_globals.device, &pipeline_layout_create_info, NULL, &vulkan_globals.alias_pipeline_layout);
 	if (err != VK_SUCCESS)
 		Sys_Error("vkCreatePipelineLayout failed");
 
-	// Sky
-	VkDescriptorSetLayout sky_layer_descriptor_set_layouts[2] = {
+	if (vulkan_globals.bindless)
+	{
+		// World bindless, texture indices come from push constants. Sets 1 and 2 are unused so world.vert still finds the latch in set 3
+		VkDescriptorSetLayout world_bindless_descriptor_set_layouts[4] = {
+			vulkan_globals.bindless_set_layout,
+			vulkan_globals.single_texture_set_layout,
+			vulkan_globals.single_texture_set_layout,
+			vulkan_globals.latch_set_layout
+		};
+
+		pipeline_layout_create_info.setLayoutCount = 4;
+		pipeline_layout_create_info.pSetLayouts = world_bindless_descriptor_set_layouts;
+
+		err = vkCreatePipelineLayout(vulkan_globals.device, &pipeline_layout_create_info, NULL, &vulkan_globals.world_bindless_pipeline_layout);
+		if (err != VK_SUCCESS)
+			Sys_Error("vkCreatePipelineLayout failed");
+
+		// Alias bindless, texture indices come from the instance data. Set 1 is unused so alias.vert still finds the instances in set 2
+		VkDescriptorSetLayout alias_bindless_descriptor_set_layouts[5] = {
+			vulkan_globals.bindless_set_layout,
+			vulkan_globals.single_texture_set_layout,
+			vulkan_globals.storage_set_layout,
+			vulkan_globals.pose_set_layout,
+			vulkan_globals.latch_set_layout
+		};
+
+		pipeline_layout_create_info.setLayoutCount = 5;
+		pipeline_layout_create_info.pSetLayouts = alias_bindless_descriptor_set_layouts;
+
+		err = vkCreatePipelineLayout(vulkan_globals.device, &pipeline_layout_create_info, NULL, &vulkan_globals.alias_bindless_pipeline_layout);
+		if (err != VK_SUCCESS)
+			Sys_Error("vkCreatePipelineLayout failed");
+	}
+
+	// Sky, set 2 holds the model matrix, eye position, scroll & fog for the per fragment lookup
+	VkDescriptorSetLayout sky_layer_descriptor_set_layouts[4] = {
 		vulkan_globals.single_texture_set_layout,
 		vulkan_globals.single_texture_set_layout,
+		vulkan_globals.ubo_set_layout,
+		vulkan_globals.latch_set_layout,
 	};
 
-	pipeline_layout_create_info.setLayoutCount = 2;
+	pipeline_layout_create_info.setLayoutCount = 4;
 	pipeline_layout_create_info.pSetLayouts = sky_layer_descriptor_set_layouts;
 
 	err = vkCreatePipelineLayout(vulkan_globals.device, &pipeline_layout_create_info, NULL, &vulkan_globals.sky_layer_pipeline_layout);
 	if (err != VK_SUCCESS)
 		Sys_Error("vkCreatePipelineLayout failed");
 
+	// Skybox, all six faces in set 0. Set 1 is unused so both share sky_layer.vert
+	VkDescriptorSetLayout sky_box_descriptor_set_layouts[4] = {
+		vulkan_globals.sky_box_set_layout,
+		vulkan_globals.single_texture_set_layout,
+		vulkan_globals.ubo_set_layout,
+		vulkan_globals.latch_set_layout,
+	};
+
+	pipeline_layout_create_info.setLayoutCount = 4;
+	pipeline_layout_create_info.pSetLayouts = sky_box_descriptor_set_layouts;
+
+	err = vkCreatePipelineLayout(vulkan_globals.device, &pipeline_layout_create_info, NULL, &vulkan_globals.sky_box_pipeline_layout);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkCreatePipelineLayout failed");
+
+	// GPU particles, set 1 holds the palette & particles, set 2 the view vectors
+	VkDescriptorSetLayout gpu_particle_descriptor_set_layouts[4] = {
+		vulkan_globals.single_texture_set_layout,
+		vulkan_globals.particle_set_layout,
+		vulkan_globals.ubo_set_layout,
+		vulkan_globals.latch_set_layout,
+	};
+
+	pipeline_layout_create_info.setLayoutCount = 4;
+	pipeline_layout_create_info.pSetLayouts = gpu_particle_descriptor_set_layouts;
+
+	err = vkCreatePipelineLayout(vulkan_globals.device, &pipeline_layout_create_info, NULL, &vulkan_globals.gpu_particle_pipeline_layout);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkCreatePipelineLayout failed");
+
 	// Postprocess
 	VkDescriptorSetLayout postprocess_descriptor_set_layouts[1] = {
 		vulkan_globals.input_attachment_set_layout,
@@ -1045,6 +1413,28 @@ void R_CreatePipelineLayouts()
 	err = vkCreatePipelineLayout(vulkan_globals.device, &pipeline_layout_create_info, NULL, &vulkan_globals.screen_warp_pipeline_layout);
 	if (err != VK_SUCCESS)
 		Sys_Error("vkCreatePipelineLayout failed");
+
+	// Foveation fill, same images as the screen warp
+	push_constant_range.size = 2 * sizeof(uint32_t) + 4 * sizeof(float);
+
+	err = vkCreatePipelineLayout(vulkan_globals.device, &pipeline_layout_create_info, NULL, &vulkan_globals.foveation_fill_pipeline_layout);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkCreatePipelineLayout failed");
+
+	// Particle simulation
+	memset(&push_constant_range, 0, sizeof(push_constant_range));
+	push_constant_range.offset = 0;
+	push_constant_range.size = 3 * sizeof(float) + sizeof(uint32_t);
+	push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	pipeline_layout_create_info.setLayoutCount = 1;
+	pipeline_layout_create_info.pSetLayouts = &vulkan_globals.particle_set_layout;
+	pipeline_layout_create_info.pushConstantRangeCount = 1;
+	pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+	err = vkCreatePipelineLayout(vulkan_globals.device, &pipeline_layout_create_info, NULL, &vulkan_globals.particle_simulate_pipeline_layout);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkCreatePipelineLayout failed");
 }
 
 /*
@@ -1110,6 +1500,7 @@ void R_InitSamplers()
 	}
 
 	TexMgr_UpdateTextureDescriptorSets();
+	Sky_UpdateSkyBoxDescriptorSet();
 }
 
 /*
@@ -1134,6 +1525,344 @@ static VkShaderModule R_CreateShaderModule(byte *code, int size)
 	return module;
 }
 
+/*
+===============================================================================
+
+PIPELINE CACHE
+
+Pipelines are compiled into a VkPipelineCache that is kept on disk between
+runs, so vid_restart and later launches skip most of the driver's compile
+work.  The file is only trusted when it was written by the same device and
+driver build.
+
+===============================================================================
+*/
+
+#define PIPELINE_CACHE_VERSION	1
+#define MAX_PIPELINE_CACHE_SIZE	(64 * 1024 * 1024)
+
+typedef struct
+{
+	char		id[4];			// "QPSO"
+	int			version;
+	uint32_t	vendor_id;
+	uint32_t	device_id;
+	uint32_t	driver_version;
+	byte		uuid[VK_UUID_SIZE];	// VkPhysicalDeviceProperties.pipelineCacheUUID
+	uint32_t	data_size;
+	uint32_t	data_crc;
+} pipelinecacheheader_t;
+
+/*
+===============
+R_PipelineCachePath
+===============
+*/
+static void R_PipelineCachePath(char *path, size_t size)
+{
+	q_snprintf(path, size, "%s/pipelines.cache", host_parms->userdir);
+}
+
+/*
+===============
+R_PipelineCacheValid -- checks our header and the one vulkan puts in front of the data
+===============
+*/
+static qboolean R_PipelineCacheValid(const pipelinecacheheader_t *header, const byte *data)
+{
+	const VkPhysicalDeviceProperties *props = &vulkan_globals.device_properties;
+	uint32_t vk_header[4];
+
+	if (memcmp(header->id, "QPSO", 4) || header->version != PIPELINE_CACHE_VERSION)
+		return false;
+	if (header->vendor_id != props->vendorID || header->device_id != props->deviceID || header->driver_version != props->driverVersion)
+		return false;
+	if (memcmp(header->uuid, props->pipelineCacheUUID, VK_UUID_SIZE))
+		return false;
+	if (!data)
+		return header->data_size >= sizeof(vk_header) + VK_UUID_SIZE && header->data_size <= MAX_PIPELINE_CACHE_SIZE;
+
+	if (CRC32_Block(data, header->data_size) != header->data_crc)
+		return false;
+
+	// length, VK_PIPELINE_CACHE_HEADER_VERSION_ONE, vendor, device, uuid
+	memcpy(vk_header, data, sizeof(vk_header));
+	if (vk_header[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE || vk_header[2] != props->vendorID || vk_header[3] != props->deviceID)
+		return false;
+	return !memcmp(data + sizeof(vk_header), props->pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+/*
+===============
+R_CreatePipelineCache -- creates the cache, seeded from disk when possible
+===============
+*/
+void R_CreatePipelineCache()
+{
+	char path[MAX_OSPATH];
+	pipelinecacheheader_t header;
+	byte *data = NULL;
+	FILE *f;
+	VkResult err;
+
+	if (!COM_CheckParm("-nopipelinecache"))
+	{
+		R_PipelineCachePath(path, sizeof(path));
+		f = fopen(path, "rb");
+		if (f)
+		{
+			if (fread(&header, sizeof(header), 1, f) == 1 && R_PipelineCacheValid(&header, NULL))
+			{
+				data = (byte *) malloc(header.data_size);
+				if (!data || fread(data, header.data_size, 1, f) != 1 || !R_PipelineCacheValid(&header, data))
+				{
+					free(data);
+					data = NULL;
+				}
+			}
+			fclose(f);
+		}
+	}
+
+	VkPipelineCacheCreateInfo cache_create_info;
+	memset(&cache_create_info, 0, sizeof(cache_create_info));
+	cache_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	if (data)
+	{
+		cache_create_info.initialDataSize = header.data_size;
+		cache_create_info.pInitialData = data;
+	}
+
+	err = vkCreatePipelineCache(vulkan_globals.device, &cache_create_info, NULL, &vulkan_globals.pipeline_cache);
+	if (err != VK_SUCCESS && data)
+	{
+		// driver didn't like the data after all, start over empty
+		cache_create_info.initialDataSize = 0;
+		cache_create_info.pInitialData = NULL;
+		err = vkCreatePipelineCache(vulkan_globals.device, &cache_create_info, NULL, &vulkan_globals.pipeline_cache);
+	}
+	if (err != VK_SUCCESS)
+		vulkan_globals.pipeline_cache = VK_NULL_HANDLE;	// pipelines still work without one
+	else if (data)
+		Con_Printf("Loaded pipeline cache (%u KB)\n", header.data_size / 1024);
+
+	free(data);
+}
+
+/*
+===============
+R_SavePipelineCache -- failures are ignored, the cache is rebuilt next time
+===============
+*/
+static void R_SavePipelineCache(void)
+{
+	char path[MAX_OSPATH], temp[MAX_OSPATH + 8];
+	pipelinecacheheader_t header;
+	size_t size = 0;
+	byte *data;
+	qboolean ok;
+	FILE *f;
+
+	if (vulkan_globals.pipeline_cache == VK_NULL_HANDLE || COM_CheckParm("-nopipelinecache"))
+		return;
+
+	if (vkGetPipelineCacheData(vulkan_globals.device, vulkan_globals.pipeline_cache, &size, NULL) != VK_SUCCESS || size == 0 || size > MAX_PIPELINE_CACHE_SIZE)
+		return;
+	data = (byte *) malloc(size);
+	if (!data)
+		return;
+	if (vkGetPipelineCacheData(vulkan_globals.device, vulkan_globals.pipeline_cache, &size, data) != VK_SUCCESS)
+	{
+		free(data);
+		return;
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.id, "QPSO", 4);
+	header.version = PIPELINE_CACHE_VERSION;
+	header.vendor_id = vulkan_globals.device_properties.vendorID;
+	header.device_id = vulkan_globals.device_properties.deviceID;
+	header.driver_version = vulkan_globals.device_properties.driverVersion;
+	memcpy(header.uuid, vulkan_globals.device_properties.pipelineCacheUUID, VK_UUID_SIZE);
+	header.data_size = (uint32_t)size;
+	header.data_crc = CRC32_Block(data, (int)size);
+
+	// write under a name of its own, so a crash never leaves half a file behind
+	R_PipelineCachePath(path, sizeof(path));
+	q_snprintf(temp, sizeof(temp), "%s.tmp", path);
+	f = fopen(temp, "wb");
+	if (f)
+	{
+		ok = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(data, size, 1, f) == 1;
+		if (fclose(f) != 0)
+			ok = false;
+
+		if (ok && rename(temp, path) != 0)
+		{
+			remove(path);	// rename won't replace an existing file on windows
+			ok = rename(temp, path) == 0;
+		}
+		if (!ok)
+			remove(temp);
+	}
+
+	free(data);
+}
+
+/*
+===============================================================================
+
+PARALLEL PIPELINE CREATION
+
+R_CreatePipelines keeps editing one set of create info structs between
+pipelines, so every queued pipeline takes a deep copy of the state it points
+at.  The copies are then compiled on the task workers in one go.
+
+===============================================================================
+*/
+
+#define MAX_PIPELINE_JOBS			64
+#define MAX_JOB_STAGES				2
+#define MAX_JOB_SPEC_ENTRIES		8
+#define MAX_JOB_SPEC_DATA			64
+#define MAX_JOB_VERTEX_BINDINGS		4
+#define MAX_JOB_VERTEX_ATTRIBUTES	8
+#define MAX_JOB_DYNAMIC_STATES		8
+
+typedef struct
+{
+	VkGraphicsPipelineCreateInfo			create_info;
+	VkPipelineShaderStageCreateInfo			stages[MAX_JOB_STAGES];
+	VkSpecializationInfo					spec_info[MAX_JOB_STAGES];
+	VkSpecializationMapEntry				spec_entries[MAX_JOB_STAGES][MAX_JOB_SPEC_ENTRIES];
+	byte									spec_data[MAX_JOB_STAGES][MAX_JOB_SPEC_DATA];
+	VkPipelineVertexInputStateCreateInfo	vertex_input;
+	VkVertexInputBindingDescription			vertex_bindings[MAX_JOB_VERTEX_BINDINGS];
+	VkVertexInputAttributeDescription		vertex_attributes[MAX_JOB_VERTEX_ATTRIBUTES];
+	VkPipelineInputAssemblyStateCreateInfo	input_assembly;
+	VkPipelineViewportStateCreateInfo		viewport;
+	VkPipelineRasterizationStateCreateInfo	rasterization;
+	VkPipelineMultisampleStateCreateInfo	multisample;
+	VkPipelineDepthStencilStateCreateInfo	depth_stencil;
+	VkPipelineColorBlendStateCreateInfo		color_blend;
+	VkPipelineColorBlendAttachmentState		blend_attachment;
+	VkPipelineDynamicStateCreateInfo		dynamic;
+	VkDynamicState							dynamic_states[MAX_JOB_DYNAMIC_STATES];
+
+	VkPipeline								*pipeline;
+	VkResult								result;
+	char									name[32];
+} pipelinejob_t;
+
+static pipelinejob_t	pipeline_jobs[MAX_PIPELINE_JOBS];
+static int				num_pipeline_jobs;
+
+/*
+===============
+R_QueueGraphicsPipeline -- copies the create info, the pipeline is created by R_FlushPipelines
+===============
+*/
+static void R_QueueGraphicsPipeline(const VkGraphicsPipelineCreateInfo *info, VkPipeline *pipeline, const char *name)
+{
+	pipelinejob_t *job;
+	uint32_t i;
+
+	if (num_pipeline_jobs == MAX_PIPELINE_JOBS)
+		Sys_Error("R_QueueGraphicsPipeline: MAX_PIPELINE_JOBS");
+	if (info->stageCount > MAX_JOB_STAGES || info->pVertexInputState->vertexBindingDescriptionCount > MAX_JOB_VERTEX_BINDINGS
+		|| info->pVertexInputState->vertexAttributeDescriptionCount > MAX_JOB_VERTEX_ATTRIBUTES
+		|| info->pColorBlendState->attachmentCount > 1 || info->pDynamicState->dynamicStateCount > MAX_JOB_DYNAMIC_STATES)
+		Sys_Error("R_QueueGraphicsPipeline: %s has too much state", name);
+
+	job = &pipeline_jobs[num_pipeline_jobs++];
+	memset(job, 0, sizeof(*job));
+
+	job->create_info = *info;
+	for (i = 0; i < info->stageCount; ++i)
+	{
+		job->stages[i] = info->pStages[i];
+		if (info->pStages[i].pSpecializationInfo)
+		{
+			const VkSpecializationInfo *spec = info->pStages[i].pSpecializationInfo;
+			if (spec->mapEntryCount > MAX_JOB_SPEC_ENTRIES || spec->dataSize > MAX_JOB_SPEC_DATA)
+				Sys_Error("R_QueueGraphicsPipeline: %s has too many constants", name);
+			job->spec_info[i] = *spec;
+			memcpy(job->spec_entries[i], spec->pMapEntries, spec->mapEntryCount * sizeof(VkSpecializationMapEntry));
+			memcpy(job->spec_data[i], spec->pData, spec->dataSize);
+			job->spec_info[i].pMapEntries = job->spec_entries[i];
+			job->spec_info[i].pData = job->spec_data[i];
+			job->stages[i].pSpecializationInfo = &job->spec_info[i];
+		}
+	}
+	job->create_info.pStages = job->stages;
+
+	job->vertex_input = *info->pVertexInputState;
+	memcpy(job->vertex_bindings, info->pVertexInputState->pVertexBindingDescriptions, job->vertex_input.vertexBindingDescriptionCount * sizeof(VkVertexInputBindingDescription));
+	memcpy(job->vertex_attributes, info->pVertexInputState->pVertexAttributeDescriptions, job->vertex_input.vertexAttributeDescriptionCount * sizeof(VkVertexInputAttributeDescription));
+	job->vertex_input.pVertexBindingDescriptions = job->vertex_input.vertexBindingDescriptionCount ? job->vertex_bindings : NULL;
+	job->vertex_input.pVertexAttributeDescriptions = job->vertex_input.vertexAttributeDescriptionCount ? job->vertex_attributes : NULL;
+	job->create_info.pVertexInputState = &job->vertex_input;
+
+	job->input_assembly = *info->pInputAssemblyState;
+	job->create_info.pInputAssemblyState = &job->input_assembly;
+	job->viewport = *info->pViewportState;
+	job->create_info.pViewportState = &job->viewport;
+	job->rasterization = *info->pRasterizationState;
+	job->create_info.pRasterizationState = &job->rasterization;
+	job->multisample = *info->pMultisampleState;
+	job->create_info.pMultisampleState = &job->multisample;
+	job->depth_stencil = *info->pDepthStencilState;
+	job->create_info.pDepthStencilState = &job->depth_stencil;
+
+	job->color_blend = *info->pColorBlendState;
+	if (job->color_blend.attachmentCount)
+	{
+		job->blend_attachment = *info->pColorBlendState->pAttachments;
+		job->color_blend.pAttachments = &job->blend_attachment;
+	}
+	job->create_info.pColorBlendState = &job->color_blend;
+
+	job->dynamic = *info->pDynamicState;
+	memcpy(job->dynamic_states, info->pDynamicState->pDynamicStates, job->dynamic.dynamicStateCount * sizeof(VkDynamicState));
+	job->dynamic.pDynamicStates = job->dynamic_states;
+	job->create_info.pDynamicState = &job->dynamic;
+
+	job->pipeline = pipeline;
+	q_strlcpy(job->name, name, sizeof(job->name));
+}
+
+/*
+===============
+R_CreatePipelineTask -- runs on the task workers, vkCreateGraphicsPipelines is free threaded
+===============
+*/
+static void R_CreatePipelineTask(int index, void *data)
+{
+	pipelinejob_t *job = (pipelinejob_t *)data + index;
+	job->result = vkCreateGraphicsPipelines(vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &job->create_info, NULL, job->pipeline);
+}
+
+/*
+===============
+R_FlushPipelines -- creates all queued pipelines
+===============
+*/
+static void R_FlushPipelines(void)
+{
+	int i;
+
+	Tasks_ParallelFor(R_CreatePipelineTask, pipeline_jobs, num_pipeline_jobs);
+
+	for (i = 0; i < num_pipeline_jobs; ++i)
+	{
+		if (pipeline_jobs[i].result != VK_SUCCESS)
+			Sys_Error("vkCreateGraphicsPipelines failed (%s)", pipeline_jobs[i].name);
+		GL_SetObjectName((uint64_t)*pipeline_jobs[i].pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, pipeline_jobs[i].name);
+	}
+
+	num_pipeline_jobs = 0;
+}
+
 /*
 ===============
 R_CreatePipelines
@@ -1155,13 +1884,25 @@ void R_CreatePipelines()
 	VkShaderModule world_frag_module = R_CreateShaderModule(world_frag_spv, world_frag_spv_size);
 	VkShaderModule alias_vert_module = R_CreateShaderModule(alias_vert_spv, alias_vert_spv_size);
 	VkShaderModule alias_frag_module = R_CreateShaderModule(alias_frag_spv, alias_frag_spv_size);
+	VkShaderModule world_bindless_frag_module = VK_NULL_HANDLE;
+	VkShaderModule alias_bindless_frag_module = VK_NULL_HANDLE;
+	if (vulkan_globals.bindless)
+	{
+		world_bindless_frag_module = R_CreateShaderModule(world_bindless_frag_spv, world_bindless_frag_spv_size);
+		alias_bindless_frag_module = R_CreateShaderModule(alias_bindless_frag_spv, alias_bindless_frag_spv_size);
+	}
 	VkShaderModule sky_layer_vert_module = R_CreateShaderModule(sky_layer_vert_spv, sky_layer_vert_spv_size);
 	VkShaderModule sky_layer_frag_module = R_CreateShaderModule(sky_layer_frag_spv, sky_layer_frag_spv_size);
+	VkShaderModule sky_box_frag_module = R_CreateShaderModule(sky_box_frag_spv, sky_box_frag_spv_size);
 	VkShaderModule postprocess_vert_module = R_CreateShaderModule(postprocess_vert_spv, postprocess_vert_spv_size);
 	VkShaderModule postprocess_frag_module = R_CreateShaderModule(postprocess_frag_spv, postprocess_frag_spv_size);
 	VkShaderModule swapchain_vert_module = R_CreateShaderModule(swapchain_vert_spv, swapchain_vert_spv_size);
 	VkShaderModule swapchain_frag_module = R_CreateShaderModule(swapchain_frag_spv, swapchain_frag_spv_size);
 	VkShaderModule screen_warp_comp_module = R_CreateShaderModule(screen_warp_comp_spv, screen_warp_comp_spv_size);
+	VkShaderModule foveation_mask_frag_module = R_CreateShaderModule(foveation_mask_frag_spv, foveation_mask_frag_spv_size);
+	VkShaderModule foveation_fill_comp_module = R_CreateShaderModule(foveation_fill_comp_spv, foveation_fill_comp_spv_size);
+	VkShaderModule particle_vert_module = R_CreateShaderModule(particle_vert_spv, particle_vert_spv_size);
+	VkShaderModule particle_simulate_comp_module = R_CreateShaderModule(particle_simulate_comp_spv, particle_simulate_comp_spv_size);
 
 	VkPipelineDynamicStateCreateInfo dynamic_state_create_info;
 	memset(&dynamic_state_create_info, 0, sizeof(dynamic_state_create_info));
@@ -1222,6 +1963,26 @@ void R_CreatePipelines()
 	viewport_state_create_info.scissorCount = 1;
 	dynamic_states[dynamic_state_create_info.dynamicStateCount++] = VK_DYNAMIC_STATE_SCISSOR;
 
+	// Scene pipelines read the rate image bound by R_BeginFoveation, index 0 is full rate
+	VkShadingRatePaletteEntryNV shading_rate_palette_entries[3] = {
+		VK_SHADING_RATE_PALETTE_ENTRY_1_INVOCATION_PER_PIXEL_NV,
+		VK_SHADING_RATE_PALETTE_ENTRY_1_INVOCATION_PER_2X2_PIXELS_NV,
+		VK_SHADING_RATE_PALETTE_ENTRY_1_INVOCATION_PER_4X4_PIXELS_NV,
+	};
+	VkShadingRatePaletteNV shading_rate_palette;
+	shading_rate_palette.shadingRatePaletteEntryCount = 3;
+	shading_rate_palette.pShadingRatePaletteEntries = shading_rate_palette_entries;
+
+	VkPipelineViewportShadingRateImageStateCreateInfoNV shading_rate_state_create_info;
+	memset(&shading_rate_state_create_info, 0, sizeof(shading_rate_state_create_info));
+	shading_rate_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_SHADING_RATE_IMAGE_STATE_CREATE_INFO_NV;
+	shading_rate_state_create_info.shadingRateImageEnable = VK_TRUE;
+	shading_rate_state_create_info.viewportCount = 1;
+	shading_rate_state_create_info.pShadingRatePalettes = &shading_rate_palette;
+
+	void *scene_viewport_state_next = vulkan_globals.shading_rate_image ? &shading_rate_state_create_info : NULL;
+	viewport_state_create_info.pNext = scene_viewport_state_next;
+
 	VkPipelineRasterizationStateCreateInfo rasterization_state_create_info;
 	memset(&rasterization_state_create_info, 0, sizeof(rasterization_state_create_info));
 	rasterization_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -1289,11 +2050,29 @@ void R_CreatePipelines()
 
 	pipeline_create_info.renderPass = vulkan_globals.main_render_pass;
 
-	err = vkCreateGraphicsPipelines(vulkan_globals.device, VK_NULL_HANDLE, 1, &pipeline_create_info, NULL, &vulkan_globals.hidden_area_mesh_pipeline);
-	if (err != VK_SUCCESS)
-		Sys_Error("vkCreateGraphicsPipelines failed");
+	R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.hidden_area_mesh_pipeline, "hidden_area_mesh");
+
+	//================
+	// Foveation mask
+	//================
+	// Depth only, the fragment shader discards the pixels that are shaded
+	VkPipelineVertexInputStateCreateInfo no_vertex_input_state_create_info;
+	memset(&no_vertex_input_state_create_info, 0, sizeof(no_vertex_input_state_create_info));
+	no_vertex_input_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-	GL_SetObjectName((uint64_t)vulkan_globals.hidden_area_mesh_pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "hidden_area_mesh");
+	shader_stages[0].module = postprocess_vert_module;
+	shader_stages[1].module = foveation_mask_frag_module;
+	pipeline_create_info.pVertexInputState = &no_vertex_input_state_create_info;
+	depth_stencil_state_create_info.depthCompareOp = VK_COMPARE_OP_ALWAYS;
+	blend_attachment_state.colorWriteMask = 0;
+
+	R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.foveation_mask_pipeline, "foveation_mask");
+
+	shader_stages[0].module = basic_vert_module;
+	shader_stages[1].module = basic_notex_frag_module;
+	pipeline_create_info.pVertexInputState = &vertex_input_state_create_info;
+	depth_stencil_state_create_info.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+	blend_attachment_state.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
 
 	//================
 	// Basic pipelines
@@ -1308,12 +2087,9 @@ void R_CreatePipelines()
 	{
 		pipeline_create_info.renderPass = (render_pass == 0) ? vulkan_globals.main_render_pass : vulkan_globals.ui_render_pass;
 		multisample_state_create_info.rasterizationSamples = (render_pass == 0) ? vulkan_globals.sample_count : VK_SAMPLE_COUNT_1_BIT;
+		viewport_state_create_info.pNext = (render_pass == 0) ? scene_viewport_state_next : NULL;
 
-		err = vkCreateGraphicsPipelines(vulkan_globals.device, VK_NULL_HANDLE, 1, &pipeline_create_info, NULL, &vulkan_globals.basic_alphatest_pipeline[render_pass]);
-		if (err != VK_SUCCESS)
-			Sys_Error("vkCreateGraphicsPipelines failed");
-
-		GL_SetObjectName((uint64_t)vulkan_globals.basic_alphatest_pipeline[render_pass], VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "basic_alphatest");
+		R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.basic_alphatest_pipeline[render_pass], "basic_alphatest");
 	}
 
 	shader_stages[1].module = basic_notex_frag_module;
@@ -1330,25 +2106,19 @@ void R_CreatePipelines()
 	{
 		pipeline_create_info.renderPass = (render_pass == 0) ? vulkan_globals.main_render_pass : vulkan_globals.ui_render_pass;
 		multisample_state_create_info.rasterizationSamples = (render_pass == 0) ? vulkan_globals.sample_count : VK_SAMPLE_COUNT_1_BIT;
+		viewport_state_create_info.pNext = (render_pass == 0) ? scene_viewport_state_next : NULL;
 
-		err = vkCreateGraphicsPipelines(vulkan_globals.device, VK_NULL_HANDLE, 1, &pipeline_create_info, NULL, &vulkan_globals.basic_notex_blend_pipeline[render_pass]);
-		if (err != VK_SUCCESS)
-			Sys_Error("vkCreateGraphicsPipelines failed");
-
-		GL_SetObjectName((uint64_t)vulkan_globals.basic_notex_blend_pipeline[render_pass], VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "basic_notex_blend");
+		R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.basic_notex_blend_pipeline[render_pass], "basic_notex_blend");
 	}
 
 	pipeline_create_info.renderPass = vulkan_globals.main_render_pass;
 	pipeline_create_info.subpass = 0;
 	multisample_state_create_info.rasterizationSamples = vulkan_globals.sample_count;
+	viewport_state_create_info.pNext = scene_viewport_state_next;
 
 	input_assembly_state_create_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN;
 
-	err = vkCreateGraphicsPipelines(vulkan_globals.device, VK_NULL_HANDLE, 1, &pipeline_create_info, NULL, &vulkan_globals.basic_poly_blend_pipeline);
-	if (err != VK_SUCCESS)
-		Sys_Error("vkCreateGraphicsPipelines failed");
-
-	GL_SetObjectName((uint64_t)vulkan_globals.basic_poly_blend_pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "basic_poly_blend");
+	R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.basic_poly_blend_pipeline, "basic_poly_blend");
 
 	input_assembly_state_create_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 
@@ -1358,35 +2128,13 @@ void R_CreatePipelines()
 	{
 		pipeline_create_info.renderPass = (render_pass == 0) ? vulkan_globals.main_render_pass : vulkan_globals.ui_render_pass;
 		multisample_state_create_info.rasterizationSamples = (render_pass == 0) ? vulkan_globals.sample_count : VK_SAMPLE_COUNT_1_BIT;
+		viewport_state_create_info.pNext = (render_pass == 0) ? scene_viewport_state_next : NULL;
 
-		err = vkCreateGraphicsPipelines(vulkan_globals.device, VK_NULL_HANDLE, 1, &pipeline_create_info, NULL, &vulkan_globals.basic_blend_pipeline[render_pass]);
-		if (err != VK_SUCCESS)
-			Sys_Error("vkCreateGraphicsPipelines failed");
-
-		GL_SetObjectName((uint64_t)vulkan_globals.basic_blend_pipeline[render_pass], VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "basic_blend");
+		R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.basic_blend_pipeline[render_pass], "basic_blend");
 	}
 
 	multisample_state_create_info.rasterizationSamples = vulkan_globals.sample_count;
-
-	//================
-	// Warp
-	//================
-	multisample_state_create_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-
-	input_assembly_state_create_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
-
-	blend_attachment_state.blendEnable = VK_FALSE;
-
-	shader_stages[0].module = basic_vert_module;
-	shader_stages[1].module = basic_frag_module;
-
-	pipeline_create_info.renderPass = vulkan_globals.warp_render_pass;
-
-	err = vkCreateGraphicsPipelines(vulkan_globals.device, VK_NULL_HANDLE, 1, &pipeline_create_info, NULL, &vulkan_globals.warp_pipeline);
-	if (err != VK_SUCCESS)
-		Sys_Error("vkCreateGraphicsPipelines failed");
-
-	GL_SetObjectName((uint64_t)vulkan_globals.warp_pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "warp");
+	viewport_state_create_info.pNext = scene_viewport_state_next;
 
 	//================
 	// Particles
@@ -1402,115 +2150,42 @@ void R_CreatePipelines()
 
 	blend_attachment_state.blendEnable = VK_TRUE;
 
-	err = vkCreateGraphicsPipelines(vulkan_globals.device, VK_NULL_HANDLE, 1, &pipeline_create_info, NULL, &vulkan_globals.particle_pipeline);
-	if (err != VK_SUCCESS)
-		Sys_Error("vkCreateGraphicsPipelines failed");
+	R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.particle_pipeline, "particle");
 
-	//================
-	// Water
-	//================
-	input_assembly_state_create_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN;
-	depth_stencil_state_create_info.depthTestEnable = VK_TRUE;
-	depth_stencil_state_create_info.depthWriteEnable = VK_TRUE;
-	depth_stencil_state_create_info.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
-	blend_attachment_state.blendEnable = VK_FALSE;
+	// No vertex input, particle.vert fetches the particle by instance index
+	VkPipelineVertexInputStateCreateInfo empty_vertex_input_state_create_info;
+	memset(&empty_vertex_input_state_create_info, 0, sizeof(empty_vertex_input_state_create_info));
+	empty_vertex_input_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-	err = vkCreateGraphicsPipelines(vulkan_globals.device, VK_NULL_HANDLE, 1, &pipeline_create_info, NULL, &vulkan_globals.water_pipeline);
-	if (err != VK_SUCCESS)
-		Sys_Error("vkCreateGraphicsPipelines failed");
+	shader_stages[0].module = particle_vert_module;
+	pipeline_create_info.pVertexInputState = &empty_vertex_input_state_create_info;
+	pipeline_create_info.layout = vulkan_globals.gpu_particle_pipeline_layout;
 
-	GL_SetObjectName((uint64_t)vulkan_globals.water_pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "water");
+	R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.gpu_particle_pipeline, "gpu_particle");
 
-	depth_stencil_state_create_info.depthWriteEnable = VK_FALSE;
-	blend_attachment_state.blendEnable = VK_TRUE;
-
-	err = vkCreateGraphicsPipelines(vulkan_globals.device, VK_NULL_HANDLE, 1, &pipeline_create_info, NULL, &vulkan_globals.water_blend_pipeline);
-	if (err != VK_SUCCESS)
-		Sys_Error("vkCreateGraphicsPipelines failed");
+	shader_stages[0].module = basic_vert_module;
+	pipeline_create_info.pVertexInputState = &vertex_input_state_create_info;
+	pipeline_create_info.layout = vulkan_globals.basic_pipeline_layout;
 
-	GL_SetObjectName((uint64_t)vulkan_globals.water_blend_pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "water_blend");
-	
 	//================
 	// Sprites
 	//================
+	input_assembly_state_create_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN;
+	depth_stencil_state_create_info.depthTestEnable = VK_TRUE;
+	depth_stencil_state_create_info.depthWriteEnable = VK_FALSE;
+	depth_stencil_state_create_info.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
 	shader_stages[1].module = basic_alphatest_frag_module;
 	blend_attachment_state.blendEnable = VK_FALSE;
 
 	dynamic_states[dynamic_state_create_info.dynamicStateCount++] = VK_DYNAMIC_STATE_DEPTH_BIAS;
 
-	err = vkCreateGraphicsPipelines(vulkan_globals.device, VK_NULL_HANDLE, 1, &pipeline_create_info, NULL, &vulkan_globals.sprite_pipeline);
-	if (err != VK_SUCCESS)
-		Sys_Error("vkCreateGraphicsPipelines failed");
-
-	GL_SetObjectName((uint64_t)vulkan_globals.sprite_pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "sprite");
+	R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.sprite_pipeline, "sprite");
 
 	dynamic_state_create_info.dynamicStateCount--;
 
-	//================
-	// Sky
-	//================
 	pipeline_create_info.renderPass = vulkan_globals.main_render_pass;
 
-	shader_stages[1].module = basic_notex_frag_module;
-
-	depth_stencil_state_create_info.depthTestEnable = VK_TRUE;
-	depth_stencil_state_create_info.depthWriteEnable = VK_FALSE;
-	depth_stencil_state_create_info.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
-
-	err = vkCreateGraphicsPipelines(vulkan_globals.device, VK_NULL_HANDLE, 1, &pipeline_create_info, NULL, &vulkan_globals.sky_color_pipeline);
-	if (err != VK_SUCCESS)
-		Sys_Error("vkCreateGraphicsPipelines failed");
-
-	GL_SetObjectName((uint64_t)vulkan_globals.sky_color_pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "sky_color");
-
-	shader_stages[1].module = basic_frag_module;
-
-	err = vkCreateGraphicsPipelines(vulkan_globals.device, VK_NULL_HANDLE, 1, &pipeline_create_info, NULL, &vulkan_globals.sky_box_pipeline);
-	if (err != VK_SUCCESS)
-		Sys_Error("vkCreateGraphicsPipelines failed");
-
-	GL_SetObjectName((uint64_t)vulkan_globals.sky_box_pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "sky_box");
-
-	VkVertexInputAttributeDescription sky_layer_vertex_input_attribute_descriptions[4];
-	sky_layer_vertex_input_attribute_descriptions[0].binding = 0;
-	sky_layer_vertex_input_attribute_descriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-	sky_layer_vertex_input_attribute_descriptions[0].location = 0;
-	sky_layer_vertex_input_attribute_descriptions[0].offset = 0;
-	sky_layer_vertex_input_attribute_descriptions[1].binding = 0;
-	sky_layer_vertex_input_attribute_descriptions[1].format = VK_FORMAT_R32G32_SFLOAT;
-	sky_layer_vertex_input_attribute_descriptions[1].location = 1;
-	sky_layer_vertex_input_attribute_descriptions[1].offset = 12;
-	sky_layer_vertex_input_attribute_descriptions[2].binding = 0;
-	sky_layer_vertex_input_attribute_descriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-	sky_layer_vertex_input_attribute_descriptions[2].location = 2;
-	sky_layer_vertex_input_attribute_descriptions[2].offset = 20;
-	sky_layer_vertex_input_attribute_descriptions[3].binding = 0;
-	sky_layer_vertex_input_attribute_descriptions[3].format = VK_FORMAT_R8G8B8A8_UNORM;
-	sky_layer_vertex_input_attribute_descriptions[3].location = 3;
-	sky_layer_vertex_input_attribute_descriptions[3].offset = 28;
-
-	VkVertexInputBindingDescription sky_layer_vertex_binding_description;
-	sky_layer_vertex_binding_description.binding = 0;
-	sky_layer_vertex_binding_description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-	sky_layer_vertex_binding_description.stride = 32;
-
-	vertex_input_state_create_info.vertexAttributeDescriptionCount = 4;
-	vertex_input_state_create_info.pVertexAttributeDescriptions = sky_layer_vertex_input_attribute_descriptions;
-	vertex_input_state_create_info.vertexBindingDescriptionCount = 1;
-	vertex_input_state_create_info.pVertexBindingDescriptions = &sky_layer_vertex_binding_description;
-
-	shader_stages[0].module = sky_layer_vert_module;
-	shader_stages[1].module = sky_layer_frag_module;
-	blend_attachment_state.blendEnable = VK_FALSE;
-
-	pipeline_create_info.layout = vulkan_globals.sky_layer_pipeline_layout;
-
-	err = vkCreateGraphicsPipelines(vulkan_globals.device, VK_NULL_HANDLE, 1, &pipeline_create_info, NULL, &vulkan_globals.sky_layer_pipeline);
-	if (err != VK_SUCCESS)
-		Sys_Error("vkCreateGraphicsPipelines failed");
-
-	GL_SetObjectName((uint64_t)vulkan_globals.sky_layer_pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "sky_layer");
-
 	//================
 	// World pipelines
 	//================
@@ -1544,7 +2219,7 @@ void R_CreatePipelines()
 	vertex_input_state_create_info.vertexBindingDescriptionCount = 1;
 	vertex_input_state_create_info.pVertexBindingDescriptions = &world_vertex_binding_description;
 
-	VkSpecializationMapEntry specialization_entries[3];
+	VkSpecializationMapEntry specialization_entries[4];
 	specialization_entries[0].constantID = 0;
 	specialization_entries[0].offset = 0;
 	specialization_entries[0].size = 4;
@@ -1554,16 +2229,20 @@ void R_CreatePipelines()
 	specialization_entries[2].constantID = 2;
 	specialization_entries[2].offset = 8;
 	specialization_entries[2].size = 4;
+	specialization_entries[3].constantID = 3;
+	specialization_entries[3].offset = 12;
+	specialization_entries[3].size = 4;
 
-	uint32_t specialization_data[3];
+	uint32_t specialization_data[4];
 	specialization_data[0] = 0;
 	specialization_data[1] = 0;
 	specialization_data[2] = 0;
+	specialization_data[3] = 0;
 
 	VkSpecializationInfo specialization_info;
-	specialization_info.mapEntryCount = 3;
+	specialization_info.mapEntryCount = 4;
 	specialization_info.pMapEntries = specialization_entries;
-	specialization_info.dataSize = 12;
+	specialization_info.dataSize = 16;
 	specialization_info.pData = specialization_data;
 	
 	pipeline_create_info.layout = vulkan_globals.world_pipeline_layout;
@@ -1583,57 +2262,83 @@ void R_CreatePipelines()
 
 				blend_attachment_state.blendEnable = alpha_blend ? VK_TRUE : VK_FALSE;
 
-				err = vkCreateGraphicsPipelines(vulkan_globals.device, VK_NULL_HANDLE, 1, &pipeline_create_info, NULL, &vulkan_globals.world_pipelines[pipeline_index]);
-				if (err != VK_SUCCESS)
-					Sys_Error("vkCreateGraphicsPipelines failed");
+				R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.world_pipelines[pipeline_index], va("world %d", pipeline_index));
+
+				if (vulkan_globals.bindless)
+				{
+					pipeline_create_info.layout = vulkan_globals.world_bindless_pipeline_layout;
+					shader_stages[1].module = world_bindless_frag_module;
+
+					R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.world_bindless_pipelines[pipeline_index], va("world_bindless %d", pipeline_index));
 
-				GL_SetObjectName((uint64_t)vulkan_globals.world_pipelines[pipeline_index], VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, va("world %d", pipeline_index));
+					pipeline_create_info.layout = vulkan_globals.world_pipeline_layout;
+					shader_stages[1].module = world_frag_module;
+				}
 			}
 		}
 	}
 
+	//================
+	// Water
+	//================
+	// world.frag with the turbulent warp instead of the lightmap, no warp images to render
+	specialization_data[0] = 0;
+	specialization_data[1] = 0;
+	specialization_data[2] = 0;
+	specialization_data[3] = 1;
+
+	blend_attachment_state.blendEnable = VK_FALSE;
+
+	R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.water_pipeline, "water");
+
+	specialization_data[2] = 1;
+
+	depth_stencil_state_create_info.depthWriteEnable = VK_FALSE;
+	blend_attachment_state.blendEnable = VK_TRUE;
+
+	R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.water_blend_pipeline, "water_blend");
+
+	depth_stencil_state_create_info.depthWriteEnable = VK_TRUE;
 	blend_attachment_state.blendEnable = VK_FALSE;
 	shader_stages[1].pSpecializationInfo = NULL;
 
+	//================
+	// Sky
+	//================
+	// Sky surfs straight from the world vertex buffer, the shaders only need the position
+	depth_stencil_state_create_info.depthWriteEnable = VK_FALSE;
+
+	shader_stages[0].module = sky_layer_vert_module;
+	shader_stages[1].module = sky_layer_frag_module;
+	pipeline_create_info.layout = vulkan_globals.sky_layer_pipeline_layout;
+
+	R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.sky_layer_pipeline, "sky_layer");
+
+	shader_stages[1].module = sky_box_frag_module;
+	pipeline_create_info.layout = vulkan_globals.sky_box_pipeline_layout;
+
+	R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.sky_box_pipeline, "sky_box");
+
+	depth_stencil_state_create_info.depthWriteEnable = VK_TRUE;
+
 	//================
 	// Alias pipeline
 	//================
-	VkVertexInputAttributeDescription alias_vertex_input_attribute_descriptions[5];
+	// Only the texture coordinates are vertex attributes, alias.vert fetches the poses from a storage buffer
+	VkVertexInputAttributeDescription alias_vertex_input_attribute_descriptions[1];
 	alias_vertex_input_attribute_descriptions[0].binding = 0;
 	alias_vertex_input_attribute_descriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
 	alias_vertex_input_attribute_descriptions[0].location = 0;
 	alias_vertex_input_attribute_descriptions[0].offset = 0;
-	alias_vertex_input_attribute_descriptions[1].binding = 1;
-	alias_vertex_input_attribute_descriptions[1].format = VK_FORMAT_R8G8B8A8_USCALED;
-	alias_vertex_input_attribute_descriptions[1].location = 1;
-	alias_vertex_input_attribute_descriptions[1].offset = 0;
-	alias_vertex_input_attribute_descriptions[2].binding = 1;
-	alias_vertex_input_attribute_descriptions[2].format = VK_FORMAT_R8G8B8A8_SNORM;
-	alias_vertex_input_attribute_descriptions[2].location = 2;
-	alias_vertex_input_attribute_descriptions[2].offset = 4;
-	alias_vertex_input_attribute_descriptions[3].binding = 2;
-	alias_vertex_input_attribute_descriptions[3].format = VK_FORMAT_R8G8B8A8_USCALED;
-	alias_vertex_input_attribute_descriptions[3].location = 3;
-	alias_vertex_input_attribute_descriptions[3].offset = 0;
-	alias_vertex_input_attribute_descriptions[4].binding = 2;
-	alias_vertex_input_attribute_descriptions[4].format = VK_FORMAT_R8G8B8A8_SNORM;
-	alias_vertex_input_attribute_descriptions[4].location = 4;
-	alias_vertex_input_attribute_descriptions[4].offset = 4;
-
-	VkVertexInputBindingDescription alias_vertex_binding_descriptions[3];
+
+	VkVertexInputBindingDescription alias_vertex_binding_descriptions[1];
 	alias_vertex_binding_descriptions[0].binding = 0;
 	alias_vertex_binding_descriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 	alias_vertex_binding_descriptions[0].stride = 8;
-	alias_vertex_binding_descriptions[1].binding = 1;
-	alias_vertex_binding_descriptions[1].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-	alias_vertex_binding_descriptions[1].stride = 8;
-	alias_vertex_binding_descriptions[2].binding = 2;
-	alias_vertex_binding_descriptions[2].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-	alias_vertex_binding_descriptions[2].stride = 8;
-
-	vertex_input_state_create_info.vertexAttributeDescriptionCount = 5;
+
+	vertex_input_state_create_info.vertexAttributeDescriptionCount = 1;
 	vertex_input_state_create_info.pVertexAttributeDescriptions = alias_vertex_input_attribute_descriptions;
-	vertex_input_state_create_info.vertexBindingDescriptionCount = 3;
+	vertex_input_state_create_info.vertexBindingDescriptionCount = 1;
 	vertex_input_state_create_info.pVertexBindingDescriptions = alias_vertex_binding_descriptions;
 
 	shader_stages[0].module = alias_vert_module;
@@ -1641,24 +2346,39 @@ void R_CreatePipelines()
 
 	pipeline_create_info.layout = vulkan_globals.alias_pipeline_layout;
 
-	err = vkCreateGraphicsPipelines(vulkan_globals.device, VK_NULL_HANDLE, 1, &pipeline_create_info, NULL, &vulkan_globals.alias_pipeline);
-	if (err != VK_SUCCESS)
-		Sys_Error("vkCreateGraphicsPipelines failed");
+	R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.alias_pipeline, "alias");
+
+	if (vulkan_globals.bindless)
+	{
+		shader_stages[1].module = alias_bindless_frag_module;
+		pipeline_create_info.layout = vulkan_globals.alias_bindless_pipeline_layout;
+
+		R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.alias_bindless_pipeline, "alias_bindless");
 
-	GL_SetObjectName((uint64_t)vulkan_globals.alias_pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "alias");
+		shader_stages[1].module = alias_frag_module;
+		pipeline_create_info.layout = vulkan_globals.alias_pipeline_layout;
+	}
 
 	depth_stencil_state_create_info.depthWriteEnable = VK_FALSE;
 	blend_attachment_state.blendEnable = VK_TRUE;
 
-	err = vkCreateGraphicsPipelines(vulkan_globals.device, VK_NULL_HANDLE, 1, &pipeline_create_info, NULL, &vulkan_globals.alias_blend_pipeline);
-	if (err != VK_SUCCESS)
-		Sys_Error("vkCreateGraphicsPipelines failed");
+	R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.alias_blend_pipeline, "alias_blend");
+
+	if (vulkan_globals.bindless)
+	{
+		shader_stages[1].module = alias_bindless_frag_module;
+		pipeline_create_info.layout = vulkan_globals.alias_bindless_pipeline_layout;
 
-	GL_SetObjectName((uint64_t)vulkan_globals.alias_blend_pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "alias_blend");
+		R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.alias_bindless_blend_pipeline, "alias_bindless_blend");
+
+		shader_stages[1].module = alias_frag_module;
+		pipeline_create_info.layout = vulkan_globals.alias_pipeline_layout;
+	}
 
 	//================
 	// Postprocess pipeline
 	//================
+	viewport_state_create_info.pNext = NULL;
 	multisample_state_create_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
 	rasterization_state_create_info.cullMode = VK_CULL_MODE_NONE;
 	depth_stencil_state_create_info.depthTestEnable = VK_FALSE;
@@ -1675,11 +2395,7 @@ void R_CreatePipelines()
 	pipeline_create_info.layout = vulkan_globals.postprocess_pipeline_layout;
 	pipeline_create_info.subpass = 1;
 
-	err = vkCreateGraphicsPipelines(vulkan_globals.device, VK_NULL_HANDLE, 1, &pipeline_create_info, NULL, &vulkan_globals.postprocess_pipeline);
-	if (err != VK_SUCCESS)
-		Sys_Error("vkCreateGraphicsPipelines failed");
-
-	GL_SetObjectName((uint64_t)vulkan_globals.postprocess_pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "postprocess");
+	R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.postprocess_pipeline, "postprocess");
 
 	//================
 	// Swap chain pipeline
@@ -1700,11 +2416,9 @@ void R_CreatePipelines()
 	pipeline_create_info.layout = vulkan_globals.swapchain_pipeline_layout;
 	pipeline_create_info.subpass = 0;
 
-	err = vkCreateGraphicsPipelines(vulkan_globals.device, VK_NULL_HANDLE, 1, &pipeline_create_info, NULL, &vulkan_globals.swapchain_pipeline);
-	if (err != VK_SUCCESS)
-		Sys_Error("vkCreateGraphicsPipelines failed");
+	R_QueueGraphicsPipeline(&pipeline_create_info, &vulkan_globals.swapchain_pipeline, "swapchain");
 
-	GL_SetObjectName((uint64_t)vulkan_globals.swapchain_pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "swapchain");
+	R_FlushPipelines();
 
 	//================
 	// Screen Warp
@@ -1723,19 +2437,55 @@ void R_CreatePipelines()
 	compute_pipeline_create_info.stage = compute_shader_stage;
 	compute_pipeline_create_info.layout = vulkan_globals.screen_warp_pipeline_layout;
 
-	err = vkCreateComputePipelines(vulkan_globals.device, VK_NULL_HANDLE, 1, &compute_pipeline_create_info, NULL, &vulkan_globals.screen_warp_pipeline);
+	err = vkCreateComputePipelines(vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &compute_pipeline_create_info, NULL, &vulkan_globals.screen_warp_pipeline);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkCreateComputePipelines failed");
+
+	GL_SetObjectName((uint64_t)vulkan_globals.screen_warp_pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "screen_warp");
+
+	//================
+	// Foveation fill
+	//================
+	compute_shader_stage.module = foveation_fill_comp_module;
+	compute_pipeline_create_info.stage = compute_shader_stage;
+	compute_pipeline_create_info.layout = vulkan_globals.foveation_fill_pipeline_layout;
+
+	err = vkCreateComputePipelines(vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &compute_pipeline_create_info, NULL, &vulkan_globals.foveation_fill_pipeline);
 	if (err != VK_SUCCESS)
-		Sys_Error("vkCreateGraphicsPipelines failed");
+		Sys_Error("vkCreateComputePipelines failed");
 
-	GL_SetObjectName((uint64_t)vulkan_globals.warp_pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "screen_warp");
+	GL_SetObjectName((uint64_t)vulkan_globals.foveation_fill_pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "foveation_fill");
 
+	//================
+	// Particle simulation
+	//================
+	compute_shader_stage.module = particle_simulate_comp_module;
+	compute_pipeline_create_info.stage = compute_shader_stage;
+	compute_pipeline_create_info.layout = vulkan_globals.particle_simulate_pipeline_layout;
+
+	err = vkCreateComputePipelines(vulkan_globals.device, vulkan_globals.pipeline_cache, 1, &compute_pipeline_create_info, NULL, &vulkan_globals.particle_simulate_pipeline);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkCreateComputePipelines failed");
+
+	GL_SetObjectName((uint64_t)vulkan_globals.particle_simulate_pipeline, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT, "particle_simulate");
+
+	R_SavePipelineCache();
+
+	vkDestroyShaderModule(vulkan_globals.device, particle_simulate_comp_module, NULL);
+	vkDestroyShaderModule(vulkan_globals.device, particle_vert_module, NULL);
+
+	vkDestroyShaderModule(vulkan_globals.device, foveation_fill_comp_module, NULL);
+	vkDestroyShaderModule(vulkan_globals.device, foveation_mask_frag_module, NULL);
 	vkDestroyShaderModule(vulkan_globals.device, screen_warp_comp_module, NULL);
 	vkDestroyShaderModule(vulkan_globals.device, postprocess_frag_module, NULL);
 	vkDestroyShaderModule(vulkan_globals.device, postprocess_vert_module, NULL);
 	vkDestroyShaderModule(vulkan_globals.device, swapchain_frag_module, NULL);
 	vkDestroyShaderModule(vulkan_globals.device, swapchain_vert_module, NULL);
 	vkDestroyShaderModule(vulkan_globals.device, sky_layer_frag_module, NULL);
+	vkDestroyShaderModule(vulkan_globals.device, sky_box_frag_module, NULL);
 	vkDestroyShaderModule(vulkan_globals.device, sky_layer_vert_module, NULL);
+	vkDestroyShaderModule(vulkan_globals.device, alias_bindless_frag_module, NULL);
+	vkDestroyShaderModule(vulkan_globals.device, world_bindless_frag_module, NULL);
 	vkDestroyShaderModule(vulkan_globals.device, alias_frag_module, NULL);
 	vkDestroyShaderModule(vulkan_globals.device, alias_vert_module, NULL);
 	vkDestroyShaderModule(vulkan_globals.device, world_frag_module, NULL);
@@ -1762,20 +2512,30 @@ void R_DestroyPipelines(void)
 	}
 	vkDestroyPipeline(vulkan_globals.device, vulkan_globals.basic_poly_blend_pipeline, NULL);
 	for (i = 0; i < WORLD_PIPELINE_COUNT; ++i)
+	{
 		vkDestroyPipeline(vulkan_globals.device, vulkan_globals.world_pipelines[i], NULL);
+		vkDestroyPipeline(vulkan_globals.device, vulkan_globals.world_bindless_pipelines[i], NULL);
+		vulkan_globals.world_bindless_pipelines[i] = VK_NULL_HANDLE;
+	}
 	vkDestroyPipeline(vulkan_globals.device, vulkan_globals.water_pipeline, NULL);
 	vkDestroyPipeline(vulkan_globals.device, vulkan_globals.water_blend_pipeline, NULL);
-	vkDestroyPipeline(vulkan_globals.device, vulkan_globals.warp_pipeline, NULL);
 	vkDestroyPipeline(vulkan_globals.device, vulkan_globals.particle_pipeline, NULL);
+	vkDestroyPipeline(vulkan_globals.device, vulkan_globals.gpu_particle_pipeline, NULL);
+	vkDestroyPipeline(vulkan_globals.device, vulkan_globals.particle_simulate_pipeline, NULL);
 	vkDestroyPipeline(vulkan_globals.device, vulkan_globals.sprite_pipeline, NULL);
-	vkDestroyPipeline(vulkan_globals.device, vulkan_globals.sky_color_pipeline, NULL);
 	vkDestroyPipeline(vulkan_globals.device, vulkan_globals.sky_box_pipeline, NULL);
 	vkDestroyPipeline(vulkan_globals.device, vulkan_globals.sky_layer_pipeline, NULL);
 	vkDestroyPipeline(vulkan_globals.device, vulkan_globals.alias_pipeline, NULL);
 	vkDestroyPipeline(vulkan_globals.device, vulkan_globals.alias_blend_pipeline, NULL);
+	vkDestroyPipeline(vulkan_globals.device, vulkan_globals.alias_bindless_pipeline, NULL);
+	vkDestroyPipeline(vulkan_globals.device, vulkan_globals.alias_bindless_blend_pipeline, NULL);
+	vulkan_globals.alias_bindless_pipeline = VK_NULL_HANDLE;
+	vulkan_globals.alias_bindless_blend_pipeline = VK_NULL_HANDLE;
 	vkDestroyPipeline(vulkan_globals.device, vulkan_globals.postprocess_pipeline, NULL);
 	vkDestroyPipeline(vulkan_globals.device, vulkan_globals.swapchain_pipeline, NULL);
 	vkDestroyPipeline(vulkan_globals.device, vulkan_globals.hidden_area_mesh_pipeline, NULL);
+	vkDestroyPipeline(vulkan_globals.device, vulkan_globals.foveation_mask_pipeline, NULL);
+	vkDestroyPipeline(vulkan_globals.device, vulkan_globals.foveation_fill_pipeline, NULL);
 }
 
 /*
@@ -1789,6 +2549,9 @@ void R_Init (void)
 
 	Cmd_AddCommand ("timerefresh", R_TimeRefresh_f);
 	Cmd_AddCommand ("pointfile", R_ReadPointFile_f);
+#ifdef PARTICLECHECK
+	Cmd_AddCommand ("r_particlecheck", R_ParticleCheck_f);
+#endif
 	Cmd_AddCommand ("vkmemstats", R_VulkanMemStats_f);
 
 	Cvar_RegisterVariable (&r_norefresh);
@@ -1802,6 +2565,9 @@ void R_Init (void)
 	Cvar_RegisterVariable (&r_dynamic);
 	Cvar_RegisterVariable (&r_novis);
 	Cvar_SetCallback (&r_novis, R_VisChanged);
+	Cvar_RegisterVariable (&r_latepose);
+	Cvar_RegisterVariable (&r_lateposemargin);
+	Cvar_RegisterVariable (&r_hiddenareacull);
 	Cvar_RegisterVariable (&r_speeds);
 	Cvar_RegisterVariable (&r_pos);
 
@@ -1817,7 +2583,6 @@ void R_Init (void)
 	//johnfitz -- new cvars
 	Cvar_RegisterVariable (&r_clearcolor);
 	Cvar_SetCallback (&r_clearcolor, R_SetClearColor_f);
-	Cvar_RegisterVariable (&r_waterquality);
 	Cvar_RegisterVariable (&r_waterwarp);
 	Cvar_RegisterVariable (&r_drawflat);
 	Cvar_RegisterVariable (&r_flatlightstyles);
@@ -2013,7 +2778,6 @@ void R_NewMap (void)
 	Fog_NewMap (); //johnfitz -- global fog in worldspawn
 	R_ParseWorldspawn (); //ericw -- wateralpha, lavaalpha, telealpha, slimealpha in worldspawn
 
-	load_subdivide_size = gl_subdivide_size.value; //johnfitz -- is this the right place to set this?
 }
 
 /*
@@ -2068,5 +2832,9 @@ void R_VulkanMemStats_f(void)
 	Con_Printf(" Mesh:   %d\n", num_vulkan_mesh_allocations);
 	Con_Printf(" Misc:   %d\n", num_vulkan_misc_allocations);
 	Con_Printf(" DynBuf: %d\n", num_vulkan_dynbuf_allocations);
+	Con_Printf("Dynamic buffer peak per frame:\n");
+	Con_Printf(" Vertex:  %u KB\n", dyn_vertex_buffer.peak_usage / 1024);
+	Con_Printf(" Index:   %u KB\n", dyn_index_buffer.peak_usage / 1024);
+	Con_Printf(" Uniform: %u KB\n", dyn_uniform_buffer.peak_usage / 1024);
 
 }
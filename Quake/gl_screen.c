@@ -551,6 +551,42 @@ void SCR_DrawDevStats (void)
 	Draw_String (x, (y++)*8-x, str);
 }
 
+/*
+==============
+SCR_DrawGPUStats -- r_gpuprofile, stacked on top of devstats
+==============
+*/
+void SCR_DrawGPUStats (void)
+{
+	char	str[40];
+	int		lines = NUM_GPU_SCOPES + 3;
+	int		y = 25 - lines - (devstats.value ? 9 : 0);
+	int		x = 0; //margin
+	int		i;
+
+	if (!r_gpuprofile.value)
+		return;
+
+	GL_SetCanvas (CANVAS_BOTTOMLEFT);
+
+	Draw_Fill (x, y*8, 21*8, lines*8, 0, 0.5); //dark rectangle
+
+	sprintf (str, "gpu ms   | Left Right");
+	Draw_String (x, (y++)*8-x, str);
+
+	sprintf (str, "---------+-----------");
+	Draw_String (x, (y++)*8-x, str);
+
+	for (i = 0; i < NUM_GPU_SCOPES; i++)
+	{
+		sprintf (str, "%-9s|%5.2f %5.2f", gpu_scope_names[i], gpu_scope_ms[VR_EYE_LEFT][i], gpu_scope_ms[VR_EYE_RIGHT][i]);
+		Draw_String (x, (y++)*8-x, str);
+	}
+
+	sprintf (str, "Total    |%5.2f %5.2f", gpu_total_ms[VR_EYE_LEFT], gpu_total_ms[VR_EYE_RIGHT]);
+	Draw_String (x, (y++)*8-x, str);
+}
+
 /*
 ==============
 SCR_DrawRam
@@ -931,6 +967,16 @@ void SCR_TileClear (void)
 	}
 }
 
+/*
+==================
+SCR_PacedByVR -- the next SCR_UpdateScreen waits for the compositor to start a frame
+==================
+*/
+qboolean SCR_PacedByVR (void)
+{
+	return scr_initialized && con_initialized && !scr_disabled_for_loading && VR_FramePending ();
+}
+
 /*
 ==================
 SCR_UpdateScreen
@@ -960,6 +1006,11 @@ void SCR_UpdateScreen (void)
 			return;
 	}
 
+	// input, networking and the server have run already, only the eyes wait
+	// for the compositor to start the next frame
+	if (!VR_WaitForFrameStart())
+		return;
+
 	for (vr.current_eye = 0; vr.current_eye < NUM_VR_EYES; ++vr.current_eye)
 	{
 		GL_BeginRendering(&glx, &gly, &glwidth, &glheight);
@@ -977,6 +1028,8 @@ void SCR_UpdateScreen (void)
 
 		V_RenderView();
 
+		GL_BeginGPUScope(GPU_SCOPE_2D);
+
 		GL_Set2D();
 
 		//FIXME: only call this when needed
@@ -1015,6 +1068,7 @@ void SCR_UpdateScreen (void)
 			SCR_CheckDrawCenterString();
 			Sbar_Draw();
 			SCR_DrawDevStats(); //johnfitz
+			SCR_DrawGPUStats();
 			SCR_DrawFPS(); //johnfitz
 			SCR_DrawClock(); //johnfitz
 			SCR_DrawConsole();
@@ -1023,6 +1077,8 @@ void SCR_UpdateScreen (void)
 
 		V_UpdateBlend(); //johnfitz -- V_UpdatePalette cleaned up and renamed
 
+		GL_EndGPUScope(GPU_SCOPE_2D);
+
 		GL_EndRendering();
 	}
 }
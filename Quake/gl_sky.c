@@ -25,69 +25,31 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "quakedef.h"
 
-#define	MAX_CLIP_VERTS 64
-
 float Fog_GetDensity(void);
 float *Fog_GetColor(void);
 
 extern	qmodel_t	*loadmodel;
 extern	int	rs_skypolys; //for r_speeds readout
 extern	int rs_skypasses; //for r_speeds readout
+extern	VkBuffer bmodel_vertex_buffer;
+extern	cvar_t vid_filter;
+extern	cvar_t vid_anisotropic;
 float	skyflatcolor[3];
-float	skymins[2][6], skymaxs[2][6];
 
 char	skybox_name[32] = ""; //name of current skybox, or "" if no skybox
 
 gltexture_t	*skybox_textures[6];
 gltexture_t	*solidskytexture, *alphaskytexture;
+static VkDescriptorSet	skybox_descriptor_set;
 
-extern cvar_t gl_farclip;
 cvar_t r_fastsky = {"r_fastsky", "0", CVAR_NONE};
-cvar_t r_sky_quality = {"r_sky_quality", "12", CVAR_NONE};
 cvar_t r_skyalpha = {"r_skyalpha", "1", CVAR_NONE};
 cvar_t r_skyfog = {"r_skyfog","0.5",CVAR_NONE};
 
 int		skytexorder[6] = {0,2,1,3,4,5}; //for skybox
 
-vec3_t	skyclip[6] = {
-	{1,1,0},
-	{1,-1,0},
-	{0,-1,1},
-	{0,1,1},
-	{1,0,1},
-	{-1,0,1}
-};
-
-int	st_to_vec[6][3] =
-{
-	{3,-1,2},
-	{-3,1,2},
-	{1,3,2},
-	{-1,-3,2},
-	{-2,-1,3},		// straight up
-	{2,-1,-3}		// straight down
-};
-
-int	vec_to_st[6][3] =
-{
-	{-2,3,1},
-	{2,3,-1},
-	{1,3,2},
-	{-1,3,-2},
-	{-2,-1,3},
-	{-2,1,-3}
-};
-
 float	skyfog; // ericw
 
-typedef struct
-{
-	float	position[3];
-	float	texcoord1[2];
-	float	texcoord2[2];
-	byte	color[4];
-} skylayervertex_t;
-
 //==============================================================================
 //
 //  INIT
@@ -215,6 +177,7 @@ void Sky_LoadSkyBox (const char *name)
 	}
 
 	strcpy(skybox_name, name);
+	Sky_UpdateSkyBoxDescriptorSet ();
 }
 
 /*
@@ -323,7 +286,6 @@ void Sky_Init (void)
 	int		i;
 
 	Cvar_RegisterVariable (&r_fastsky);
-	Cvar_RegisterVariable (&r_sky_quality);
 	Cvar_RegisterVariable (&r_skyalpha);
 	Cvar_RegisterVariable (&r_skyfog);
 	Cvar_SetCallback (&r_skyfog, R_SetSkyfog_f);
@@ -336,220 +298,211 @@ void Sky_Init (void)
 
 //==============================================================================
 //
-//  PROCESS SKY SURFS
+//  SKYBOX DESCRIPTORS
 //
 //==============================================================================
 
 /*
 =================
-Sky_ProjectPoly
+Sky_UpdateSkyBoxDescriptorSet
 
-update sky bounds
+all six faces in one set, so sky_box.frag can pick the face per fragment.
+also called when the samplers change
 =================
 */
-void Sky_ProjectPoly (int nump, vec3_t vecs)
+void Sky_UpdateSkyBoxDescriptorSet (void)
 {
-	int		i,j;
-	vec3_t	v, av;
-	float	s, t, dv;
-	int		axis;
-	float	*vp;
-
-	// decide which face it maps to
-	VectorCopy (vec3_origin, v);
-	for (i=0, vp=vecs ; i<nump ; i++, vp+=3)
-	{
-		VectorAdd (vp, v, v);
-	}
-	av[0] = fabs(v[0]);
-	av[1] = fabs(v[1]);
-	av[2] = fabs(v[2]);
-	if (av[0] > av[1] && av[0] > av[2])
-	{
-		if (v[0] < 0)
-			axis = 1;
-		else
-			axis = 0;
-	}
-	else if (av[1] > av[2] && av[1] > av[0])
+	int						i;
+	VkDescriptorImageInfo	image_infos[6];
+	VkWriteDescriptorSet	texture_write;
+
+	if (!skybox_name[0])
+		return;
+
+	GL_WaitForDeviceIdle ();
+
+	if (skybox_descriptor_set == VK_NULL_HANDLE)
 	{
-		if (v[1] < 0)
-			axis = 3;
-		else
-			axis = 2;
+		VkDescriptorSetAllocateInfo descriptor_set_allocate_info;
+		memset(&descriptor_set_allocate_info, 0, sizeof(descriptor_set_allocate_info));
+		descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		descriptor_set_allocate_info.descriptorPool = vulkan_globals.descriptor_pool;
+		descriptor_set_allocate_info.descriptorSetCount = 1;
+		descriptor_set_allocate_info.pSetLayouts = &vulkan_globals.sky_box_set_layout;
+
+		if (vkAllocateDescriptorSets(vulkan_globals.device, &descriptor_set_allocate_info, &skybox_descriptor_set) != VK_SUCCESS)
+			Sys_Error("vkAllocateDescriptorSets failed");
 	}
-	else
+
+	// same sampler choice TexMgr makes for TEXPREF_NONE textures
+	VkSampler point_sampler = (vid_anisotropic.value == 1) ? vulkan_globals.point_aniso_sampler : vulkan_globals.point_sampler;
+	VkSampler linear_sampler = (vid_anisotropic.value == 1) ? vulkan_globals.linear_aniso_sampler : vulkan_globals.linear_sampler;
+
+	memset(&image_infos, 0, sizeof(image_infos));
+	for (i=0 ; i<6 ; i++)
 	{
-		if (v[2] < 0)
-			axis = 5;
-		else
-			axis = 4;
+		image_infos[i].imageView = skybox_textures[skytexorder[i]]->image_view;
+		image_infos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		image_infos[i].sampler = (vid_filter.value == 1) ? point_sampler : linear_sampler;
 	}
 
-	// project new texture coords
-	for (i=0 ; i<nump ; i++, vecs+=3)
-	{
-		j = vec_to_st[axis][2];
-		if (j > 0)
-			dv = vecs[j - 1];
-		else
-			dv = -vecs[-j - 1];
+	memset(&texture_write, 0, sizeof(texture_write));
+	texture_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	texture_write.dstSet = skybox_descriptor_set;
+	texture_write.dstBinding = 0;
+	texture_write.dstArrayElement = 0;
+	texture_write.descriptorCount = 6;
+	texture_write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	texture_write.pImageInfo = image_infos;
 
-		j = vec_to_st[axis][0];
-		if (j < 0)
-			s = -vecs[-j -1] / dv;
-		else
-			s = vecs[j-1] / dv;
-		j = vec_to_st[axis][1];
-		if (j < 0)
-			t = -vecs[-j -1] / dv;
-		else
-			t = vecs[j-1] / dv;
-
-		if (s < skymins[0][axis])
-			skymins[0][axis] = s;
-		if (t < skymins[1][axis])
-			skymins[1][axis] = t;
-		if (s > skymaxs[0][axis])
-			skymaxs[0][axis] = s;
-		if (t > skymaxs[1][axis])
-			skymaxs[1][axis] = t;
-	}
+	vkUpdateDescriptorSets(vulkan_globals.device, 1, &texture_write, 0, NULL);
 }
 
+//==============================================================================
+//
+//  DRAW SKY SURFS
+//
+//==============================================================================
+
+#define MAX_SKY_BATCH_SIZE 4096
+
+static uint32_t	sky_indices[MAX_SKY_BATCH_SIZE];
+static int		num_sky_indices;
+static VkPipelineLayout	sky_pipeline_layout;
+static qboolean	sky_pipeline_bound;
+
 /*
-=================
-Sky_ClipPoly
-=================
+================
+Sky_FlushBatch
+================
 */
-void Sky_ClipPoly (int nump, vec3_t vecs, int stage)
+static void Sky_FlushBatch (void)
 {
-	float	*norm;
-	float	*v;
-	qboolean	front, back;
-	float	d, e;
-	float	dists[MAX_CLIP_VERTS];
-	int		sides[MAX_CLIP_VERTS];
-	vec3_t	newv[2][MAX_CLIP_VERTS];
-	int		newc[2];
-	int		i, j;
-
-	if (nump > MAX_CLIP_VERTS-2)
-		Sys_Error ("Sky_ClipPoly: MAX_CLIP_VERTS");
-	if (stage == 6) // fully clipped
-	{
-		Sky_ProjectPoly (nump, vecs);
+	VkBuffer		buffer;
+	VkDeviceSize	buffer_offset;
+	byte			*indices;
+
+	if (num_sky_indices == 0)
 		return;
-	}
 
-	front = back = false;
-	norm = skyclip[stage];
-	for (i=0, v = vecs ; i<nump ; i++, v+=3)
+	// bound on the first draw only, the layer textures may be stale if this map has no sky
+	if (!sky_pipeline_bound)
 	{
-		d = DotProduct (v, norm);
-		if (d > ON_EPSILON)
+		if (skybox_name[0])
 		{
-			front = true;
-			sides[i] = SIDE_FRONT;
+			vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.sky_box_pipeline);
+			vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, sky_pipeline_layout, 0, 1, &skybox_descriptor_set, 0, NULL);
 		}
-		else if (d < ON_EPSILON)
+		else
 		{
-			back = true;
-			sides[i] = SIDE_BACK;
+			VkDescriptorSet descriptor_sets[2] = { solidskytexture->descriptor_set, alphaskytexture->descriptor_set };
+			vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.sky_layer_pipeline);
+			vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, sky_pipeline_layout, 0, 2, descriptor_sets, 0, NULL);
 		}
-		else
-			sides[i] = SIDE_ON;
-		dists[i] = d;
+		R_BindLatch(sky_pipeline_layout, 3, false);
+		sky_pipeline_bound = true;
 	}
 
-	if (!front || !back)
-	{	// not clipped
-		Sky_ClipPoly (nump, vecs, stage+1);
-		return;
-	}
+	indices = R_IndexAllocate(num_sky_indices * sizeof(uint32_t), &buffer, &buffer_offset);
+	memcpy(indices, sky_indices, num_sky_indices * sizeof(uint32_t));
 
-	// clip it
-	sides[i] = sides[0];
-	dists[i] = dists[0];
-	VectorCopy (vecs, (vecs+(i*3)) );
-	newc[0] = newc[1] = 0;
+	vkCmdBindIndexBuffer(vulkan_globals.command_buffer, buffer, buffer_offset, VK_INDEX_TYPE_UINT32);
+	vkCmdDrawIndexed(vulkan_globals.command_buffer, num_sky_indices, 1, 0, 0, 0);
 
-	for (i=0, v = vecs ; i<nump ; i++, v+=3)
-	{
-		switch (sides[i])
-		{
-		case SIDE_FRONT:
-			VectorCopy (v, newv[0][newc[0]]);
-			newc[0]++;
-			break;
-		case SIDE_BACK:
-			VectorCopy (v, newv[1][newc[1]]);
-			newc[1]++;
-			break;
-		case SIDE_ON:
-			VectorCopy (v, newv[0][newc[0]]);
-			newc[0]++;
-			VectorCopy (v, newv[1][newc[1]]);
-			newc[1]++;
-			break;
-		}
+	num_sky_indices = 0;
+	rs_skypasses++;
+}
 
-		if (sides[i] == SIDE_ON || sides[i+1] == SIDE_ON || sides[i+1] == sides[i])
-			continue;
+/*
+================
+Sky_BatchSurface
 
-		d = dists[i] / (dists[i] - dists[i+1]);
-		for (j=0 ; j<3 ; j++)
-		{
-			e = v[j] + d*(v[j+3] - v[j]);
-			newv[0][newc[0]][j] = e;
-			newv[1][newc[1]][j] = e;
-		}
-		newc[0]++;
-		newc[1]++;
+sky surfs are already in the world vertex buffer, so only indices are needed
+================
+*/
+static void Sky_BatchSurface (msurface_t *s)
+{
+	int		i;
+	int		num_surf_indices = 3 * (s->numedges - 2);
+
+	if (num_sky_indices + num_surf_indices > MAX_SKY_BATCH_SIZE)
+		Sky_FlushBatch ();
+
+	for (i=2 ; i<s->numedges ; i++)
+	{
+		sky_indices[num_sky_indices++] = s->vbo_firstvert;
+		sky_indices[num_sky_indices++] = s->vbo_firstvert + i - 1;
+		sky_indices[num_sky_indices++] = s->vbo_firstvert + i;
 	}
 
-	// continue
-	Sky_ClipPoly (newc[0], newv[0][0], stage+1);
-	Sky_ClipPoly (newc[1], newv[1][0], stage+1);
+	rs_skypolys++;
 }
 
 /*
 ================
-Sky_ProcessPoly
+Sky_SetUniforms
+
+model matrix to get world space view directions, plus everything else the
+sky shaders need. fog_color alpha is how much of it to blend in, 1 for a flat sky
 ================
 */
-void Sky_ProcessPoly (glpoly_t	*p, float color[3])
+static void Sky_SetUniforms (float model_matrix[16])
 {
-	int			i;
-	vec3_t		verts[MAX_CLIP_VERTS];
+	VkBuffer		buffer;
+	uint32_t		buffer_offset;
+	VkDescriptorSet	descriptor_set;
+	float			*params, *color, scroll;
+
+	params = (float *) R_UniformAllocate(28 * sizeof(float), &buffer, &buffer_offset, &descriptor_set);
+
+	memcpy(params, model_matrix, 16 * sizeof(float));
 
-	//draw it
-	DrawGLPoly(p, color, 1.0f);
-	rs_brushpasses++;
+	VectorCopy (r_origin, (params + 16));
+	params[19] = 0.0f;
 
-	//update sky bounds
-	if (!r_fastsky.value)
+	if (Fog_GetDensity() > 0)
 	{
-		for (i=0 ; i<p->numverts ; i++)
-			VectorSubtract (p->verts[i], r_origin, verts[i]);
-		Sky_ClipPoly (p->numverts, verts[0], 0);
+		color = Fog_GetColor();
+		params[23] = r_fastsky.value ? 1.0f : CLAMP(0.0, skyfog, 1.0);
 	}
+	else
+	{
+		color = skyflatcolor;
+		params[23] = r_fastsky.value ? 1.0f : 0.0f;
+	}
+	VectorCopy (color, (params + 20));
+
+	// scrolling cloud layers, in texture space
+	scroll = cl.time*8;
+	scroll -= (int)scroll & ~127;
+	params[24] = scroll * (1.0/128);
+	scroll = cl.time*16;
+	scroll -= (int)scroll & ~127;
+	params[25] = scroll * (1.0/128);
+	params[26] = r_skyalpha.value;
+	params[27] = 0.0f;
+
+	vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, sky_pipeline_layout, 2, 1, &descriptor_set, 1, &buffer_offset);
 }
 
 /*
 ================
-Sky_ProcessTextureChains -- handles sky polys in world model
+Sky_DrawTextureChains -- handles sky surfs in world model
 ================
 */
-void Sky_ProcessTextureChains (float color[3])
+static void Sky_DrawTextureChains (void)
 {
 	int			i;
 	msurface_t	*s;
 	texture_t	*t;
+	float		model_matrix[16];
 
 	if (!r_drawworld_cheatsafe)
 		return;
 
+	IdentityMatrix (model_matrix);
+	Sky_SetUniforms (model_matrix);
+
 	for (i=0 ; i<cl.worldmodel->numtextures ; i++)
 	{
 		t = cl.worldmodel->textures[i];
@@ -559,24 +512,24 @@ void Sky_ProcessTextureChains (float color[3])
 
 		for (s = t->texturechains[chain_world]; s; s = s->texturechain)
 			if (!s->culled)
-				Sky_ProcessPoly (s->polys, color);
+				Sky_BatchSurface (s);
 	}
+
+	Sky_FlushBatch ();
 }
 
 /*
 ================
-Sky_ProcessEntities -- handles sky polys on brush models
+Sky_DrawEntities -- handles sky surfs on brush models
 ================
 */
-void Sky_ProcessEntities (float color[3])
+static void Sky_DrawEntities (void)
 {
 	entity_t	*e;
 	msurface_t	*s;
-	glpoly_t	*p;
-	int			i,j,k,mark;
-	float		dot;
-	qboolean	rotated;
-	vec3_t		temp, forward, right, up;
+	int			i, j;
+	qboolean	found;
+	float		model_matrix[16], mvp[16];
 
 	if (!r_drawentities.value)
 		return;
@@ -594,430 +547,63 @@ void Sky_ProcessEntities (float color[3])
 		if (e->alpha == ENTALPHA_ZERO)
 			continue;
 
-		VectorSubtract (r_refdef.vieworg, e->origin, modelorg);
-		if (e->angles[0] || e->angles[1] || e->angles[2])
-		{
-			rotated = true;
-			AngleVectors (e->angles, forward, right, up);
-			VectorCopy (modelorg, temp);
-			modelorg[0] = DotProduct (temp, forward);
-			modelorg[1] = -DotProduct (temp, right);
-			modelorg[2] = DotProduct (temp, up);
-		}
-		else
-			rotated = false;
-
+		found = false;
 		s = &e->model->surfaces[e->model->firstmodelsurface];
-
 		for (j=0 ; j<e->model->nummodelsurfaces ; j++, s++)
 		{
-			if (s->flags & SURF_DRAWSKY)
-			{
-				dot = DotProduct (modelorg, s->plane->normal) - s->plane->dist;
-				if (((s->flags & SURF_PLANEBACK) && (dot < -BACKFACE_EPSILON)) ||
-					(!(s->flags & SURF_PLANEBACK) && (dot > BACKFACE_EPSILON)))
-				{
-					//copy the polygon and translate manually, since Sky_ProcessPoly needs it to be in world space
-					mark = Hunk_LowMark();
-					p = (glpoly_t *) Hunk_Alloc (sizeof(*s->polys)); //FIXME: don't allocate for each poly
-					p->numverts = s->polys->numverts;
-					for (k=0; k<p->numverts; k++)
-					{
-						if (rotated)
-						{
-							p->verts[k][0] = e->origin[0] + s->polys->verts[k][0] * forward[0]
-														  - s->polys->verts[k][1] * right[0]
-														  + s->polys->verts[k][2] * up[0];
-							p->verts[k][1] = e->origin[1] + s->polys->verts[k][0] * forward[1]
-														  - s->polys->verts[k][1] * right[1]
-														  + s->polys->verts[k][2] * up[1];
-							p->verts[k][2] = e->origin[2] + s->polys->verts[k][0] * forward[2]
-														  - s->polys->verts[k][1] * right[2]
-														  + s->polys->verts[k][2] * up[2];
-						}
-						else
-							VectorAdd(s->polys->verts[k], e->origin, p->verts[k]);
-					}
-					Sky_ProcessPoly (p, color);
-					Hunk_FreeToLowMark (mark);
-				}
-			}
-		}
-	}
-}
-
-//==============================================================================
-//
-//  RENDER SKYBOX
-//
-//==============================================================================
-
-/*
-==============
-Sky_EmitSkyBoxVertex
-==============
-*/
-void Sky_EmitSkyBoxVertex (basicvertex_t * vertex, float s, float t, int axis)
-{
-	vec3_t		v, b;
-	int			j, k;
-	float		w, h;
-
-	b[0] = s * gl_farclip.value / sqrt(3.0);
-	b[1] = t * gl_farclip.value / sqrt(3.0);
-	b[2] = gl_farclip.value / sqrt(3.0);
-
-	for (j=0 ; j<3 ; j++)
-	{
-		k = st_to_vec[axis][j];
-		if (k < 0)
-			v[j] = -b[-k - 1];
-		else
-			v[j] = b[k - 1];
-		v[j] += r_origin[j];
-	}
-
-	// convert from range [-1,1] to [0,1]
-	s = (s+1)*0.5;
-	t = (t+1)*0.5;
-
-	// avoid bilerp seam
-	w = skybox_textures[skytexorder[axis]]->width;
-	h = skybox_textures[skytexorder[axis]]->height;
-	s = s * (w-1)/w + 0.5/w;
-	t = t * (h-1)/h + 0.5/h;
-
-	t = 1.0 - t;
-
-	vertex->position[0] = v[0];
-	vertex->position[1] = v[1];
-	vertex->position[2] = v[2];
-
-	vertex->texcoord[0] = s;
-	vertex->texcoord[1] = t;
-
-	vertex->color[0] = 255;
-	vertex->color[1] = 255;
-	vertex->color[2] = 255;
-	vertex->color[3] = 255;
-}
-
-/*
-==============
-Sky_DrawSkyBox
-
-FIXME: eliminate cracks by adding an extra vert on tjuncs
-==============
-*/
-void Sky_DrawSkyBox (void)
-{
-	int		i, j;
-
-	for (i=0 ; i<6 ; i++)
-	{
-		if (skymins[0][i] >= skymaxs[0][i] || skymins[1][i] >= skymaxs[1][i])
-			continue;
-
-		vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.basic_pipeline_layout, 0, 1, &skybox_textures[skytexorder[i]]->descriptor_set, 0, NULL);
-
-		VkBuffer buffer;
-		VkDeviceSize buffer_offset;
-		basicvertex_t * vertices = (basicvertex_t*)R_VertexAllocate(4 * sizeof(basicvertex_t), &buffer, &buffer_offset);
-
-#if 1 //FIXME: this is to avoid tjunctions until i can do it the right way
-		skymins[0][i] = -1;
-		skymins[1][i] = -1;
-		skymaxs[0][i] = 1;
-		skymaxs[1][i] = 1;
-#endif
-		Sky_EmitSkyBoxVertex (vertices + 0, skymins[0][i], skymins[1][i], i);
-		Sky_EmitSkyBoxVertex (vertices + 1, skymins[0][i], skymaxs[1][i], i);
-		Sky_EmitSkyBoxVertex (vertices + 2, skymaxs[0][i], skymaxs[1][i], i);
-		Sky_EmitSkyBoxVertex (vertices + 3, skymaxs[0][i], skymins[1][i], i);
-
-		vkCmdBindVertexBuffers(vulkan_globals.command_buffer, 0, 1, &buffer, &buffer_offset);
-		vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.sky_box_pipeline);
-		vkCmdDraw(vulkan_globals.command_buffer, 4, 1, 0, 0);
-
-		rs_skypolys++;
-		rs_skypasses++;
-
-		if (Fog_GetDensity() > 0 && skyfog > 0)
-		{
-			float *c = Fog_GetColor();
-
-			VkBuffer buffer;
-			VkDeviceSize buffer_offset;
-			basicvertex_t * vertices = (basicvertex_t*)R_VertexAllocate(4 * sizeof(basicvertex_t), &buffer, &buffer_offset);
-
-			Sky_EmitSkyBoxVertex (vertices + 0, skymins[0][i], skymins[1][i], i);
-			Sky_EmitSkyBoxVertex (vertices + 1, skymins[0][i], skymaxs[1][i], i);
-			Sky_EmitSkyBoxVertex (vertices + 2, skymaxs[0][i], skymaxs[1][i], i);
-			Sky_EmitSkyBoxVertex (vertices + 3, skymaxs[0][i], skymins[1][i], i);
+			if (!(s->flags & SURF_DRAWSKY))
+				continue;
 
-			for (j = 0; j < 4; ++j)
+			// the pipeline culls back faces, so no plane test here
+			if (!found)
 			{
-				vertices[j].color[0] = c[0] * 255.0f;
-				vertices[j].color[1] = c[1] * 255.0f;
-				vertices[j].color[2] = c[2] * 255.0f;
-				vertices[j].color[3] = CLAMP(0.0,skyfog,1.0) * 255.0f;
-			}
-
-			vkCmdBindVertexBuffers(vulkan_globals.command_buffer, 0, 1, &buffer, &buffer_offset);
-			vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.basic_poly_blend_pipeline);
-			vkCmdDraw(vulkan_globals.command_buffer, 4, 1, 0, 0);
-
-			rs_skypasses++;
-		}
-	}
-}
-
-//==============================================================================
-//
-//  RENDER CLOUDS
-//
-//==============================================================================
-
-/*
-==============
-Sky_SetBoxVert
-==============
-*/
-void Sky_SetBoxVert (float s, float t, int axis, vec3_t v)
-{
-	vec3_t		b;
-	int			j, k;
-
-	b[0] = s * gl_farclip.value / sqrt(3.0);
-	b[1] = t * gl_farclip.value / sqrt(3.0);
-	b[2] = gl_farclip.value / sqrt(3.0);
-
-	for (j=0 ; j<3 ; j++)
-	{
-		k = st_to_vec[axis][j];
-		if (k < 0)
-			v[j] = -b[-k - 1];
-		else
-			v[j] = b[k - 1];
-		v[j] += r_origin[j];
-	}
-}
-
-/*
-=============
-Sky_GetTexCoord
-=============
-*/
-void Sky_GetTexCoord (vec3_t v, float speed, float *s, float *t)
-{
-	vec3_t	dir;
-	float	length, scroll;
+				e->angles[0] = -e->angles[0];	// stupid quake bug
+				IdentityMatrix (model_matrix);
+				R_RotateForEntity (model_matrix, e->origin, e->angles);
+				e->angles[0] = -e->angles[0];	// stupid quake bug
 
-	VectorSubtract (v, r_origin, dir);
-	dir[2] *= 3;	// flatten the sphere
-
-	length = dir[0]*dir[0] + dir[1]*dir[1] + dir[2]*dir[2];
-	length = sqrt (length);
-	length = 6*63/length;
-
-	scroll = cl.time*speed;
-	scroll -= (int)scroll & ~127;
-
-	*s = (scroll + dir[0] * length) * (1.0/128);
-	*t = (scroll + dir[1] * length) * (1.0/128);
-}
-
-/*
-===============
-Sky_DrawFaceQuad
-===============
-*/
-void Sky_DrawFaceQuad (glpoly_t *p, float alpha)
-{
-	float	*v;
-	int		i;
-
-	VkDescriptorSet descriptor_sets[2] = { solidskytexture->descriptor_set, alphaskytexture->descriptor_set };
-	vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.sky_layer_pipeline_layout, 0, 2, descriptor_sets, 0, NULL);
-
-	VkBuffer vertex_buffer;
-	VkDeviceSize vertex_buffer_offset;
-	skylayervertex_t * vertices = (skylayervertex_t*)R_VertexAllocate(4 * sizeof(skylayervertex_t), &vertex_buffer, &vertex_buffer_offset);
-
-	for (i=0, v=p->verts[0] ; i<4 ; i++, v+=VERTEXSIZE)
-	{
-		vertices[i].position[0] = v[0];
-		vertices[i].position[1] = v[1];
-		vertices[i].position[2] = v[2];
-		
-		Sky_GetTexCoord (v, 8, &vertices[i].texcoord1[0], &vertices[i].texcoord1[1]);
-		Sky_GetTexCoord (v, 16, &vertices[i].texcoord2[0], &vertices[i].texcoord2[1]);
-
-		vertices[i].color[0] = 255;
-		vertices[i].color[1] = 255;
-		vertices[i].color[2] = 255;
-		vertices[i].color[3] = alpha * 255.0f;
-	}
+				memcpy(mvp, vulkan_globals.view_projection_matrix, 16 * sizeof(float));
+				MatrixMultiply(mvp, model_matrix);
+				vkCmdPushConstants(vulkan_globals.command_buffer, vulkan_globals.basic_pipeline_layout, VK_SHADER_STAGE_ALL_GRAPHICS, 0, 16 * sizeof(float), mvp);
 
-	vkCmdBindVertexBuffers(vulkan_globals.command_buffer, 0, 1, &vertex_buffer, &vertex_buffer_offset);
-	vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.sky_layer_pipeline);
-	vkCmdDraw(vulkan_globals.command_buffer, 4, 1, 0, 0);
-
-	rs_skypolys++;
-	rs_skypasses++;
-
-	if (Fog_GetDensity() > 0 && skyfog > 0)
-	{
-		float *c = Fog_GetColor();
+				Sky_SetUniforms (model_matrix);
+				found = true;
+			}
 
-		VkBuffer buffer;
-		VkDeviceSize buffer_offset;
-		basicvertex_t * vertices = (basicvertex_t*)R_VertexAllocate(4 * sizeof(basicvertex_t), &buffer, &buffer_offset);
-		
-		for (i=0, v=p->verts[0] ; i<4 ; i++, v+=VERTEXSIZE)
-		{
-			vertices[i].position[0] = v[0];
-			vertices[i].position[1] = v[1];
-			vertices[i].position[2] = v[2];
-			vertices[i].texcoord[0] = 0.0f;
-			vertices[i].texcoord[1] = 0.0f;
-			vertices[i].color[0] = c[0] * 255.0f;
-			vertices[i].color[1] = c[1] * 255.0f;
-			vertices[i].color[2] = c[2] * 255.0f;
-			vertices[i].color[3] = CLAMP(0.0,skyfog,1.0) * 255.0f;
+			Sky_BatchSurface (s);
 		}
 
-		vkCmdBindVertexBuffers(vulkan_globals.command_buffer, 0, 1, &buffer, &buffer_offset);
-		vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.basic_poly_blend_pipeline);
-		vkCmdDraw(vulkan_globals.command_buffer, 4, 1, 0, 0);
-
-		rs_skypasses++;
-	}
-}
-
-/*
-==============
-Sky_DrawFace
-==============
-*/
-
-void Sky_DrawFace (int axis, float alpha)
-{
-	glpoly_t	*p;
-	vec3_t		verts[4];
-	int			i, j, start;
-	float		di,qi,dj,qj;
-	vec3_t		vup, vright, temp, temp2;
-
-	Sky_SetBoxVert(-1.0, -1.0, axis, verts[0]);
-	Sky_SetBoxVert(-1.0,  1.0, axis, verts[1]);
-	Sky_SetBoxVert(1.0,   1.0, axis, verts[2]);
-	Sky_SetBoxVert(1.0,  -1.0, axis, verts[3]);
-
-	start = Hunk_LowMark ();
-	p = (glpoly_t *) Hunk_Alloc(sizeof(glpoly_t));
-
-	VectorSubtract(verts[2],verts[3],vup);
-	VectorSubtract(verts[2],verts[1],vright);
-
-	di = q_max((int)r_sky_quality.value, 1);
-	qi = 1.0 / di;
-	dj = (axis < 4) ? di*2 : di; //subdivide vertically more than horizontally on skybox sides
-	qj = 1.0 / dj;
-
-	for (i=0; i<di; i++)
-	{
-		for (j=0; j<dj; j++)
+		if (found)
 		{
-			if (i*qi < skymins[0][axis]/2+0.5 - qi || i*qi > skymaxs[0][axis]/2+0.5 ||
-				j*qj < skymins[1][axis]/2+0.5 - qj || j*qj > skymaxs[1][axis]/2+0.5)
-				continue;
-
-			//if (i&1 ^ j&1) continue; //checkerboard test
-			VectorScale (vright, qi*i, temp);
-			VectorScale (vup, qj*j, temp2);
-			VectorAdd(temp,temp2,temp);
-			VectorAdd(verts[0],temp,p->verts[0]);
-
-			VectorScale (vup, qj, temp);
-			VectorAdd (p->verts[0],temp,p->verts[1]);
-
-			VectorScale (vright, qi, temp);
-			VectorAdd (p->verts[1],temp,p->verts[2]);
-
-			VectorAdd (p->verts[0],temp,p->verts[3]);
-
-			Sky_DrawFaceQuad (p, alpha);
+			Sky_FlushBatch ();
+			vkCmdPushConstants(vulkan_globals.command_buffer, vulkan_globals.basic_pipeline_layout, VK_SHADER_STAGE_ALL_GRAPHICS, 0, 16 * sizeof(float), vulkan_globals.view_projection_matrix);
 		}
 	}
-	Hunk_FreeToLowMark (start);
-}
-
-/*
-==============
-Sky_DrawSkyLayers
-
-draws the old-style scrolling cloud layers
-==============
-*/
-void Sky_DrawSkyLayers (void)
-{
-	int i;
-
-	for (i=0 ; i<6 ; i++)
-		if (skymins[0][i] < skymaxs[0][i] && skymins[1][i] < skymaxs[1][i])
-			Sky_DrawFace (i, r_skyalpha.value);
 }
 
 /*
 ==============
 Sky_DrawSky
 
-called once per frame before drawing anything else
+called once per frame before drawing anything else. the sky surfs are drawn
+once, the skybox or cloud layer lookup happens per fragment, so there is no
+clipping or subdivision on the CPU anymore
 ==============
 */
 void Sky_DrawSky (void)
 {
-	int				i;
+	VkDeviceSize offset = 0;
 
 	//in these special render modes, the sky faces are handled in the normal world/brush renderer
 	if (r_drawflat_cheatsafe || r_lightmap_cheatsafe )
 		return;
 
-	//
-	// reset sky bounds
-	//
-	for (i=0 ; i<6 ; i++)
-	{
-		skymins[0][i] = skymins[1][i] = 9999;
-		skymaxs[0][i] = skymaxs[1][i] = -9999;
-	}
-
-	vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.sky_color_pipeline);
+	sky_pipeline_layout = skybox_name[0] ? vulkan_globals.sky_box_pipeline_layout : vulkan_globals.sky_layer_pipeline_layout;
+	sky_pipeline_bound = false;
+	num_sky_indices = 0;
 
-	//
-	// process world and bmodels: draw flat-shaded sky surfs, and update skybounds
-	//
-	Fog_DisableGFog ();
-	float * color;
-	if (Fog_GetDensity() > 0)
-		color = Fog_GetColor();
-	else
-		color = skyflatcolor;
-
-	Sky_ProcessTextureChains (color);
-	Sky_ProcessEntities (color);
-
-	//
-	// render slow sky: cloud layers or skybox
-	//
-	if (!r_fastsky.value && !(Fog_GetDensity() > 0 && skyfog >= 1))
-	{
-		if (skybox_name[0])
-			Sky_DrawSkyBox ();
-		else
-			Sky_DrawSkyLayers ();
-	}
+	vkCmdBindVertexBuffers(vulkan_globals.command_buffer, 0, 1, &bmodel_vertex_buffer, &offset);
 
-	Fog_EnableGFog ();
+	Sky_DrawTextureChains ();
+	Sky_DrawEntities ();
 }
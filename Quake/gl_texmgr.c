@@ -25,12 +25,17 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "quakedef.h"
 #include "gl_heap.h"
+#include <setjmp.h>
 
 static cvar_t	gl_max_size = {"gl_max_size", "0", CVAR_NONE};
 static cvar_t	gl_picmip = {"gl_picmip", "0", CVAR_NONE};
+static cvar_t	gl_gpumipmaps = {"gl_gpumipmaps", "1", CVAR_NONE};
+static cvar_t	gl_dds = {"gl_dds", "1", CVAR_NONE};
+static cvar_t	gl_texcache = {"gl_texcache", "1", CVAR_NONE};
 
 extern cvar_t vid_filter;
 extern cvar_t vid_anisotropic;
+extern cvar_t gl_fullbrights;
 
 #define	MAX_MIPS 16
 static int numgltextures;
@@ -45,6 +50,7 @@ unsigned int d_8to24table_nobright_fence[256];
 unsigned int d_8to24table_conchars[256];
 unsigned int d_8to24table_shirt[256];
 unsigned int d_8to24table_pants[256];
+static unsigned int texmgr_palette_crc;
 
 // Heap
 #define TEXTURE_HEAP_SIZE_MB 32
@@ -97,6 +103,14 @@ static void TexMgr_SetFilterModes (gltexture_t *glt)
 	texture_write.pImageInfo = &image_info;
 
 	vkUpdateDescriptorSets(vulkan_globals.device, 1, &texture_write, 0, NULL);
+
+	// same image and sampler in the texture's slot of the bindless array
+	if (vulkan_globals.bindless)
+	{
+		texture_write.dstSet = vulkan_globals.bindless_descriptor_set;
+		texture_write.dstArrayElement = glt->bindless_index;
+		vkUpdateDescriptorSets(vulkan_globals.device, 1, &texture_write, 0, NULL);
+	}
 }
 
 /*
@@ -393,9 +407,22 @@ void TexMgr_LoadPalette (void)
 	memcpy(d_8to24table_conchars, d_8to24table, 256*4);
 	((byte *) &d_8to24table_conchars[0]) [3] = 0;
 
+	// the others are derived from it, so this is all the texture cache needs
+	texmgr_palette_crc = CRC32_Block ((byte *)d_8to24table, 256*4);
+
 	Hunk_FreeToLowMark (mark);
 }
 
+/*
+================
+TexMgr_DDS_f -- DDS replacement textures are only looked for if BC formats can be sampled
+================
+*/
+static void TexMgr_DDS_f (cvar_t *var)
+{
+	image_dds = vulkan_globals.texture_compression_bc && var->value;
+}
+
 /*
 ================
 TexMgr_NewGame
@@ -425,8 +452,12 @@ void TexMgr_Init (void)
 	free_gltextures = (gltexture_t *) Hunk_AllocName (MAX_GLTEXTURES * sizeof(gltexture_t), "gltextures");
 	active_gltextures = NULL;
 	for (i = 0; i < MAX_GLTEXTURES - 1; i++)
+	{
 		free_gltextures[i].next = &free_gltextures[i+1];
+		free_gltextures[i].bindless_index = i;
+	}
 	free_gltextures[i].next = NULL;
+	free_gltextures[i].bindless_index = i;
 	numgltextures = 0;
 
 	// palette
@@ -434,6 +465,11 @@ void TexMgr_Init (void)
 
 	Cvar_RegisterVariable (&gl_max_size);
 	Cvar_RegisterVariable (&gl_picmip);
+	Cvar_RegisterVariable (&gl_gpumipmaps);
+	Cvar_RegisterVariable (&gl_dds);
+	Cvar_RegisterVariable (&gl_texcache);
+	Cvar_SetCallback (&gl_dds, TexMgr_DDS_f);
+	TexMgr_DDS_f (&gl_dds);
 	Cmd_AddCommand ("imagelist", &TexMgr_Imagelist_f);
 
 	// load notexture images
@@ -452,6 +488,85 @@ void TexMgr_Init (void)
 ================================================================================
 */
 
+/*
+texture jobs do the CPU side of loading (decoding, palette conversion,
+padding, mipmapping) on the task workers.  anything they allocate comes
+from TexMgr_Alloc, which is the hunk when loading directly and a list of
+malloc'd blocks freed with the job otherwise.
+*/
+typedef struct texscratch_s
+{
+	struct texscratch_s	*next;
+	double				align;	// keeps what follows 8 byte aligned
+} texscratch_t;
+
+typedef struct texjob_s
+{
+	gltexture_t		*glt;
+	byte			*data;		// source pixels, or NULL to decode file
+	imagefile_t		file;
+	byte			*decoded;	// malloc'd by Image_DecodeFile
+	texscratch_t	*scratch;
+	byte			*chain;		// mips to upload, laid out one after the other
+	int				chainsize;
+	int				num_mips;
+	int				num_levels;	// in chain, the rest are generated on the GPU
+	jmp_buf			abort;		// TexMgr_JobError returns to TexMgr_RunJob
+	char			error[256];	// reported by TexMgr_EndBatch
+} texjob_t;
+
+#define TEXMGR_BATCH_BYTES	(256 * 1024 * 1024)	// scratch estimate per ParallelFor
+
+static texjob_t		*texmgr_jobs;
+static int			texmgr_numjobs;
+static int			texmgr_maxjobs;
+static qboolean		texmgr_batching;
+
+/*
+================
+TexMgr_JobError
+
+Sys_Error when loading directly.  The task workers can't shut anything down,
+the job is abandoned instead and TexMgr_EndBatch reports the error
+================
+*/
+static void TexMgr_JobError (texjob_t *job, const char *error, ...) __attribute__((__format__(__printf__,2,3), __noreturn__));
+static void TexMgr_JobError (texjob_t *job, const char *error, ...)
+{
+	va_list	argptr;
+	char	text[256];
+
+	va_start (argptr, error);
+	q_vsnprintf (text, sizeof(text), error, argptr);
+	va_end (argptr);
+
+	if (!job)
+		Sys_Error ("%s", text);
+
+	q_strlcpy (job->error, text, sizeof(job->error));
+	longjmp (job->abort, 1);
+}
+
+/*
+================
+TexMgr_Alloc
+================
+*/
+static void *TexMgr_Alloc (texjob_t *job, int size)
+{
+	texscratch_t *scratch;
+
+	if (!job)
+		return Hunk_Alloc (size);
+
+	scratch = (texscratch_t *) malloc (sizeof(texscratch_t) + size);
+	if (!scratch)
+		TexMgr_JobError (job, "TexMgr_Alloc: failed on allocation of %i bytes", size);
+	scratch->next = job->scratch;
+	job->scratch = scratch;
+	return scratch + 1;
+}
+
 /*
 ================
 TexMgr_Pad -- return smallest power of two greater than or equal to s
@@ -735,12 +850,12 @@ static void TexMgr_PadEdgeFixH (byte *data, int width, int height)
 TexMgr_8to32
 ================
 */
-static unsigned *TexMgr_8to32 (byte *in, int pixels, unsigned int *usepal)
+static unsigned *TexMgr_8to32 (byte *in, int pixels, unsigned int *usepal, texjob_t *job)
 {
 	int i;
 	unsigned *out, *data;
 
-	out = data = (unsigned *) Hunk_Alloc(pixels*4);
+	out = data = (unsigned *) TexMgr_Alloc(job, pixels*4);
 
 	for (i = 0; i < pixels; i++)
 		*out++ = usepal[*in++];
@@ -753,7 +868,7 @@ static unsigned *TexMgr_8to32 (byte *in, int pixels, unsigned int *usepal)
 TexMgr_PadImageW -- return image with width padded up to power-of-two dimentions
 ================
 */
-static byte *TexMgr_PadImageW (byte *in, int width, int height, byte padbyte)
+static byte *TexMgr_PadImageW (byte *in, int width, int height, byte padbyte, texjob_t *job)
 {
 	int i, j, outwidth;
 	byte *out, *data;
@@ -763,7 +878,7 @@ static byte *TexMgr_PadImageW (byte *in, int width, int height, byte padbyte)
 
 	outwidth = TexMgr_Pad(width);
 
-	out = data = (byte *) Hunk_Alloc(outwidth*height);
+	out = data = (byte *) TexMgr_Alloc(job, outwidth*height);
 
 	for (i = 0; i < height; i++)
 	{
@@ -781,7 +896,7 @@ static byte *TexMgr_PadImageW (byte *in, int width, int height, byte padbyte)
 TexMgr_PadImageH -- return image with height padded up to power-of-two dimentions
 ================
 */
-static byte *TexMgr_PadImageH (byte *in, int width, int height, byte padbyte)
+static byte *TexMgr_PadImageH (byte *in, int width, int height, byte padbyte, texjob_t *job)
 {
 	int i, srcpix, dstpix;
 	byte *data, *out;
@@ -792,7 +907,7 @@ static byte *TexMgr_PadImageH (byte *in, int width, int height, byte padbyte)
 	srcpix = width * height;
 	dstpix = width * TexMgr_Pad(height);
 
-	out = data = (byte *) Hunk_Alloc(dstpix);
+	out = data = (byte *) TexMgr_Alloc(job, dstpix);
 
 	for (i = 0; i < srcpix; i++)
 		*out++ = *in++;
@@ -838,10 +953,22 @@ static int TexMgr_DeriveStagingSize(int width, int height)
 
 /*
 ================
-TexMgr_LoadImage32 -- handles 32bit source data
+TexMgr_GPUMipmaps -- only the base level gets uploaded, the rest are blitted
 ================
 */
-static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data)
+static qboolean TexMgr_GPUMipmaps (void)
+{
+	return vulkan_globals.blit_mipmaps && gl_gpumipmaps.value;
+}
+
+/*
+================
+TexMgr_BuildMipChain -- applies picmip and lays out the mips the way they
+get uploaded.  returns NULL for warp images, which have nothing to upload.
+num_levels is less than num_mips if the GPU builds the smaller mips
+================
+*/
+static byte *TexMgr_BuildMipChain (gltexture_t *glt, unsigned *data, texjob_t *job, int *num_mips, int *num_levels, int *chainsize)
 {
 	// mipmap down
 	int picmip = (glt->flags & TEXPREF_NOPICMIP) ? 0 : q_max((int)gl_picmip.value, 0);
@@ -862,15 +989,74 @@ static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data)
 			TexMgr_AlphaEdgeFix ((byte *)data, glt->width, glt->height);
 	}
 
-	int num_mips = (glt->flags & TEXPREF_MIPMAP) ? TexMgr_DeriveNumMips(glt->width, glt->height) : 1;
+	*num_mips = (glt->flags & TEXPREF_MIPMAP) ? TexMgr_DeriveNumMips(glt->width, glt->height) : 1;
 
-	const qboolean warp_image = (glt->flags & TEXPREF_WARPIMAGE);
-	if (warp_image)
-		num_mips = WARPIMAGEMIPS;
-	
 	// Check for sanity. This should never be reached.
-	if (num_mips > MAX_MIPS)
-		Sys_Error("Texture has over %d mips", MAX_MIPS);
+	if (*num_mips > MAX_MIPS)
+		TexMgr_JobError (job, "Texture has over %d mips", MAX_MIPS);
+
+	// picmip can leave the image smaller than the target size
+	mipwidth = glt->width;
+	mipheight = glt->height;
+
+	if (!(glt->flags & TEXPREF_MIPMAP) || TexMgr_GPUMipmaps ())
+	{
+		*num_levels = 1;
+		*chainsize = mipwidth * mipheight * 4;
+		return (byte *)data;
+	}
+
+	byte *chain, *mip;
+	*num_levels = *num_mips;
+	*chainsize = TexMgr_DeriveStagingSize(mipwidth, mipheight);
+	chain = mip = (byte *) TexMgr_Alloc (job, *chainsize);
+
+	while (mipwidth >= 1 && mipheight >= 1)
+	{
+		memcpy(mip, data, mipwidth * mipheight * 4);
+		mip += mipwidth * mipheight * 4;
+
+		TexMgr_MipMapW(data, mipwidth, mipheight);
+		TexMgr_MipMapH(data, mipwidth, mipheight);
+
+		mipwidth /= 2;
+		mipheight /= 2;
+	}
+
+	return chain;
+}
+
+/*
+================
+TexMgr_VulkanFormat
+================
+*/
+static VkFormat TexMgr_VulkanFormat (int format)
+{
+	switch (format)
+	{
+	case IMAGE_BC1:
+		return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+	case IMAGE_BC3:
+		return VK_FORMAT_BC3_UNORM_BLOCK;
+	case IMAGE_BC7:
+		return VK_FORMAT_BC7_UNORM_BLOCK;
+	default:
+		return VK_FORMAT_R8G8B8A8_UNORM;
+	}
+}
+
+/*
+================
+TexMgr_UploadImage -- creates the image and copies a chain from
+TexMgr_BuildMipChain or a DDS file to it, then blits down the mips past
+num_levels.  main thread only
+================
+*/
+static void TexMgr_UploadImage (gltexture_t *glt, int format, int num_mips, int num_levels, byte *chain, int chainsize)
+{
+	const qboolean gpu_mips = (num_levels < num_mips);
+	int mipwidth, mipheight, i;
 
 	VkResult err;
 
@@ -878,7 +1064,7 @@ static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data)
 	memset(&image_create_info, 0, sizeof(image_create_info));
 	image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 	image_create_info.imageType = VK_IMAGE_TYPE_2D;
-	image_create_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+	image_create_info.format = TexMgr_VulkanFormat (format);
 	image_create_info.extent.width = glt->width;
 	image_create_info.extent.height = glt->height;
 	image_create_info.extent.depth = 1;
@@ -886,7 +1072,9 @@ static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data)
 	image_create_info.arrayLayers = 1;
 	image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
 	image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
-	image_create_info.usage = warp_image ? (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT) : (VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+	image_create_info.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	if (gpu_mips)
+		image_create_info.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 	image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 	image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
@@ -911,7 +1099,7 @@ static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data)
 	image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 	image_view_create_info.image = glt->image;
 	image_view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-	image_view_create_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+	image_view_create_info.format = image_create_info.format;
 	image_view_create_info.components.r = VK_COMPONENT_SWIZZLE_R;
 	image_view_create_info.components.g = VK_COMPONENT_SWIZZLE_G;
 	image_view_create_info.components.b = VK_COMPONENT_SWIZZLE_B;
@@ -940,95 +1128,44 @@ static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data)
 
 	TexMgr_SetFilterModes (glt);
 
-	// Don't upload data for warp image, will be updated by rendering
-	if (warp_image)
-	{
-		image_view_create_info.subresourceRange.levelCount = 1;
-		err = vkCreateImageView(vulkan_globals.device, &image_view_create_info, NULL, &glt->target_image_view);
-		if (err != VK_SUCCESS)
-			Sys_Error("vkCreateImageView failed");
-
-		GL_SetObjectName((uint64_t)glt->target_image_view, VK_DEBUG_REPORT_OBJECT_TYPE_IMAGE_VIEW_EXT, glt->name);
-
-		VkFramebufferCreateInfo framebuffer_create_info;
-		memset(&framebuffer_create_info, 0, sizeof(framebuffer_create_info));
-		framebuffer_create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-		framebuffer_create_info.renderPass = vulkan_globals.warp_render_pass;
-		framebuffer_create_info.attachmentCount = 1;
-		framebuffer_create_info.pAttachments = &glt->target_image_view;
-		framebuffer_create_info.width = glt->width;
-		framebuffer_create_info.height = glt->height;
-		framebuffer_create_info.layers = 1;
-		err = vkCreateFramebuffer(vulkan_globals.device, &framebuffer_create_info, NULL, &glt->frame_buffer);
-		if (err != VK_SUCCESS)
-			Sys_Error("vkCreateFramebuffer failed");
-
-		GL_SetObjectName((uint64_t)glt->frame_buffer, VK_DEBUG_REPORT_OBJECT_TYPE_FRAMEBUFFER_EXT, glt->name);
-
-		return;
-	}
-	else
-		glt->target_image_view = VK_NULL_HANDLE;
-
-	glt->frame_buffer = VK_NULL_HANDLE;
-
 	// Upload
 	VkBufferImageCopy regions[MAX_MIPS];
 	memset(&regions, 0, sizeof(regions));
 
-	int staging_size = (glt->flags & TEXPREF_MIPMAP) ? TexMgr_DeriveStagingSize(mipwidth, mipheight) : (mipwidth * mipheight * 4);
-
 	VkBuffer staging_buffer;
 	VkCommandBuffer command_buffer;
 	int staging_offset;
-	unsigned char * staging_memory = R_StagingAllocate(staging_size, 4, &command_buffer, &staging_buffer, &staging_offset);
+	// compressed blocks need the buffer offset aligned to the block size
+	unsigned char * staging_memory = R_StagingAllocate(chainsize, (format == IMAGE_RGBA) ? 4 : 16, &command_buffer, &staging_buffer, &staging_offset);
 
-	int num_regions = 0;
+	int num_regions;
 	int mip_offset = 0;
 
-	if (glt->flags & TEXPREF_MIPMAP)
-	{
-		mipwidth = glt->width;
-		mipheight = glt->height;
+	memcpy(staging_memory, chain, chainsize);
 
-		while (mipwidth >= 1 && mipheight >= 1)
-		{
-			memcpy(staging_memory + mip_offset, data, mipwidth * mipheight * 4);
-			regions[num_regions].bufferOffset = staging_offset + mip_offset;
-			regions[num_regions].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			regions[num_regions].imageSubresource.layerCount = 1;
-			regions[num_regions].imageSubresource.mipLevel = num_regions;
-			regions[num_regions].imageExtent.width = mipwidth;
-			regions[num_regions].imageExtent.height = mipheight;
-			regions[num_regions].imageExtent.depth = 1;
-
-			mip_offset += mipwidth * mipheight * 4;
-			num_regions += 1;
-
-			TexMgr_MipMapW(data, mipwidth, mipheight);
-			TexMgr_MipMapH(data, mipwidth, mipheight);
-
-			mipwidth /= 2;
-			mipheight /= 2;
-		}
-	}
-	else
+	mipwidth = glt->width;
+	mipheight = glt->height;
+
+	for (num_regions = 0; num_regions < num_levels; num_regions++)
 	{
-		memcpy(staging_memory + mip_offset, data, mipwidth * mipheight * 4);
-		regions[0].bufferOffset = staging_offset + mip_offset;
-		regions[0].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		regions[0].imageSubresource.layerCount = 1;
-		regions[0].imageSubresource.mipLevel = 0;
-		regions[0].imageExtent.width = mipwidth;
-		regions[0].imageExtent.height = mipheight;
-		regions[0].imageExtent.depth = 1;
+		regions[num_regions].bufferOffset = staging_offset + mip_offset;
+		regions[num_regions].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		regions[num_regions].imageSubresource.layerCount = 1;
+		regions[num_regions].imageSubresource.mipLevel = num_regions;
+		regions[num_regions].imageExtent.width = mipwidth;
+		regions[num_regions].imageExtent.height = mipheight;
+		regions[num_regions].imageExtent.depth = 1;
+
+		mip_offset += Image_MipSize(format, mipwidth, mipheight);
+		mipwidth = q_max(mipwidth / 2, 1);
+		mipheight = q_max(mipheight / 2, 1);
 	}
 
 	VkImageMemoryBarrier image_memory_barrier;
 	memset(&image_memory_barrier, 0, sizeof(image_memory_barrier));
 	image_memory_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 	image_memory_barrier.srcAccessMask = 0;
-	image_memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	image_memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 	image_memory_barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 	image_memory_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 	image_memory_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
@@ -1040,23 +1177,292 @@ static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data)
 	image_memory_barrier.subresourceRange.baseArrayLayer = 0;
 	image_memory_barrier.subresourceRange.layerCount = 1;
 
-	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, NULL, 0, NULL, 1, &image_memory_barrier);
+	// Textures are only sampled by fragment shaders, a reload waits for the reads of the old contents
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &image_memory_barrier);
 
-	vkCmdCopyBufferToImage(command_buffer, staging_buffer, glt->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, num_mips, regions);
+	vkCmdCopyBufferToImage(command_buffer, staging_buffer, glt->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, num_levels, regions);
 
+	if (!gpu_mips)
+	{
+		image_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		image_memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		image_memory_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		image_memory_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 1, &image_memory_barrier);
+		return;
+	}
+
+	// Blit each level down to the next, the previous level has to be a transfer source first
+	VkImageBlit blit;
+	memset(&blit, 0, sizeof(blit));
+	blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	blit.srcSubresource.layerCount = 1;
+	blit.srcOffsets[1].z = 1;
+	blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	blit.dstSubresource.layerCount = 1;
+	blit.dstOffsets[1].z = 1;
+
+	image_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	image_memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 	image_memory_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-	image_memory_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, NULL, 0, NULL, 1, &image_memory_barrier);
+	image_memory_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	image_memory_barrier.subresourceRange.levelCount = 1;
+
+	for (i = num_levels; i < num_mips; i++)
+	{
+		image_memory_barrier.subresourceRange.baseMipLevel = i - 1;
+		vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &image_memory_barrier);
+
+		blit.srcSubresource.mipLevel = i - 1;
+		blit.srcOffsets[1].x = q_max(glt->width >> (i - 1), 1);
+		blit.srcOffsets[1].y = q_max(glt->height >> (i - 1), 1);
+		blit.dstSubresource.mipLevel = i;
+		blit.dstOffsets[1].x = q_max(glt->width >> i, 1);
+		blit.dstOffsets[1].y = q_max(glt->height >> i, 1);
+		vkCmdBlitImage(command_buffer, glt->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, glt->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+	}
+
+	// All levels but the last were blit sources
+	VkImageMemoryBarrier final_barriers[2];
+	final_barriers[0] = image_memory_barrier;
+	final_barriers[0].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	final_barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	final_barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	final_barriers[0].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	final_barriers[0].subresourceRange.baseMipLevel = 0;
+	final_barriers[0].subresourceRange.levelCount = num_mips - 1;
+	final_barriers[1] = final_barriers[0];
+	final_barriers[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	final_barriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	final_barriers[1].subresourceRange.baseMipLevel = num_mips - 1;
+	final_barriers[1].subresourceRange.levelCount = 1;
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, 2, final_barriers);
+}
+
+/*
+================================================================================
+
+	TEXTURE CACHE
+
+================================================================================
+*/
+
+/*
+processed textures are kept in <gamedir>/texcache, named by a crc of the
+source data and a crc of everything else that changes the result.  a hit
+skips decoding, palette conversion and mipmapping.  files are only ever
+added, delete the directory to clean it up.
+*/
+#define TEXCACHE_VERSION	1
+#define TEXCACHE_MINPIXELS	(128 * 128)	// smaller ones are quicker to process than to look up
+
+typedef struct
+{
+	unsigned int	source;		// crc of the source data
+	unsigned int	params;		// crc of the flags, cvars and palette it gets processed with
+} texcachekey_t;
+
+typedef struct
+{
+	char			id[4];		// "QTEX"
+	int				version;
+	texcachekey_t	key;
+	unsigned int	width, height, flags;	// after processing
+	unsigned int	source_crc;
+	int				num_mips, num_levels, chainsize;
+} texcacheheader_t;
+
+static char texmgr_cachedir[MAX_OSPATH];	// "" until created for the current gamedir
+
+/*
+================
+TexMgr_CacheDir -- makes sure the cache directory exists.  main thread only,
+call before loading anything that might get written to the cache
+================
+*/
+static void TexMgr_CacheDir (void)
+{
+	char path[MAX_OSPATH];
+
+	if (!gl_texcache.value)
+		return;
+
+	q_snprintf (path, sizeof(path), "%s/texcache", com_gamedir);
+	if (!strcmp (path, texmgr_cachedir))
+		return;
+
+	Sys_mkdir (path);
+	q_strlcpy (texmgr_cachedir, path, sizeof(texmgr_cachedir));
 }
 
 /*
 ================
-TexMgr_LoadImage8 -- handles 8bit source data, then passes it to LoadImage32
+TexMgr_CacheKey -- returns false for textures that don't get cached
 ================
 */
-static void TexMgr_LoadImage8 (gltexture_t *glt, byte *data)
+static qboolean TexMgr_CacheKey (gltexture_t *glt, const byte *source, int size, texcachekey_t *key)
+{
+	int params[10];
+
+	if (!gl_texcache.value || !texmgr_cachedir[0])
+		return false;
+	if (glt->source_format == SRC_LIGHTMAP)
+		return false;
+	if (glt->source_width * glt->source_height < TEXCACHE_MINPIXELS)
+		return false;
+
+	params[0] = TEXCACHE_VERSION;
+	params[1] = glt->source_format;
+	params[2] = glt->source_width;
+	params[3] = glt->source_height;
+	params[4] = glt->flags;
+	params[5] = (glt->flags & TEXPREF_NOPICMIP) ? 0 : q_max((int)gl_picmip.value, 0);
+	params[6] = vulkan_globals.device_properties.limits.maxImageDimension2D;
+	params[7] = TexMgr_GPUMipmaps ();
+	params[8] = (glt->source_format == SRC_INDEXED) ? texmgr_palette_crc : 0;
+	params[9] = (glt->flags & TEXPREF_NOBRIGHT) && gl_fullbrights.value;
+
+	key->source = CRC32_Block (source, size);
+	key->params = CRC32_Block ((byte *)params, sizeof(params));
+	return true;
+}
+
+/*
+================
+TexMgr_CachePath
+================
+*/
+static void TexMgr_CachePath (const texcachekey_t *key, char *path, size_t size)
+{
+	q_snprintf (path, size, "%s/%08x%08x.tex", texmgr_cachedir, key->source, key->params);
+}
+
+/*
+================
+TexMgr_ChainSize -- bytes in the first num_levels rgba mips
+================
+*/
+static int TexMgr_ChainSize (int width, int height, int num_levels)
+{
+	int size = 0;
+	while (num_levels--)
+	{
+		size += width * height * 4;
+		width = q_max(width / 2, 1);
+		height = q_max(height / 2, 1);
+	}
+	return size;
+}
+
+/*
+================
+TexMgr_ReadCache -- on a hit, sets up glt the way processing would have and
+returns the chain, allocated with TexMgr_Alloc.  safe on the task workers
+================
+*/
+static byte *TexMgr_ReadCache (gltexture_t *glt, const texcachekey_t *key, texjob_t *job, int *num_mips, int *num_levels, int *chainsize)
+{
+	const unsigned int max_size = vulkan_globals.device_properties.limits.maxImageDimension2D;
+	char path[MAX_OSPATH];
+	texcacheheader_t header;
+	byte *chain;
+	FILE *f;
+
+	TexMgr_CachePath (key, path, sizeof(path));
+	f = fopen (path, "rb");
+	if (!f)
+		return NULL;
+
+	chain = NULL;
+	if (fread (&header, sizeof(header), 1, f) == 1 &&
+	    !memcmp (header.id, "QTEX", 4) && header.version == TEXCACHE_VERSION &&
+	    header.key.source == key->source && header.key.params == key->params &&
+	    header.width >= 1 && header.width <= max_size && header.height >= 1 && header.height <= max_size &&
+	    header.num_mips >= 1 && header.num_mips <= MAX_MIPS &&
+	    header.num_levels >= 1 && header.num_levels <= header.num_mips &&
+	    header.chainsize == TexMgr_ChainSize (header.width, header.height, header.num_levels))
+	{
+		chain = (byte *) TexMgr_Alloc (job, header.chainsize);
+		if (fread (chain, header.chainsize, 1, f) != 1)
+			chain = NULL;	// truncated, the scratch goes with the job or hunk mark
+	}
+	fclose (f);
+
+	if (!chain)
+		return NULL;
+
+	glt->width = header.width;
+	glt->height = header.height;
+	glt->flags = header.flags;
+	glt->source_crc = header.source_crc;
+	*num_mips = header.num_mips;
+	*num_levels = header.num_levels;
+	*chainsize = header.chainsize;
+	return chain;
+}
+
+/*
+================
+TexMgr_WriteCache -- safe on the task workers, failures are ignored
+================
+*/
+static void TexMgr_WriteCache (const gltexture_t *glt, const texcachekey_t *key, const byte *chain, int num_mips, int num_levels, int chainsize)
+{
+	char path[MAX_OSPATH], temp[MAX_OSPATH + 32];
+	texcacheheader_t header;
+	qboolean ok;
+	FILE *f;
+
+	memset (&header, 0, sizeof(header));
+	memcpy (header.id, "QTEX", 4);
+	header.version = TEXCACHE_VERSION;
+	header.key = *key;
+	header.width = glt->width;
+	header.height = glt->height;
+	header.flags = glt->flags;
+	header.source_crc = glt->source_crc;
+	header.num_mips = num_mips;
+	header.num_levels = num_levels;
+	header.chainsize = chainsize;
+
+	// write under a name of its own, so nobody reads half a file
+	TexMgr_CachePath (key, path, sizeof(path));
+	q_snprintf (temp, sizeof(temp), "%s.%p", path, (void *)glt);
+	f = fopen (temp, "wb");
+	if (!f)
+		return;
+
+	ok = fwrite (&header, sizeof(header), 1, f) == 1 && fwrite (chain, chainsize, 1, f) == 1;
+	if (fclose (f) != 0)
+		ok = false;
+
+	if (!ok || rename (temp, path) != 0)
+		remove (temp);	// rename fails on windows if another job got there first
+}
+
+/*
+================
+TexMgr_LoadImage32 -- handles 32bit source data
+================
+*/
+static void TexMgr_LoadImage32 (gltexture_t *glt, unsigned *data, const texcachekey_t *key)
+{
+	int num_mips, num_levels, chainsize;
+	byte *chain;
+
+	chain = TexMgr_BuildMipChain (glt, data, NULL, &num_mips, &num_levels, &chainsize);
+	if (key && chain)
+		TexMgr_WriteCache (glt, key, chain, num_mips, num_levels, chainsize);
+	TexMgr_UploadImage (glt, IMAGE_RGBA, num_mips, num_levels, chain, chainsize);
+}
+
+/*
+================
+TexMgr_Convert8to32 -- pads and converts 8bit source data
+================
+*/
+static unsigned *TexMgr_Convert8to32 (gltexture_t *glt, byte *data, texjob_t *job)
 {
-	extern cvar_t gl_fullbrights;
 	qboolean padw = false, padh = false;
 	byte padbyte;
 	unsigned int *usepal;
@@ -1070,7 +1476,11 @@ static void TexMgr_LoadImage8 (gltexture_t *glt, byte *data)
 		// This texture in b_shell1.bsp has some of the first 32 pixels painted white.
 		// They are invisible in software, but look really ugly in GL. So we just copy
 		// 32 pixels from the bottom to make it look nice.
-		memcpy (data, data + 32*31, 32);
+		// Patch a copy, jobs for the texture and its fullbright share the source.
+		byte *copy = (byte *) TexMgr_Alloc (job, 1024);
+		memcpy (copy, data, 1024);
+		memcpy (copy, data + 32*31, 32);
+		data = copy;
 	}
 
 	// detect false alpha cases
@@ -1116,20 +1526,20 @@ static void TexMgr_LoadImage8 (gltexture_t *glt, byte *data)
 	{
 		if ((int) glt->width < TexMgr_SafeTextureSize(glt->width))
 		{
-			data = TexMgr_PadImageW (data, glt->width, glt->height, padbyte);
+			data = TexMgr_PadImageW (data, glt->width, glt->height, padbyte, job);
 			glt->width = TexMgr_Pad(glt->width);
 			padw = true;
 		}
 		if ((int) glt->height < TexMgr_SafeTextureSize(glt->height))
 		{
-			data = TexMgr_PadImageH (data, glt->width, glt->height, padbyte);
+			data = TexMgr_PadImageH (data, glt->width, glt->height, padbyte, job);
 			glt->height = TexMgr_Pad(glt->height);
 			padh = true;
 		}
 	}
 
 	// convert to 32bit
-	data = (byte *)TexMgr_8to32(data, glt->width * glt->height, usepal);
+	data = (byte *)TexMgr_8to32(data, glt->width * glt->height, usepal, job);
 
 	// fix edges
 	if (glt->flags & TEXPREF_ALPHA)
@@ -1142,8 +1552,17 @@ static void TexMgr_LoadImage8 (gltexture_t *glt, byte *data)
 			TexMgr_PadEdgeFixH (data, glt->source_width, glt->source_height);
 	}
 
-	// upload it
-	TexMgr_LoadImage32 (glt, (unsigned *)data);
+	return (unsigned *)data;
+}
+
+/*
+================
+TexMgr_LoadImage8 -- handles 8bit source data, then passes it to LoadImage32
+================
+*/
+static void TexMgr_LoadImage8 (gltexture_t *glt, byte *data, const texcachekey_t *key)
+{
+	TexMgr_LoadImage32 (glt, TexMgr_Convert8to32 (glt, data, NULL), key);
 }
 
 /*
@@ -1153,48 +1572,47 @@ TexMgr_LoadLightmap -- handles lightmap data
 */
 static void TexMgr_LoadLightmap (gltexture_t *glt, byte *data)
 {
-	TexMgr_LoadImage32(glt, (unsigned *)data);
+	TexMgr_LoadImage32(glt, (unsigned *)data, NULL);
 }
 
 /*
 ================
-TexMgr_LoadImage -- the one entry point for loading all textures
+TexMgr_SourceSize
 ================
 */
-gltexture_t *TexMgr_LoadImage (qmodel_t *owner, const char *name, int width, int height, enum srcformat format,
-			       byte *data, const char *source_file, src_offset_t source_offset, unsigned flags)
+static int TexMgr_SourceSize (enum srcformat format, int width, int height)
 {
-	unsigned short crc;
-	gltexture_t *glt;
-	int mark;
-
-	if (isDedicated)
-		return NULL;
-
-	// cache check
 	switch (format)
 	{
 	case SRC_INDEXED:
-		crc = CRC_Block(data, width * height);
-		break;
+		return width * height;
 	case SRC_LIGHTMAP:
-		crc = CRC_Block(data, width * height * lightmap_bytes);
-		break;
+		return width * height * lightmap_bytes;
 	case SRC_RGBA:
-		crc = CRC_Block(data, width * height * 4);
-		break;
+		return width * height * 4;
 	default: /* not reachable but avoids compiler warnings */
-		crc = 0;
-	}
-	if ((flags & TEXPREF_OVERWRITE) && (glt = TexMgr_FindTexture (owner, name)))
-	{
-		if (glt->source_crc == crc)
-			return glt;
+		return 0;
 	}
-	else
-		glt = TexMgr_NewTexture ();
+}
 
-	// copy data
+/*
+================
+TexMgr_SourceCRC
+================
+*/
+static unsigned short TexMgr_SourceCRC (enum srcformat format, byte *data, int width, int height)
+{
+	return CRC_Block(data, TexMgr_SourceSize (format, width, height));
+}
+
+/*
+================
+TexMgr_InitTexture
+================
+*/
+static void TexMgr_InitTexture (gltexture_t *glt, qmodel_t *owner, const char *name, int width, int height, enum srcformat format,
+				const char *source_file, src_offset_t source_offset, unsigned flags)
+{
 	glt->owner = owner;
 	q_strlcpy (glt->name, name, sizeof(glt->name));
 	glt->width = width;
@@ -1207,21 +1625,62 @@ gltexture_t *TexMgr_LoadImage (qmodel_t *owner, const char *name, int width, int
 	glt->source_format = format;
 	glt->source_width = width;
 	glt->source_height = height;
+}
+
+/*
+================
+TexMgr_LoadImage -- the one entry point for loading all textures
+================
+*/
+gltexture_t *TexMgr_LoadImage (qmodel_t *owner, const char *name, int width, int height, enum srcformat format,
+			       byte *data, const char *source_file, src_offset_t source_offset, unsigned flags)
+{
+	unsigned short crc;
+	gltexture_t *glt;
+	texcachekey_t key;
+	qboolean cache;
+	int mark, num_mips, num_levels, chainsize;
+	byte *chain;
+
+	if (isDedicated)
+		return NULL;
+
+	// cache check
+	crc = TexMgr_SourceCRC (format, data, width, height);
+	if ((flags & TEXPREF_OVERWRITE) && (glt = TexMgr_FindTexture (owner, name)))
+	{
+		if (glt->source_crc == crc)
+			return glt;
+	}
+	else
+		glt = TexMgr_NewTexture ();
+
+	// copy data
+	TexMgr_InitTexture (glt, owner, name, width, height, format, source_file, source_offset, flags);
 	glt->source_crc = crc;
 
 	//upload it
 	mark = Hunk_LowMark();
 
+	TexMgr_CacheDir ();
+	cache = TexMgr_CacheKey (glt, data, TexMgr_SourceSize (format, width, height), &key);
+	if (cache && (chain = TexMgr_ReadCache (glt, &key, NULL, &num_mips, &num_levels, &chainsize)))
+	{
+		TexMgr_UploadImage (glt, IMAGE_RGBA, num_mips, num_levels, chain, chainsize);
+		Hunk_FreeToLowMark(mark);
+		return glt;
+	}
+
 	switch (glt->source_format)
 	{
 	case SRC_INDEXED:
-		TexMgr_LoadImage8 (glt, data);
+		TexMgr_LoadImage8 (glt, data, cache ? &key : NULL);
 		break;
 	case SRC_LIGHTMAP:
 		TexMgr_LoadLightmap (glt, data);
 		break;
 	case SRC_RGBA:
-		TexMgr_LoadImage32 (glt, (unsigned *)data);
+		TexMgr_LoadImage32 (glt, (unsigned *)data, cache ? &key : NULL);
 		break;
 	}
 
@@ -1230,6 +1689,309 @@ gltexture_t *TexMgr_LoadImage (qmodel_t *owner, const char *name, int width, int
 	return glt;
 }
 
+/*
+================
+TexMgr_LoadDDS -- uploads the mips stored in a DDS file as they are.
+picmip and gl_max_size skip the top levels instead of resampling
+================
+*/
+static gltexture_t *TexMgr_LoadDDS (qmodel_t *owner, const char *name, imagefile_t *file, const char *source_file, unsigned flags)
+{
+	unsigned short crc;
+	gltexture_t *glt;
+	int picmip, maxwidth, maxheight, first, num_mips, offset, size, i;
+
+	Image_ReadFile (file);
+
+	// cache check
+	crc = CRC_Block (file->data, file->size);
+	if ((flags & TEXPREF_OVERWRITE) && (glt = TexMgr_FindTexture (owner, name)))
+	{
+		if (glt->source_crc == crc)
+		{
+			Image_FreeFile (file);
+			return glt;
+		}
+	}
+	else
+		glt = TexMgr_NewTexture ();
+
+	TexMgr_InitTexture (glt, owner, name, file->width, file->height, SRC_RGBA, source_file, 0, flags);
+	glt->source_crc = crc;
+
+	picmip = (flags & TEXPREF_NOPICMIP) ? 0 : q_max((int)gl_picmip.value, 0);
+	maxwidth = q_max(TexMgr_SafeTextureSize (file->width >> picmip), 1);
+	maxheight = q_max(TexMgr_SafeTextureSize (file->height >> picmip), 1);
+	offset = file->offset;
+	for (first = 0; first < file->num_mips - 1; first++)
+	{
+		if ((int) glt->width <= maxwidth && (int) glt->height <= maxheight)
+			break;
+		offset += Image_MipSize (file->format, glt->width, glt->height);
+		glt->width = q_max(glt->width >> 1, 1);
+		glt->height = q_max(glt->height >> 1, 1);
+	}
+
+	num_mips = (flags & TEXPREF_MIPMAP) ? file->num_mips - first : 1;
+	for (i = 0, size = 0; i < num_mips; i++)
+		size += Image_MipSize (file->format, glt->width >> i, glt->height >> i);
+
+	TexMgr_UploadImage (glt, file->format, num_mips, num_mips, file->data + offset, size);
+	Image_FreeFile (file);
+
+	return glt;
+}
+
+/*
+================================================================================
+
+	BATCHED LOADING
+
+================================================================================
+*/
+
+/*
+================
+TexMgr_FreeJob
+================
+*/
+static void TexMgr_FreeJob (texjob_t *job)
+{
+	texscratch_t *scratch, *next;
+
+	for (scratch = job->scratch; scratch; scratch = next)
+	{
+		next = scratch->next;
+		free (scratch);
+	}
+	free (job->decoded);
+	Image_FreeFile (&job->file);
+	memset (job, 0, sizeof(*job));
+}
+
+/*
+================
+TexMgr_NewJob
+================
+*/
+static texjob_t *TexMgr_NewJob (gltexture_t *glt)
+{
+	texjob_t *job;
+
+	if (texmgr_numjobs == texmgr_maxjobs)
+	{
+		texmgr_maxjobs = q_max(64, texmgr_maxjobs * 2);
+		texmgr_jobs = (texjob_t *) realloc (texmgr_jobs, texmgr_maxjobs * sizeof(texjob_t));
+		if (!texmgr_jobs)
+			Sys_Error ("TexMgr_NewJob: out of memory");
+	}
+
+	job = &texmgr_jobs[texmgr_numjobs++];
+	memset (job, 0, sizeof(*job));
+	job->glt = glt;
+	return job;
+}
+
+/*
+================
+TexMgr_JobCost -- rough guess at the memory a job needs while it runs
+================
+*/
+static size_t TexMgr_JobCost (texjob_t *job)
+{
+	size_t pixels = (size_t)job->glt->source_width * job->glt->source_height;
+
+	if (pixels == 0)	// not known until the file is decoded
+		pixels = (size_t)job->file.width * job->file.height;
+
+	return job->file.size + pixels * 4 * 3;
+}
+
+/*
+================
+TexMgr_RunJob -- task worker side, no Vulkan, hunk or console in here, errors
+go through TexMgr_JobError
+================
+*/
+static void TexMgr_RunJob (int index, void *data)
+{
+	texjob_t	*job = (texjob_t *)data + index;
+	gltexture_t	*glt = job->glt;
+	byte		*pixels = job->data;
+	unsigned	*rgba;
+	texcachekey_t	key;
+	qboolean	cache;
+
+	if (setjmp (job->abort))
+		return;
+
+	// files are looked up before decoding, by their contents
+	if (job->file.data)
+	{
+		glt->source_width = job->file.width;
+		glt->source_height = job->file.height;
+		cache = TexMgr_CacheKey (glt, job->file.data, job->file.size, &key);
+	}
+	else
+		cache = TexMgr_CacheKey (glt, pixels, TexMgr_SourceSize (glt->source_format, glt->source_width, glt->source_height), &key);
+
+	if (cache && (job->chain = TexMgr_ReadCache (glt, &key, job, &job->num_mips, &job->num_levels, &job->chainsize)))
+	{
+		Image_FreeFile (&job->file);
+		return;
+	}
+
+	if (job->file.data)
+	{
+		job->decoded = pixels = Image_DecodeFile (&job->file);
+		Image_FreeFile (&job->file);
+		if (!pixels)
+			TexMgr_JobError (job, "TexMgr_RunJob: out of memory decoding %s", glt->name);
+		glt->width = glt->source_width = job->file.width;
+		glt->height = glt->source_height = job->file.height;
+	}
+
+	glt->source_crc = TexMgr_SourceCRC (glt->source_format, pixels, glt->source_width, glt->source_height);
+
+	if (glt->source_format == SRC_INDEXED)
+		rgba = TexMgr_Convert8to32 (glt, pixels, job);
+	else
+		rgba = (unsigned *)pixels;
+
+	job->chain = TexMgr_BuildMipChain (glt, rgba, job, &job->num_mips, &job->num_levels, &job->chainsize);
+	if (cache && job->chain)
+		TexMgr_WriteCache (glt, &key, job->chain, job->num_mips, job->num_levels, job->chainsize);
+}
+
+/*
+================
+TexMgr_BeginBatch -- TexMgr_Queue* calls until TexMgr_EndBatch are deferred
+================
+*/
+void TexMgr_BeginBatch (void)
+{
+	// drop anything left behind by a Host_Error during the last batch
+	while (texmgr_numjobs > 0)
+		TexMgr_FreeJob (&texmgr_jobs[--texmgr_numjobs]);
+
+	TexMgr_CacheDir ();
+	texmgr_batching = true;
+}
+
+/*
+================
+TexMgr_EndBatch -- runs the queued jobs on the task workers a memory budget
+at a time, then creates and uploads the images on the main thread
+================
+*/
+void TexMgr_EndBatch (void)
+{
+	int first, last, i;
+	size_t budget, cost;
+	texjob_t *job;
+
+	texmgr_batching = false;
+
+	for (first = 0; first < texmgr_numjobs; first = last)
+	{
+		budget = 0;
+		for (last = first; last < texmgr_numjobs; last++)
+		{
+			job = &texmgr_jobs[last];
+			cost = TexMgr_JobCost (job);
+			if (last > first && budget + cost > TEXMGR_BATCH_BYTES)
+				break;
+			budget += cost;
+			if (job->file.type)
+				Image_ReadFile (&job->file);	// file system isn't thread safe
+		}
+
+		Tasks_ParallelFor (TexMgr_RunJob, texmgr_jobs + first, last - first);
+
+		for (i = first; i < last; i++)
+		{
+			job = &texmgr_jobs[i];
+			if (job->error[0])
+				Sys_Error ("%s", job->error);
+			TexMgr_UploadImage (job->glt, IMAGE_RGBA, job->num_mips, job->num_levels, job->chain, job->chainsize);
+			TexMgr_FreeJob (job);
+		}
+	}
+
+	texmgr_numjobs = 0;
+}
+
+/*
+================
+TexMgr_QueueImage -- like TexMgr_LoadImage, but inside a batch the work is
+deferred to TexMgr_EndBatch, so data has to stay valid until then
+================
+*/
+gltexture_t *TexMgr_QueueImage (qmodel_t *owner, const char *name, int width, int height, enum srcformat format,
+				byte *data, const char *source_file, src_offset_t source_offset, unsigned flags)
+{
+	gltexture_t *glt;
+	texjob_t *job;
+
+	if (isDedicated)
+		return NULL;
+
+	if (!texmgr_batching || format == SRC_LIGHTMAP || (flags & TEXPREF_OVERWRITE))
+		return TexMgr_LoadImage (owner, name, width, height, format, data, source_file, source_offset, flags);
+
+	glt = TexMgr_NewTexture ();
+	TexMgr_InitTexture (glt, owner, name, width, height, format, source_file, source_offset, flags);
+
+	job = TexMgr_NewJob (glt);
+	job->data = data;
+
+	return glt;
+}
+
+/*
+================
+TexMgr_QueueImageFile -- queues an image found by Image_FindImage, and
+takes ownership of file
+================
+*/
+gltexture_t *TexMgr_QueueImageFile (qmodel_t *owner, const char *name, imagefile_t *file, const char *source_file, unsigned flags)
+{
+	gltexture_t *glt;
+	texjob_t *job;
+	byte *data;
+
+	if (isDedicated)
+	{
+		Image_FreeFile (file);
+		return NULL;
+	}
+
+	// nothing to do on the CPU for these
+	if (file->type == IMAGE_DDS)
+		return TexMgr_LoadDDS (owner, name, file, source_file, flags);
+
+	if (!texmgr_batching || (flags & TEXPREF_OVERWRITE))
+	{
+		Image_ReadFile (file);
+		data = Image_DecodeFile (file);
+		Image_FreeFile (file);
+		if (!data)
+			Sys_Error ("TexMgr_QueueImageFile: out of memory decoding %s", file->name);
+		glt = TexMgr_LoadImage (owner, name, file->width, file->height, SRC_RGBA, data, source_file, 0, flags);
+		free (data);
+		return glt;
+	}
+
+	glt = TexMgr_NewTexture ();
+	TexMgr_InitTexture (glt, owner, name, 0, 0, SRC_RGBA, source_file, 0, flags);
+
+	job = TexMgr_NewJob (glt);
+	job->file = *file;
+	file->data = NULL;
+
+	return glt;
+}
+
 /*
 ================================================================================
 
@@ -1348,13 +2110,13 @@ invalid:
 	switch (glt->source_format)
 	{
 	case SRC_INDEXED:
-		TexMgr_LoadImage8 (glt, data);
+		TexMgr_LoadImage8 (glt, data, NULL);
 		break;
 	case SRC_LIGHTMAP:
 		TexMgr_LoadLightmap (glt, data);
 		break;
 	case SRC_RGBA:
-		TexMgr_LoadImage32 (glt, (unsigned *)data);
+		TexMgr_LoadImage32 (glt, (unsigned *)data, NULL);
 		break;
 	}
 
@@ -1394,18 +2156,12 @@ static void GL_DeleteTexture (gltexture_t *texture)
 {
 	GL_WaitForDeviceIdle();
 
-	if (texture->frame_buffer != VK_NULL_HANDLE)
-		vkDestroyFramebuffer(vulkan_globals.device, texture->frame_buffer, NULL);
-	if(texture->target_image_view)
-		vkDestroyImageView(vulkan_globals.device, texture->target_image_view, NULL);
 	vkDestroyImageView(vulkan_globals.device, texture->image_view, NULL);
 	vkDestroyImage(vulkan_globals.device, texture->image, NULL);
 	vkFreeDescriptorSets(vulkan_globals.device, vulkan_globals.descriptor_pool, 1, &texture->descriptor_set);
 
 	GL_FreeFromHeaps(TEXTURE_MAX_HEAPS, texmgr_heaps, texture->heap, texture->heap_node, &num_vulkan_tex_allocations);
 
-	texture->frame_buffer = VK_NULL_HANDLE;
-	texture->target_image_view = VK_NULL_HANDLE;
 	texture->image_view = VK_NULL_HANDLE;
 	texture->image = VK_NULL_HANDLE;
 	texture->heap = NULL;
@@ -38,7 +38,6 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define TEXPREF_FULLBRIGHT		0x0100	// use fullbright mask palette
 #define TEXPREF_NOBRIGHT		0x0200	// use nobright mask palette
 #define TEXPREF_CONCHARS		0x0400	// use conchars palette
-#define TEXPREF_WARPIMAGE		0x0800	// resize this texture when warpimagesize changes
 
 enum srcformat {SRC_INDEXED, SRC_LIGHTMAP, SRC_RGBA};
 
@@ -66,11 +65,10 @@ typedef struct gltexture_s {
 //used for rendering
 	VkImage				image;
 	VkImageView			image_view;
-	VkImageView			target_image_view;
 	struct glheap_s *	heap;
 	struct glheapnode_s *	heap_node;
 	VkDescriptorSet		descriptor_set;
-	VkFramebuffer		frame_buffer;
+	int					bindless_index; //slot in vulkan_globals.bindless_descriptor_set, fixed per gltexture_t
 	int			visframe; //matches r_framecount if texture was bound this frame
 } gltexture_t;
 
@@ -102,6 +100,13 @@ gltexture_t *TexMgr_LoadImage (qmodel_t *owner, const char *name, int width, int
 void TexMgr_ReloadImage (gltexture_t *glt, int shirt, int pants);
 void TexMgr_ReloadNobrightImages (void);
 
+// BATCHED LOADING -- decoding, conversion and mipmapping on the task workers
+void TexMgr_BeginBatch (void);
+void TexMgr_EndBatch (void);
+gltexture_t *TexMgr_QueueImage (qmodel_t *owner, const char *name, int width, int height, enum srcformat format,
+				byte *data, const char *source_file, src_offset_t source_offset, unsigned flags);
+gltexture_t *TexMgr_QueueImageFile (qmodel_t *owner, const char *name, imagefile_t *file, const char *source_file, unsigned flags);
+
 int TexMgr_Pad(int s);
 int TexMgr_SafeTextureSize (int s);
 int TexMgr_PadConditional (int s);
@@ -40,7 +40,6 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define MAXHEIGHT		10000
 
 #define MAX_ENABLED_EXTENSIONS 16
-#define NUM_COMMAND_BUFFERS 2
 #define NUM_SWAPCHAIN_COMMAND_BUFFERS 2
 #define MAX_SWAP_CHAIN_IMAGES 8
 #define COLOR_BUFFER_FORMAT VK_FORMAT_R8G8B8A8_UNORM
@@ -93,6 +92,10 @@ static cvar_t	vid_borderless = {"vid_borderless", "0", CVAR_ARCHIVE}; // QuakeSp
 cvar_t	vid_filter = {"vid_filter", "0", CVAR_ARCHIVE};
 cvar_t	vid_anisotropic = {"vid_anisotropic", "0", CVAR_ARCHIVE};
 cvar_t vid_fsaa = {"vid_fsaa", "0", CVAR_ARCHIVE};
+cvar_t vid_dynres = {"vid_dynres", "0", CVAR_ARCHIVE};					// scale the eye resolution to the measured gpu time
+static cvar_t vid_dynres_min = {"vid_dynres_min", "0.6", CVAR_ARCHIVE};
+static cvar_t vid_dynres_max = {"vid_dynres_max", "1", CVAR_ARCHIVE};
+static cvar_t vid_dynres_target = {"vid_dynres_target", "0.85", CVAR_ARCHIVE};	// part of the display's frame time both eyes may take
 
 cvar_t		vid_gamma = {"gamma", "1", CVAR_ARCHIVE}; //johnfitz -- moved here from view.c
 cvar_t		vid_contrast = {"contrast", "1", CVAR_ARCHIVE}; //QuakeSpasm, MarkV
@@ -104,15 +107,18 @@ static VkPhysicalDeviceFeatures		vulkan_physical_device_features;
 static VkSurfaceKHR					vulkan_surface;
 static VkSurfaceCapabilitiesKHR		vulkan_surface_capabilities;
 static VkSwapchainKHR				vulkan_swapchain;
+static SDL_mutex					*queue_mutex;			// the vr pacing thread submits on our queue too
 
 static uint32_t						num_swap_chain_images;
-static uint32_t						current_command_buffer;
+static uint32_t						current_command_buffer;	// frame in flight * NUM_VR_EYES + eye
+static int							current_frame_in_flight;
 static uint32_t						current_swapchain_command_buffer;
 static VkCommandPool				command_pool;
 static VkCommandPool				transient_command_pool;
 static VkCommandBuffer				command_buffers[NUM_COMMAND_BUFFERS];
 static VkCommandBuffer				swapchain_command_buffers[NUM_SWAPCHAIN_COMMAND_BUFFERS];
 static VkFence						command_buffer_fences[NUM_COMMAND_BUFFERS];
+static uint32_t						gfx_queue_timestamp_bits;
 static VkFence						swapchain_command_buffer_fences[NUM_SWAPCHAIN_COMMAND_BUFFERS];
 static qboolean						command_buffer_submitted[NUM_COMMAND_BUFFERS];
 static qboolean						swapchain_command_buffer_submitted[NUM_SWAPCHAIN_COMMAND_BUFFERS];
@@ -143,6 +149,9 @@ static PFN_vkDestroySwapchainKHR fpDestroySwapchainKHR;
 static PFN_vkGetSwapchainImagesKHR fpGetSwapchainImagesKHR;
 static PFN_vkAcquireNextImageKHR fpAcquireNextImageKHR;
 static PFN_vkQueuePresentKHR fpQueuePresentKHR;
+static PFN_vkGetPhysicalDeviceFeatures2KHR fpGetPhysicalDeviceFeatures2KHR;
+static PFN_vkGetPhysicalDeviceProperties2KHR fpGetPhysicalDeviceProperties2KHR;
+static qboolean found_properties2_extension;
 
 #ifdef _DEBUG
 static PFN_vkCreateDebugReportCallbackEXT fpCreateDebugReportCallbackEXT;
@@ -646,6 +655,18 @@ static void GL_InitInstance( void )
 				Sys_Error("Couldn't find %s instance extension", extensions[i]);
 		}
 
+		// Optional, needed to query descriptor indexing support for bindless textures
+		found_properties2_extension = false;
+		for (j = 0; j < num_available_extensions; ++j)
+		{
+			if (Q_strcmp(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME, available_extensions[j].extensionName) == 0)
+			{
+				found_properties2_extension = true;
+				AddExtension(extensions, &num_extensions, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+				break;
+			}
+		}
+
 		free(available_extensions);
 	}
 
@@ -710,6 +731,11 @@ static void GL_InitInstance( void )
 	GET_INSTANCE_PROC_ADDR(vulkan_instance, GetPhysicalDeviceSurfaceFormatsKHR);
 	GET_INSTANCE_PROC_ADDR(vulkan_instance, GetPhysicalDeviceSurfacePresentModesKHR);
 	GET_INSTANCE_PROC_ADDR(vulkan_instance, GetSwapchainImagesKHR);
+	if (found_properties2_extension)
+	{
+		GET_INSTANCE_PROC_ADDR(vulkan_instance, GetPhysicalDeviceFeatures2KHR);
+		GET_INSTANCE_PROC_ADDR(vulkan_instance, GetPhysicalDeviceProperties2KHR);
+	}
 
 #ifdef _DEBUG
 	if(vulkan_globals.validation)
@@ -786,6 +812,8 @@ static void GL_InitDevice( void )
 	AddExtension(extensions, &num_extensions, VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 
 	qboolean found, found_debug_marker_extension;
+	qboolean found_descriptor_indexing_extension = false, found_maintenance3_extension = false;
+	qboolean found_shading_rate_image_extension = false;
 	uint32_t num_available_extensions = 0;
 	err = vkEnumerateDeviceExtensionProperties(vulkan_physical_device, NULL, &num_available_extensions, NULL);
 
@@ -804,6 +832,16 @@ static void GL_InitDevice( void )
 			}
 		}
 
+		for (j = 0; j < num_available_extensions; ++j)
+		{
+			if (Q_strcmp(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME, available_extensions[j].extensionName) == 0)
+				found_descriptor_indexing_extension = true;
+			else if (Q_strcmp(VK_KHR_MAINTENANCE3_EXTENSION_NAME, available_extensions[j].extensionName) == 0)
+				found_maintenance3_extension = true;
+			else if (Q_strcmp(VK_NV_SHADING_RATE_IMAGE_EXTENSION_NAME, available_extensions[j].extensionName) == 0)
+				found_shading_rate_image_extension = true;
+		}
+
 		for (i = 0; i < num_extensions; ++i)
 		{
 			found = false;
@@ -845,6 +883,7 @@ static void GL_InitDevice( void )
 		{
 			found_graphics_queue = true;
 			vulkan_globals.gfx_queue_family_index = i;
+			gfx_queue_timestamp_bits = queue_family_properties[i].timestampValidBits;
 			break;
 		}
 	}
@@ -863,11 +902,120 @@ static void GL_InitDevice( void )
 	queue_create_info.queueCount = 1;
 	queue_create_info.pQueuePriorities = queue_priorities;
 
+	vkGetPhysicalDeviceFeatures(vulkan_physical_device, &vulkan_physical_device_features);
+
+	// only turn on what's used, BC compressed textures are for DDS replacement textures
+	VkPhysicalDeviceFeatures device_features;
+	memset(&device_features, 0, sizeof(device_features));
+	device_features.sampleRateShading = vulkan_physical_device_features.sampleRateShading;
+	device_features.samplerAnisotropy = vulkan_physical_device_features.samplerAnisotropy;
+	device_features.textureCompressionBC = vulkan_physical_device_features.textureCompressionBC;
+	vulkan_globals.texture_compression_bc = vulkan_physical_device_features.textureCompressionBC ? true : false;
+
+	// Bindless textures: one big array of every texture that can be written while in use
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexing_features;
+	memset(&indexing_features, 0, sizeof(indexing_features));
+	indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+	vulkan_globals.bindless = false;
+	if (found_properties2_extension && found_descriptor_indexing_extension && found_maintenance3_extension && !COM_CheckParm("-nobindless"))
+	{
+		VkPhysicalDeviceFeatures2KHR physical_device_features2;
+		memset(&physical_device_features2, 0, sizeof(physical_device_features2));
+		physical_device_features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+		physical_device_features2.pNext = &indexing_features;
+		fpGetPhysicalDeviceFeatures2KHR(vulkan_physical_device, &physical_device_features2);
+
+		VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexing_properties;
+		memset(&indexing_properties, 0, sizeof(indexing_properties));
+		indexing_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+
+		VkPhysicalDeviceProperties2KHR physical_device_properties2;
+		memset(&physical_device_properties2, 0, sizeof(physical_device_properties2));
+		physical_device_properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+		physical_device_properties2.pNext = &indexing_properties;
+		fpGetPhysicalDeviceProperties2KHR(vulkan_physical_device, &physical_device_properties2);
+
+		// world textures are picked by push constants, alias model textures per instance (non-uniform)
+		vulkan_globals.bindless = vulkan_physical_device_features.shaderSampledImageArrayDynamicIndexing
+			&& indexing_features.runtimeDescriptorArray
+			&& indexing_features.shaderSampledImageArrayNonUniformIndexing
+			&& indexing_features.descriptorBindingPartiallyBound
+			&& indexing_features.descriptorBindingSampledImageUpdateAfterBind
+			&& indexing_features.descriptorBindingUpdateUnusedWhilePending
+			&& indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers >= MAX_GLTEXTURES
+			&& indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages >= MAX_GLTEXTURES
+			&& indexing_properties.maxDescriptorSetUpdateAfterBindSamplers >= MAX_GLTEXTURES
+			&& indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages >= MAX_GLTEXTURES;
+	}
+
+	// Foveated rendering, without it r_foveated falls back to masking out pixels in gl_foveate.c
+	VkPhysicalDeviceShadingRateImageFeaturesNV shading_rate_image_features;
+	memset(&shading_rate_image_features, 0, sizeof(shading_rate_image_features));
+	shading_rate_image_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADING_RATE_IMAGE_FEATURES_NV;
+
+	vulkan_globals.shading_rate_image = false;
+	if (found_properties2_extension && found_shading_rate_image_extension && !COM_CheckParm("-noshadingrate"))
+	{
+		VkPhysicalDeviceFeatures2KHR physical_device_features2;
+		memset(&physical_device_features2, 0, sizeof(physical_device_features2));
+		physical_device_features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+		physical_device_features2.pNext = &shading_rate_image_features;
+		fpGetPhysicalDeviceFeatures2KHR(vulkan_physical_device, &physical_device_features2);
+
+		VkPhysicalDeviceShadingRateImagePropertiesNV shading_rate_image_properties;
+		memset(&shading_rate_image_properties, 0, sizeof(shading_rate_image_properties));
+		shading_rate_image_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADING_RATE_IMAGE_PROPERTIES_NV;
+
+		VkPhysicalDeviceProperties2KHR physical_device_properties2;
+		memset(&physical_device_properties2, 0, sizeof(physical_device_properties2));
+		physical_device_properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+		physical_device_properties2.pNext = &shading_rate_image_properties;
+		fpGetPhysicalDeviceProperties2KHR(vulkan_physical_device, &physical_device_properties2);
+
+		vulkan_globals.shading_rate_image = shading_rate_image_features.shadingRateImage
+			&& shading_rate_image_properties.shadingRateTexelSize.width > 0
+			&& shading_rate_image_properties.shadingRateTexelSize.height > 0
+			&& shading_rate_image_properties.shadingRatePaletteSize >= 3;
+		vulkan_globals.shading_rate_texel_size = shading_rate_image_properties.shadingRateTexelSize;
+	}
+
+	VkPhysicalDeviceShadingRateImageFeaturesNV enabled_shading_rate_image_features;
+	memset(&enabled_shading_rate_image_features, 0, sizeof(enabled_shading_rate_image_features));
+	enabled_shading_rate_image_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADING_RATE_IMAGE_FEATURES_NV;
+
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT enabled_indexing_features;
+	memset(&enabled_indexing_features, 0, sizeof(enabled_indexing_features));
+	enabled_indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
 	VkDeviceCreateInfo device_create_info;
 	memset(&device_create_info, 0, sizeof(device_create_info));
 	device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	device_create_info.queueCreateInfoCount = 1;
 	device_create_info.pQueueCreateInfos = &queue_create_info;
+	device_create_info.pEnabledFeatures = &device_features;
+
+	if (vulkan_globals.bindless)
+	{
+		Con_Printf("Using bindless textures\n");
+		device_features.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+		enabled_indexing_features.runtimeDescriptorArray = VK_TRUE;
+		enabled_indexing_features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		enabled_indexing_features.descriptorBindingPartiallyBound = VK_TRUE;
+		enabled_indexing_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		enabled_indexing_features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		device_create_info.pNext = &enabled_indexing_features;
+		AddExtension(extensions, &num_extensions, VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+		AddExtension(extensions, &num_extensions, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+	}
+	if (vulkan_globals.shading_rate_image)
+	{
+		Con_Printf("Using shading rate image\n");
+		enabled_shading_rate_image_features.shadingRateImage = VK_TRUE;
+		enabled_shading_rate_image_features.pNext = (void *)device_create_info.pNext;
+		device_create_info.pNext = &enabled_shading_rate_image_features;
+		AddExtension(extensions, &num_extensions, VK_NV_SHADING_RATE_IMAGE_EXTENSION_NAME);
+	}
 #if _DEBUG
 	if (found_debug_marker_extension)
 		AddExtension(extensions, &num_extensions, VK_EXT_DEBUG_MARKER_EXTENSION_NAME);
@@ -882,14 +1030,19 @@ static void GL_InitDevice( void )
 	for (i = 0; i < num_extensions; ++i)
 		free(extensions[i]);
 
-	vkGetPhysicalDeviceFeatures(vulkan_physical_device, &vulkan_physical_device_features);
-
 	GET_DEVICE_PROC_ADDR(vulkan_globals.device, CreateSwapchainKHR);
 	GET_DEVICE_PROC_ADDR(vulkan_globals.device, DestroySwapchainKHR);
 	GET_DEVICE_PROC_ADDR(vulkan_globals.device, GetSwapchainImagesKHR);
 	GET_DEVICE_PROC_ADDR(vulkan_globals.device, AcquireNextImageKHR);
 	GET_DEVICE_PROC_ADDR(vulkan_globals.device, QueuePresentKHR);
 
+	if (vulkan_globals.shading_rate_image)
+	{
+		vulkan_globals.cmd_bind_shading_rate_image = (PFN_vkCmdBindShadingRateImageNV)fpGetDeviceProcAddr(vulkan_globals.device, "vkCmdBindShadingRateImageNV");
+		if (vulkan_globals.cmd_bind_shading_rate_image == NULL)
+			Sys_Error("vkGetDeviceProcAddr failed to find vkCmdBindShadingRateImageNV");
+	}
+
 #if _DEBUG
 	if (found_debug_marker_extension)
 	{
@@ -899,6 +1052,10 @@ static void GL_InitDevice( void )
 
 	vkGetDeviceQueue(vulkan_globals.device, vulkan_globals.gfx_queue_family_index, 0, &vulkan_globals.queue);
 
+	queue_mutex = SDL_CreateMutex();
+	if (!queue_mutex)
+		Sys_Error("Couldn't create queue mutex: %s", SDL_GetError());
+
 	// Find depth format
 	VkFormatProperties format_properties;
 
@@ -912,6 +1069,11 @@ static void GL_InitDevice( void )
 		vulkan_globals.depth_format = VK_FORMAT_X8_D24_UNORM_PACK32;
 	else if(d32_support)
 		vulkan_globals.depth_format = VK_FORMAT_D32_SFLOAT;
+
+	// Mipmaps can be generated on the GPU if textures can be blitted with linear filtering
+	const VkFormatFeatureFlags blit_features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+	vkGetPhysicalDeviceFormatProperties(vulkan_physical_device, VK_FORMAT_R8G8B8A8_UNORM, &format_properties);
+	vulkan_globals.blit_mipmaps = (format_properties.optimalTilingFeatures & blit_features) == blit_features;
 }
 
 /*
@@ -966,6 +1128,7 @@ static void GL_InitCommandBuffers( void )
 	}
 
 	// Command buffers for swap chain render pass
+	command_buffer_allocate_info.commandBufferCount = NUM_SWAPCHAIN_COMMAND_BUFFERS;
 	err = vkAllocateCommandBuffers(vulkan_globals.device, &command_buffer_allocate_info, swapchain_command_buffers);
 	if (err != VK_SUCCESS)
 		Sys_Error("vkAllocateCommandBuffers failed");
@@ -995,21 +1158,22 @@ static void GL_CreateRenderPasses()
 
 	const qboolean resolve = ( vulkan_globals.sample_count != VK_SAMPLE_COUNT_1_BIT);
 
-	attachment_descriptions[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	// R_BeginMainRenderPass has already put the attachments in their layouts
+	attachment_descriptions[0].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 	attachment_descriptions[0].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 	attachment_descriptions[0].samples = VK_SAMPLE_COUNT_1_BIT;
 	attachment_descriptions[0].format = COLOR_BUFFER_FORMAT;
 	attachment_descriptions[0].loadOp = resolve ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : VK_ATTACHMENT_LOAD_OP_CLEAR;
 	attachment_descriptions[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 
-	attachment_descriptions[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	attachment_descriptions[1].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 	attachment_descriptions[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 	attachment_descriptions[1].samples = vulkan_globals.sample_count;
 	attachment_descriptions[1].format = vulkan_globals.depth_format;
 	attachment_descriptions[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 	attachment_descriptions[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
-	attachment_descriptions[2].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	attachment_descriptions[2].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 	attachment_descriptions[2].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 	attachment_descriptions[2].samples = vulkan_globals.sample_count;
 	attachment_descriptions[2].format = COLOR_BUFFER_FORMAT;
@@ -1090,7 +1254,7 @@ static void GL_CreateRenderPasses()
 	subpass_descriptions[1].inputAttachmentCount = 1;
 	subpass_descriptions[1].pInputAttachments = &color_input_attachment_reference;
 
-	VkSubpassDependency subpass_dependencies[1];
+	VkSubpassDependency subpass_dependencies[3];
 	subpass_dependencies[0].srcSubpass = 0;
 	subpass_dependencies[0].dstSubpass = 1;
 	subpass_dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
@@ -1099,13 +1263,32 @@ static void GL_CreateRenderPasses()
 	subpass_dependencies[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 	subpass_dependencies[0].dependencyFlags = 0;
 
+	// The eye buffer isn't waited for with a fence anymore.  The compositor copies
+	// it and the mirror samples it after this pass, and the next frame's pass
+	// overwrites it, so it has to wait for those reads to finish
+	subpass_dependencies[1].srcSubpass = 1;
+	subpass_dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	subpass_dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	subpass_dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	subpass_dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	subpass_dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+	subpass_dependencies[1].dependencyFlags = 0;
+
+	subpass_dependencies[2].srcSubpass = VK_SUBPASS_EXTERNAL;
+	subpass_dependencies[2].dstSubpass = 1;
+	subpass_dependencies[2].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	subpass_dependencies[2].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	subpass_dependencies[2].srcAccessMask = 0;
+	subpass_dependencies[2].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	subpass_dependencies[2].dependencyFlags = 0;
+
 	memset(&render_pass_create_info, 0, sizeof(render_pass_create_info));
 	render_pass_create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
 	render_pass_create_info.attachmentCount = 2;
 	render_pass_create_info.pAttachments = attachment_descriptions;
 	render_pass_create_info.subpassCount = 2;
 	render_pass_create_info.pSubpasses = subpass_descriptions;
-	render_pass_create_info.dependencyCount = 1;
+	render_pass_create_info.dependencyCount = 3;
 	render_pass_create_info.pDependencies = subpass_dependencies;
 
 	err = vkCreateRenderPass(vulkan_globals.device, &render_pass_create_info, NULL, &vulkan_globals.ui_render_pass);
@@ -1114,37 +1297,6 @@ static void GL_CreateRenderPasses()
 
 	GL_SetObjectName((uint64_t)vulkan_globals.main_render_pass, VK_DEBUG_REPORT_OBJECT_TYPE_RENDER_PASS_EXT, "ui");
 
-	if(vulkan_globals.warp_render_pass == VK_NULL_HANDLE)
-	{
-		// Warp rendering
-		attachment_descriptions[0].format = VK_FORMAT_R8G8B8A8_UNORM;
-		attachment_descriptions[0].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		attachment_descriptions[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-		attachment_descriptions[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		attachment_descriptions[0].finalLayout = VK_IMAGE_LAYOUT_GENERAL;
-		scene_color_attachment_reference.attachment = 0;
-		scene_color_attachment_reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		VkSubpassDescription subpass_description;
-		memset(&subpass_description, 0, sizeof(subpass_description));
-		subpass_description.colorAttachmentCount = 1;
-		subpass_description.pColorAttachments = &scene_color_attachment_reference;
-		subpass_description.pDepthStencilAttachment = NULL;
-		subpass_description.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-
-		render_pass_create_info.subpassCount = 1;
-		render_pass_create_info.pSubpasses = &subpass_description;
-		render_pass_create_info.attachmentCount = 1;
-		render_pass_create_info.dependencyCount = 0;
-		render_pass_create_info.pDependencies = NULL;
-
-		err = vkCreateRenderPass(vulkan_globals.device, &render_pass_create_info, NULL, &vulkan_globals.warp_render_pass);
-		if (err != VK_SUCCESS)
-			Sys_Error("Couldn't create Vulkan render pass");
-
-		GL_SetObjectName((uint64_t)vulkan_globals.warp_render_pass, VK_DEBUG_REPORT_OBJECT_TYPE_RENDER_PASS_EXT, "warp");
-	}
-
 	// Swap chain render pass
 	attachment_descriptions[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 	attachment_descriptions[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
@@ -1202,7 +1354,7 @@ static void GL_CreateDepthBuffer( void )
 	image_create_info.arrayLayers = 1;
 	image_create_info.samples = vulkan_globals.sample_count;
 	image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
-	image_create_info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	image_create_info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
 
 	err = vkCreateImage(vulkan_globals.device, &image_create_info, NULL, &depth_buffer);
 	if (err != VK_SUCCESS)
@@ -1217,7 +1369,8 @@ static void GL_CreateDepthBuffer( void )
 	memset(&memory_allocate_info, 0, sizeof(memory_allocate_info));
 	memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
 	memory_allocate_info.allocationSize = memory_requirements.size;
-	memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0);
+	// never loaded or stored, tilers can keep it on chip
+	memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
 
 	num_vulkan_misc_allocations += 1;
 	err = vkAllocateMemory(vulkan_globals.device, &memory_allocate_info, NULL, &depth_buffer_memory);
@@ -1248,6 +1401,8 @@ static void GL_CreateDepthBuffer( void )
 		Sys_Error("vkCreateImageView failed");
 
 	GL_SetObjectName((uint64_t)depth_buffer_view, VK_DEBUG_REPORT_OBJECT_TYPE_IMAGE_VIEW_EXT, "Depth Buffer View");
+
+	R_GraphSetImage(RG_DEPTH_BUFFER, depth_buffer, VK_IMAGE_ASPECT_DEPTH_BIT);
 }
 
 
@@ -1374,7 +1529,7 @@ static void GL_CreateColorBuffer( void )
 	if (vulkan_globals.sample_count != VK_SAMPLE_COUNT_1_BIT)
 	{
 		image_create_info.samples = vulkan_globals.sample_count;
-		image_create_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+		image_create_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
 
 		err = vkCreateImage(vulkan_globals.device, &image_create_info, NULL, &msaa_color_buffer);
 		if (err != VK_SUCCESS)
@@ -1389,7 +1544,8 @@ static void GL_CreateColorBuffer( void )
 		memset(&memory_allocate_info, 0, sizeof(memory_allocate_info));
 		memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
 		memory_allocate_info.allocationSize = memory_requirements.size;
-		memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0);
+		// only ever resolved, like the depth buffer
+		memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
 
 		num_vulkan_misc_allocations += 1;
 		err = vkAllocateMemory(vulkan_globals.device, &memory_allocate_info, NULL, &msaa_color_buffer_memory);
@@ -1419,6 +1575,10 @@ static void GL_CreateColorBuffer( void )
 		if (err != VK_SUCCESS)
 			Sys_Error("vkCreateImageView failed");
 	}
+
+	R_GraphSetImage(RG_COLOR_BUFFER_0, vulkan_globals.color_buffers[0], VK_IMAGE_ASPECT_COLOR_BIT);
+	R_GraphSetImage(RG_COLOR_BUFFER_1, vulkan_globals.color_buffers[1], VK_IMAGE_ASPECT_COLOR_BIT);
+	R_GraphSetImage(RG_MSAA_COLOR_BUFFER, msaa_color_buffer, VK_IMAGE_ASPECT_COLOR_BIT);
 }
 
 /*
@@ -1818,6 +1978,186 @@ static void GL_DestroyBeforeSetMode( void )
 	vkDestroyRenderPass(vulkan_globals.device, vulkan_globals.swapchain_render_pass, NULL);
 }
 
+/*
+=================
+GL_DrawMirror -- copies the right eye into the window and presents it
+=================
+*/
+static void GL_DrawMirror (void)
+{
+	VkResult err;
+
+	if (swapchain_command_buffer_submitted[current_swapchain_command_buffer])
+	{
+		err = vkWaitForFences(vulkan_globals.device, 1, &swapchain_command_buffer_fences[current_swapchain_command_buffer], VK_TRUE, UINT64_MAX);
+		if (err != VK_SUCCESS)
+			Sys_Error("vkWaitForFences failed");
+	}
+
+	err = vkResetFences(vulkan_globals.device, 1, &swapchain_command_buffer_fences[current_swapchain_command_buffer]);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkResetFences failed");
+
+	VkCommandBufferBeginInfo command_buffer_begin_info;
+	memset(&command_buffer_begin_info, 0, sizeof(command_buffer_begin_info));
+	command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+	vulkan_globals.swapchain_command_buffer = swapchain_command_buffers[current_swapchain_command_buffer];
+	err = vkBeginCommandBuffer(vulkan_globals.swapchain_command_buffer, &command_buffer_begin_info);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkBeginCommandBuffer failed");
+
+	GL_ProfilerBeginFrame(vulkan_globals.swapchain_command_buffer, GPU_CONTEXT_SWAPCHAIN + current_swapchain_command_buffer, VR_EYE_RIGHT);
+
+	err = fpAcquireNextImageKHR(vulkan_globals.device, vulkan_swapchain, UINT64_MAX, image_aquired_semaphores[current_swapchain_command_buffer], VK_NULL_HANDLE, &current_swapchain_buffer);
+	if (err != VK_SUCCESS)
+		Sys_Error("Couldn't acquire next image");
+
+	VkRect2D render_area;
+	render_area.offset.x = 0;
+	render_area.offset.y = 0;
+	render_area.extent.width = vid.width;
+	render_area.extent.height = vid.height;
+
+	memset(&vulkan_globals.swapchain_render_pass_begin_info, 0, sizeof(vulkan_globals.swapchain_render_pass_begin_info));
+	vulkan_globals.swapchain_render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	vulkan_globals.swapchain_render_pass_begin_info.renderArea = render_area;
+	vulkan_globals.swapchain_render_pass_begin_info.renderPass = vulkan_globals.swapchain_render_pass;
+	vulkan_globals.swapchain_render_pass_begin_info.framebuffer = swapchain_framebuffers[current_swapchain_buffer];
+
+	vkCmdSetScissor(vulkan_globals.swapchain_command_buffer, 0, 1, &render_area);
+
+	VkViewport viewport;
+	viewport.x = 0;
+	viewport.y = 0;
+	viewport.width = vid.width;
+	viewport.height = vid.height;
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	vkCmdSetViewport(vulkan_globals.swapchain_command_buffer, 0, 1, &viewport);
+
+	GL_BeginGPUScope(GPU_SCOPE_SWAPCHAIN);
+	vkCmdBeginRenderPass(vulkan_globals.swapchain_command_buffer, &vulkan_globals.swapchain_render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+
+	// only the rendered part of the eye buffer
+	const float u = (float)vr.render_width / (float)vr.width;
+	const float v = (float)vr.render_height / (float)vr.height;
+	float texcoord_values[6] = { 0.0f, 0.0f, u * 2.0f, 0.0f, 0.0f, v * 2.0f };
+
+	vkCmdBindDescriptorSets(vulkan_globals.swapchain_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.swapchain_pipeline_layout, 0, 1, &swapchain_descriptor_set, 0, NULL);
+	vkCmdBindPipeline(vulkan_globals.swapchain_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.swapchain_pipeline);
+	vkCmdPushConstants(vulkan_globals.swapchain_command_buffer, vulkan_globals.swapchain_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, 6 * sizeof(float), texcoord_values);
+	vkCmdDraw(vulkan_globals.swapchain_command_buffer, 3, 1, 0, 0);
+
+	vkCmdEndRenderPass(vulkan_globals.swapchain_command_buffer);
+	GL_EndGPUScope(GPU_SCOPE_SWAPCHAIN);
+
+	err = vkEndCommandBuffer(vulkan_globals.swapchain_command_buffer);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkEndCommandBuffer failed");
+
+	VkPipelineStageFlags wait_dst_stage_mask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+	VkSubmitInfo submit_info;
+	memset(&submit_info, 0, sizeof(submit_info));
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &swapchain_command_buffers[current_swapchain_command_buffer];
+	submit_info.waitSemaphoreCount = 1;
+	submit_info.pWaitSemaphores = &image_aquired_semaphores[current_swapchain_command_buffer];
+	submit_info.pWaitDstStageMask = &wait_dst_stage_mask;
+
+	GL_LockQueue();
+	err = vkQueueSubmit(vulkan_globals.queue, 1, &submit_info, swapchain_command_buffer_fences[current_swapchain_command_buffer]);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkQueueSubmit failed");
+
+	vulkan_globals.device_idle = false;
+
+	swapchain_command_buffer_submitted[current_swapchain_command_buffer] = true;
+	current_swapchain_command_buffer = (current_swapchain_command_buffer + 1) % NUM_SWAPCHAIN_COMMAND_BUFFERS;
+
+	VkPresentInfoKHR present_info;
+	memset(&present_info, 0, sizeof(present_info));
+	present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+	present_info.swapchainCount = 1;
+	present_info.pSwapchains = &vulkan_swapchain,
+		present_info.pImageIndices = &current_swapchain_buffer;
+	err = fpQueuePresentKHR(vulkan_globals.queue, &present_info);
+	GL_UnlockQueue();
+	if (err != VK_SUCCESS)
+		Sys_Error("vkQueuePresentKHR failed");
+}
+
+/*
+=================
+GL_UpdateRenderScale
+
+Timestamps come back a few frames late, so after every change the scale is held
+until they reflect it.  Going down is fast and proportional to the overshoot,
+going up is in small steps and only with a clear margin, so it doesn't flip
+back and forth around the budget
+=================
+*/
+#define DYNRES_SETTLE_FRAMES	4		// on top of the frames in flight
+#define DYNRES_RAISE_MARGIN		0.8f	// raise only below this part of the budget
+#define DYNRES_RAISE_STEP		0.02f
+#define DYNRES_MAX_DROP			0.85f	// largest decrease per step
+
+static void GL_UpdateRenderScale (void)
+{
+	static float	scale = 1.0f;
+	static float	average_ms;
+	static int		settle_frames;
+	float			min_scale, max_scale, budget_ms, gpu_ms, new_scale;
+
+	max_scale = CLAMP (0.25f, vid_dynres_max.value, 1.0f);
+	min_scale = CLAMP (0.25f, vid_dynres_min.value, max_scale);
+
+	if (!vid_dynres.value)
+	{
+		scale = 1.0f;
+		average_ms = 0.0f;
+		settle_frames = 0;
+	}
+	else if (settle_frames > 0)
+	{
+		settle_frames--;
+	}
+	else
+	{
+		gpu_ms = gpu_total_ms[VR_EYE_LEFT] + gpu_total_ms[VR_EYE_RIGHT];
+		if (gpu_ms > 0.0f)
+		{
+			average_ms = (average_ms > 0.0f) ? average_ms * 0.75f + gpu_ms * 0.25f : gpu_ms;
+			budget_ms = 1000.0f / VR_GetDisplayFrequency () * CLAMP (0.25f, vid_dynres_target.value, 1.0f);
+
+			// the pixel count and roughly the gpu time go with the square of the scale
+			new_scale = scale;
+			if (average_ms > budget_ms)
+				new_scale = scale * q_max (DYNRES_MAX_DROP, sqrtf (budget_ms / average_ms));
+			else if (average_ms < budget_ms * DYNRES_RAISE_MARGIN)
+				new_scale = scale + DYNRES_RAISE_STEP;
+
+			new_scale = CLAMP (min_scale, new_scale, max_scale);
+			if (fabsf (new_scale - scale) > 0.001f)
+			{
+				scale = new_scale;
+				average_ms = 0.0f;
+				settle_frames = vulkan_globals.num_frames_in_flight + DYNRES_SETTLE_FRAMES;
+			}
+		}
+	}
+
+	scale = CLAMP (min_scale, scale, max_scale);
+	if (!vid_dynres.value)
+		scale = 1.0f;
+
+	vr.render_width = q_max (1, (uint32_t)(vr.width * scale));
+	vr.render_height = q_max (1, (uint32_t)(vr.height * scale));
+}
+
 /*
 =================
 GL_BeginRendering
@@ -1827,10 +2167,17 @@ void GL_BeginRendering (int *x, int *y, int *width, int *height)
 {
 	int i;
 
-	R_SwapDynamicBuffers();
-
 	vulkan_globals.device_idle = false;
-	current_command_buffer = vr.current_eye;
+
+	// both eyes of a frame share its slot, the CPU only waits once a slot comes around again
+	// and render at the same resolution
+	if (vr.current_eye == VR_EYE_LEFT)
+	{
+		current_frame_in_flight = (current_frame_in_flight + 1) % vulkan_globals.num_frames_in_flight;
+		GL_UpdateRenderScale();
+	}
+	current_command_buffer = current_frame_in_flight * NUM_VR_EYES + vr.current_eye;
+
 	*x = *y = 0;
 	*width = vr.width;
 	*height = vr.height;
@@ -1842,107 +2189,12 @@ void GL_BeginRendering (int *x, int *y, int *width, int *height)
 		err = vkWaitForFences(vulkan_globals.device, 1, &command_buffer_fences[current_command_buffer], VK_TRUE, UINT64_MAX);
 		if (err != VK_SUCCESS)
 			Sys_Error("vkWaitForFences failed");
-
-		VR_Submit(vr.current_eye, vulkan_globals.color_buffers[vr.current_eye == VR_EYE_LEFT ? VR_EYE_BUFFER_LEFT : VR_EYE_BUFFER_RIGHT]);
-
-		if (vr.current_eye == VR_EYE_RIGHT)
-		{
-			// Render right eye color buffer to swap chain
-			if (swapchain_command_buffer_submitted[current_swapchain_command_buffer])
-			{
-				err = vkWaitForFences(vulkan_globals.device, 1, &swapchain_command_buffer_fences[current_swapchain_command_buffer], VK_TRUE, UINT64_MAX);
-				if (err != VK_SUCCESS)
-					Sys_Error("vkWaitForFences failed");
-			}
-
-			err = vkResetFences(vulkan_globals.device, 1, &swapchain_command_buffer_fences[current_swapchain_command_buffer]);
-			if (err != VK_SUCCESS)
-				Sys_Error("vkResetFences failed");
-
-			VkCommandBufferBeginInfo command_buffer_begin_info;
-			memset(&command_buffer_begin_info, 0, sizeof(command_buffer_begin_info));
-			command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-
-			vulkan_globals.swapchain_command_buffer = swapchain_command_buffers[current_swapchain_command_buffer];
-			err = vkBeginCommandBuffer(vulkan_globals.swapchain_command_buffer, &command_buffer_begin_info);
-			if (err != VK_SUCCESS)
-				Sys_Error("vkBeginCommandBuffer failed");
-
-			err = fpAcquireNextImageKHR(vulkan_globals.device, vulkan_swapchain, UINT64_MAX, image_aquired_semaphores[current_swapchain_command_buffer], VK_NULL_HANDLE, &current_swapchain_buffer);
-			if (err != VK_SUCCESS)
-				Sys_Error("Couldn't acquire next image");
-
-			VkRect2D render_area;
-			render_area.offset.x = 0;
-			render_area.offset.y = 0;
-			render_area.extent.width = vid.width;
-			render_area.extent.height = vid.height;
-
-			memset(&vulkan_globals.swapchain_render_pass_begin_info, 0, sizeof(vulkan_globals.swapchain_render_pass_begin_info));
-			vulkan_globals.swapchain_render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-			vulkan_globals.swapchain_render_pass_begin_info.renderArea = render_area;
-			vulkan_globals.swapchain_render_pass_begin_info.renderPass = vulkan_globals.swapchain_render_pass;
-			vulkan_globals.swapchain_render_pass_begin_info.framebuffer = swapchain_framebuffers[current_swapchain_buffer];
-
-			vkCmdSetScissor(vulkan_globals.swapchain_command_buffer, 0, 1, &render_area);
-
-			VkViewport viewport;
-			viewport.x = 0;
-			viewport.y = 0;
-			viewport.width = vid.width;
-			viewport.height = vid.height;
-			viewport.minDepth = 0.0f;
-			viewport.maxDepth = 1.0f;
-
-			vkCmdSetViewport(vulkan_globals.swapchain_command_buffer, 0, 1, &viewport);
-
-			vkCmdBeginRenderPass(vulkan_globals.swapchain_command_buffer, &vulkan_globals.swapchain_render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
-
-			float texcoord_values[6] = { 0.0f, 0.0f, 1.0f * 2.0f, 0.0f, 0.0f, 1.0f * 2.0f };
-
-			vkCmdBindDescriptorSets(vulkan_globals.swapchain_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.swapchain_pipeline_layout, 0, 1, &swapchain_descriptor_set, 0, NULL);
-			vkCmdBindPipeline(vulkan_globals.swapchain_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.swapchain_pipeline);
-			vkCmdPushConstants(vulkan_globals.swapchain_command_buffer, vulkan_globals.swapchain_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, 6 * sizeof(float), texcoord_values);
-			vkCmdDraw(vulkan_globals.swapchain_command_buffer, 3, 1, 0, 0);
-
-			vkCmdEndRenderPass(vulkan_globals.swapchain_command_buffer);
-
-			err = vkEndCommandBuffer(vulkan_globals.swapchain_command_buffer);
-			if (err != VK_SUCCESS)
-				Sys_Error("vkEndCommandBuffer failed");
-
-			VkPipelineStageFlags wait_dst_stage_mask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-
-			VkSubmitInfo submit_info;
-			memset(&submit_info, 0, sizeof(submit_info));
-			submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-			submit_info.commandBufferCount = 1;
-			submit_info.pCommandBuffers = &swapchain_command_buffers[current_swapchain_command_buffer];
-			submit_info.waitSemaphoreCount = 1;
-			submit_info.pWaitSemaphores = &image_aquired_semaphores[current_swapchain_command_buffer];
-			submit_info.pWaitDstStageMask = &wait_dst_stage_mask;
-
-			err = vkQueueSubmit(vulkan_globals.queue, 1, &submit_info, swapchain_command_buffer_fences[current_swapchain_command_buffer]);
-			if (err != VK_SUCCESS)
-				Sys_Error("vkQueueSubmit failed");
-
-			vulkan_globals.device_idle = false;
-
-			swapchain_command_buffer_submitted[current_swapchain_command_buffer] = true;
-			current_swapchain_command_buffer = (current_swapchain_command_buffer + 1) % NUM_SWAPCHAIN_COMMAND_BUFFERS;
-
-			VkPresentInfoKHR present_info;
-			memset(&present_info, 0, sizeof(present_info));
-			present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-			present_info.swapchainCount = 1;
-			present_info.pSwapchains = &vulkan_swapchain,
-				present_info.pImageIndices = &current_swapchain_buffer;
-			err = fpQueuePresentKHR(vulkan_globals.queue, &present_info);
-			if (err != VK_SUCCESS)
-				Sys_Error("vkQueuePresentKHR failed");
-		}
 	}
 
+	// the fence has been waited on, the dynamic buffers and latch slot of this frame are free again
+	R_SwapDynamicBuffers(current_command_buffer);
+	R_BeginLatch(current_command_buffer);
+
 	err = vkResetFences(vulkan_globals.device, 1, &command_buffer_fences[current_command_buffer]);
 	if (err != VK_SUCCESS)
 		Sys_Error("vkResetFences failed");
@@ -1956,11 +2208,14 @@ void GL_BeginRendering (int *x, int *y, int *width, int *height)
 	if (err != VK_SUCCESS)
 		Sys_Error("vkBeginCommandBuffer failed");
 
+	GL_ProfilerBeginFrame(vulkan_globals.command_buffer, current_command_buffer, vr.current_eye);
+	R_BeginFoveation(current_command_buffer);
+
 	VkRect2D render_area;
 	render_area.offset.x = 0;
 	render_area.offset.y = 0;
-	render_area.extent.width = vr.width;
-	render_area.extent.height = vr.height;
+	render_area.extent.width = vr.render_width;
+	render_area.extent.height = vr.render_height;
 
 	VkClearValue depth_clear_value;
 	depth_clear_value.depthStencil.depth = 1.0f;
@@ -1993,8 +2248,8 @@ void GL_BeginRendering (int *x, int *y, int *width, int *height)
 	VkViewport viewport;
 	viewport.x = 0;
 	viewport.y = 0;
-	viewport.width = vr.width;
-	viewport.height = vr.height;
+	viewport.width = vr.render_width;
+	viewport.height = vr.render_height;
 	viewport.minDepth = 0.0f;
 	viewport.maxDepth = 1.0f;
 
@@ -2018,10 +2273,12 @@ void GL_EndRendering (void)
 	float postprocess_values[2] = { vid_gamma.value, q_min(2.0f, q_max(1.0f, vid_contrast.value)) };
 
 	vkCmdNextSubpass(vulkan_globals.command_buffer, VK_SUBPASS_CONTENTS_INLINE);
+	GL_BeginGPUScope(GPU_SCOPE_POSTPROCESS);
 	vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.postprocess_pipeline_layout, 0, 1, &postprocess_descriptor_set, 0, NULL);
 	vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.postprocess_pipeline);
 	vkCmdPushConstants(vulkan_globals.command_buffer, vulkan_globals.postprocess_pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, 2 * sizeof(float), postprocess_values);
 	vkCmdDraw(vulkan_globals.command_buffer, 3, 1, 0, 0);
+	GL_EndGPUScope(GPU_SCOPE_POSTPROCESS);
 
 	vkCmdEndRenderPass(vulkan_globals.command_buffer);
 
@@ -2035,13 +2292,50 @@ void GL_EndRendering (void)
 	submit_info.commandBufferCount = 1;
 	submit_info.pCommandBuffers = &command_buffers[current_command_buffer];
 
+	// As late as possible, the head has moved since the view was recorded
+	R_LatchPose();
+
+	GL_LockQueue();
 	err = vkQueueSubmit(vulkan_globals.queue, 1, &submit_info, command_buffer_fences[current_command_buffer]);
+	GL_UnlockQueue();
 	if (err != VK_SUCCESS)
 		Sys_Error("vkQueueSubmit failed");
 
 	vulkan_globals.device_idle = false;
 
 	command_buffer_submitted[current_command_buffer] = true;
+
+	// Before the right eye goes to the compositor, with vr_pacing the queue may
+	// then be busy until WaitGetPoses returns
+	if (vr.current_eye == VR_EYE_RIGHT)
+		GL_DrawMirror();
+
+	// The compositor copies the eye on our queue, so it lands after the commands
+	// that rendered it and there is no need to wait for the fence first
+	VR_Submit(vr.current_eye, vulkan_globals.color_buffers[vr.current_eye == VR_EYE_LEFT ? VR_EYE_BUFFER_LEFT : VR_EYE_BUFFER_RIGHT]);
+}
+
+/*
+=================
+GL_LockQueue
+
+Everything that uses the queue, vkDeviceWaitIdle included, must hold this.
+SDL mutexes are recursive
+=================
+*/
+void GL_LockQueue (void)
+{
+	SDL_LockMutex(queue_mutex);
+}
+
+/*
+=================
+GL_UnlockQueue
+=================
+*/
+void GL_UnlockQueue (void)
+{
+	SDL_UnlockMutex(queue_mutex);
 }
 
 /*
@@ -2054,7 +2348,9 @@ void GL_WaitForDeviceIdle()
 	if (!vulkan_globals.device_idle)
 	{
 		R_SubmitStagingBuffers();
+		GL_LockQueue();
 		vkDeviceWaitIdle(vulkan_globals.device);
+		GL_UnlockQueue();
 	}
 
 	vulkan_globals.device_idle = true;
@@ -2205,6 +2501,10 @@ void	VID_Init (void)
 	Cvar_RegisterVariable (&vid_filter);
 	Cvar_RegisterVariable (&vid_anisotropic);
 	Cvar_RegisterVariable (&vid_fsaa);
+	Cvar_RegisterVariable (&vid_dynres);
+	Cvar_RegisterVariable (&vid_dynres_min);
+	Cvar_RegisterVariable (&vid_dynres_max);
+	Cvar_RegisterVariable (&vid_dynres_target);
 	Cvar_RegisterVariable (&vid_desktopfullscreen); //QuakeSpasm
 	Cvar_RegisterVariable (&vid_borderless); //QuakeSpasm
 	Cvar_SetCallback (&vid_fullscreen, VID_Changed_f);
@@ -2310,6 +2610,11 @@ void	VID_Init (void)
 
 	vid_initialized = true;
 
+	vulkan_globals.num_frames_in_flight = 2;
+	p = COM_CheckParm("-framesinflight");
+	if (p && p < com_argc-1)
+		vulkan_globals.num_frames_in_flight = CLAMP(1, Q_atoi(com_argv[p+1]), MAX_FRAMES_IN_FLIGHT);
+
 	vid.colormap = host_colormap;
 	vid.fullbright = 256 - LittleLong (*((int *)vid.colormap + 2048));
 
@@ -2322,6 +2627,7 @@ void	VID_Init (void)
 	GL_InitInstance();
 	GL_InitDevice();
 	GL_InitCommandBuffers();
+	GL_InitProfiler(gfx_queue_timestamp_bits);
 	GL_CreateSwapChain();
 	GL_CreateColorBuffer();
 	GL_CreateDepthBuffer();
@@ -2331,8 +2637,12 @@ void	VID_Init (void)
 	R_CreateDescriptorSetLayouts();
 	R_CreateDescriptorPool();
 	R_InitDynamicBuffers();
+	R_InitLatchBuffer();
+	R_InitFoveation();
+	VR_CreateHiddenAreaMeshBuffer();
 	R_InitSamplers();
 	R_CreatePipelineLayouts();
+	R_CreatePipelineCache();
 	R_CreatePipelines();
 	GL_CreateDescriptorSets();
 
@@ -2407,6 +2717,7 @@ static void VID_Restart (void)
 	GL_CreateDepthBuffer();
 	GL_CreateRenderPasses();
 	GL_CreateFrameBuffers();
+	VR_CreateHiddenAreaMeshBuffer();
 	R_CreatePipelines();
 	GL_CreateDescriptorSets();
 
@@ -3083,7 +3394,7 @@ void SCR_ScreenShot_f (void)
 	image_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
 	image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 	image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	image_barrier.image = swapchain_images[current_command_buffer];
+	image_barrier.image = swapchain_images[current_swapchain_buffer];
 	image_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	image_barrier.subresourceRange.baseMipLevel = 0;
 	image_barrier.subresourceRange.levelCount = 1;
@@ -3103,7 +3414,7 @@ void SCR_ScreenShot_f (void)
 	image_copy.imageExtent.height = glheight;
 	image_copy.imageExtent.depth = 1;
 
-	vkCmdCopyImageToBuffer(command_buffer, swapchain_images[current_command_buffer], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &image_copy);
+	vkCmdCopyImageToBuffer(command_buffer, swapchain_images[current_swapchain_buffer], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &image_copy);
 
 	err = vkEndCommandBuffer(command_buffer);
 	if (err != VK_SUCCESS)
@@ -3115,11 +3426,13 @@ void SCR_ScreenShot_f (void)
 	submit_info.commandBufferCount = 1;
 	submit_info.pCommandBuffers = &command_buffer;
 
+	GL_LockQueue();
 	err = vkQueueSubmit(vulkan_globals.queue, 1, &submit_info, VK_NULL_HANDLE);
 	if (err != VK_SUCCESS)
 		Sys_Error("vkQueueSubmit failed");
 
 	err = vkDeviceWaitIdle(vulkan_globals.device);
+	GL_UnlockQueue();
 	if (err != VK_SUCCESS)
 		Sys_Error("vkDeviceWaitIdle failed");
 
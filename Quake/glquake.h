@@ -26,6 +26,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define __GLQUAKE_H
 
 void GL_WaitForDeviceIdle();
+void GL_LockQueue (void);
+void GL_UnlockQueue (void);
 void GL_BeginRendering (int *x, int *y, int *width, int *height);
 void GL_EndRendering (void);
 void GL_Set2D (void);
@@ -49,6 +51,8 @@ extern	int glx, gly, glwidth, glheight;
 
 #define	MAX_GLTEXTURES	2048
 #define NUM_COLOR_BUFFERS 4
+#define MAX_FRAMES_IN_FLIGHT 3
+#define NUM_COMMAND_BUFFERS (MAX_FRAMES_IN_FLIGHT * NUM_VR_EYES)	// one per eye of every frame in flight
 
 void R_TimeRefresh_f (void);
 void R_ReadPointFile_f (void);
@@ -87,20 +91,25 @@ typedef enum {
 	pt_static, pt_grav, pt_slowgrav, pt_fire, pt_explode, pt_explode2, pt_blob, pt_blob2
 } ptype_t;
 
-// !!! if this is changed, it must be changed in d_ifacea.h too !!!
+// a spawned particle, r_part.c moves it into the GPU ring or the per type CPU buckets
 typedef struct particle_s
 {
-// driver-usable fields
 	vec3_t		org;
 	float		color;
-// drivers never touch the following fields
-	struct particle_s	*next;
 	vec3_t		vel;
 	float		ramp;
 	float		die;
 	ptype_t		type;
 } particle_t;
 
+#ifdef PARTICLECHECK	// r_particlecheck, see r_partcheck.c
+void R_ParticleCheck_f (void);
+int R_CheckRecordSpawns (particle_t *dst, int max, int effect, double time);
+void R_CheckRunBuckets (const particle_t *spawns, int count, double time, float frametime, float grav);
+int R_CheckGetBucket (int type, particle_t *dst);
+void R_CheckFreeBuckets (void);
+#endif
+
 #define WORLD_PIPELINE_COUNT 8
 
 typedef struct
@@ -119,6 +128,13 @@ typedef struct
 	VkFormat							depth_format;
 	VkSampleCountFlagBits				sample_count;
 	qboolean							supersampling;
+	qboolean							texture_compression_bc;
+	qboolean							blit_mipmaps;
+	qboolean							bindless;
+	qboolean							shading_rate_image;		// VK_NV_shading_rate_image, see r_foveated
+	VkExtent2D							shading_rate_texel_size;
+	PFN_vkCmdBindShadingRateImageNV		cmd_bind_shading_rate_image;
+	int									num_frames_in_flight;	// -framesinflight, at most MAX_FRAMES_IN_FLIGHT
 
 	// Buffers
 	VkImage								color_buffers[NUM_COLOR_BUFFERS];
@@ -129,11 +145,11 @@ typedef struct
 	VkRenderPassBeginInfo				main_render_pass_begin_infos[2];
 	VkRenderPass						ui_render_pass;
 	VkRenderPassBeginInfo				ui_render_pass_begin_info;
-	VkRenderPass						warp_render_pass;
 	VkRenderPass						swapchain_render_pass;
 	VkRenderPassBeginInfo				swapchain_render_pass_begin_info;
 
 	// Pipelines
+	VkPipelineCache						pipeline_cache;
 	VkPipeline							basic_alphatest_pipeline[2];
 	VkPipeline							basic_blend_pipeline[2];
 	VkPipeline							basic_notex_blend_pipeline[2];
@@ -141,18 +157,26 @@ typedef struct
 	VkPipelineLayout					basic_pipeline_layout;
 	VkPipeline							world_pipelines[WORLD_PIPELINE_COUNT];
 	VkPipelineLayout					world_pipeline_layout;
+	VkPipeline							world_bindless_pipelines[WORLD_PIPELINE_COUNT];
+	VkPipelineLayout					world_bindless_pipeline_layout;
 	VkPipeline							water_pipeline;
 	VkPipeline							water_blend_pipeline;
-	VkPipeline							warp_pipeline;
 	VkPipeline							particle_pipeline;
+	VkPipeline							gpu_particle_pipeline;
+	VkPipelineLayout					gpu_particle_pipeline_layout;
+	VkPipeline							particle_simulate_pipeline;
+	VkPipelineLayout					particle_simulate_pipeline_layout;
 	VkPipeline							sprite_pipeline;
-	VkPipeline							sky_color_pipeline;
 	VkPipeline							sky_box_pipeline;
+	VkPipelineLayout					sky_box_pipeline_layout;
 	VkPipeline							sky_layer_pipeline;
 	VkPipelineLayout					sky_layer_pipeline_layout;
 	VkPipeline							alias_pipeline;
 	VkPipeline							alias_blend_pipeline;
 	VkPipelineLayout					alias_pipeline_layout;
+	VkPipeline							alias_bindless_pipeline;
+	VkPipeline							alias_bindless_blend_pipeline;
+	VkPipelineLayout					alias_bindless_pipeline_layout;
 	VkPipeline							postprocess_pipeline;
 	VkPipelineLayout					postprocess_pipeline_layout;
 	VkPipeline							swapchain_pipeline;
@@ -160,14 +184,25 @@ typedef struct
 	VkPipeline							hidden_area_mesh_pipeline;
 	VkPipeline							screen_warp_pipeline;
 	VkPipelineLayout					screen_warp_pipeline_layout;
+	VkPipeline							foveation_mask_pipeline;
+	VkPipeline							foveation_fill_pipeline;
+	VkPipelineLayout					foveation_fill_pipeline_layout;
 
 	// Descriptors
 	VkDescriptorPool					descriptor_pool;
 	VkDescriptorSetLayout				ubo_set_layout;
+	VkDescriptorSetLayout				storage_set_layout;
+	VkDescriptorSetLayout				pose_set_layout;
+	VkDescriptorSetLayout				latch_set_layout;
+	VkDescriptorSetLayout				particle_set_layout;
+	VkDescriptorSetLayout				sky_box_set_layout;
 	VkDescriptorSetLayout				single_texture_set_layout;
 	VkDescriptorSetLayout				input_attachment_set_layout;
 	VkDescriptorSet						screen_warp_desc_set;
 	VkDescriptorSetLayout				screen_warp_set_layout;
+	VkDescriptorPool					bindless_descriptor_pool;
+	VkDescriptorSetLayout				bindless_set_layout;
+	VkDescriptorSet						bindless_descriptor_set;	// every texture, indexed by gltexture_t.bindless_index
 
 	// Samplers
 	VkSampler							point_sampler;
@@ -193,6 +228,7 @@ extern	int		r_framecount;
 extern	mplane_t	frustum[4];
 extern	int render_pass_index;
 extern	qboolean render_warp;
+extern	qboolean foveation_mask;
 
 //
 // view origin
@@ -235,8 +271,6 @@ extern	cvar_t	gl_nocolors;
 
 extern	cvar_t	gl_playermip;
 
-extern	cvar_t	gl_subdivide_size;
-extern	float	load_subdivide_size; //johnfitz -- remember what subdivide_size value was when this map was loaded
 
 extern int		gl_stencilbits;
 
@@ -319,13 +353,14 @@ void R_InitParticles (void);
 void R_DrawParticles (void);
 void CL_RunParticles (void);
 void R_ClearParticles (void);
+void R_UpdateGPUParticles (void);
 
 void R_TranslatePlayerSkin (int playernum);
 void R_TranslateNewPlayerSkin (int playernum); //johnfitz -- this handles cases when the actual texture changes
-void R_UpdateWarpTextures (void);
 
 void R_DrawWorld (void);
 void R_DrawAliasModel (entity_t *e);
+void R_FlushAliasInstances (void);
 void R_DrawBrushModel (entity_t *e);
 void R_DrawSpriteModel (entity_t *e);
 
@@ -341,7 +376,6 @@ void R_RebuildAllLightmaps (void);
 
 int R_LightPoint (vec3_t p);
 
-void GL_SubdivideSurface (msurface_t *fa);
 void R_BuildLightMap (msurface_t *surf, byte *dest, int stride);
 void R_RenderDynamicLightmaps (msurface_t *fa);
 void R_UploadLightmaps (void);
@@ -361,6 +395,7 @@ void Sky_DrawSky (void);
 void Sky_NewMap (void);
 void Sky_LoadTexture (texture_t *mt);
 void Sky_LoadSkyBox (const char *name);
+void Sky_UpdateSkyBoxDescriptorSet (void);
 
 void R_ClearTextureChains (qmodel_t *mod, texchain_t chain);
 void R_ChainSurface (msurface_t *surf, texchain_t chain);
@@ -375,6 +410,7 @@ void R_CreateDescriptorPool();
 void R_CreateDescriptorSetLayouts();
 void R_InitSamplers();
 void R_CreatePipelineLayouts();
+void R_CreatePipelineCache();
 void R_CreatePipelines();
 void R_DestroyPipelines();
 
@@ -383,13 +419,87 @@ void R_SubmitStagingBuffers();
 byte * R_StagingAllocate(int size, int alignment, VkCommandBuffer * command_buffer, VkBuffer * buffer, int * buffer_offset);
 
 void R_InitDynamicBuffers();
-void R_SwapDynamicBuffers();
+void R_SwapDynamicBuffers(int frame_index);
 void R_FlushDynamicBuffers();
 byte * R_VertexAllocate(int size, VkBuffer * buffer, VkDeviceSize * buffer_offset);
 byte * R_IndexAllocate(int size, VkBuffer * buffer, VkDeviceSize * buffer_offset);
 byte * R_UniformAllocate(int size, VkBuffer * buffer, uint32_t * buffer_offset, VkDescriptorSet * descriptor_set);
+byte * R_StorageAllocate(int size, VkBuffer * buffer, uint32_t * buffer_offset, VkDescriptorSet * descriptor_set);
+
+void R_InitLatchBuffer();
+void R_BeginLatch(int slot);
+void R_StoreLatchMatrix(const float matrix[16]);
+void R_BindLatch(VkPipelineLayout layout, uint32_t set, qboolean head_locked);
+void R_LatchPose(void);
 
 void GL_SetObjectName(uint64_t object, VkDebugReportObjectTypeEXT objectType, const char * name);
 
+// gl_profile.c -- gpu timestamps, read back when their command buffer comes around again
+typedef enum
+{
+	GPU_SCOPE_HIDDEN_AREA_MESH,
+	GPU_SCOPE_SKY,
+	GPU_SCOPE_WORLD,
+	GPU_SCOPE_ENTITIES,
+	GPU_SCOPE_WATER,
+	GPU_SCOPE_PARTICLES,
+	GPU_SCOPE_VIEW_MODEL,
+	GPU_SCOPE_2D,
+	GPU_SCOPE_POSTPROCESS,
+	GPU_SCOPE_SWAPCHAIN,
+	NUM_GPU_SCOPES
+} gpuscope_t;
+
+#define GPU_CONTEXT_SWAPCHAIN	NUM_COMMAND_BUFFERS		// eye command buffers first, then the swap chain ones
+#define NUM_GPU_CONTEXTS		(NUM_COMMAND_BUFFERS + 2)
+
+extern cvar_t r_gpuprofile;
+extern const char *gpu_scope_names[NUM_GPU_SCOPES];
+extern float gpu_scope_ms[NUM_VR_EYES][NUM_GPU_SCOPES];
+extern float gpu_total_ms[NUM_VR_EYES];
+
+void GL_InitProfiler (uint32_t timestamp_valid_bits);
+void GL_ProfilerBeginFrame (VkCommandBuffer command_buffer, int context, int eye);
+void GL_BeginGPUScope (gpuscope_t scope);
+void GL_EndGPUScope (gpuscope_t scope);
+
+// gl_foveate.c -- coarser shading away from the lens center
+void R_InitFoveation (void);
+void R_BeginFoveation (int slot);
+void R_DrawFoveationMask (void);
+void R_FillFoveation (void);
+
+// gl_rgraph.c -- frame images and the barriers between the passes that use them
+typedef enum
+{
+	RG_COLOR_BUFFER_0,		// scene, or the screen compute output, then the ui
+	RG_COLOR_BUFFER_1,		// scene when the screen compute runs
+	RG_DEPTH_BUFFER,
+	RG_MSAA_COLOR_BUFFER,
+	NUM_RG_RESOURCES
+} rgresource_t;
+
+typedef enum
+{
+	RG_USE_COLOR_ATTACHMENT_DISCARD,
+	RG_USE_DEPTH_ATTACHMENT_DISCARD,
+	RG_USE_UI_ATTACHMENT,			// loaded, drawn over, then the postprocess input
+	RG_USE_COMPUTE_READ,
+	RG_USE_COMPUTE_WRITE_DISCARD,
+	NUM_RG_USES
+} rguse_t;
+
+typedef struct
+{
+	rgresource_t	resource;
+	rguse_t			use;
+} rgpassuse_t;
+
+void R_GraphSetImage (rgresource_t resource, VkImage image, VkImageAspectFlags aspect);
+void R_GraphPass (VkCommandBuffer command_buffer, int num_uses, const rgpassuse_t *uses);
+void R_BeginMainRenderPass (int index);
+void R_BeginScreenCompute (void);
+void R_BeginUIRenderPass (void);
+
 #endif	/* __GLQUAKE_H */
 
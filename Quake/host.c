@@ -543,10 +543,17 @@ not reinitialize anything.
 */
 void Host_ClearMemory (void)
 {
+	int		i;
+
 	Con_DPrintf ("Clearing memory\n");
 	Mod_ClearAll ();
 /* host_hunklevel MUST be set at this point */
 	Hunk_FreeToLowMark (host_hunklevel);
+	if (svs.clients)
+	{	// the PROTOCOL_DELTA snapshots were on the hunk
+		for (i = 0; i < svs.maxclientslimit; i++)
+			svs.clients[i].snapshots = NULL;
+	}
 	cls.signon = 0;
 	free(sv.edicts); // ericw -- sv.edicts switched to use malloc()
 	memset (&sv, 0, sizeof(sv));
@@ -573,11 +580,17 @@ qboolean Host_FilterTime (float time)
 
 	realtime += time;
 
-	//johnfitz -- max fps cvar
-	maxfps = CLAMP (10.0, host_maxfps.value, 1000.0);
-	if (!cls.timedemo && realtime - oldrealtime < 1.0/maxfps)
-		return false; // framerate is too high
-	//johnfitz
+	// with vr_pacing the rendering waits for the compositor to start the next
+	// frame, see SCR_UpdateScreen, that paces the loop instead of host_maxfps.
+	// Not while loading, nothing waits then
+	if (!SCR_PacedByVR ())
+	{
+		//johnfitz -- max fps cvar
+		maxfps = CLAMP (10.0, host_maxfps.value, 1000.0);
+		if (!cls.timedemo && realtime - oldrealtime < 1.0/maxfps)
+			return false; // framerate is too high
+		//johnfitz
+	}
 
 	host_frametime = realtime - oldrealtime;
 	oldrealtime = realtime;
@@ -633,7 +646,8 @@ void Host_ServerFrame (void)
 // set the time and clear the general datagram
 	SV_ClearDatagram ();
 
-// check for new clients
+// read what arrived since the last frame, then check for new clients
+	NET_Drain ();
 	SV_CheckForNewClients ();
 
 // read client messages
@@ -843,6 +857,7 @@ void Host_Init (void)
 	}
 	PR_Init ();
 	Mod_Init ();
+	Tasks_Init ();
 	NET_Init ();
 	SV_Init ();
 
@@ -925,6 +940,7 @@ void Host_Shutdown(void)
 	Host_WriteConfiguration ();
 
 	NET_Shutdown ();
+	Tasks_Shutdown ();
 
 	if (cls.state != ca_dedicated)
 	{
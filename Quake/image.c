@@ -26,7 +26,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 static char loadfilename[MAX_OSPATH]; //file scope so that error messages can use it
 
 typedef struct stdio_buffer_s {
-	FILE *f;
+	FILE *f;		// NULL when reading from memory
+	const unsigned char *data;
 	unsigned char buffer[1024];
 	int size;
 	int pos;
@@ -36,9 +37,18 @@ static stdio_buffer_t *Buf_Alloc(FILE *f)
 {
 	stdio_buffer_t *buf = (stdio_buffer_t *) calloc(1, sizeof(stdio_buffer_t));
 	buf->f = f;
+	buf->data = buf->buffer;
 	return buf;
 }
 
+static void Buf_InitMemory(stdio_buffer_t *buf, const byte *data, int size)
+{
+	buf->f = NULL;
+	buf->data = data;
+	buf->size = q_max(size, 0);
+	buf->pos = 0;
+}
+
 static void Buf_Free(stdio_buffer_t *buf)
 {
 	free(buf);
@@ -48,6 +58,9 @@ static inline int Buf_GetC(stdio_buffer_t *buf)
 {
 	if (buf->pos >= buf->size)
 	{
+		if (!buf->f)
+			return EOF;
+
 		buf->size = fread(buf->buffer, 1, sizeof(buf->buffer), buf->f);
 		buf->pos = 0;
 		
@@ -55,9 +68,45 @@ static inline int Buf_GetC(stdio_buffer_t *buf)
 			return EOF;
 	}
 
-	return buf->buffer[buf->pos++];
+	return buf->data[buf->pos++];
 }
 
+typedef struct targaheader_s {
+	unsigned char 	id_length, colormap_type, image_type;
+	unsigned short	colormap_index, colormap_length;
+	unsigned char	colormap_size;
+	unsigned short	x_origin, y_origin, width, height;
+	unsigned char	pixel_size, attributes;
+} targaheader_t;
+
+#define TARGAHEADERSIZE 18 //size on disk
+
+targaheader_t targa_header;
+
+typedef struct
+{
+    char			signature;
+    char			version;
+    char			encoding;
+    char			bits_per_pixel;
+    unsigned short	xmin,ymin,xmax,ymax;
+    unsigned short	hdpi,vdpi;
+    byte			colortable[48];
+    char			reserved;
+    char			color_planes;
+    unsigned short	bytes_per_line;
+    unsigned short	palette_type;
+    char			filler[58];
+} pcxheader_t;
+
+static void Image_OpenTGA (const byte *header, const char *name, int *width, int *height);
+static void Image_DecodeTGA (stdio_buffer_t *buf, const byte *header, byte *targa_rgba);
+static void Image_OpenPCX (const byte *header, const char *name, int *width, int *height);
+static void Image_DecodePCX (stdio_buffer_t *buf, const byte *header, const byte *palette, byte *data);
+static qboolean Image_OpenDDS (imagefile_t *file);
+
+qboolean image_dds = false;
+
 /*
 ============
 Image_LoadImage
@@ -84,24 +133,145 @@ byte *Image_LoadImage (const char *name, int *width, int *height)
 	return NULL;
 }
 
+/*
+============
+Image_FindImage
+
+looks for name.tga then name.pcx like Image_LoadImage and checks the
+header, without reading the pixels.  fills in everything in file but
+the data.  if image_dds is set a usable name.dds comes first.
+============
+*/
+qboolean Image_FindImage (const char *name, imagefile_t *file)
+{
+	FILE	*f;
+
+	memset (file, 0, sizeof(*file));
+
+	if (image_dds)
+	{
+		q_snprintf (file->name, sizeof(file->name), "%s.dds", name);
+		COM_FOpenFile (file->name, &f, NULL);
+		if (f)
+		{
+			file->type = IMAGE_DDS;
+			file->size = com_filesize;
+			fread (file->header, 1, q_min(file->size, IMAGE_HEADERSIZE), f);
+			fclose (f);
+			if (Image_OpenDDS (file))
+				return true;
+			memset (file, 0, sizeof(*file));
+		}
+	}
+
+	file->num_mips = 1;
+
+	q_snprintf (file->name, sizeof(file->name), "%s.tga", name);
+	COM_FOpenFile (file->name, &f, NULL);
+	if (f)
+		file->type = IMAGE_TGA;
+	else
+	{
+		q_snprintf (file->name, sizeof(file->name), "%s.pcx", name);
+		COM_FOpenFile (file->name, &f, NULL);
+		if (!f)
+			return false;
+		file->type = IMAGE_PCX;
+	}
+
+	file->size = com_filesize;
+	fread (file->header, 1, q_min(file->size, IMAGE_HEADERSIZE), f);
+	fclose (f);
+
+	if (file->type == IMAGE_TGA)
+		Image_OpenTGA (file->header, file->name, &file->width, &file->height);
+	else
+		Image_OpenPCX (file->header, file->name, &file->width, &file->height);
+
+	return true;
+}
+
+/*
+============
+Image_ReadFile
+
+reads the whole file found by Image_FindImage into malloc'd memory
+============
+*/
+void Image_ReadFile (imagefile_t *file)
+{
+	FILE	*f;
+
+	COM_FOpenFile (file->name, &f, NULL);
+	if (!f)
+		Sys_Error ("Image_ReadFile: couldn't reopen %s", file->name);
+
+	file->data = (byte *) malloc (file->size);
+	if (!file->data)
+		Sys_Error ("Image_ReadFile: out of memory for %s", file->name);
+	if (fread (file->data, 1, file->size, f) != (size_t)file->size)
+		memset (file->data, 0, file->size);	// truncated pak, decode garbage rather than crash
+	fclose (f);
+}
+
+/*
+============
+Image_DecodeFile
+
+returns malloc'd RGBA data for a file read by Image_ReadFile.  doesn't
+touch the hunk or any globals, so it can be called from task workers.
+DDS files are already in their final form and aren't decoded.
+============
+*/
+byte *Image_DecodeFile (const imagefile_t *file)
+{
+	stdio_buffer_t	buf;
+	byte		*rgba;
+	int			offset;
+
+	if (file->type == IMAGE_DDS)
+		return NULL;
+
+	// PCX reads a padding byte past the last line
+	rgba = (byte *) malloc ((file->width * file->height + 1) * 4);
+	if (!rgba)
+		return NULL;
+
+	if (file->type == IMAGE_TGA)
+	{
+		offset = TARGAHEADERSIZE + file->header[0];	// skip the image comment
+		Buf_InitMemory (&buf, file->data + offset, file->size - offset);
+		Image_DecodeTGA (&buf, file->header, rgba);
+	}
+	else if (file->size >= (int) sizeof(pcxheader_t) + 768)
+	{
+		offset = sizeof(pcxheader_t);
+		Buf_InitMemory (&buf, file->data + offset, file->size - offset - 768);
+		Image_DecodePCX (&buf, file->header, file->data + file->size - 768, rgba);
+	}
+	else	// truncated, no palette
+		memset (rgba, 0, file->width * file->height * 4);
+
+	return rgba;
+}
+
+/*
+============
+Image_FreeFile
+============
+*/
+void Image_FreeFile (imagefile_t *file)
+{
+	free (file->data);
+	file->data = NULL;
+}
+
 //==============================================================================
 //
 //  TGA
 //
 //==============================================================================
 
-typedef struct targaheader_s {
-	unsigned char 	id_length, colormap_type, image_type;
-	unsigned short	colormap_index, colormap_length;
-	unsigned char	colormap_size;
-	unsigned short	x_origin, y_origin, width, height;
-	unsigned char	pixel_size, attributes;
-} targaheader_t;
-
-#define TARGAHEADERSIZE 18 //size on disk
-
-targaheader_t targa_header;
-
 int fgetLittleShort (FILE *f)
 {
 	byte	b1, b2;
@@ -173,6 +343,48 @@ qboolean Image_WriteTGA (const char *name, byte *data, int width, int height, in
 	return true;
 }
 
+/*
+=============
+Image_ParseTGAHeader
+=============
+*/
+static void Image_ParseTGAHeader (const byte *p, targaheader_t *header)
+{
+	header->id_length = p[0];
+	header->colormap_type = p[1];
+	header->image_type = p[2];
+	header->colormap_index = p[3] + p[4]*256;
+	header->colormap_length = p[5] + p[6]*256;
+	header->colormap_size = p[7];
+	header->x_origin = p[8] + p[9]*256;
+	header->y_origin = p[10] + p[11]*256;
+	header->width = p[12] + p[13]*256;
+	header->height = p[14] + p[15]*256;
+	header->pixel_size = p[16];
+	header->attributes = p[17];
+}
+
+/*
+=============
+Image_OpenTGA -- validates the header, errors out on unsupported files
+=============
+*/
+static void Image_OpenTGA (const byte *p, const char *name, int *width, int *height)
+{
+	targaheader_t	header;
+
+	Image_ParseTGAHeader (p, &header);
+
+	if (header.image_type!=2 && header.image_type!=10)
+		Sys_Error ("Image_LoadTGA: %s is not a type 2 or type 10 targa\n", name);
+
+	if (header.colormap_type !=0 || (header.pixel_size!=32 && header.pixel_size!=24))
+		Sys_Error ("Image_LoadTGA: %s is not a 24bit or 32bit targa\n", name);
+
+	*width = header.width;
+	*height = header.height;
+}
+
 /*
 =============
 Image_LoadTGA
@@ -180,47 +392,49 @@ Image_LoadTGA
 */
 byte *Image_LoadTGA (FILE *fin, int *width, int *height)
 {
-	int				columns, rows, numPixels;
-	byte			*pixbuf;
-	int				row, column;
+	byte			header[TARGAHEADERSIZE];
 	byte			*targa_rgba;
-	int				realrow; //johnfitz -- fix for upside-down targas
-	qboolean		upside_down; //johnfitz -- fix for upside-down targas
 	stdio_buffer_t	*buf;
 
-	targa_header.id_length = fgetc(fin);
-	targa_header.colormap_type = fgetc(fin);
-	targa_header.image_type = fgetc(fin);
+	memset (header, 0, sizeof(header));
+	fread (header, 1, TARGAHEADERSIZE, fin);
+	Image_ParseTGAHeader (header, &targa_header);
+	Image_OpenTGA (header, loadfilename, width, height);
 
-	targa_header.colormap_index = fgetLittleShort(fin);
-	targa_header.colormap_length = fgetLittleShort(fin);
-	targa_header.colormap_size = fgetc(fin);
-	targa_header.x_origin = fgetLittleShort(fin);
-	targa_header.y_origin = fgetLittleShort(fin);
-	targa_header.width = fgetLittleShort(fin);
-	targa_header.height = fgetLittleShort(fin);
-	targa_header.pixel_size = fgetc(fin);
-	targa_header.attributes = fgetc(fin);
+	targa_rgba = (byte *) Hunk_Alloc ((*width) * (*height) * 4);
 
-	if (targa_header.image_type!=2 && targa_header.image_type!=10)
-		Sys_Error ("Image_LoadTGA: %s is not a type 2 or type 10 targa\n", loadfilename);
+	if (targa_header.id_length != 0)
+		fseek(fin, targa_header.id_length, SEEK_CUR);  // skip TARGA image comment
 
-	if (targa_header.colormap_type !=0 || (targa_header.pixel_size!=32 && targa_header.pixel_size!=24))
-		Sys_Error ("Image_LoadTGA: %s is not a 24bit or 32bit targa\n", loadfilename);
+	buf = Buf_Alloc(fin);
+	Image_DecodeTGA (buf, header, targa_rgba);
+	Buf_Free(buf);
+	fclose(fin);
 
-	columns = targa_header.width;
-	rows = targa_header.height;
-	numPixels = columns * rows;
-	upside_down = !(targa_header.attributes & 0x20); //johnfitz -- fix for upside-down targas
+	return targa_rgba;
+}
 
-	targa_rgba = (byte *) Hunk_Alloc (numPixels*4);
+/*
+=============
+Image_DecodeTGA -- reads the pixels following the header and image comment
+=============
+*/
+static void Image_DecodeTGA (stdio_buffer_t *buf, const byte *p, byte *targa_rgba)
+{
+	targaheader_t	header;
+	int				columns, rows;
+	byte			*pixbuf;
+	int				row, column;
+	int				realrow; //johnfitz -- fix for upside-down targas
+	qboolean		upside_down; //johnfitz -- fix for upside-down targas
 
-	if (targa_header.id_length != 0)
-		fseek(fin, targa_header.id_length, SEEK_CUR);  // skip TARGA image comment
+	Image_ParseTGAHeader (p, &header);
 
-	buf = Buf_Alloc(fin);
+	columns = header.width;
+	rows = header.height;
+	upside_down = !(header.attributes & 0x20); //johnfitz -- fix for upside-down targas
 
-	if (targa_header.image_type==2) // Uncompressed, RGB images
+	if (header.image_type==2) // Uncompressed, RGB images
 	{
 		for(row=rows-1; row>=0; row--)
 		{
@@ -231,7 +445,7 @@ byte *Image_LoadTGA (FILE *fin, int *width, int *height)
 			for(column=0; column<columns; column++)
 			{
 				unsigned char red,green,blue,alphabyte;
-				switch (targa_header.pixel_size)
+				switch (header.pixel_size)
 				{
 				case 24:
 					blue = Buf_GetC(buf);
@@ -256,7 +470,7 @@ byte *Image_LoadTGA (FILE *fin, int *width, int *height)
 			}
 		}
 	}
-	else if (targa_header.image_type==10) // Runlength encoded RGB images
+	else if (header.image_type==10) // Runlength encoded RGB images
 	{
 		unsigned char red,green,blue,alphabyte,packetHeader,packetSize,j;
 		for(row=rows-1; row>=0; row--)
@@ -271,7 +485,7 @@ byte *Image_LoadTGA (FILE *fin, int *width, int *height)
 				packetSize = 1 + (packetHeader & 0x7f);
 				if (packetHeader & 0x80) // run-length packet
 				{
-					switch (targa_header.pixel_size)
+					switch (header.pixel_size)
 					{
 					case 24:
 						blue = Buf_GetC(buf);
@@ -314,7 +528,7 @@ byte *Image_LoadTGA (FILE *fin, int *width, int *height)
 				{
 					for(j=0;j<packetSize;j++)
 					{
-						switch (targa_header.pixel_size)
+						switch (header.pixel_size)
 						{
 						case 24:
 							blue = Buf_GetC(buf);
@@ -357,13 +571,6 @@ byte *Image_LoadTGA (FILE *fin, int *width, int *height)
 			breakOut:;
 		}
 	}
-
-	Buf_Free(buf);
-	fclose(fin);
-
-	*width = (int)(targa_header.width);
-	*height = (int)(targa_header.height);
-	return targa_rgba;
 }
 
 //==============================================================================
@@ -372,66 +579,95 @@ byte *Image_LoadTGA (FILE *fin, int *width, int *height)
 //
 //==============================================================================
 
-typedef struct
+/*
+============
+Image_ParsePCXHeader
+============
+*/
+static void Image_ParsePCXHeader (const byte *p, pcxheader_t *pcx)
 {
-    char			signature;
-    char			version;
-    char			encoding;
-    char			bits_per_pixel;
-    unsigned short	xmin,ymin,xmax,ymax;
-    unsigned short	hdpi,vdpi;
-    byte			colortable[48];
-    char			reserved;
-    char			color_planes;
-    unsigned short	bytes_per_line;
-    unsigned short	palette_type;
-    char			filler[58];
-} pcxheader_t;
+	memcpy (pcx, p, sizeof(*pcx));
+	pcx->xmin = (unsigned short)LittleShort (pcx->xmin);
+	pcx->ymin = (unsigned short)LittleShort (pcx->ymin);
+	pcx->xmax = (unsigned short)LittleShort (pcx->xmax);
+	pcx->ymax = (unsigned short)LittleShort (pcx->ymax);
+	pcx->bytes_per_line = (unsigned short)LittleShort (pcx->bytes_per_line);
+}
 
 /*
 ============
-Image_LoadPCX
+Image_OpenPCX -- validates the header, errors out on unsupported files
 ============
 */
-byte *Image_LoadPCX (FILE *f, int *width, int *height)
+static void Image_OpenPCX (const byte *p, const char *name, int *width, int *height)
 {
 	pcxheader_t	pcx;
-	int			x, y, w, h, readbyte, runlength, start;
-	byte		*p, *data;
-	byte		palette[768];
-	stdio_buffer_t  *buf;
 
-	start = ftell (f); //save start of file (since we might be inside a pak file, SEEK_SET might not be the start of the pcx)
-
-	fread(&pcx, sizeof(pcx), 1, f);
-	pcx.xmin = (unsigned short)LittleShort (pcx.xmin);
-	pcx.ymin = (unsigned short)LittleShort (pcx.ymin);
-	pcx.xmax = (unsigned short)LittleShort (pcx.xmax);
-	pcx.ymax = (unsigned short)LittleShort (pcx.ymax);
-	pcx.bytes_per_line = (unsigned short)LittleShort (pcx.bytes_per_line);
+	Image_ParsePCXHeader (p, &pcx);
 
 	if (pcx.signature != 0x0A)
-		Sys_Error ("'%s' is not a valid PCX file", loadfilename);
+		Sys_Error ("'%s' is not a valid PCX file", name);
 
 	if (pcx.version != 5)
-		Sys_Error ("'%s' is version %i, should be 5", loadfilename, pcx.version);
+		Sys_Error ("'%s' is version %i, should be 5", name, pcx.version);
 
 	if (pcx.encoding != 1 || pcx.bits_per_pixel != 8 || pcx.color_planes != 1)
-		Sys_Error ("'%s' has wrong encoding or bit depth", loadfilename);
+		Sys_Error ("'%s' has wrong encoding or bit depth", name);
 
-	w = pcx.xmax - pcx.xmin + 1;
-	h = pcx.ymax - pcx.ymin + 1;
+	*width = pcx.xmax - pcx.xmin + 1;
+	*height = pcx.ymax - pcx.ymin + 1;
+}
 
-	data = (byte *) Hunk_Alloc((w*h+1)*4); //+1 to allow reading padding byte on last line
+/*
+============
+Image_LoadPCX
+============
+*/
+byte *Image_LoadPCX (FILE *f, int *width, int *height)
+{
+	byte		header[sizeof(pcxheader_t)];
+	byte		*data;
+	byte		palette[768];
+	int			start;
+	stdio_buffer_t  *buf;
+
+	start = ftell (f); //save start of file (since we might be inside a pak file, SEEK_SET might not be the start of the pcx)
+
+	memset (header, 0, sizeof(header));
+	fread (header, 1, sizeof(header), f);
+	Image_OpenPCX (header, loadfilename, width, height);
+
+	data = (byte *) Hunk_Alloc(((*width)*(*height)+1)*4); //+1 to allow reading padding byte on last line
 
 	//load palette
 	fseek (f, start + com_filesize - 768, SEEK_SET);
 	fread (palette, 1, 768, f);
 
 	//back to start of image data
-	fseek (f, start + sizeof(pcx), SEEK_SET);
+	fseek (f, start + sizeof(pcxheader_t), SEEK_SET);
 
 	buf = Buf_Alloc(f);
+	Image_DecodePCX (buf, header, palette, data);
+	Buf_Free(buf);
+	fclose(f);
+
+	return data;
+}
+
+/*
+============
+Image_DecodePCX -- reads the pixels following the header
+============
+*/
+static void Image_DecodePCX (stdio_buffer_t *buf, const byte *header, const byte *palette, byte *data)
+{
+	pcxheader_t	pcx;
+	int			x, y, w, h, readbyte, runlength;
+	byte		*p;
+
+	Image_ParsePCXHeader (header, &pcx);
+	w = pcx.xmax - pcx.xmin + 1;
+	h = pcx.ymax - pcx.ymin + 1;
 
 	for (y=0; y<h; y++)
 	{
@@ -440,11 +676,13 @@ byte *Image_LoadPCX (FILE *f, int *width, int *height)
 		for (x=0; x<(pcx.bytes_per_line); ) //read the extra padding byte if necessary
 		{
 			readbyte = Buf_GetC(buf);
+			if (readbyte == EOF) // truncated file
+				readbyte = 0;
 
 			if(readbyte >= 0xC0)
 			{
 				runlength = readbyte & 0x3F;
-				readbyte = Buf_GetC(buf);
+				readbyte = Buf_GetC(buf) & 0xFF;
 			}
 			else
 				runlength = 1;
@@ -460,11 +698,134 @@ byte *Image_LoadPCX (FILE *f, int *width, int *height)
 			}
 		}
 	}
+}
 
-	Buf_Free(buf);
-	fclose(f);
+//==============================================================================
+//
+//  DDS
+//
+//==============================================================================
 
-	*width = w;
-	*height = h;
-	return data;
+#define DDSHEADERSIZE		128		// magic and DDS_HEADER
+#define DDSDX10HEADERSIZE	20
+
+#define DDSD_MIPMAPCOUNT	0x20000
+#define DDPF_FOURCC			0x4
+#define DDSCAPS2_CUBEMAP	0x200
+#define DDSCAPS2_VOLUME		0x200000
+
+#define DXGI_FORMAT_BC1_UNORM	71
+#define DXGI_FORMAT_BC3_UNORM	77
+#define DXGI_FORMAT_BC7_UNORM	98
+
+#define DDS_FOURCC(a,b,c,d)	((a) | ((b) << 8) | ((c) << 16) | ((d) << 24))
+
+/*
+============
+Image_GetLong
+============
+*/
+static int Image_GetLong (const byte *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24);
+}
+
+/*
+============
+Image_MipSize -- bytes in one mip level of the given format
+============
+*/
+int Image_MipSize (int format, int width, int height)
+{
+	width = q_max(width, 1);
+	height = q_max(height, 1);
+
+	switch (format)
+	{
+	case IMAGE_BC1:
+		return ((width + 3) / 4) * ((height + 3) / 4) * 8;
+	case IMAGE_BC3:
+	case IMAGE_BC7:
+		return ((width + 3) / 4) * ((height + 3) / 4) * 16;
+	default:
+		return width * height * 4;
+	}
+}
+
+/*
+============
+Image_OpenDDS -- validates the header.  unlike the other formats a bad file
+isn't fatal, there is usually a tga or pcx to fall back to
+============
+*/
+static qboolean Image_OpenDDS (imagefile_t *file)
+{
+	const byte	*p = file->header;
+	int			flags, pfflags, fourcc, caps2, mips, size, i;
+
+	if (file->size < DDSHEADERSIZE || memcmp (p, "DDS ", 4) || Image_GetLong (p + 4) != 124)
+	{
+		Con_Printf ("%s is not a valid DDS file\n", file->name);
+		return false;
+	}
+
+	flags = Image_GetLong (p + 8);
+	file->height = Image_GetLong (p + 12);
+	file->width = Image_GetLong (p + 16);
+	mips = Image_GetLong (p + 28);
+	pfflags = Image_GetLong (p + 80);
+	fourcc = Image_GetLong (p + 84);
+	caps2 = Image_GetLong (p + 112);
+
+	file->format = IMAGE_RGBA;
+	file->offset = DDSHEADERSIZE;
+	if (pfflags & DDPF_FOURCC)
+	{
+		if (fourcc == DDS_FOURCC('D','X','T','1'))
+			file->format = IMAGE_BC1;
+		else if (fourcc == DDS_FOURCC('D','X','T','5'))
+			file->format = IMAGE_BC3;
+		else if (fourcc == DDS_FOURCC('D','X','1','0') && file->size >= DDSHEADERSIZE + DDSDX10HEADERSIZE)
+		{
+			// array textures aren't supported
+			if (Image_GetLong (p + DDSHEADERSIZE + 12) <= 1)
+			{
+				switch (Image_GetLong (p + DDSHEADERSIZE))
+				{
+				case DXGI_FORMAT_BC1_UNORM: file->format = IMAGE_BC1; break;
+				case DXGI_FORMAT_BC3_UNORM: file->format = IMAGE_BC3; break;
+				case DXGI_FORMAT_BC7_UNORM: file->format = IMAGE_BC7; break;
+				}
+			}
+			file->offset += DDSDX10HEADERSIZE;
+		}
+	}
+
+	if (file->format == IMAGE_RGBA || (caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME)))
+	{
+		Con_Printf ("%s is not a 2D DXT1, DXT5 or BC7 texture\n", file->name);
+		return false;
+	}
+
+	if (file->width <= 0 || file->height <= 0 || file->width > 32768 || file->height > 32768)
+	{
+		Con_Printf ("%s has bad dimensions %ix%i\n", file->name, file->width, file->height);
+		return false;
+	}
+
+	file->num_mips = ((flags & DDSD_MIPMAPCOUNT) && mips > 0) ? q_min(mips, 16) : 1;
+	while (file->num_mips > 1 && !(file->width >> (file->num_mips - 1)) && !(file->height >> (file->num_mips - 1)))
+		file->num_mips--;
+
+	// every level has to be there, the texture manager uploads straight from the file
+	size = file->offset;
+	for (i = 0; i < file->num_mips; i++)
+		size += Image_MipSize (file->format, file->width >> i, file->height >> i);
+	if (size > file->size)
+	{
+		Con_Printf ("%s is truncated\n", file->name);
+		return false;
+	}
+
+	return true;
 }
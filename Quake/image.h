@@ -25,11 +25,45 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 //image.h -- image reading / writing
 
+#define IMAGE_TGA		1
+#define IMAGE_PCX		2
+#define IMAGE_DDS		3
+#define IMAGE_HEADERSIZE	148		// enough for any, DDS with the DX10 extension is the biggest
+
+// block compressed formats, only found in DDS files
+#define IMAGE_RGBA		0
+#define IMAGE_BC1		1		// DXT1
+#define IMAGE_BC3		2		// DXT5
+#define IMAGE_BC7		3
+
+typedef struct imagefile_s
+{
+	char	name[MAX_OSPATH];	// with extension
+	int		type;
+	int		width, height;
+	int		size;
+	int		format;				// IMAGE_RGBA, or IMAGE_BC* for DDS
+	int		num_mips;			// stored in the file, 1 unless DDS
+	int		offset;				// of the first mip, DDS only
+	byte	header[IMAGE_HEADERSIZE];
+	byte	*data;				// whole file, after Image_ReadFile
+} imagefile_t;
+
+extern qboolean image_dds;		// set by the renderer when it can sample BC formats
+
 //be sure to free the hunk after using these loading functions
 byte *Image_LoadTGA (FILE *f, int *width, int *height);
 byte *Image_LoadPCX (FILE *f, int *width, int *height);
 byte *Image_LoadImage (const char *name, int *width, int *height);
 
+//split up loading for the texture manager's worker threads: find and read
+//files on the main thread, decode anywhere.  decoded data is malloc'd
+qboolean Image_FindImage (const char *name, imagefile_t *file);
+void Image_ReadFile (imagefile_t *file);
+byte *Image_DecodeFile (const imagefile_t *file);
+void Image_FreeFile (imagefile_t *file);
+int Image_MipSize (int format, int width, int height);
+
 qboolean Image_WriteTGA (const char *name, byte *data, int width, int height, int bpp, qboolean upsidedown, qboolean bgra);
 
 #endif	/* __GL_IMAGE_H */
@@ -79,6 +79,14 @@ int	NET_SendUnreliableMessage (struct qsocket_s *sock, sizebuf_t *data);
 int	NET_SendToAll(sizebuf_t *data, double blocktime);
 // This is a reliable *blocking* send to all attached clients.
 
+void	NET_Drain (void);
+// reads everything a driver receives in one batch into its queues; the server
+// calls this once per frame before checking for new clients
+
+void	NET_Flush (void);
+// pushes out datagrams a driver held back to send in one batch; the server
+// calls this once it has written to all clients for the frame
+
 void	NET_Close (struct qsocket_s *sock);
 // if a dead connection is returned by a get or send function, this function
 // should be called when it is convenient
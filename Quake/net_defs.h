@@ -183,6 +183,9 @@ typedef struct
 	int		(*AddrCompare) (struct qsockaddr *addr1, struct qsockaddr *addr2);
 	int		(*GetSocketPort) (struct qsockaddr *addr);
 	int		(*SetSocketPort) (struct qsockaddr *addr, int port);
+	sys_socket_t	(*Accept) (sys_socket_t socketid, struct qsockaddr *addr);	// may be NULL
+	void		(*Flush) (void);	// may be NULL
+	void		(*Drain) (void);	// may be NULL
 } net_landriver_t;
 
 #define	MAX_NET_DRIVERS		8
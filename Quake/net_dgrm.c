@@ -1064,8 +1064,13 @@ static qsocket_t *_Datagram_CheckNewConnections (void)
 		return NULL;
 	}
 
-	// allocate a network socket
-	newsock = dfunc.Open_Socket(0);
+	// allocate a network socket, or share the accept socket if the
+	// driver batches its I/O
+	newsock = INVALID_SOCKET;
+	if (dfunc.Accept)
+		newsock = dfunc.Accept(acceptsock, &clientaddr);
+	if (newsock == INVALID_SOCKET)
+		newsock = dfunc.Open_Socket(0);
 	if (newsock == INVALID_SOCKET)
 	{
 		NET_FreeQSocket(sock);
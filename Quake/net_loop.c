@@ -30,10 +30,50 @@ static qboolean	localconnectpending = false;
 static qsocket_t	*loop_client = NULL;
 static qsocket_t	*loop_server = NULL;
 
+/*
+Messages are queued whole, one per buffer.  Reading one swaps its buffer
+with net_message.data instead of copying it out, so every buffer here and
+net_message's own must stay NET_MAXMESSAGE bytes.  The last slot is kept
+for the single reliable message that can be in flight.
+*/
+#define LOOP_MAXQUEUED	8
+
+typedef struct
+{
+	int		type;		// 1 = reliable, 2 = unreliable
+	int		length;
+	byte	*data;
+} loopmsg_t;
+
+typedef struct
+{
+	loopmsg_t	msgs[LOOP_MAXQUEUED];
+	int			head;
+	int			count;
+} loopqueue_t;
+
+static loopqueue_t	loop_toclient;
+static loopqueue_t	loop_toserver;
+
+static loopqueue_t *Loop_Queue (qsocket_t *sock)
+{
+	return (sock == loop_client) ? &loop_toclient : &loop_toserver;
+}
+
 int Loop_Init (void)
 {
+	byte	*buffers;
+	int		i;
+
 	if (cls.state == ca_dedicated)
 		return -1;
+
+	buffers = (byte *) Hunk_AllocName (2 * LOOP_MAXQUEUED * NET_MAXMESSAGE, "loopback");
+	for (i = 0; i < LOOP_MAXQUEUED; i++)
+	{
+		loop_toclient.msgs[i].data = buffers + i * NET_MAXMESSAGE;
+		loop_toserver.msgs[i].data = buffers + (LOOP_MAXQUEUED + i) * NET_MAXMESSAGE;
+	}
 	return 0;
 }
 
@@ -85,6 +125,7 @@ qsocket_t *Loop_Connect (const char *host)
 	loop_client->receiveMessageLength = 0;
 	loop_client->sendMessageLength = 0;
 	loop_client->canSend = true;
+	loop_toclient.count = 0;
 
 	if (!loop_server)
 	{
@@ -98,6 +139,7 @@ qsocket_t *Loop_Connect (const char *host)
 	loop_server->receiveMessageLength = 0;
 	loop_server->sendMessageLength = 0;
 	loop_server->canSend = true;
+	loop_toserver.count = 0;
 
 	loop_client->driverdata = (void *)loop_server;
 	loop_server->driverdata = (void *)loop_client;
@@ -118,35 +160,41 @@ qsocket_t *Loop_CheckNewConnections (void)
 	loop_client->sendMessageLength = 0;
 	loop_client->receiveMessageLength = 0;
 	loop_client->canSend = true;
+	loop_toclient.count = 0;
+	loop_toserver.count = 0;
 	return loop_server;
 }
 
 
-static int IntAlign(int value)
+static loopmsg_t *Loop_QueueMessage (qsocket_t *sock, int type)
 {
-	return (value + (sizeof(int) - 1)) & (~(sizeof(int) - 1));
+	loopqueue_t	*q = Loop_Queue ((qsocket_t *)sock->driverdata);
+
+	if (q->count >= LOOP_MAXQUEUED - (type == 2))
+		return NULL;
+	return &q->msgs[(q->head + q->count++) % LOOP_MAXQUEUED];
 }
 
 
 int Loop_GetMessage (qsocket_t *sock)
 {
-	int		ret;
-	int		length;
+	loopqueue_t	*q = Loop_Queue (sock);
+	loopmsg_t	*m;
+	byte		*swap;
+	int			ret;
 
-	if (sock->receiveMessageLength == 0)
+	if (q->count == 0)
 		return 0;
 
-	ret = sock->receiveMessage[0];
-	length = sock->receiveMessage[1] + (sock->receiveMessage[2] << 8);
-	// alignment byte skipped here
-	SZ_Clear (&net_message);
-	SZ_Write (&net_message, &sock->receiveMessage[4], length);
+	m = &q->msgs[q->head];
+	q->head = (q->head + 1) % LOOP_MAXQUEUED;
+	q->count--;
 
-	length = IntAlign(length + 4);
-	sock->receiveMessageLength -= length;
-
-	if (sock->receiveMessageLength)
-		memmove (sock->receiveMessage, &sock->receiveMessage[length], sock->receiveMessageLength);
+	ret = m->type;
+	swap = net_message.data;
+	net_message.data = m->data;
+	net_message.cursize = m->length;
+	m->data = swap;
 
 	if (sock->driverdata && ret == 1)
 		((qsocket_t *)sock->driverdata)->canSend = true;
@@ -157,32 +205,17 @@ int Loop_GetMessage (qsocket_t *sock)
 
 int Loop_SendMessage (qsocket_t *sock, sizebuf_t *data)
 {
-	byte *buffer;
-	int  *bufferLength;
+	loopmsg_t	*m;
 
 	if (!sock->driverdata)
 		return -1;
 
-	bufferLength = &((qsocket_t *)sock->driverdata)->receiveMessageLength;
-
-	if ((*bufferLength + data->cursize + 4) > NET_MAXMESSAGE)
+	if (data->cursize > NET_MAXMESSAGE || (m = Loop_QueueMessage (sock, 1)) == NULL)
 		Sys_Error("Loop_SendMessage: overflow");
 
-	buffer = ((qsocket_t *)sock->driverdata)->receiveMessage + *bufferLength;
-
-	// message type
-	*buffer++ = 1;
-
-	// length
-	*buffer++ = data->cursize & 0xff;
-	*buffer++ = data->cursize >> 8;
-
-	// align
-	buffer++;
-
-	// message
-	Q_memcpy(buffer, data->data, data->cursize);
-	*bufferLength = IntAlign(*bufferLength + data->cursize + 4);
+	m->type = 1;
+	m->length = data->cursize;
+	Q_memcpy(m->data, data->data, data->cursize);
 
 	sock->canSend = false;
 	return 1;
@@ -191,32 +224,17 @@ int Loop_SendMessage (qsocket_t *sock, sizebuf_t *data)
 
 int Loop_SendUnreliableMessage (qsocket_t *sock, sizebuf_t *data)
 {
-	byte *buffer;
-	int  *bufferLength;
+	loopmsg_t	*m;
 
 	if (!sock->driverdata)
 		return -1;
 
-	bufferLength = &((qsocket_t *)sock->driverdata)->receiveMessageLength;
-
-	if ((*bufferLength + data->cursize + sizeof(byte) + sizeof(short)) > NET_MAXMESSAGE)
+	if (data->cursize > NET_MAXMESSAGE || (m = Loop_QueueMessage (sock, 2)) == NULL)
 		return 0;
 
-	buffer = ((qsocket_t *)sock->driverdata)->receiveMessage + *bufferLength;
-
-	// message type
-	*buffer++ = 2;
-
-	// length
-	*buffer++ = data->cursize & 0xff;
-	*buffer++ = data->cursize >> 8;
-
-	// align
-	buffer++;
-
-	// message
-	Q_memcpy(buffer, data->data, data->cursize);
-	*bufferLength = IntAlign(*bufferLength + data->cursize + 4);
+	m->type = 2;
+	m->length = data->cursize;
+	Q_memcpy(m->data, data->data, data->cursize);
 	return 1;
 }
 
@@ -242,6 +260,7 @@ void Loop_Close (qsocket_t *sock)
 	sock->receiveMessageLength = 0;
 	sock->sendMessageLength = 0;
 	sock->canSend = true;
+	Loop_Queue (sock)->count = 0;
 	if (sock == loop_client)
 		loop_client = NULL;
 	else
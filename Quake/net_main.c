@@ -749,6 +749,40 @@ int NET_SendToAll (sizebuf_t *data, double blocktime)
 }
 
 
+/*
+===================
+NET_Drain
+===================
+*/
+void NET_Drain (void)
+{
+	int	i;
+
+	for (i = 0; i < net_numlandrivers; i++)
+	{
+		if (net_landrivers[i].initialized && net_landrivers[i].Drain)
+			net_landrivers[i].Drain ();
+	}
+}
+
+
+/*
+===================
+NET_Flush
+===================
+*/
+void NET_Flush (void)
+{
+	int	i;
+
+	for (i = 0; i < net_numlandrivers; i++)
+	{
+		if (net_landrivers[i].initialized && net_landrivers[i].Flush)
+			net_landrivers[i].Flush ();
+	}
+}
+
+
 //=============================================================================
 
 /*
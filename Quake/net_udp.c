@@ -20,6 +20,10 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE	/* recvmmsg, sendmmsg */
+#endif
+
 #include "q_stdinc.h"
 #include "arch_def.h"
 #include "net_sys.h"
@@ -35,6 +39,484 @@ static in_addr_t	myAddr;
 
 #include "net_udp.h"
 
+/*
+=============================================================================
+
+BATCHED I/O
+
+On linux the server multiplexes every remote connection onto the accept
+socket instead of opening a socket per client.  Incoming datagrams are
+drained once per frame with recvmmsg and handed out to the connections
+by source address, outgoing ones are held back and pushed with sendmmsg
+when the frame is done (UDP_Flush), so the syscall count per server frame
+no longer grows with the number of clients.
+
+Connections get a "virtual" socket handle that only the functions in this
+file know how to interpret.  Pass -noudpbatch to get the old behaviour.
+
+=============================================================================
+*/
+
+#ifdef __linux__
+#define UDP_BATCHED_IO
+#endif
+
+#ifdef UDP_BATCHED_IO
+
+#include <sys/epoll.h>
+
+#define UDP_BATCH		16		// datagrams per recvmmsg/sendmmsg call
+#define UDP_MAXPACKETS		256		// queued incoming datagrams
+#define UDP_MAXUNCLAIMED	32		// of which not for a connection
+#define UDP_SMALLPACKET		1400		// larger datagrams get their own allocation
+#define UDP_MAXVIRTUAL		MAX_SCOREBOARD
+#define UDP_VIRTUAL_BASE	0x40000000
+
+#define UDP_IsVirtual(s)	((s) >= UDP_VIRTUAL_BASE && (s) < UDP_VIRTUAL_BASE + UDP_MAXVIRTUAL)
+
+typedef struct udppacket_s
+{
+	struct udppacket_s	*next;
+	struct qsockaddr	addr;
+	int			len;
+	byte			*data;		// small, unless the datagram didn't fit
+	byte			small[UDP_SMALLPACKET];
+} udppacket_t;
+
+typedef struct
+{
+	udppacket_t	*head;
+	udppacket_t	*tail;
+	int		count;
+} udpqueue_t;
+
+typedef struct
+{
+	qboolean		active;
+	struct qsockaddr	addr;
+	udpqueue_t		queue;
+	int			drained;	// udp_drains when a read last came up empty
+} udpvirtual_t;
+
+static int		udp_epoll = -1;		// -1 when not batching
+static qboolean		udp_listening;		// accept socket may outlive Listen(false)
+static int		udp_drains;
+
+static udppacket_t	udp_packets[UDP_MAXPACKETS];
+static udppacket_t	*udp_freepackets;
+static udpqueue_t	udp_unclaimed;		// control requests and unknown senders
+static udpvirtual_t	udp_virtual[UDP_MAXVIRTUAL];
+static int		udp_numvirtual;
+
+static byte		*udp_recvbuf;		// UDP_BATCH * NET_DATAGRAMSIZE
+static struct mmsghdr	udp_recvmsgs[UDP_BATCH];
+static struct iovec	udp_recviov[UDP_BATCH];
+static struct qsockaddr	udp_recvaddr[UDP_BATCH];
+
+static byte		*udp_sendbuf;		// UDP_BATCH * NET_DATAGRAMSIZE
+static struct mmsghdr	udp_sendmsgs[UDP_BATCH];
+static struct iovec	udp_sendiov[UDP_BATCH];
+static struct qsockaddr	udp_sendaddr[UDP_BATCH];
+static int		udp_numsends;
+
+/*
+====================
+UDP_FreePacket
+====================
+*/
+static void UDP_FreePacket (udppacket_t *p)
+{
+	if (p->data != p->small)
+		free (p->data);
+	p->next = udp_freepackets;
+	udp_freepackets = p;
+}
+
+/*
+====================
+UDP_PopPacket
+====================
+*/
+static udppacket_t *UDP_PopPacket (udpqueue_t *q)
+{
+	udppacket_t *p = q->head;
+
+	if (!p)
+		return NULL;
+	q->head = p->next;
+	if (!q->head)
+		q->tail = NULL;
+	q->count--;
+	p->next = NULL;
+	return p;
+}
+
+/*
+====================
+UDP_PushPacket
+====================
+*/
+static void UDP_PushPacket (udpqueue_t *q, udppacket_t *p)
+{
+	p->next = NULL;
+	if (q->tail)
+		q->tail->next = p;
+	else
+		q->head = p;
+	q->tail = p;
+	q->count++;
+}
+
+/*
+====================
+UDP_ClearQueue
+====================
+*/
+static void UDP_ClearQueue (udpqueue_t *q)
+{
+	udppacket_t *p;
+
+	while ((p = UDP_PopPacket (q)) != NULL)
+		UDP_FreePacket (p);
+}
+
+/*
+====================
+UDP_Enqueue
+
+Hands a received datagram to the connection it came from.  Control
+packets always go to the accept queue, so a client retrying its connect
+request still gets a duplicate CCREP_ACCEPT.
+====================
+*/
+static void UDP_Enqueue (struct qsockaddr *addr, byte *data, int len)
+{
+	udpqueue_t	*q = &udp_unclaimed;
+	udppacket_t	*p;
+	int		i;
+
+	if (len <= 0)
+		return;	// quietly absorb empty packets
+
+	if (len < (int) sizeof(int) || !(BigLong(*(int *)data) & NETFLAG_CTL))
+	{
+		for (i = 0; i < UDP_MAXVIRTUAL; i++)
+		{
+			if (udp_virtual[i].active && UDP_AddrCompare (addr, &udp_virtual[i].addr) == 0)
+			{
+				q = &udp_virtual[i].queue;
+				break;
+			}
+		}
+	}
+
+	if (q == &udp_unclaimed && q->count >= UDP_MAXUNCLAIMED)
+		UDP_FreePacket (UDP_PopPacket (q));	// drop the oldest
+
+	if (!udp_freepackets)
+		return;	// dropped, the protocol copes with lost datagrams
+	p = udp_freepackets;
+	udp_freepackets = p->next;
+
+	p->addr = *addr;
+	p->len = len;
+	p->data = (len <= UDP_SMALLPACKET) ? p->small : (byte *) malloc (len);
+	if (!p->data)
+	{
+		p->data = p->small;
+		UDP_FreePacket (p);
+		return;
+	}
+	memcpy (p->data, data, len);
+	UDP_PushPacket (q, p);
+}
+
+/*
+====================
+UDP_Flush
+
+Sends everything queued by UDP_Write on virtual sockets.
+====================
+*/
+void UDP_Flush (void)
+{
+	int	sent, ret, err;
+
+	for (sent = 0; sent < udp_numsends; sent += ret)
+	{
+		ret = sendmmsg (net_acceptsocket, udp_sendmsgs + sent, udp_numsends - sent, 0);
+		if (ret <= 0)
+		{
+			err = SOCKETERRNO;
+			if (err == NET_EWOULDBLOCK)
+				break;	// same as a dropped UDP_Write
+			Con_SafePrintf ("UDP_Flush, sendmmsg: %s\n", socketerror(err));
+			ret = 1;	// skip the offending datagram
+		}
+	}
+	udp_numsends = 0;
+}
+
+/*
+====================
+UDP_Drain
+
+Moves everything waiting on the accept socket into the queues.  The
+server calls this once per frame (NET_Drain), whatever is still waiting
+in the accept queue.
+====================
+*/
+void UDP_Drain (void)
+{
+	struct epoll_event	event;
+	int			i, n, err;
+
+	if (udp_epoll == -1)
+		return;
+
+	// replies are usually what we're waiting for
+	UDP_Flush ();
+
+	udp_drains++;
+	if (epoll_wait (udp_epoll, &event, 1, 0) <= 0)
+		return;
+
+	do
+	{
+		for (i = 0; i < UDP_BATCH; i++)
+			udp_recvmsgs[i].msg_hdr.msg_namelen = sizeof(struct qsockaddr);
+
+		n = recvmmsg (net_acceptsocket, udp_recvmsgs, UDP_BATCH, MSG_DONTWAIT, NULL);
+		if (n == SOCKET_ERROR)
+		{
+			err = SOCKETERRNO;
+			if (err != NET_EWOULDBLOCK && err != NET_ECONNREFUSED)
+				Con_SafePrintf ("UDP_Drain, recvmmsg: %s\n", socketerror(err));
+			break;
+		}
+
+		for (i = 0; i < n; i++)
+			UDP_Enqueue (&udp_recvaddr[i], udp_recviov[i].iov_base, (int) udp_recvmsgs[i].msg_len);
+	} while (n == UDP_BATCH);
+}
+
+/*
+====================
+UDP_InitBatch
+====================
+*/
+static void UDP_InitBatch (void)
+{
+	struct epoll_event	event;
+	int			i;
+
+	if (COM_CheckParm ("-noudpbatch"))
+		return;
+
+	udp_epoll = epoll_create1 (EPOLL_CLOEXEC);
+	if (udp_epoll == -1)
+	{
+		Con_SafePrintf ("UDP_InitBatch: epoll_create1: %s\n", strerror(errno));
+		return;
+	}
+	memset (&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = net_acceptsocket;
+	if (epoll_ctl (udp_epoll, EPOLL_CTL_ADD, net_acceptsocket, &event) == -1)
+	{
+		Con_SafePrintf ("UDP_InitBatch: epoll_ctl: %s\n", strerror(errno));
+		close (udp_epoll);
+		udp_epoll = -1;
+		return;
+	}
+
+	if (!udp_recvbuf)
+	{
+		udp_recvbuf = (byte *) malloc (UDP_BATCH * NET_DATAGRAMSIZE);
+		udp_sendbuf = (byte *) malloc (UDP_BATCH * NET_DATAGRAMSIZE);
+		if (!udp_recvbuf || !udp_sendbuf)
+			Sys_Error ("UDP_InitBatch: out of memory");
+	}
+
+	memset (udp_recvmsgs, 0, sizeof(udp_recvmsgs));
+	memset (udp_sendmsgs, 0, sizeof(udp_sendmsgs));
+	for (i = 0; i < UDP_BATCH; i++)
+	{
+		udp_recviov[i].iov_base = udp_recvbuf + i * NET_DATAGRAMSIZE;
+		udp_recviov[i].iov_len = NET_DATAGRAMSIZE;
+		udp_recvmsgs[i].msg_hdr.msg_name = &udp_recvaddr[i];
+		udp_recvmsgs[i].msg_hdr.msg_iov = &udp_recviov[i];
+		udp_recvmsgs[i].msg_hdr.msg_iovlen = 1;
+
+		udp_sendiov[i].iov_base = udp_sendbuf + i * NET_DATAGRAMSIZE;
+		udp_sendmsgs[i].msg_hdr.msg_name = &udp_sendaddr[i];
+		udp_sendmsgs[i].msg_hdr.msg_namelen = sizeof(struct qsockaddr);
+		udp_sendmsgs[i].msg_hdr.msg_iov = &udp_sendiov[i];
+		udp_sendmsgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	udp_freepackets = NULL;
+	for (i = UDP_MAXPACKETS - 1; i >= 0; i--)
+	{
+		udp_packets[i].data = udp_packets[i].small;
+		udp_packets[i].next = udp_freepackets;
+		udp_freepackets = &udp_packets[i];
+	}
+	memset (&udp_unclaimed, 0, sizeof(udp_unclaimed));
+	memset (udp_virtual, 0, sizeof(udp_virtual));
+	udp_numvirtual = 0;
+	udp_numsends = 0;
+}
+
+/*
+====================
+UDP_ShutdownBatch
+====================
+*/
+static void UDP_ShutdownBatch (void)
+{
+	int	i;
+
+	if (udp_epoll == -1)
+		return;
+
+	UDP_Flush ();
+	UDP_ClearQueue (&udp_unclaimed);
+	for (i = 0; i < UDP_MAXVIRTUAL; i++)
+	{
+		UDP_ClearQueue (&udp_virtual[i].queue);
+		udp_virtual[i].active = false;
+	}
+	udp_numvirtual = 0;
+
+	close (udp_epoll);
+	udp_epoll = -1;
+}
+
+/*
+====================
+UDP_ReadQueued
+====================
+*/
+static int UDP_ReadQueued (sys_socket_t socketid, byte *buf, int len, struct qsockaddr *addr)
+{
+	udpvirtual_t	*v = NULL;
+	udpqueue_t	*q = &udp_unclaimed;
+	udppacket_t	*p;
+
+	if (socketid != net_acceptsocket)
+	{
+		v = &udp_virtual[socketid - UDP_VIRTUAL_BASE];
+		if (!v->active)
+			return -1;
+		q = &v->queue;
+	}
+
+	if (!q->head && v)
+	{
+		// a connection read dry twice since the last drain means nobody
+		// else is draining (e.g. NET_SendToAll waiting for acks), so do it
+		if (v->drained != udp_drains)
+		{
+			v->drained = udp_drains;
+			return 0;
+		}
+		UDP_Drain ();
+		v->drained = udp_drains;
+	}
+
+	p = UDP_PopPacket (q);
+	if (!p)
+		return 0;
+
+	if (len > p->len)
+		len = p->len;
+	memcpy (buf, p->data, len);
+	*addr = p->addr;
+	UDP_FreePacket (p);
+	return len;
+}
+
+/*
+====================
+UDP_WriteQueued
+====================
+*/
+static int UDP_WriteQueued (byte *buf, int len, struct qsockaddr *addr)
+{
+	if (len > NET_DATAGRAMSIZE)
+		return -1;
+
+	memcpy (udp_sendiov[udp_numsends].iov_base, buf, len);
+	udp_sendiov[udp_numsends].iov_len = len;
+	udp_sendaddr[udp_numsends] = *addr;
+	if (++udp_numsends == UDP_BATCH)
+		UDP_Flush ();
+	return len;
+}
+
+#else	/* !UDP_BATCHED_IO */
+
+void UDP_Flush (void)
+{
+}
+
+void UDP_Drain (void)
+{
+}
+
+#endif	/* UDP_BATCHED_IO */
+
+/*
+====================
+UDP_Accept
+
+Returns a handle for a new connection from addr that shares socketid,
+or INVALID_SOCKET if the caller should open a socket of its own.
+====================
+*/
+sys_socket_t UDP_Accept (sys_socket_t socketid, struct qsockaddr *addr)
+{
+#ifdef UDP_BATCHED_IO
+	udpqueue_t	pending;
+	udppacket_t	*p;
+	int		i;
+
+	if (udp_epoll == -1 || socketid != net_acceptsocket)
+		return INVALID_SOCKET;
+
+	for (i = 0; i < UDP_MAXVIRTUAL; i++)
+	{
+		if (!udp_virtual[i].active)
+			break;
+	}
+	if (i == UDP_MAXVIRTUAL)
+		return INVALID_SOCKET;
+
+	memset (&udp_virtual[i], 0, sizeof(udp_virtual[i]));
+	udp_virtual[i].active = true;
+	udp_virtual[i].addr = *addr;
+	udp_virtual[i].drained = udp_drains;
+	udp_numvirtual++;
+
+	// claim anything it already sent that isn't a control request
+	memset (&pending, 0, sizeof(pending));
+	while ((p = UDP_PopPacket (&udp_unclaimed)) != NULL)
+	{
+		if (UDP_AddrCompare (&p->addr, addr) == 0 && !(p->len >= (int) sizeof(int) &&
+				(BigLong(*(int *)p->data) & NETFLAG_CTL)))
+			UDP_PushPacket (&udp_virtual[i].queue, p);
+		else
+			UDP_PushPacket (&pending, p);
+	}
+	udp_unclaimed = pending;
+
+	return UDP_VIRTUAL_BASE + i;
+#else
+	return INVALID_SOCKET;
+#endif
+}
+
 //=============================================================================
 
 sys_socket_t UDP_Init (void)
@@ -102,6 +584,14 @@ sys_socket_t UDP_Init (void)
 void UDP_Shutdown (void)
 {
 	UDP_Listen (false);
+#ifdef UDP_BATCHED_IO
+	if (net_acceptsocket != INVALID_SOCKET)
+	{	// connections still open, shut down regardless
+		UDP_ShutdownBatch ();
+		UDP_CloseSocket (net_acceptsocket);
+		net_acceptsocket = INVALID_SOCKET;
+	}
+#endif
 	UDP_CloseSocket (net_controlsocket);
 }
 
@@ -112,16 +602,31 @@ void UDP_Listen (qboolean state)
 	// enable listening
 	if (state)
 	{
+#ifdef UDP_BATCHED_IO
+		udp_listening = true;
+#endif
 		if (net_acceptsocket != INVALID_SOCKET)
 			return;
 		if ((net_acceptsocket = UDP_OpenSocket (net_hostport)) == INVALID_SOCKET)
 			Sys_Error ("UDP_Listen: Unable to open accept socket");
+#ifdef UDP_BATCHED_IO
+		UDP_InitBatch ();
+#endif
 		return;
 	}
 
 	// disable listening
 	if (net_acceptsocket == INVALID_SOCKET)
 		return;
+#ifdef UDP_BATCHED_IO
+	udp_listening = false;
+	if (udp_numvirtual)
+	{	// connected clients still talk through it, close with the last one
+		UDP_ClearQueue (&udp_unclaimed);
+		return;
+	}
+	UDP_ShutdownBatch ();
+#endif
 	UDP_CloseSocket (net_acceptsocket);
 	net_acceptsocket = INVALID_SOCKET;
 }
@@ -163,6 +668,25 @@ ErrorReturn:
 
 int UDP_CloseSocket (sys_socket_t socketid)
 {
+#ifdef UDP_BATCHED_IO
+	if (UDP_IsVirtual(socketid))
+	{
+		udpvirtual_t *v = &udp_virtual[socketid - UDP_VIRTUAL_BASE];
+
+		if (!v->active)
+			return -1;
+		UDP_Flush ();	// let the disconnect message out
+		UDP_ClearQueue (&v->queue);
+		v->active = false;
+		if (--udp_numvirtual == 0 && !udp_listening && net_acceptsocket != INVALID_SOCKET)
+		{
+			UDP_ShutdownBatch ();
+			UDP_CloseSocket (net_acceptsocket);
+			net_acceptsocket = INVALID_SOCKET;
+		}
+		return 0;
+	}
+#endif
 	if (socketid == net_broadcastsocket)
 		net_broadcastsocket = 0;
 	return closesocket (socketid);
@@ -243,6 +767,15 @@ sys_socket_t UDP_CheckNewConnections (void)
 	if (net_acceptsocket == INVALID_SOCKET)
 		return INVALID_SOCKET;
 
+#ifdef UDP_BATCHED_IO
+	if (udp_epoll != -1)
+	{
+		if (!udp_listening)
+			return INVALID_SOCKET;
+		return udp_unclaimed.head ? net_acceptsocket : INVALID_SOCKET;
+	}
+#endif
+
 	if (ioctl (net_acceptsocket, FIONREAD, &available) == -1)
 	{
 		int err = SOCKETERRNO;
@@ -262,6 +795,13 @@ int UDP_Read (sys_socket_t socketid, byte *buf, int len, struct qsockaddr *addr)
 	socklen_t addrlen = sizeof(struct qsockaddr);
 	int ret;
 
+#ifdef UDP_BATCHED_IO
+	if (UDP_IsVirtual(socketid))
+		return (udp_epoll != -1) ? UDP_ReadQueued (socketid, buf, len, addr) : -1;
+	if (udp_epoll != -1 && socketid == net_acceptsocket)
+		return UDP_ReadQueued (socketid, buf, len, addr);
+#endif
+
 	ret = recvfrom (socketid, buf, len, 0, (struct sockaddr *)addr, &addrlen);
 	if (ret == SOCKET_ERROR)
 	{
@@ -319,6 +859,11 @@ int UDP_Write (sys_socket_t socketid, byte *buf, int len, struct qsockaddr *addr
 {
 	int	ret;
 
+#ifdef UDP_BATCHED_IO
+	if (UDP_IsVirtual(socketid))
+		return (udp_epoll != -1) ? UDP_WriteQueued (buf, len, addr) : -1;
+#endif
+
 	ret = sendto (socketid, buf, len, 0, (struct sockaddr *)addr,
 							sizeof(struct qsockaddr));
 	if (ret == SOCKET_ERROR)
@@ -367,6 +912,11 @@ int UDP_GetSocketAddr (sys_socket_t socketid, struct qsockaddr *addr)
 	socklen_t addrlen = sizeof(struct qsockaddr);
 	in_addr_t a;
 
+#ifdef UDP_BATCHED_IO
+	if (UDP_IsVirtual(socketid))
+		socketid = net_acceptsocket;
+#endif
+
 	memset(addr, 0, sizeof(struct qsockaddr));
 	if (getsockname(socketid, (struct sockaddr *)addr, &addrlen) != 0)
 		return -1;
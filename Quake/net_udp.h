@@ -40,6 +40,9 @@ int  UDP_GetAddrFromName (const char *name, struct qsockaddr *addr);
 int  UDP_AddrCompare (struct qsockaddr *addr1, struct qsockaddr *addr2);
 int  UDP_GetSocketPort (struct qsockaddr *addr);
 int  UDP_SetSocketPort (struct qsockaddr *addr, int port);
+sys_socket_t  UDP_Accept (sys_socket_t socketid, struct qsockaddr *addr);
+void UDP_Flush (void);
+void UDP_Drain (void);
 
 #endif	/* __net_udp_h */
 
@@ -91,7 +91,10 @@ net_landriver_t	net_landrivers[] =
 		WINS_GetAddrFromName,
 		WINS_AddrCompare,
 		WINS_GetSocketPort,
-		WINS_SetSocketPort
+		WINS_SetSocketPort,
+		NULL,
+		NULL,
+		NULL
 	},
 
 	{	"Winsock IPX",
@@ -114,7 +117,10 @@ net_landriver_t	net_landrivers[] =
 		WIPX_GetAddrFromName,
 		WIPX_AddrCompare,
 		WIPX_GetSocketPort,
-		WIPX_SetSocketPort
+		WIPX_SetSocketPort,
+		NULL,
+		NULL,
+		NULL
 	}
 };
 
@@ -28,6 +28,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define	PROTOCOL_NETQUAKE	15 //johnfitz -- standard quake protocol
 #define PROTOCOL_FITZQUAKE	666 //johnfitz -- added new protocol for fitzquake 0.85
 #define PROTOCOL_RMQ		999
+#define PROTOCOL_DELTA		1000 // PROTOCOL_RMQ plus delta-compressed entity snapshots (svc_snapshot)
 
 // PROTOCOL_RMQ protocol flags
 #define PRFL_SHORTANGLE		(1 << 1)
@@ -201,6 +202,10 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define	svc_spawnstaticsound2	44	// [coord3] [short] samp [byte] vol [byte] aten
 //johnfitz
 
+// PROTOCOL_DELTA -- replaces the per-entity fast updates
+#define	svc_snapshot			45	// [long] sequence [long] delta sequence, then entity deltas
+									// terminated by a zero [short] entity number, see SV_WriteSnapshotToClient
+
 //
 // client to server
 //
@@ -243,6 +248,33 @@ typedef struct
 	int		effects;
 } entity_state_t;
 
+//
+// PROTOCOL_DELTA entity snapshots
+//
+#define	UPDATE_BACKUP			16	// snapshots kept for delta references, must be a power of 2
+#define	UPDATE_MASK				(UPDATE_BACKUP-1)
+#define	MAX_SNAPSHOT_ENTITIES	512
+
+#define	SNAP_REMOVE			(1<<15)	// set in the entity number of a snapshot record, no data follows
+
+#define	SNAPFL_STEP			(1<<0)	// MOVETYPE_STEP, sent as U_STEP
+#define	SNAPFL_LERPFINISH	(1<<1)	// lerpfinish is valid for this snapshot only
+
+typedef struct
+{
+	unsigned short	number;
+	byte			flags;		// SNAPFL_*
+	byte			lerpfinish;
+	entity_state_t	state;
+} snapshot_entity_t;
+
+typedef struct
+{
+	int					sequence;	// 0 = not valid
+	int					num_entities;
+	snapshot_entity_t	entities[MAX_SNAPSHOT_ENTITIES];	// sorted by number
+} snapshot_t;
+
 typedef struct
 {
 	vec3_t	viewangles;
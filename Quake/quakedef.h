@@ -187,9 +187,6 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #define	SOUND_CHANNELS		8
 
-#define WARPIMAGESIZE		512
-#define WARPIMAGEMIPS		5
-
 typedef struct
 {
 	const char *basedir;
@@ -216,6 +213,7 @@ typedef struct
 
 #include "cmd.h"
 #include "crc.h"
+#include "tasks.h"
 
 #include "progs.h"
 #include "server.h"
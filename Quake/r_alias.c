@@ -65,6 +65,7 @@ typedef struct {
 } lerpdata_t;
 //johnfitz
 
+// per instance data, matches InstanceData in alias.vert (std430, 128 byte stride)
 typedef struct {
 	float model_matrix[16];
 	float shade_vector[3];
@@ -72,30 +73,39 @@ typedef struct {
 	float light_color[3];
 	unsigned int use_fullbright;
 	float entalpha;
-} aliasubo_t;
+	unsigned int diffuse_index; // only read by the bindless pipelines
+	unsigned int fullbright_index;
+	unsigned int pose1_offset; // first vertex of the pose in the model's pose buffer
+	unsigned int pose2_offset;
+	float padding[3];
+} aliasinstance_t;
+
+// an alias model queued by R_DrawAliasModel, drawn instanced by R_FlushAliasInstances
+typedef struct {
+	qmodel_t *model;
+	aliashdr_t *paliashdr;
+	gltexture_t *tx, *fb;
+	qboolean alpha_blend;
+	aliasinstance_t instance;
+} aliasdraw_t;
 
-/*
-=============
-GLARB_GetXYZOffset
+#define MAX_ALIAS_INSTANCES 512 // per draw call, 64KB of instance data
 
-Returns the offset of the first vertex's meshxyz_t.xyz in the vbo for the given
-model and pose.
-=============
-*/
-static VkDeviceSize GLARB_GetXYZOffset (aliashdr_t *hdr, int pose)
-{
-	meshxyz_t dummy;
-	int xyzoffs = ((char*)&dummy.xyz - (char*)&dummy);
-	return currententity->model->vboxyzofs + (hdr->numverts_vbo * pose * sizeof (meshxyz_t)) + xyzoffs;
-}
+static aliasdraw_t	alias_draws[MAX_VISEDICTS + 1]; // +1 for the view model
+static aliasdraw_t	*sorted_alias_draws[MAX_VISEDICTS + 1];
+static int			num_alias_draws;
 
 /*
 =============
 GL_DrawAliasFrame -- ericw
 
-Optimized alias model drawing codepath. This makes 1 draw call,
-no vertex data is uploaded (it's already in the r_meshvbo and r_meshindexesvbo
-static VBOs), and lerping and lighting is done in the vertex shader.
+Optimized alias model drawing codepath. No vertex data is uploaded (it's already
+in the r_meshvbo and r_meshindexesvbo static VBOs), and lerping and lighting is
+done in the vertex shader, which fetches both poses by offset from the model's
+pose buffer.
+
+Only queues the model, R_FlushAliasInstances draws all models sharing the same
+vertex data and skin with a single instanced draw call, whatever their frames.
 
 Supports optional fullbright pixels.
 
@@ -104,8 +114,12 @@ Based on code by MH from RMQEngine
 */
 static void GL_DrawAliasFrame (aliashdr_t *paliashdr, lerpdata_t lerpdata, gltexture_t *tx, gltexture_t *fb, float model_matrix[16], float entalpha)
 {
+	aliasdraw_t	*draw;
 	float	blend;
 
+	if (num_alias_draws == MAX_VISEDICTS + 1)
+		R_FlushAliasInstances ();
+
 	if (lerpdata.pose1 != lerpdata.pose2)
 	{
 		blend = lerpdata.blend;
@@ -115,31 +129,130 @@ static void GL_DrawAliasFrame (aliashdr_t *paliashdr, lerpdata_t lerpdata, gltex
 		blend = 0;
 	}
 
-	vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, (entalpha < 1.0f) ? vulkan_globals.alias_blend_pipeline : vulkan_globals.alias_pipeline);
+	if (tx == NULL)
+		tx = notexture;
+
+	draw = &alias_draws[num_alias_draws];
+	sorted_alias_draws[num_alias_draws] = draw;
+	num_alias_draws++;
+
+	draw->model = currententity->model;
+	draw->paliashdr = paliashdr;
+	draw->tx = tx;
+	draw->fb = fb;
+	draw->alpha_blend = entalpha < 1.0f;
+
+	memcpy(draw->instance.model_matrix, model_matrix, 16 * sizeof(float));
+	memcpy(draw->instance.shade_vector, shadevector, 3 * sizeof(float));
+	draw->instance.blend_factor = blend;
+	memcpy(draw->instance.light_color, lightcolor, 3 * sizeof(float));
+	draw->instance.use_fullbright = (fb != NULL) ? 1 : 0;
+	draw->instance.entalpha = entalpha;
+	draw->instance.diffuse_index = tx->bindless_index;
+	draw->instance.fullbright_index = (fb != NULL) ? fb->bindless_index : tx->bindless_index;
+	draw->instance.pose1_offset = lerpdata.pose1 * paliashdr->numverts_vbo;
+	draw->instance.pose2_offset = lerpdata.pose2 * paliashdr->numverts_vbo;
+	memset(draw->instance.padding, 0, sizeof(draw->instance.padding));
 
-	VkBuffer uniform_buffer;
-	uint32_t uniform_offset;
-	VkDescriptorSet ubo_set;
-	aliasubo_t * ubo = (aliasubo_t*)R_UniformAllocate(sizeof(aliasubo_t), &uniform_buffer, &uniform_offset, &ubo_set);
-	
-	memcpy(ubo->model_matrix, model_matrix, 16 * sizeof(float));
-	memcpy(ubo->shade_vector, shadevector, 3 * sizeof(float));
-	ubo->blend_factor = blend;
-	memcpy(ubo->light_color, lightcolor, 3 * sizeof(float));
-	ubo->use_fullbright = (fb != NULL) ? 1 : 0;
-	ubo->entalpha = entalpha;
+	rs_aliaspasses += paliashdr->numtris;
+}
 
-	VkDescriptorSet descriptor_sets[3] = { tx->descriptor_set, (fb != NULL) ? fb->descriptor_set : tx->descriptor_set, ubo_set };
-	vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.alias_pipeline_layout, 0, 3, descriptor_sets, 1, &uniform_offset);
+/*
+=============
+R_CompareAliasDraws
 
-	VkBuffer vertex_buffers[3] = { currententity->model->vertex_buffer, currententity->model->vertex_buffer, currententity->model->vertex_buffer };
-	VkDeviceSize vertex_offsets[3] = { (unsigned)currententity->model->vbostofs, GLARB_GetXYZOffset (paliashdr, lerpdata.pose1), GLARB_GetXYZOffset (paliashdr, lerpdata.pose2) };
-	vkCmdBindVertexBuffers(vulkan_globals.command_buffer, 0, 3, vertex_buffers, vertex_offsets);
-	vkCmdBindIndexBuffer(vulkan_globals.command_buffer, currententity->model->index_buffer, 0, VK_INDEX_TYPE_UINT16);
+Sort key for instancing. Bindless draws look their skins up by an index from
+the instance data, it has to be the same for the whole draw to be dynamically
+uniform, so the textures have to match there too.
+=============
+*/
+static int R_CompareAliasDraws (const void *a, const void *b)
+{
+	const aliasdraw_t *draw1 = *(const aliasdraw_t **)a;
+	const aliasdraw_t *draw2 = *(const aliasdraw_t **)b;
+
+	if (draw1->alpha_blend != draw2->alpha_blend)
+		return draw1->alpha_blend - draw2->alpha_blend;
+	if (draw1->model != draw2->model)
+		return (draw1->model < draw2->model) ? -1 : 1;
+	if (draw1->tx != draw2->tx)
+		return (draw1->tx < draw2->tx) ? -1 : 1;
+	if (draw1->fb != draw2->fb)
+		return (draw1->fb < draw2->fb) ? -1 : 1;
+	// keep the submission order otherwise
+	return (draw1 < draw2) ? -1 : (draw1 > draw2);
+}
 
-	vkCmdDrawIndexed(vulkan_globals.command_buffer, paliashdr->numindexes, 1, 0, 0, 0);
+/*
+=============
+R_FlushAliasInstances
 
-	rs_aliaspasses += paliashdr->numtris;
+Draws all alias models queued since the last flush, one instanced draw per
+run of models with the same key
+=============
+*/
+void R_FlushAliasInstances (void)
+{
+	int			i, j, k;
+	aliasdraw_t	*draw;
+	VkPipeline	pipeline, current_pipeline = VK_NULL_HANDLE;
+
+	if (num_alias_draws == 0)
+		return;
+
+	qsort (sorted_alias_draws, num_alias_draws, sizeof(aliasdraw_t *), R_CompareAliasDraws);
+
+	for (i = 0; i < num_alias_draws; i = j)
+	{
+		draw = sorted_alias_draws[i];
+
+		for (j = i + 1; j < num_alias_draws && (j - i) < MAX_ALIAS_INSTANCES; ++j)
+		{
+			aliasdraw_t *other = sorted_alias_draws[j];
+			if (other->alpha_blend != draw->alpha_blend || other->model != draw->model)
+				break;
+			if (other->tx != draw->tx || other->fb != draw->fb)
+				break;
+		}
+
+		if (vulkan_globals.bindless)
+			pipeline = draw->alpha_blend ? vulkan_globals.alias_bindless_blend_pipeline : vulkan_globals.alias_bindless_pipeline;
+		else
+			pipeline = draw->alpha_blend ? vulkan_globals.alias_blend_pipeline : vulkan_globals.alias_pipeline;
+		if (pipeline != current_pipeline)
+		{
+			vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+			R_BindLatch(vulkan_globals.bindless ? vulkan_globals.alias_bindless_pipeline_layout : vulkan_globals.alias_pipeline_layout, 4, false);
+			current_pipeline = pipeline;
+		}
+
+		VkBuffer storage_buffer;
+		uint32_t storage_offset;
+		VkDescriptorSet storage_set;
+		aliasinstance_t * instances = (aliasinstance_t*)R_StorageAllocate((j - i) * sizeof(aliasinstance_t), &storage_buffer, &storage_offset, &storage_set);
+		for (k = i; k < j; ++k)
+			memcpy(&instances[k - i], &sorted_alias_draws[k]->instance, sizeof(aliasinstance_t));
+
+		if (vulkan_globals.bindless)
+		{
+			// set 1 is unused by the bindless shader, any texture set satisfies the layout
+			VkDescriptorSet descriptor_sets[4] = { vulkan_globals.bindless_descriptor_set, draw->tx->descriptor_set, storage_set, draw->model->pose_descriptor_set };
+			vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.alias_bindless_pipeline_layout, 0, 4, descriptor_sets, 1, &storage_offset);
+		}
+		else
+		{
+			VkDescriptorSet descriptor_sets[4] = { draw->tx->descriptor_set, (draw->fb != NULL) ? draw->fb->descriptor_set : draw->tx->descriptor_set, storage_set, draw->model->pose_descriptor_set };
+			vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.alias_pipeline_layout, 0, 4, descriptor_sets, 1, &storage_offset);
+		}
+
+		VkDeviceSize vertex_offset = (unsigned)draw->model->vbostofs;
+		vkCmdBindVertexBuffers(vulkan_globals.command_buffer, 0, 1, &draw->model->vertex_buffer, &vertex_offset);
+		vkCmdBindIndexBuffer(vulkan_globals.command_buffer, draw->model->index_buffer, 0, VK_INDEX_TYPE_UINT16);
+
+		vkCmdDrawIndexed(vulkan_globals.command_buffer, draw->paliashdr->numindexes, j - i, 0, 0, 0);
+	}
+
+	num_alias_draws = 0;
 }
 
 /*
@@ -28,12 +28,50 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 										//  time
 #define ABSOLUTE_MIN_PARTICLES	512		// no fewer than this no matter what's
 										//  on the command line
+#define MAX_GPU_PARTICLES		(1024*1024)	// upper limit of -particles when simulating on the GPU
+#define MAX_PARTICLE_SPAWNS	8192	// spawns collected before they are moved to the GPU ring or the CPU buckets
+#define NUM_PARTICLE_TYPES		(pt_blob2 + 1)
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 1))
+#define USE_SSE
+#include <xmmintrin.h>
+#endif
+
+// Must match struct Particle in particle.vert and particle_simulate.comp (std430)
+typedef struct
+{
+	float		org[3];
+	float		color;
+	float		vel[3];
+	float		ramp;
+	float		die;
+	uint32_t	type;
+	float		padding[2];
+} gpuparticle_t;
+
+#define GPU_PARTICLE_PALETTE_SIZE	(256 * sizeof(uint32_t)) // d_8to24table in front of the particles
 
 int		ramp1[8] = {0x6f, 0x6d, 0x6b, 0x69, 0x67, 0x65, 0x63, 0x61};
 int		ramp2[8] = {0x6f, 0x6e, 0x6d, 0x6c, 0x6b, 0x6a, 0x68, 0x66};
 int		ramp3[8] = {0x6d, 0x6b, 6, 5, 4, 3};
 
-particle_t	*active_particles, *free_particles, *particles;
+/*
+CPU particles: structure of arrays, one bucket per ptype_t so the update
+kernels run over whole streams without looking at the type. Dead particles
+are swap-removed, which keeps the streams packed but changes draw order
+*/
+typedef struct
+{
+	int		count, capacity;
+	float	*org[3];
+	float	*vel[3];
+	float	*color;
+	float	*ramp;
+	float	*die;
+} particlebucket_t;
+
+static particlebucket_t	particle_buckets[NUM_PARTICLE_TYPES];
+static int				num_cpu_particles;
 
 vec3_t			r_pright, r_pup, r_ppn;
 
@@ -44,6 +82,23 @@ float texturescalefactor; //johnfitz -- compensate for apparent size of differen
 
 cvar_t	r_particles = {"r_particles","1", CVAR_ARCHIVE}; //johnfitz
 
+/*
+GPU particles: spawns are collected on the CPU and copied into a ring buffer of gpuparticle_t
+once per frame, particle_simulate.comp does what CL_RunParticles does, and particle.vert
+expands each instance into a billboard. Use -cpuparticles to simulate on the CPU.
+*/
+static qboolean			r_gpuparticles;
+static particle_t		*particle_spawns;		// used by both paths
+static int				num_particle_spawns, max_particle_spawns;
+static int				gpu_particle_head;		// next ring slot to overwrite
+static int				num_gpu_particles;		// slots written since the last clear
+static float			gpu_particle_die;		// latest death of anything in the ring
+static qboolean			gpu_particle_simulate;
+static float			gpu_particle_params[3];	// time, frametime, grav of the last CL_RunParticles
+static VkBuffer			gpu_particle_buffer;
+static VkDeviceMemory	gpu_particle_memory;
+static VkDescriptorSet	gpu_particle_descriptor_set;
+
 /*
 ===============
 R_ParticleTextureLookup -- johnfitz -- generate nice antialiased 32x32 circle for particles
@@ -141,6 +196,93 @@ static void R_SetParticleTexture_f (cvar_t *var)
 	}
 }
 
+/*
+===============
+R_InitGPUParticles
+===============
+*/
+static void R_InitGPUParticles (void)
+{
+	VkResult err;
+	const int buffer_size = GPU_PARTICLE_PALETTE_SIZE + r_numparticles * sizeof(gpuparticle_t);
+
+	Con_Printf ("Initializing GPU particles\n");
+
+	VkBufferCreateInfo buffer_create_info;
+	memset(&buffer_create_info, 0, sizeof(buffer_create_info));
+	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_create_info.size = buffer_size;
+	buffer_create_info.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	err = vkCreateBuffer(vulkan_globals.device, &buffer_create_info, NULL, &gpu_particle_buffer);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkCreateBuffer failed");
+
+	GL_SetObjectName((uint64_t)gpu_particle_buffer, VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Particle Buffer");
+
+	VkMemoryRequirements memory_requirements;
+	vkGetBufferMemoryRequirements(vulkan_globals.device, gpu_particle_buffer, &memory_requirements);
+
+	VkMemoryAllocateInfo memory_allocate_info;
+	memset(&memory_allocate_info, 0, sizeof(memory_allocate_info));
+	memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memory_allocate_info.allocationSize = memory_requirements.size;
+	memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0);
+
+	num_vulkan_misc_allocations += 1;
+	err = vkAllocateMemory(vulkan_globals.device, &memory_allocate_info, NULL, &gpu_particle_memory);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkAllocateMemory failed");
+
+	GL_SetObjectName((uint64_t)gpu_particle_memory, VK_DEBUG_REPORT_OBJECT_TYPE_DEVICE_MEMORY_EXT, "Particle Memory");
+
+	err = vkBindBufferMemory(vulkan_globals.device, gpu_particle_buffer, gpu_particle_memory, 0);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkBindBufferMemory failed");
+
+	// The palette never changes, particles only ever get read after they were spawned
+	VkBuffer staging_buffer;
+	VkCommandBuffer command_buffer;
+	int staging_offset;
+	unsigned char * staging_memory = R_StagingAllocate(GPU_PARTICLE_PALETTE_SIZE, 4, &command_buffer, &staging_buffer, &staging_offset);
+
+	memcpy(staging_memory, d_8to24table, GPU_PARTICLE_PALETTE_SIZE);
+
+	VkBufferCopy region;
+	region.srcOffset = staging_offset;
+	region.dstOffset = 0;
+	region.size = GPU_PARTICLE_PALETTE_SIZE;
+	vkCmdCopyBuffer(command_buffer, staging_buffer, gpu_particle_buffer, 1, &region);
+
+	VkDescriptorSetAllocateInfo descriptor_set_allocate_info;
+	memset(&descriptor_set_allocate_info, 0, sizeof(descriptor_set_allocate_info));
+	descriptor_set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptor_set_allocate_info.descriptorPool = vulkan_globals.descriptor_pool;
+	descriptor_set_allocate_info.descriptorSetCount = 1;
+	descriptor_set_allocate_info.pSetLayouts = &vulkan_globals.particle_set_layout;
+
+	err = vkAllocateDescriptorSets(vulkan_globals.device, &descriptor_set_allocate_info, &gpu_particle_descriptor_set);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkAllocateDescriptorSets failed");
+
+	VkDescriptorBufferInfo buffer_info;
+	memset(&buffer_info, 0, sizeof(buffer_info));
+	buffer_info.buffer = gpu_particle_buffer;
+	buffer_info.offset = 0;
+	buffer_info.range = buffer_size;
+
+	VkWriteDescriptorSet particle_write;
+	memset(&particle_write, 0, sizeof(particle_write));
+	particle_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	particle_write.dstSet = gpu_particle_descriptor_set;
+	particle_write.dstBinding = 0;
+	particle_write.dstArrayElement = 0;
+	particle_write.descriptorCount = 1;
+	particle_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	particle_write.pBufferInfo = &buffer_info;
+
+	vkUpdateDescriptorSets(vulkan_globals.device, 1, &particle_write, 0, NULL);
+}
+
 /*
 ===============
 R_InitParticles
@@ -150,6 +292,8 @@ void R_InitParticles (void)
 {
 	int		i;
 
+	r_gpuparticles = !COM_CheckParm ("-cpuparticles");
+
 	i = COM_CheckParm ("-particles");
 
 	if (i)
@@ -157,14 +301,19 @@ void R_InitParticles (void)
 		r_numparticles = (int)(Q_atoi(com_argv[i+1]));
 		if (r_numparticles < ABSOLUTE_MIN_PARTICLES)
 			r_numparticles = ABSOLUTE_MIN_PARTICLES;
+		if (r_gpuparticles && r_numparticles > MAX_GPU_PARTICLES)
+			r_numparticles = MAX_GPU_PARTICLES;
 	}
 	else
 	{
 		r_numparticles = MAX_PARTICLES;
 	}
 
-	particles = (particle_t *)
-			Hunk_AllocName (r_numparticles * sizeof(particle_t), "particles");
+	max_particle_spawns = q_min(r_numparticles, MAX_PARTICLE_SPAWNS);
+	particle_spawns = (particle_t *) Hunk_AllocName (max_particle_spawns * sizeof(particle_t), "particles");
+
+	if (r_gpuparticles)
+		R_InitGPUParticles ();
 
 	Cvar_RegisterVariable (&r_particles); //johnfitz
 	Cvar_SetCallback (&r_particles, R_SetParticleTexture_f);
@@ -172,6 +321,105 @@ void R_InitParticles (void)
 	R_InitParticleTextures (); //johnfitz
 }
 
+/*
+===============
+R_GrowParticleBucket
+===============
+*/
+static void R_GrowParticleBucket (particlebucket_t *b, int count)
+{
+	int		i;
+
+	if (count <= b->capacity)
+		return;
+
+	b->capacity = q_max(count, q_max(b->capacity * 2, 256));
+	for (i = 0; i < 3; i++)
+	{
+		b->org[i] = (float *) realloc (b->org[i], b->capacity * sizeof(float));
+		b->vel[i] = (float *) realloc (b->vel[i], b->capacity * sizeof(float));
+	}
+	b->color = (float *) realloc (b->color, b->capacity * sizeof(float));
+	b->ramp = (float *) realloc (b->ramp, b->capacity * sizeof(float));
+	b->die = (float *) realloc (b->die, b->capacity * sizeof(float));
+
+	if (!b->org[0] || !b->org[1] || !b->org[2] || !b->vel[0] || !b->vel[1] || !b->vel[2] || !b->color || !b->ramp || !b->die)
+		Sys_Error ("R_GrowParticleBucket: out of memory");
+}
+
+/*
+===============
+R_AddParticlesToBuckets
+===============
+*/
+static void R_AddParticlesToBuckets (particlebucket_t *buckets, const particle_t *spawns, int count)
+{
+	int					i, j;
+	const particle_t	*p;
+	particlebucket_t	*b;
+
+	for (i = 0, p = spawns; i < count; i++, p++)
+	{
+		b = &buckets[p->type];
+		R_GrowParticleBucket (b, b->count + 1);
+
+		for (j = 0; j < 3; j++)
+		{
+			b->org[j][b->count] = p->org[j];
+			b->vel[j][b->count] = p->vel[j];
+		}
+		b->color[b->count] = p->color;
+		b->ramp[b->count] = p->ramp;
+		b->die[b->count] = p->die;
+		b->count++;
+	}
+}
+
+/*
+===============
+R_FlushParticleSpawns
+
+Moves the CPU path's spawns into their type's bucket
+===============
+*/
+static void R_FlushParticleSpawns (void)
+{
+	R_AddParticlesToBuckets (particle_buckets, particle_spawns, num_particle_spawns);
+
+	num_cpu_particles += num_particle_spawns;
+	num_particle_spawns = 0;
+}
+
+/*
+===============
+R_AllocParticle
+
+Returns NULL when out of particles. The particle is a slot in the spawn
+list, R_UpdateGPUParticles or R_FlushParticleSpawns moves it to its final place
+===============
+*/
+static particle_t *R_AllocParticle (void)
+{
+	particle_t	*p;
+
+	if (r_gpuparticles)
+	{
+		if (num_particle_spawns == max_particle_spawns)
+			return NULL;
+	}
+	else
+	{
+		if (num_cpu_particles + num_particle_spawns >= r_numparticles)
+			return NULL;
+		if (num_particle_spawns == max_particle_spawns)
+			R_FlushParticleSpawns ();
+	}
+
+	p = &particle_spawns[num_particle_spawns++];
+	memset (p, 0, sizeof(particle_t));
+	return p;
+}
+
 /*
 ===============
 R_EntityParticles
@@ -225,12 +473,8 @@ void R_EntityParticles (entity_t *ent)
 		forward[1] = cp*sy;
 		forward[2] = -sp;
 
-		if (!free_particles)
+		if (!(p = R_AllocParticle ()))
 			return;
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
 
 		p->die = cl.time + 0.01;
 		p->color = 0x6f;
@@ -251,12 +495,15 @@ void R_ClearParticles (void)
 {
 	int		i;
 
-	free_particles = &particles[0];
-	active_particles = NULL;
+	num_particle_spawns = 0;
+
+	gpu_particle_head = 0;
+	num_gpu_particles = 0;
+	gpu_particle_simulate = false;
 
-	for (i=0 ;i<r_numparticles ; i++)
-		particles[i].next = &particles[i+1];
-	particles[r_numparticles-1].next = NULL;
+	for (i = 0; i < NUM_PARTICLE_TYPES; i++)
+		particle_buckets[i].count = 0;
+	num_cpu_particles = 0;
 }
 
 /*
@@ -294,15 +541,11 @@ void R_ReadPointFile_f (void)
 			break;
 		c++;
 
-		if (!free_particles)
+		if (!(p = R_AllocParticle ()))
 		{
 			Con_Printf ("Not enough free particles\n");
 			break;
 		}
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
 
 		p->die = 99999;
 		p->color = (-c)&15;
@@ -354,12 +597,8 @@ void R_ParticleExplosion (vec3_t org)
 
 	for (i=0 ; i<1024 ; i++)
 	{
-		if (!free_particles)
+		if (!(p = R_AllocParticle ()))
 			return;
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
 
 		p->die = cl.time + 5;
 		p->color = ramp1[0];
@@ -398,12 +637,8 @@ void R_ParticleExplosion2 (vec3_t org, int colorStart, int colorLength)
 
 	for (i=0; i<512; i++)
 	{
-		if (!free_particles)
+		if (!(p = R_AllocParticle ()))
 			return;
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
 
 		p->die = cl.time + 0.3;
 		p->color = colorStart + (colorMod % colorLength);
@@ -430,12 +665,8 @@ void R_BlobExplosion (vec3_t org)
 
 	for (i=0 ; i<1024 ; i++)
 	{
-		if (!free_particles)
+		if (!(p = R_AllocParticle ()))
 			return;
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
 
 		p->die = cl.time + 1 + (rand()&8)*0.05;
 
@@ -474,12 +705,8 @@ void R_RunParticleEffect (vec3_t org, vec3_t dir, int color, int count)
 
 	for (i=0 ; i<count ; i++)
 	{
-		if (!free_particles)
+		if (!(p = R_AllocParticle ()))
 			return;
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
 
 		if (count == 1024)
 		{	// rocket explosion
@@ -535,12 +762,8 @@ void R_LavaSplash (vec3_t org)
 		for (j=-16 ; j<16 ; j++)
 			for (k=0 ; k<1 ; k++)
 			{
-				if (!free_particles)
+				if (!(p = R_AllocParticle ()))
 					return;
-				p = free_particles;
-				free_particles = p->next;
-				p->next = active_particles;
-				active_particles = p;
 
 				p->die = cl.time + 2 + (rand()&31) * 0.02;
 				p->color = 224 + (rand()&7);
@@ -576,12 +799,8 @@ void R_TeleportSplash (vec3_t org)
 		for (j=-16 ; j<16 ; j+=4)
 			for (k=-24 ; k<32 ; k+=4)
 			{
-				if (!free_particles)
+				if (!(p = R_AllocParticle ()))
 					return;
-				p = free_particles;
-				free_particles = p->next;
-				p->next = active_particles;
-				active_particles = p;
 
 				p->die = cl.time + 0.2 + (rand()&7) * 0.02;
 				p->color = 7 + (rand()&7);
@@ -631,12 +850,8 @@ void R_RocketTrail (vec3_t start, vec3_t end, int type)
 	{
 		len -= dec;
 
-		if (!free_particles)
+		if (!(p = R_AllocParticle ()))
 			return;
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
 
 		VectorCopy (vec3_origin, p->vel);
 		p->die = cl.time + 2;
@@ -713,108 +928,348 @@ void R_RocketTrail (vec3_t start, vec3_t end, int type)
 
 /*
 ===============
-CL_RunParticles -- johnfitz -- all the particle behavior, separated from R_DrawParticles
+R_ParticleStreamMA -- dst[i] += src[i] * scale
 ===============
 */
-void CL_RunParticles (void)
+static void R_ParticleStreamMA (float *dst, const float *src, float scale, int count)
 {
-	particle_t		*p, *kill;
-	int				i;
-	float			time1, time2, time3, dvel, frametime, grav;
-	extern	cvar_t	sv_gravity;
+	int		i = 0;
+#ifdef USE_SSE
+	const __m128 s = _mm_set1_ps (scale);
+
+	for ( ; i + 4 <= count; i += 4)
+		_mm_storeu_ps (dst + i, _mm_add_ps (_mm_loadu_ps (dst + i), _mm_mul_ps (_mm_loadu_ps (src + i), s)));
+#endif
+	for ( ; i < count; i++)
+		dst[i] += src[i] * scale;
+}
 
-	frametime = cl.time - cl.oldtime;
-	time3 = frametime * 15;
-	time2 = frametime * 10;
-	time1 = frametime * 5;
-	grav = frametime * sv_gravity.value * 0.05;
-	dvel = 4*frametime;
+/*
+===============
+R_ParticleStreamMS -- dst[i] -= src[i] * scale
+===============
+*/
+static void R_ParticleStreamMS (float *dst, const float *src, float scale, int count)
+{
+	int		i = 0;
+#ifdef USE_SSE
+	const __m128 s = _mm_set1_ps (scale);
+
+	for ( ; i + 4 <= count; i += 4)
+		_mm_storeu_ps (dst + i, _mm_sub_ps (_mm_loadu_ps (dst + i), _mm_mul_ps (_mm_loadu_ps (src + i), s)));
+#endif
+	for ( ; i < count; i++)
+		dst[i] -= src[i] * scale;
+}
 
-	for ( ;; )
+/*
+===============
+R_ParticleStreamAdd -- dst[i] += value
+===============
+*/
+static void R_ParticleStreamAdd (float *dst, float value, int count)
+{
+	int		i = 0;
+#ifdef USE_SSE
+	const __m128 v = _mm_set1_ps (value);
+
+	for ( ; i + 4 <= count; i += 4)
+		_mm_storeu_ps (dst + i, _mm_add_ps (_mm_loadu_ps (dst + i), v));
+#endif
+	for ( ; i < count; i++)
+		dst[i] += value;
+}
+
+/*
+===============
+R_ParticleRamp -- color from the ramp table until the ramp runs out, then die next frame
+===============
+*/
+static void R_ParticleRamp (particlebucket_t *b, const int *ramp, float end)
+{
+	int		i;
+
+	for (i = 0; i < b->count; i++)
+	{
+		if (b->ramp[i] >= end)
+			b->die[i] = -1;
+		else
+			b->color[i] = ramp[(int)b->ramp[i]];
+	}
+}
+
+/*
+===============
+R_KillParticles -- returns how many died
+===============
+*/
+static int R_KillParticles (particlebucket_t *b, double time)
+{
+	int		i, j, last, killed;
+
+	for (i = 0, killed = 0; i < b->count; )
 	{
-		kill = active_particles;
-		if (kill && kill->die < cl.time)
+		if (b->die[i] >= time)
 		{
-			active_particles = kill->next;
-			kill->next = free_particles;
-			free_particles = kill;
+			i++;
 			continue;
 		}
-		break;
-	}
 
-	for (p=active_particles ; p ; p=p->next)
-	{
-		for ( ;; )
+		last = --b->count;
+		for (j = 0; j < 3; j++)
 		{
-			kill = p->next;
-			if (kill && kill->die < cl.time)
-			{
-				p->next = kill->next;
-				kill->next = free_particles;
-				free_particles = kill;
-				continue;
-			}
-			break;
+			b->org[j][i] = b->org[j][last];
+			b->vel[j][i] = b->vel[j][last];
 		}
+		b->color[i] = b->color[last];
+		b->ramp[i] = b->ramp[last];
+		b->die[i] = b->die[last];
+		killed++;
+	}
 
-		p->org[0] += p->vel[0]*frametime;
-		p->org[1] += p->vel[1]*frametime;
-		p->org[2] += p->vel[2]*frametime;
+	return killed;
+}
 
-		switch (p->type)
+/*
+===============
+R_RunParticleBuckets -- returns how many died
+===============
+*/
+static int R_RunParticleBuckets (particlebucket_t *buckets, double time, float frametime, float grav)
+{
+	particlebucket_t	*b;
+	int					i, type, killed;
+	float				time1, time2, time3, dvel;
+
+	time3 = frametime * 15;
+	time2 = frametime * 10;
+	time1 = frametime * 5;
+	dvel = 4*frametime;
+
+	for (type = 0, killed = 0; type < NUM_PARTICLE_TYPES; type++)
+	{
+		b = &buckets[type];
+
+		killed += R_KillParticles (b, time);
+		if (!b->count)
+			continue;
+
+		for (i = 0; i < 3; i++)
+			R_ParticleStreamMA (b->org[i], b->vel[i], frametime, b->count);
+
+		switch (type)
 		{
 		case pt_static:
 			break;
+
 		case pt_fire:
-			p->ramp += time1;
-			if (p->ramp >= 6)
-				p->die = -1;
-			else
-				p->color = ramp3[(int)p->ramp];
-			p->vel[2] += grav;
+			R_ParticleStreamAdd (b->ramp, time1, b->count);
+			R_ParticleRamp (b, ramp3, 6);
+			R_ParticleStreamAdd (b->vel[2], grav, b->count);
 			break;
 
 		case pt_explode:
-			p->ramp += time2;
-			if (p->ramp >=8)
-				p->die = -1;
-			else
-				p->color = ramp1[(int)p->ramp];
-			for (i=0 ; i<3 ; i++)
-				p->vel[i] += p->vel[i]*dvel;
-			p->vel[2] -= grav;
+			R_ParticleStreamAdd (b->ramp, time2, b->count);
+			R_ParticleRamp (b, ramp1, 8);
+			for (i = 0; i < 3; i++)
+				R_ParticleStreamMA (b->vel[i], b->vel[i], dvel, b->count);
+			R_ParticleStreamAdd (b->vel[2], -grav, b->count);
 			break;
 
 		case pt_explode2:
-			p->ramp += time3;
-			if (p->ramp >=8)
-				p->die = -1;
-			else
-				p->color = ramp2[(int)p->ramp];
-			for (i=0 ; i<3 ; i++)
-				p->vel[i] -= p->vel[i]*frametime;
-			p->vel[2] -= grav;
+			R_ParticleStreamAdd (b->ramp, time3, b->count);
+			R_ParticleRamp (b, ramp2, 8);
+			for (i = 0; i < 3; i++)
+				R_ParticleStreamMS (b->vel[i], b->vel[i], frametime, b->count);
+			R_ParticleStreamAdd (b->vel[2], -grav, b->count);
 			break;
 
 		case pt_blob:
-			for (i=0 ; i<3 ; i++)
-				p->vel[i] += p->vel[i]*dvel;
-			p->vel[2] -= grav;
+			for (i = 0; i < 3; i++)
+				R_ParticleStreamMA (b->vel[i], b->vel[i], dvel, b->count);
+			R_ParticleStreamAdd (b->vel[2], -grav, b->count);
 			break;
 
 		case pt_blob2:
-			for (i=0 ; i<2 ; i++)
-				p->vel[i] -= p->vel[i]*dvel;
-			p->vel[2] -= grav;
+			for (i = 0; i < 2; i++)
+				R_ParticleStreamMS (b->vel[i], b->vel[i], dvel, b->count);
+			R_ParticleStreamAdd (b->vel[2], -grav, b->count);
 			break;
 
 		case pt_grav:
 		case pt_slowgrav:
-			p->vel[2] -= grav;
+			R_ParticleStreamAdd (b->vel[2], -grav, b->count);
 			break;
 		}
 	}
+
+	return killed;
+}
+
+/*
+===============
+CL_RunParticles -- johnfitz -- all the particle behavior, separated from R_DrawParticles
+===============
+*/
+void CL_RunParticles (void)
+{
+	float				frametime, grav;
+	extern	cvar_t		sv_gravity;
+
+	frametime = cl.time - cl.oldtime;
+	grav = frametime * sv_gravity.value * 0.05;
+
+	if (r_gpuparticles)
+	{
+		// everything in the ring is dead, stop simulating and drawing it
+		if (num_gpu_particles && gpu_particle_die < cl.time)
+		{
+			gpu_particle_head = 0;
+			num_gpu_particles = 0;
+		}
+
+		gpu_particle_params[0] = cl.time;
+		gpu_particle_params[1] = frametime;
+		gpu_particle_params[2] = grav;
+		gpu_particle_simulate = true;
+		return;
+	}
+
+	R_FlushParticleSpawns ();
+
+	num_cpu_particles -= R_RunParticleBuckets (particle_buckets, cl.time, frametime, grav);
+}
+
+/*
+===============
+R_UpdateGPUParticles
+
+Runs the simulation step recorded by the last CL_RunParticles and copies this
+frame's spawns into the ring. Has to be called outside of a render pass
+===============
+*/
+void R_UpdateGPUParticles (void)
+{
+	int				i, first, count;
+	particle_t		*p;
+	gpuparticle_t	*gp;
+	VkMemoryBarrier	memory_barrier;
+	qboolean		updated = false;
+
+	if (!r_gpuparticles)
+		return;
+
+	memset(&memory_barrier, 0, sizeof(memory_barrier));
+	memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+
+	if (gpu_particle_simulate && num_gpu_particles > 0)
+	{
+		const uint32_t num_particles = num_gpu_particles;
+
+		// last frame's spawn copy and draw are done with the buffer
+		memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(vulkan_globals.command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memory_barrier, 0, NULL, 0, NULL);
+
+		vkCmdPushConstants(vulkan_globals.command_buffer, vulkan_globals.particle_simulate_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, 3 * sizeof(float), gpu_particle_params);
+		vkCmdPushConstants(vulkan_globals.command_buffer, vulkan_globals.particle_simulate_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 3 * sizeof(float), sizeof(uint32_t), &num_particles);
+		vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, vulkan_globals.particle_simulate_pipeline_layout, 0, 1, &gpu_particle_descriptor_set, 0, NULL);
+		vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, vulkan_globals.particle_simulate_pipeline);
+		vkCmdDispatch(vulkan_globals.command_buffer, (num_particles + 63) / 64, 1, 1);
+
+		updated = true;
+	}
+	gpu_particle_simulate = false;
+
+	if (num_particle_spawns > 0)
+	{
+		VkBuffer		spawn_buffer;
+		VkDeviceSize	spawn_buffer_offset;
+		VkBufferCopy	regions[2];
+		int				num_regions = 0;
+
+		if (!num_gpu_particles)
+			gpu_particle_die = 0.0f;
+
+		gp = (gpuparticle_t *) R_VertexAllocate(num_particle_spawns * sizeof(gpuparticle_t), &spawn_buffer, &spawn_buffer_offset);
+		for (i = 0, p = particle_spawns; i < num_particle_spawns; ++i, ++p, ++gp)
+		{
+			VectorCopy (p->org, gp->org);
+			gp->color = p->color;
+			VectorCopy (p->vel, gp->vel);
+			gp->ramp = p->ramp;
+			gp->die = p->die;
+			gp->type = p->type;
+			gpu_particle_die = q_max(gpu_particle_die, p->die);
+		}
+
+		// the ring wraps at most once because there are never more spawns than slots
+		for (first = 0; first < num_particle_spawns; first += count)
+		{
+			count = q_min(num_particle_spawns - first, r_numparticles - gpu_particle_head);
+			regions[num_regions].srcOffset = spawn_buffer_offset + first * sizeof(gpuparticle_t);
+			regions[num_regions].dstOffset = GPU_PARTICLE_PALETTE_SIZE + gpu_particle_head * sizeof(gpuparticle_t);
+			regions[num_regions].size = count * sizeof(gpuparticle_t);
+			num_regions++;
+
+			gpu_particle_head = (gpu_particle_head + count) % r_numparticles;
+			num_gpu_particles = q_min(num_gpu_particles + count, r_numparticles);
+		}
+
+		// the copy overwrites whatever the simulation or last frame's draw touched
+		memory_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		memory_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(vulkan_globals.command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &memory_barrier, 0, NULL, 0, NULL);
+
+		vkCmdCopyBuffer(vulkan_globals.command_buffer, spawn_buffer, gpu_particle_buffer, num_regions, regions);
+
+		num_particle_spawns = 0;
+		updated = true;
+	}
+
+	if (updated)
+	{
+		memory_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(vulkan_globals.command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, 0, 1, &memory_barrier, 0, NULL, 0, NULL);
+	}
+}
+
+/*
+===============
+R_DrawGPUParticles
+===============
+*/
+static void R_DrawGPUParticles (void)
+{
+	VkBuffer		uniform_buffer;
+	uint32_t		uniform_offset;
+	VkDescriptorSet	descriptor_sets[3];
+	float			*params;
+
+	if (!num_gpu_particles)
+		return;
+
+	// origin & texture scale, forward, up, right. vec4s to keep std140 simple
+	params = (float *) R_UniformAllocate(16 * sizeof(float), &uniform_buffer, &uniform_offset, &descriptor_sets[2]);
+	VectorCopy (r_origin, params);
+	params[3] = texturescalefactor;
+	VectorCopy (vpn, (params + 4));
+	params[7] = 0.0f;
+	VectorScale (vup, 1.5, (params + 8));
+	params[11] = 0.0f;
+	VectorScale (vright, 1.5, (params + 12));
+	params[15] = 0.0f;
+
+	descriptor_sets[0] = particletexture->descriptor_set;
+	descriptor_sets[1] = gpu_particle_descriptor_set;
+
+	vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.gpu_particle_pipeline);
+	vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.gpu_particle_pipeline_layout, 0, 3, descriptor_sets, 1, &uniform_offset);
+	R_BindLatch(vulkan_globals.gpu_particle_pipeline_layout, 3, false);
+	vkCmdDraw(vulkan_globals.command_buffer, 3, num_gpu_particles, 0, 0);
+
+	rs_particles += num_gpu_particles;
 }
 
 /*
@@ -824,16 +1279,25 @@ R_DrawParticles -- johnfitz -- moved all non-drawing code to CL_RunParticles
 */
 void R_DrawParticles (void)
 {
-	particle_t		*p;
-	float			scale;
-	vec3_t			up, right, p_up, p_right; //johnfitz -- p_ vectors
-	extern	cvar_t	r_particles; //johnfitz
+	particlebucket_t	*b;
+	int					i, type;
+	float				scale;
+	vec3_t				org, up, right, p_up, p_right; //johnfitz -- p_ vectors
+	extern	cvar_t		r_particles; //johnfitz
 
 	if (!r_particles.value)
 		return;
 
+	if (r_gpuparticles)
+	{
+		R_DrawGPUParticles ();
+		return;
+	}
+
+	R_FlushParticleSpawns ();
+
 	//ericw -- avoid empty glBegin(),glEnd() pair below; causes issues on AMD
-	if (!active_particles)
+	if (!num_cpu_particles)
 		return;
 
 	VectorScale (vup, 1.5, up);
@@ -841,71 +1305,58 @@ void R_DrawParticles (void)
 
 	vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.particle_pipeline);
 	vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.basic_pipeline_layout, 0, 1, &particletexture->descriptor_set, 0, NULL);
-
-	int num_triangles = 0;
-	for (p=active_particles ; p ; p=p->next)
-		num_triangles += 1;
+	R_BindLatch(vulkan_globals.basic_pipeline_layout, 1, false);
 
 	VkBuffer vertex_buffer;
 	VkDeviceSize vertex_buffer_offset;
-	basicvertex_t * vertices = (basicvertex_t*)R_VertexAllocate(num_triangles * 3 * sizeof(basicvertex_t), &vertex_buffer, &vertex_buffer_offset);	
-	
-	int current_vertex = 0;
-	for (p=active_particles ; p ; p=p->next)
+	basicvertex_t * vertices = (basicvertex_t*)R_VertexAllocate(num_cpu_particles * 3 * sizeof(basicvertex_t), &vertex_buffer, &vertex_buffer_offset);
+	basicvertex_t * v = vertices;
+
+	for (type = 0; type < NUM_PARTICLE_TYPES; type++)
 	{
-		// hack a scale up to keep particles from disapearing
-		scale = (p->org[0] - r_origin[0]) * vpn[0]
-				+ (p->org[1] - r_origin[1]) * vpn[1]
-				+ (p->org[2] - r_origin[2]) * vpn[2];
-		if (scale < 20)
-			scale = 1 + 0.08; //johnfitz -- added .08 to be consistent
-		else
-			scale = 1 + scale * 0.004;
-
-		scale *= texturescalefactor; //johnfitz -- compensate for apparent size of different particle textures
-
-		byte * c = (byte*)&d_8to24table[(int)p->color];
-
-		vertices[current_vertex].position[0] = p->org[0];
-		vertices[current_vertex].position[1] = p->org[1];
-		vertices[current_vertex].position[2] = p->org[2];
-		vertices[current_vertex].texcoord[0] = 0.0f;
-		vertices[current_vertex].texcoord[1] = 0.0f;
-		vertices[current_vertex].color[0] = c[0];
-		vertices[current_vertex].color[1] = c[1];
-		vertices[current_vertex].color[2] = c[2];
-		vertices[current_vertex].color[3] = 255;
-		current_vertex++;
-	
-		VectorMA (p->org, scale, up, p_up);
-		vertices[current_vertex].position[0] = p_up[0];
-		vertices[current_vertex].position[1] = p_up[1];
-		vertices[current_vertex].position[2] = p_up[2];
-		vertices[current_vertex].texcoord[0] = 1.0f;
-		vertices[current_vertex].texcoord[1] = 0.0f;
-		vertices[current_vertex].color[0] = c[0];
-		vertices[current_vertex].color[1] = c[1];
-		vertices[current_vertex].color[2] = c[2];
-		vertices[current_vertex].color[3] = 255;
-		current_vertex++;
-
-		VectorMA (p->org, scale, right, p_right);
-		vertices[current_vertex].position[0] = p_right[0];
-		vertices[current_vertex].position[1] = p_right[1];
-		vertices[current_vertex].position[2] = p_right[2];
-		vertices[current_vertex].texcoord[0] = 0.0f;
-		vertices[current_vertex].texcoord[1] = 1.0f;
-		vertices[current_vertex].color[0] = c[0];
-		vertices[current_vertex].color[1] = c[1];
-		vertices[current_vertex].color[2] = c[2];
-		vertices[current_vertex].color[3] = 255;
-		current_vertex++;
-
-		rs_particles++;
+		b = &particle_buckets[type];
+		for (i = 0; i < b->count; i++, v += 3)
+		{
+			org[0] = b->org[0][i];
+			org[1] = b->org[1][i];
+			org[2] = b->org[2][i];
+
+			// hack a scale up to keep particles from disapearing
+			scale = (org[0] - r_origin[0]) * vpn[0]
+					+ (org[1] - r_origin[1]) * vpn[1]
+					+ (org[2] - r_origin[2]) * vpn[2];
+			if (scale < 20)
+				scale = 1 + 0.08; //johnfitz -- added .08 to be consistent
+			else
+				scale = 1 + scale * 0.004;
+
+			scale *= texturescalefactor; //johnfitz -- compensate for apparent size of different particle textures
+
+			VectorMA (org, scale, up, p_up);
+			VectorMA (org, scale, right, p_right);
+
+			VectorCopy (org, v[0].position);
+			VectorCopy (p_up, v[1].position);
+			VectorCopy (p_right, v[2].position);
+			v[0].texcoord[0] = 0.0f;
+			v[0].texcoord[1] = 0.0f;
+			v[1].texcoord[0] = 1.0f;
+			v[1].texcoord[1] = 0.0f;
+			v[2].texcoord[0] = 0.0f;
+			v[2].texcoord[1] = 1.0f;
+
+			byte * c = (byte*)&d_8to24table[(int)b->color[i]];
+			memcpy (v[0].color, c, 3);
+			memcpy (v[1].color, c, 3);
+			memcpy (v[2].color, c, 3);
+			v[0].color[3] = v[1].color[3] = v[2].color[3] = 255;
+		}
 	}
 
+	rs_particles += num_cpu_particles;
+
 	vkCmdBindVertexBuffers(vulkan_globals.command_buffer, 0, 1, &vertex_buffer, &vertex_buffer_offset);
-	vkCmdDraw(vulkan_globals.command_buffer, num_triangles * 3, 1, 0, 0);
+	vkCmdDraw(vulkan_globals.command_buffer, num_cpu_particles * 3, 1, 0, 0);
 }
 
 /*
@@ -953,3 +1404,128 @@ void R_DrawParticles_ShowTris (void)
 	}*/
 }
 
+
+#ifdef PARTICLECHECK
+/*
+==============================================================================
+
+r_particlecheck hooks, the check itself is in r_partcheck.c
+
+==============================================================================
+*/
+
+static particlebucket_t	check_buckets[NUM_PARTICLE_TYPES];
+
+/*
+===============
+R_CheckRecordSpawns
+
+Runs one of the game's effects into dst instead of the spawn list, with
+cl.time set to when it happens
+===============
+*/
+int R_CheckRecordSpawns (particle_t *dst, int max, int effect, double time)
+{
+	particle_t	*saved_spawns = particle_spawns;
+	int			saved_num = num_particle_spawns;
+	int			saved_max = max_particle_spawns;
+	qboolean	saved_gpu = r_gpuparticles;
+	double		saved_time = cl.time;
+	vec3_t		org = {0, 0, 0};
+	vec3_t		dir = {0, 0, 1};
+	vec3_t		end = {256, 128, 64};
+	int			count, type;
+
+	// a plain spawn list, nothing is moved to the buckets when it fills up
+	particle_spawns = dst;
+	num_particle_spawns = 0;
+	max_particle_spawns = max;
+	r_gpuparticles = true;
+	cl.time = time;
+
+	switch (effect % 7)
+	{
+	case 0: R_ParticleExplosion (org); break;
+	case 1: R_BlobExplosion (org); break;
+	case 2: R_ParticleExplosion2 (org, 32, 16); break;
+	case 3: R_RunParticleEffect (org, dir, 73, 64); break;
+	case 4: R_LavaSplash (org); break;
+	case 5: R_TeleportSplash (org); break;
+	case 6:
+		for (type = 0; type < 7; type++)
+			R_RocketTrail (org, end, type);
+		break;
+	}
+	count = num_particle_spawns;
+
+	particle_spawns = saved_spawns;
+	num_particle_spawns = saved_num;
+	max_particle_spawns = saved_max;
+	r_gpuparticles = saved_gpu;
+	cl.time = saved_time;
+
+	return count;
+}
+
+/*
+===============
+R_CheckRunBuckets -- adds the spawns to buckets of its own and runs them, the live particles aren't touched
+===============
+*/
+void R_CheckRunBuckets (const particle_t *spawns, int count, double time, float frametime, float grav)
+{
+	R_AddParticlesToBuckets (check_buckets, spawns, count);
+	R_RunParticleBuckets (check_buckets, time, frametime, grav);
+}
+
+/*
+===============
+R_CheckGetBucket -- copies out the particles of one type, returns how many
+===============
+*/
+int R_CheckGetBucket (int type, particle_t *dst)
+{
+	particlebucket_t	*b = &check_buckets[type];
+	int					i, j;
+
+	for (i = 0; i < b->count; i++)
+	{
+		for (j = 0; j < 3; j++)
+		{
+			dst[i].org[j] = b->org[j][i];
+			dst[i].vel[j] = b->vel[j][i];
+		}
+		dst[i].color = b->color[i];
+		dst[i].ramp = b->ramp[i];
+		dst[i].die = b->die[i];
+		dst[i].type = (ptype_t) type;
+	}
+
+	return b->count;
+}
+
+/*
+===============
+R_CheckFreeBuckets
+===============
+*/
+void R_CheckFreeBuckets (void)
+{
+	particlebucket_t	*b;
+	int					type, j;
+
+	for (type = 0; type < NUM_PARTICLE_TYPES; type++)
+	{
+		b = &check_buckets[type];
+		for (j = 0; j < 3; j++)
+		{
+			free (b->org[j]);
+			free (b->vel[j]);
+		}
+		free (b->color);
+		free (b->ramp);
+		free (b->die);
+	}
+	memset (check_buckets, 0, sizeof(check_buckets));
+}
+#endif	/* PARTICLECHECK */
@@ -0,0 +1,291 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+Copyright (C) 2010-2014 QuakeSpasm developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// r_partcheck.c -- the CPU particle update against the linked list update it
+// replaced.  Only built with "make PARTICLECHECK=1"
+
+#include "quakedef.h"
+
+#define NUM_PARTICLE_TYPES		(pt_blob2 + 1)
+#define CHECK_SPAWN_INTERVAL	16		// frames between recorded effects
+#define CHECK_MAX_SPAWNS		2048	// per effect, more than any of them makes
+
+extern int	ramp1[8];
+extern int	ramp2[8];
+extern int	ramp3[8];
+
+typedef struct refparticle_s
+{
+	particle_t				p;
+	struct refparticle_s	*next;
+} refparticle_t;
+
+/*
+===============
+R_RunParticleListReference
+
+The linked list CL_RunParticles, as it was before the buckets
+===============
+*/
+static void R_RunParticleListReference (refparticle_t **active_particles, refparticle_t **free_particles, double time, float frametime, float grav)
+{
+	refparticle_t	*p, *kill;
+	int				i;
+	float			time1, time2, time3, dvel;
+
+	time3 = frametime * 15;
+	time2 = frametime * 10;
+	time1 = frametime * 5;
+	dvel = 4*frametime;
+
+	for ( ;; )
+	{
+		kill = *active_particles;
+		if (kill && kill->p.die < time)
+		{
+			*active_particles = kill->next;
+			kill->next = *free_particles;
+			*free_particles = kill;
+			continue;
+		}
+		break;
+	}
+
+	for (p=*active_particles ; p ; p=p->next)
+	{
+		for ( ;; )
+		{
+			kill = p->next;
+			if (kill && kill->p.die < time)
+			{
+				p->next = kill->next;
+				kill->next = *free_particles;
+				*free_particles = kill;
+				continue;
+			}
+			break;
+		}
+
+		p->p.org[0] += p->p.vel[0]*frametime;
+		p->p.org[1] += p->p.vel[1]*frametime;
+		p->p.org[2] += p->p.vel[2]*frametime;
+
+		switch (p->p.type)
+		{
+		case pt_static:
+			break;
+		case pt_fire:
+			p->p.ramp += time1;
+			if (p->p.ramp >= 6)
+				p->p.die = -1;
+			else
+				p->p.color = ramp3[(int)p->p.ramp];
+			p->p.vel[2] += grav;
+			break;
+
+		case pt_explode:
+			p->p.ramp += time2;
+			if (p->p.ramp >=8)
+				p->p.die = -1;
+			else
+				p->p.color = ramp1[(int)p->p.ramp];
+			for (i=0 ; i<3 ; i++)
+				p->p.vel[i] += p->p.vel[i]*dvel;
+			p->p.vel[2] -= grav;
+			break;
+
+		case pt_explode2:
+			p->p.ramp += time3;
+			if (p->p.ramp >=8)
+				p->p.die = -1;
+			else
+				p->p.color = ramp2[(int)p->p.ramp];
+			for (i=0 ; i<3 ; i++)
+				p->p.vel[i] -= p->p.vel[i]*frametime;
+			p->p.vel[2] -= grav;
+			break;
+
+		case pt_blob:
+			for (i=0 ; i<3 ; i++)
+				p->p.vel[i] += p->p.vel[i]*dvel;
+			p->p.vel[2] -= grav;
+			break;
+
+		case pt_blob2:
+			for (i=0 ; i<2 ; i++)
+				p->p.vel[i] -= p->p.vel[i]*dvel;
+			p->p.vel[2] -= grav;
+			break;
+
+		case pt_grav:
+		case pt_slowgrav:
+			p->p.vel[2] -= grav;
+			break;
+		}
+	}
+}
+
+/*
+===============
+R_CompareCheckParticles -- memcmp order, a bucket is in no particular order
+===============
+*/
+static int R_CompareCheckParticles (const void *a, const void *b)
+{
+	return memcmp (a, b, 9 * sizeof(float));
+}
+
+/*
+===============
+R_CheckParticleRecord -- the state both updates write, as 9 floats
+===============
+*/
+static void R_CheckParticleRecord (float *dst, const particle_t *p)
+{
+	int		j;
+
+	for (j = 0; j < 3; j++)
+	{
+		dst[j] = p->org[j];
+		dst[3 + j] = p->vel[j];
+	}
+	dst[6] = p->color;
+	dst[7] = p->ramp;
+	dst[8] = p->die;
+}
+
+/*
+===============
+R_ParticleCheck_f -- "r_particlecheck [frames] [seed]"
+
+Spawns the game's effects every few frames from a fixed random seed and runs
+them through both the buckets and the linked list update at 72 fps.  After
+every frame each type has to hold the same particles, bit for bit
+===============
+*/
+void R_ParticleCheck_f (void)
+{
+	refparticle_t		*pool, *active_particles, *free_particles, *p;
+	particle_t			*spawns, *bucket;
+	float				*ref, *soa, frametime, grav;
+	double				time;
+	int					frames, seed, reseed, frame, capacity, num_spawns, total, type, count, i, n;
+	extern	cvar_t		sv_gravity;
+
+	frames = (Cmd_Argc () > 1) ? atoi (Cmd_Argv (1)) : 360;
+	frames = CLAMP (1, frames, 3600);
+	seed = (Cmd_Argc () > 2) ? atoi (Cmd_Argv (2)) : 1;
+
+	capacity = (frames / CHECK_SPAWN_INTERVAL + 1) * CHECK_MAX_SPAWNS;
+	pool = (refparticle_t *) malloc (capacity * sizeof(refparticle_t));
+	spawns = (particle_t *) malloc (CHECK_MAX_SPAWNS * sizeof(particle_t));
+	bucket = (particle_t *) malloc (capacity * sizeof(particle_t));
+	ref = (float *) malloc (capacity * 9 * sizeof(float));
+	soa = (float *) malloc (capacity * 9 * sizeof(float));
+	if (!pool || !spawns || !bucket || !ref || !soa)
+	{
+		Con_Printf ("r_particlecheck: out of memory\n");
+		free (pool);
+		free (spawns);
+		free (bucket);
+		free (ref);
+		free (soa);
+		return;
+	}
+
+	active_particles = NULL;
+	free_particles = pool;
+	for (i = 0; i < capacity - 1; i++)
+		pool[i].next = &pool[i + 1];
+	pool[capacity - 1].next = NULL;
+
+	// rand () state can't be saved, carry on from a seed drawn before the check
+	reseed = rand ();
+	srand (seed);
+
+	frametime = 1.0f / 72.0f;
+	grav = frametime * sv_gravity.value * 0.05;
+	time = cl.time;
+	total = 0;
+
+	for (frame = 0; frame < frames; frame++)
+	{
+		time += frametime;
+
+		num_spawns = 0;
+		if (frame % CHECK_SPAWN_INTERVAL == 0)
+		{
+			num_spawns = R_CheckRecordSpawns (spawns, CHECK_MAX_SPAWNS, frame / CHECK_SPAWN_INTERVAL, time);
+			for (i = 0; i < num_spawns; i++)
+			{
+				p = free_particles;
+				free_particles = p->next;
+				p->next = active_particles;
+				active_particles = p;
+				p->p = spawns[i];
+			}
+			total += num_spawns;
+		}
+
+		R_RunParticleListReference (&active_particles, &free_particles, time, frametime, grav);
+		R_CheckRunBuckets (spawns, num_spawns, time, frametime, grav);
+
+		for (type = 0; type < NUM_PARTICLE_TYPES; type++)
+		{
+			for (p = active_particles, n = 0; p; p = p->next)
+			{
+				if (p->p.type == type)
+					R_CheckParticleRecord (&ref[9 * n++], &p->p);
+			}
+
+			count = R_CheckGetBucket (type, bucket);
+			if (n != count)
+			{
+				Con_Printf ("r_particlecheck: frame %i type %i: %i particles, the linked list has %i\n", frame, type, count, n);
+				goto done;
+			}
+			for (i = 0; i < n; i++)
+				R_CheckParticleRecord (&soa[9 * i], &bucket[i]);
+
+			qsort (ref, n, 9 * sizeof(float), R_CompareCheckParticles);
+			qsort (soa, n, 9 * sizeof(float), R_CompareCheckParticles);
+			for (i = 0; i < n; i++)
+			{
+				if (memcmp (&ref[i * 9], &soa[i * 9], 9 * sizeof(float)))
+				{
+					Con_Printf ("r_particlecheck: frame %i type %i: particle %i of %i differs from the linked list\n", frame, type, i, n);
+					goto done;
+				}
+			}
+		}
+	}
+
+	Con_Printf ("r_particlecheck: %i particles over %i frames, bit for bit the same as the linked list\n", total, frames);
+
+done:
+	srand (reseed);
+	R_CheckFreeBuckets ();
+	free (pool);
+	free (spawns);
+	free (bucket);
+	free (ref);
+	free (soa);
+}
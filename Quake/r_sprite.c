@@ -188,5 +188,6 @@ void R_DrawSpriteModel (entity_t *e)
 		vkCmdSetDepthBias(vulkan_globals.command_buffer, OFFSET_NONE, 0.0f, 0.0f);
 
 	vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.basic_pipeline_layout, 0, 1, &frame->gltexture->descriptor_set, 0, NULL);
+	R_BindLatch(vulkan_globals.basic_pipeline_layout, 1, false);
 	vkCmdDraw(vulkan_globals.command_buffer, 4, 1, 0, 0);
 }
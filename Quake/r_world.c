@@ -229,8 +229,6 @@ void R_CullSurfaces (void)
 			{
 				s->culled = false;
 				rs_brushpolys++; //count wpolys here
-				if (s->texinfo->texture->warpimage)
-					s->texinfo->texture->update_warp = true;
 			}
 		}
 	}
@@ -340,6 +338,29 @@ static void R_ClearBatch ()
 	num_vbo_indices = 0;
 }
 
+/*
+================
+R_DrawBatch
+
+Draws the current batch with whatever pipeline is bound and clears it.
+================
+*/
+static void R_DrawBatch (void)
+{
+	if (num_vbo_indices > 0)
+	{
+		VkBuffer buffer;
+		VkDeviceSize buffer_offset;
+		byte * indices = R_IndexAllocate(num_vbo_indices * sizeof(uint32_t), &buffer, &buffer_offset);
+		memcpy(indices, vbo_indices, num_vbo_indices * sizeof(uint32_t));
+
+		vkCmdBindIndexBuffer(vulkan_globals.command_buffer, buffer, buffer_offset, VK_INDEX_TYPE_UINT32);
+		vkCmdDrawIndexed(vulkan_globals.command_buffer, num_vbo_indices, 1, 0, 0, 0);
+
+		num_vbo_indices = 0;
+	}
+}
+
 /*
 ================
 R_FlushBatch
@@ -352,22 +373,14 @@ static void R_FlushBatch (VkPipeline * current_pipeline, qboolean fullbright_ena
 	if (num_vbo_indices > 0)
 	{
 		int pipeline_index = (fullbright_enabled ? 1 : 0) + (alpha_test ? 2 : 0) + (alpha_blend ? 4 : 0);
-		VkPipeline new_pipeline = vulkan_globals.world_pipelines[pipeline_index];
+		VkPipeline new_pipeline = vulkan_globals.bindless ? vulkan_globals.world_bindless_pipelines[pipeline_index] : vulkan_globals.world_pipelines[pipeline_index];
 		if (new_pipeline != *current_pipeline)
 		{
 			vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, new_pipeline);
 			*current_pipeline = new_pipeline;
 		}
 
-		VkBuffer buffer;
-		VkDeviceSize buffer_offset;
-		byte * indices = R_IndexAllocate(num_vbo_indices * sizeof(uint32_t), &buffer, &buffer_offset);
-		memcpy(indices, vbo_indices, num_vbo_indices * sizeof(uint32_t));
-
-		vkCmdBindIndexBuffer(vulkan_globals.command_buffer, buffer, buffer_offset, VK_INDEX_TYPE_UINT32);
-		vkCmdDrawIndexed(vulkan_globals.command_buffer, num_vbo_indices, 1, 0, 0, 0);
-
-		num_vbo_indices = 0;
+		R_DrawBatch ();
 	}
 }
 
@@ -420,14 +433,26 @@ void R_DrawTextureChains_Water (qmodel_t *model, entity_t *ent, texchain_t chain
 	msurface_t	*s;
 	texture_t	*t;
 	qboolean	bound;
-	float entalpha;
+	float		entalpha;
+	float		time;
+	VkPipeline	current_pipeline = VK_NULL_HANDLE;
+	VkPipeline	new_pipeline;
 
 	if (r_drawflat_cheatsafe || r_lightmap_cheatsafe) // ericw -- !r_drawworld_cheatsafe check moved to R_DrawWorld_Water ()
 		return;
 
-	float color[3] = { 1.0f, 1.0f, 1.0f };
+	VkDeviceSize offset = 0;
+	vkCmdBindVertexBuffers(vulkan_globals.command_buffer, 0, 1, &bmodel_vertex_buffer, &offset);
+
+	// the water variant of world.frag never samples the lightmap or fullbright sets, but they need to be bound
+	VkDescriptorSet descriptor_sets[2] = { nulltexture->descriptor_set, nulltexture->descriptor_set };
+	vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout, 1, 2, descriptor_sets, 0, NULL);
+	R_BindLatch(vulkan_globals.world_pipeline_layout, 3, false);
 
-	vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.water_pipeline);
+	time = cl.time;
+	vkCmdPushConstants(vulkan_globals.command_buffer, vulkan_globals.basic_pipeline_layout, VK_SHADER_STAGE_ALL_GRAPHICS, 21 * sizeof(float), 1 * sizeof(float), &time);
+
+	R_ClearBatch ();
 
 	for (i=0 ; i<model->numtextures ; i++)
 	{
@@ -435,33 +460,34 @@ void R_DrawTextureChains_Water (qmodel_t *model, entity_t *ent, texchain_t chain
 		if (!t || !t->texturechains[chain] || !(t->texturechains[chain]->flags & SURF_DRAWTURB))
 			continue;
 		bound = false;
-		entalpha = 1.0f;
 		for (s = t->texturechains[chain]; s; s = s->texturechain)
 			if (!s->culled)
 			{
 				if (!bound) //only bind once we are sure we need this texture
 				{
 					entalpha = GL_WaterAlphaForEntitySurface (ent, s);
-					if (entalpha < 1.0f)
-						vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.water_blend_pipeline);
-					else
-						vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.water_pipeline);
-
-					vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.basic_pipeline_layout, 0, 1, &t->warpimage->descriptor_set, 0, NULL);
-
-					if (model != cl.worldmodel)
+					new_pipeline = (entalpha < 1.0f) ? vulkan_globals.water_blend_pipeline : vulkan_globals.water_pipeline;
+					if (new_pipeline != current_pipeline)
 					{
-						// ericw -- this is copied from R_DrawSequentialPoly.
-						// If the poly is not part of the world we have to
-						// set this flag
-						t->update_warp = true; // FIXME: one frame too late!
+						vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, new_pipeline);
+						current_pipeline = new_pipeline;
 					}
+					if (entalpha < 1.0f)
+						vkCmdPushConstants(vulkan_globals.command_buffer, vulkan_globals.basic_pipeline_layout, VK_SHADER_STAGE_ALL_GRAPHICS, 20 * sizeof(float), 1 * sizeof(float), &entalpha);
 
+					vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout, 0, 1, &t->gltexture->descriptor_set, 0, NULL);
 					bound = true;
 				}
-				DrawGLPoly (s->polys, color, entalpha);
+
+				if (num_vbo_indices + R_NumTriangleIndicesForSurf (s) > MAX_BATCH_SIZE)
+					R_DrawBatch ();
+				R_TriangleIndicesForSurf (s, &vbo_indices[num_vbo_indices]);
+				num_vbo_indices += R_NumTriangleIndicesForSurf (s);
 				rs_brushpasses++;
 			}
+
+		// the next texture binds a different set 0
+		R_DrawBatch ();
 	}
 }
 
@@ -482,11 +508,22 @@ void R_DrawTextureChains_Multitexture (qmodel_t *model, entity_t *ent, texchain_
 	int		lastlightmap;
 	gltexture_t	*fullbright = NULL;
 	VkPipeline current_pipeline = VK_NULL_HANDLE;
+	uint32_t	texture_indices[3]; // diffuse, lightmap, fullbright slots in the bindless set
 
 	VkDeviceSize offset = 0;
 	vkCmdBindVertexBuffers(vulkan_globals.command_buffer, 0, 1, &bmodel_vertex_buffer, &offset);
 
-	vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout, 2, 1, &nulltexture->descriptor_set, 0, NULL);
+	// bindless: every texture is reachable from this one set, only the indices get pushed per texture and lightmap
+	if (vulkan_globals.bindless)
+	{
+		vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_bindless_pipeline_layout, 0, 1, &vulkan_globals.bindless_descriptor_set, 0, NULL);
+		R_BindLatch(vulkan_globals.world_bindless_pipeline_layout, 3, false);
+	}
+	else
+	{
+		vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout, 2, 1, &nulltexture->descriptor_set, 0, NULL);
+		R_BindLatch(vulkan_globals.world_pipeline_layout, 3, false);
+	}
 
 	if (alpha_blend)
 		vkCmdPushConstants(vulkan_globals.command_buffer, vulkan_globals.basic_pipeline_layout, VK_SHADER_STAGE_ALL_GRAPHICS, 20 * sizeof(float), 1 * sizeof(float), &alpha);
@@ -502,11 +539,13 @@ void R_DrawTextureChains_Multitexture (qmodel_t *model, entity_t *ent, texchain_
 		if (gl_fullbrights.value && (fullbright = R_TextureAnimation(t, ent != NULL ? ent->frame : 0)->fullbright))
 		{
 			fullbright_enabled = true;
-			vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout, 2, 1, &fullbright->descriptor_set, 0, NULL);
+			if (!vulkan_globals.bindless)
+				vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout, 2, 1, &fullbright->descriptor_set, 0, NULL);
 		}
 		else
 		{
 			fullbright_enabled = false;
+			fullbright = nulltexture;
 		}
 
 		R_ClearBatch ();
@@ -521,7 +560,20 @@ void R_DrawTextureChains_Multitexture (qmodel_t *model, entity_t *ent, texchain_
 				{
 					texture_t * texture = R_TextureAnimation(t, ent != NULL ? ent->frame : 0);
 					gltexture_t * gl_texture = texture->gltexture;
-					vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout, 0, 1, &gl_texture->descriptor_set, 0, NULL);
+					gltexture_t * lightmap_texture = lightmap_textures[s->lightmaptexturenum];
+
+					if (vulkan_globals.bindless)
+					{
+						texture_indices[0] = gl_texture->bindless_index;
+						texture_indices[1] = lightmap_texture->bindless_index;
+						texture_indices[2] = fullbright->bindless_index;
+						vkCmdPushConstants(vulkan_globals.command_buffer, vulkan_globals.basic_pipeline_layout, VK_SHADER_STAGE_ALL_GRAPHICS, 21 * sizeof(float), 3 * sizeof(uint32_t), texture_indices);
+					}
+					else
+					{
+						vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout, 0, 1, &gl_texture->descriptor_set, 0, NULL);
+						vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout, 1, 1, &lightmap_texture->descriptor_set, 0, NULL);
+					}
 
 					alpha_test = (t->texturechains[chain]->flags & SURF_DRAWFENCE) != 0;
 					bound = true;
@@ -531,10 +583,17 @@ void R_DrawTextureChains_Multitexture (qmodel_t *model, entity_t *ent, texchain_
 				if (s->lightmaptexturenum != lastlightmap)
 				{	
 					R_FlushBatch (&current_pipeline, fullbright_enabled, alpha_test, alpha_blend);
-				}
 
-				gltexture_t * lightmap_texture = lightmap_textures[s->lightmaptexturenum];
-				vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout, 1, 1, &lightmap_texture->descriptor_set, 0, NULL);
+					// only switch lightmaps between batches, surfaces are chained by lightmap
+					gltexture_t * lightmap_texture = lightmap_textures[s->lightmaptexturenum];
+					if (vulkan_globals.bindless)
+					{
+						texture_indices[1] = lightmap_texture->bindless_index;
+						vkCmdPushConstants(vulkan_globals.command_buffer, vulkan_globals.basic_pipeline_layout, VK_SHADER_STAGE_ALL_GRAPHICS, 22 * sizeof(float), 1 * sizeof(uint32_t), &texture_indices[1]);
+					}
+					else
+						vkCmdBindDescriptorSets(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.world_pipeline_layout, 1, 1, &lightmap_texture->descriptor_set, 0, NULL);
+				}
 
 				lastlightmap = s->lightmaptexturenum;
 				R_BatchSurface (s, &current_pipeline, fullbright_enabled, alpha_test, alpha_blend);
@@ -54,6 +54,7 @@ extern	cvar_t		scr_viewsize;
 extern	cvar_t		scr_sbaralpha; //johnfitz
 
 void SCR_UpdateWholeScreen (void);
+qboolean SCR_PacedByVR (void);
 
 //johnfitz -- stuff for 2d drawing control
 typedef enum {
@@ -62,7 +63,6 @@ typedef enum {
 	CANVAS_CONSOLE,
 	CANVAS_MENU,
 	CANVAS_SBAR,
-	CANVAS_WARPIMAGE,
 	CANVAS_CROSSHAIR,
 	CANVAS_BOTTOMLEFT,
 	CANVAS_BOTTOMRIGHT,
@@ -111,6 +111,11 @@ typedef struct client_s
 
 // client known data for deltas
 	int				old_frags;
+
+// PROTOCOL_DELTA entity snapshots
+	snapshot_t		*snapshots;			// [UPDATE_BACKUP], on the hunk for the current level
+	int				snapshot_sequence;	// last snapshot sent
+	int				snapshot_ack;		// last snapshot the client received intact
 } client_t;
 
 
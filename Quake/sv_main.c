@@ -50,8 +50,8 @@ void SV_Protocol_f (void)
 		break;
 	case 2:
 		i = atoi(Cmd_Argv(1));
-		if (i != PROTOCOL_NETQUAKE && i != PROTOCOL_FITZQUAKE && i != PROTOCOL_RMQ)
-			Con_Printf ("sv_protocol must be %i or %i or %i\n", PROTOCOL_NETQUAKE, PROTOCOL_FITZQUAKE, PROTOCOL_RMQ);
+		if (i != PROTOCOL_NETQUAKE && i != PROTOCOL_FITZQUAKE && i != PROTOCOL_RMQ && i != PROTOCOL_DELTA)
+			Con_Printf ("sv_protocol must be %i or %i or %i or %i\n", PROTOCOL_NETQUAKE, PROTOCOL_FITZQUAKE, PROTOCOL_RMQ, PROTOCOL_DELTA);
 		else
 		{
 			sv_protocol = i;
@@ -124,9 +124,12 @@ void SV_Init (void)
 	case PROTOCOL_RMQ:
 		p = "RMQ";
 		break;
+	case PROTOCOL_DELTA:
+		p = "Delta";
+		break;
 	default:
-		Sys_Error ("Bad protocol version request %i. Accepted values: %i, %i, %i.",
-				sv_protocol, PROTOCOL_NETQUAKE, PROTOCOL_FITZQUAKE, PROTOCOL_RMQ);
+		Sys_Error ("Bad protocol version request %i. Accepted values: %i, %i, %i, %i.",
+				sv_protocol, PROTOCOL_NETQUAKE, PROTOCOL_FITZQUAKE, PROTOCOL_RMQ, PROTOCOL_DELTA);
 		p = "Unknown";
 	}
 	Sys_Printf ("Server using protocol %i (%s)\n", sv_protocol, p);
@@ -295,7 +298,7 @@ void SV_SendServerinfo (client_t *client)
 	MSG_WriteByte (&client->message, svc_serverinfo);
 	MSG_WriteLong (&client->message, sv.protocol); //johnfitz -- sv.protocol instead of PROTOCOL_VERSION
 	
-	if (sv.protocol == PROTOCOL_RMQ)
+	if (sv.protocol == PROTOCOL_RMQ || sv.protocol == PROTOCOL_DELTA)
 	{
 		// mh - now send protocol flags so that the client knows the protocol features to expect
 		MSG_WriteLong (&client->message, sv.protocolflags);
@@ -334,6 +337,18 @@ void SV_SendServerinfo (client_t *client)
 	MSG_WriteByte (&client->message, svc_signonnum);
 	MSG_WriteByte (&client->message, 1);
 
+// snapshots from a previous level can't be delta references anymore.  They
+// are on the hunk until the level ends, the next client in this slot reuses them
+	if (sv.protocol == PROTOCOL_DELTA && !client->snapshots)
+		client->snapshots = (snapshot_t *) Hunk_AllocName (UPDATE_BACKUP*sizeof(snapshot_t), "snapshots");
+	if (client->snapshots)
+	{
+		for (i=0 ; i<UPDATE_BACKUP ; i++)
+			client->snapshots[i].sequence = 0;
+	}
+	client->snapshot_sequence = 0;
+	client->snapshot_ack = 0;
+
 	client->sendsignon = true;
 	client->spawned = false;		// need prespawn, spawn, etc
 }
@@ -352,6 +367,7 @@ void SV_ConnectClient (int clientnum)
 	client_t		*client;
 	int				edictnum;
 	struct qsocket_s *netconnection;
+	snapshot_t		*snapshots;
 	int				i;
 	float			spawn_parms[NUM_SPAWN_PARMS];
 
@@ -365,11 +381,13 @@ void SV_ConnectClient (int clientnum)
 
 // set up the client_t
 	netconnection = client->netconnection;
+	snapshots = client->snapshots;
 
 	if (sv.loadgame)
 		memcpy (spawn_parms, client->spawn_parms, sizeof(spawn_parms));
 	memset (client, 0, sizeof(*client));
 	client->netconnection = netconnection;
+	client->snapshots = snapshots;
 
 	strcpy (client->name, "unconnected");
 	client->active = true;
@@ -537,47 +555,228 @@ qboolean SV_VisibleToClient (edict_t *client, edict_t *test, qmodel_t *worldmode
 	return false;
 }
 
-//=============================================================================
+/*
+=============================================================================
+
+FAT PVS CACHE
+
+Decompressing and merging the leaf PVS rows is the expensive part of
+SV_FatPVS, and clients standing in the same spot of the map end up with
+identical results.  The fat PVS is therefore cached, keyed by the set of
+leafs within 8 units of the view origin (the traversal visits them in a
+fixed order, so equal sets give equal keys).  Each cache entry also keeps
+a bitset of the edicts that touch its PVS, built at most once per server
+frame and shared by every client that maps to the entry.
+
+=============================================================================
+*/
+
+#define	FATPVS_CACHE_SIZE	32		// must be >= MAX_SCOREBOARD, see SV_BuildClientDatagrams
+#define	FATPVS_MAX_LEAFS	8		// more leafs than this and the result is not cached
+#define	EDICT_BITS_WORDS	((MAX_EDICTS+31)>>5)
+
+typedef struct
+{
+	qmodel_t	*worldmodel;		// NULL = free slot
+	int			numleafs;
+	mleaf_t		*leafs[FATPVS_MAX_LEAFS];
+	int			lastused;
+	int			visframe;			// sv_fatpvs_frame when visedicts was built
+	byte		pvs[MAX_MAP_LEAFS/8];
+	unsigned int	visedicts[EDICT_BITS_WORDS];
+} fatpvs_cache_t;
+
+static fatpvs_cache_t	fatpvs_cache[FATPVS_CACHE_SIZE];
+static int				fatpvs_cache_time;
+
+static int				sv_fatpvs_frame;	// bumped once per SV_SendClientMessages
+static unsigned int		sv_sendable[EDICT_BITS_WORDS];	// edicts with a model the protocol can send
+static int				sv_sendable_frame;
 
 /*
 =============
-SV_WriteEntitiesToClient
+SV_ClearFatPVSCache
 
+Must be called whenever the world model changes
 =============
 */
-void SV_WriteEntitiesToClient (edict_t	*clent, sizebuf_t *msg)
+static void SV_ClearFatPVSCache (void)
 {
-	int		e, i;
-	int		bits;
-	byte	*pvs;
-	vec3_t	org;
-	float	miss;
+	int		i;
+
+	for (i=0 ; i<FATPVS_CACHE_SIZE ; i++)
+		fatpvs_cache[i].worldmodel = NULL;
+	fatpvs_cache_time = 0;
+	sv_sendable_frame = sv_fatpvs_frame - 1;
+}
+
+/*
+=============
+SV_FindFatPVSLeafs
+
+Collects the non-solid leafs within 8 units of org, in traversal order.
+Returns false if there are more than FATPVS_MAX_LEAFS of them.
+=============
+*/
+static qboolean SV_FindFatPVSLeafs (vec3_t org, mnode_t *node, mleaf_t **leafs, int *numleafs)
+{
+	mplane_t	*plane;
+	float		d;
+
+	while (1)
+	{
+		if (node->contents < 0)
+		{
+			if (node->contents != CONTENTS_SOLID)
+			{
+				if (*numleafs == FATPVS_MAX_LEAFS)
+					return false;
+				leafs[(*numleafs)++] = (mleaf_t *)node;
+			}
+			return true;
+		}
+
+		plane = node->plane;
+		d = DotProduct (org, plane->normal) - plane->dist;
+		if (d > 8)
+			node = node->children[0];
+		else if (d < -8)
+			node = node->children[1];
+		else
+		{	// go down both
+			if (!SV_FindFatPVSLeafs (org, node->children[0], leafs, numleafs))
+				return false;
+			node = node->children[1];
+		}
+	}
+}
+
+/*
+=============
+SV_CachedFatPVS
+
+Same result as SV_FatPVS, but looked up in (or added to) the fat PVS cache.
+Returns NULL if the view origin touches too many leafs to be cached.
+=============
+*/
+static fatpvs_cache_t *SV_CachedFatPVS (vec3_t org, qmodel_t *worldmodel)
+{
+	mleaf_t		*leafs[FATPVS_MAX_LEAFS];
+	int			numleafs, i, j, bytes;
+	byte		*pvs;
+	fatpvs_cache_t	*entry, *oldest;
+
+	numleafs = 0;
+	if (!SV_FindFatPVSLeafs (org, worldmodel->nodes, leafs, &numleafs))
+		return NULL;
+
+	fatpvs_cache_time++;
+
+	oldest = fatpvs_cache;
+	for (i=0, entry=fatpvs_cache ; i<FATPVS_CACHE_SIZE ; i++, entry++)
+	{
+		if (entry->worldmodel == worldmodel && entry->numleafs == numleafs &&
+			!memcmp (entry->leafs, leafs, numleafs * sizeof(leafs[0])))
+		{
+			entry->lastused = fatpvs_cache_time;
+			return entry;
+		}
+		if (!entry->worldmodel)
+			oldest = entry;
+		else if (oldest->worldmodel && entry->lastused < oldest->lastused)
+			oldest = entry;
+	}
+
+// not found, replace the least recently used entry
+	entry = oldest;
+	entry->worldmodel = worldmodel;
+	entry->numleafs = numleafs;
+	memcpy (entry->leafs, leafs, numleafs * sizeof(leafs[0]));
+	entry->lastused = fatpvs_cache_time;
+	entry->visframe = sv_fatpvs_frame - 1;
+
+	bytes = (worldmodel->numleafs+31)>>3;
+	Q_memset (entry->pvs, 0, bytes);
+	for (i=0 ; i<numleafs ; i++)
+	{
+		pvs = Mod_LeafPVS (leafs[i], worldmodel);
+		for (j=0 ; j<bytes ; j++)
+			entry->pvs[j] |= pvs[j];
+	}
+
+	return entry;
+}
+
+/*
+=============
+SV_UpdateSendableEdicts
+
+Builds the bitset of edicts that have something to send this frame,
+independent of which client is looking.  Also updates the entity alphas.
+=============
+*/
+static void SV_UpdateSendableEdicts (void)
+{
+	int		e;
 	edict_t	*ent;
 
-// find the client's PVS
-	VectorAdd (clent->v.origin, clent->v.view_ofs, org);
-	pvs = SV_FatPVS (org, sv.worldmodel);
-	
-// send over all entities (excpet the client) that touch the pvs
+	if (sv_sendable_frame == sv_fatpvs_frame)
+		return;
+	sv_sendable_frame = sv_fatpvs_frame;
+
+	memset (sv_sendable, 0, ((sv.num_edicts+31)>>5) * sizeof(sv_sendable[0]));
 	ent = NEXT_EDICT(sv.edicts);
 	for (e=1 ; e<sv.num_edicts ; e++, ent = NEXT_EDICT(ent))
 	{
-
-		if (ent != clent)	// clent is ALLWAYS sent
+		//johnfitz -- alpha
+		if (pr_alpha_supported)
 		{
-			// ignore ents without visible models
-			if (!ent->v.modelindex || !PR_GetString(ent->v.model)[0])
-				continue;
+			eval_t	*val;
+			val = GetEdictFieldValue(ent, "alpha");
+			if (val)
+				ent->alpha = ENTALPHA_ENCODE(val->_float);
+		}
+
+		// ignore ents without visible models
+		if (!ent->v.modelindex || !PR_GetString(ent->v.model)[0])
+			continue;
+
+		//johnfitz -- don't send model>255 entities if protocol is 15
+		if (sv.protocol == PROTOCOL_NETQUAKE && (int)ent->v.modelindex & 0xFF00)
+			continue;
+
+		sv_sendable[e>>5] |= 1u << (e&31);
+	}
+}
 
-			//johnfitz -- don't send model>255 entities if protocol is 15
-			if (sv.protocol == PROTOCOL_NETQUAKE && (int)ent->v.modelindex & 0xFF00)
+/*
+=============
+SV_EdictsTouchingPVS
+
+Sets a bit in visedicts for every sendable edict that touches the pvs
+=============
+*/
+static void SV_EdictsTouchingPVS (byte *pvs, unsigned int *visedicts)
+{
+	int		w, e, i, words;
+	unsigned int	bits;
+	edict_t	*ent;
+
+	words = (sv.num_edicts+31)>>5;
+	for (w=0 ; w<words ; w++)
+	{
+		visedicts[w] = 0;
+		for (e = w<<5, bits = sv_sendable[w] ; bits ; e++, bits >>= 1)
+		{
+			if (!(bits & 1))
 				continue;
+			ent = EDICT_NUM(e);
 
 			// ignore if not touching a PV leaf
 			for (i=0 ; i < ent->num_leafs ; i++)
 				if (pvs[ent->leafnums[i] >> 3] & (1 << (ent->leafnums[i]&7) ))
 					break;
-			
+
 			// ericw -- added ent->num_leafs < MAX_ENT_LEAFS condition.
 			//
 			// if ent->num_leafs == MAX_ENT_LEAFS, the ent is visible from too many leafs
@@ -586,155 +785,500 @@ void SV_WriteEntitiesToClient (edict_t	*clent, sizebuf_t *msg)
 			// spanning the entire map, or really tall lifts, etc.
 			if (i == ent->num_leafs && ent->num_leafs < MAX_ENT_LEAFS)
 				continue;		// not visible
+
+			visedicts[w] |= 1u << (e&31);
 		}
+	}
+}
+
+
+/*
+=============
+SV_VisibleEdicts
+
+Returns the bitset of sendable edicts that touch the fat PVS of clent.
+The client itself is not included.  scratch receives the bitset if the
+fat PVS can't be cached.
+=============
+*/
+static unsigned int *SV_VisibleEdicts (edict_t *clent, unsigned int *scratch)
+{
+	vec3_t	org;
+	fatpvs_cache_t	*fat;
+
+	VectorAdd (clent->v.origin, clent->v.view_ofs, org);
+	SV_UpdateSendableEdicts ();
+	fat = SV_CachedFatPVS (org, sv.worldmodel);
+	if (!fat)
+	{
+		SV_EdictsTouchingPVS (SV_FatPVS (org, sv.worldmodel), scratch);
+		return scratch;
+	}
+
+	if (fat->visframe != sv_fatpvs_frame)
+	{
+		fat->visframe = sv_fatpvs_frame;
+		SV_EdictsTouchingPVS (fat->pvs, fat->visedicts);
+	}
+	return fat->visedicts;
+}
+
+/*
+=============
+SV_PacketStats -- johnfitz -- devstats
+=============
+*/
+static void SV_PacketStats (int packetsize, qboolean overflowed)
+{
+	//johnfitz -- less spammy overflow message
+	if (overflowed && (!dev_overflows.packetsize || dev_overflows.packetsize + CONSOLE_RESPAM_TIME < realtime))
+	{
+		Con_Printf ("Packet overflow!\n");
+		dev_overflows.packetsize = realtime;
+	}
 
-		//johnfitz -- max size for protocol 15 is 18 bytes, not 16 as originally
-		//assumed here.  And, for protocol 85 the max size is actually 24 bytes.
-		if (msg->cursize + 24 > msg->maxsize)
+	if (packetsize > 1024 && dev_peakstats.packetsize <= 1024)
+		Con_DWarning ("%i byte packet exceeds standard limit of 1024.\n", packetsize);
+	dev_stats.packetsize = packetsize;
+	dev_peakstats.packetsize = q_max(packetsize, dev_peakstats.packetsize);
+}
+
+//=============================================================================
+
+/*
+=============
+SV_WriteEntitiesToClient
+
+visedicts comes from SV_VisibleEdicts.  Returns true if some entities
+didn't fit in the message.
+=============
+*/
+qboolean SV_WriteEntitiesToClient (edict_t	*clent, unsigned int *visedicts, sizebuf_t *msg)
+{
+	int		e, i, w, words, clentnum;
+	int		bits;
+	unsigned int	visbits;
+	float	miss;
+	edict_t	*ent;
+
+// send over all entities (excpet the client) that touch the pvs
+	clentnum = NUM_FOR_EDICT(clent);
+	words = (sv.num_edicts+31)>>5;
+	for (w=0 ; w<words ; w++)
+	{
+		visbits = visedicts[w];
+		if (w == clentnum>>5)
+			visbits |= 1u << (clentnum&31);	// clent is ALLWAYS sent
+
+		for (e = w<<5 ; visbits ; e++, visbits >>= 1)
 		{
-			//johnfitz -- less spammy overflow message
-			if (!dev_overflows.packetsize || dev_overflows.packetsize + CONSOLE_RESPAM_TIME < realtime )
+			if (!(visbits & 1))
+				continue;
+			ent = EDICT_NUM(e);
+
+			//johnfitz -- max size for protocol 15 is 18 bytes, not 16 as originally
+			//assumed here.  And, for protocol 85 the max size is actually 24 bytes.
+			if (msg->cursize + 24 > msg->maxsize)
+				return true;
+
+// send an update
+			bits = 0;
+
+			for (i=0 ; i<3 ; i++)
+			{
+				miss = ent->v.origin[i] - ent->baseline.origin[i];
+				if ( miss < -0.1 || miss > 0.1 )
+					bits |= U_ORIGIN1<<i;
+			}
+
+			if ( ent->v.angles[0] != ent->baseline.angles[0] )
+				bits |= U_ANGLE1;
+
+			if ( ent->v.angles[1] != ent->baseline.angles[1] )
+				bits |= U_ANGLE2;
+
+			if ( ent->v.angles[2] != ent->baseline.angles[2] )
+				bits |= U_ANGLE3;
+
+			if (ent->v.movetype == MOVETYPE_STEP)
+				bits |= U_STEP;	// don't mess up the step animation
+
+			if (ent->baseline.colormap != ent->v.colormap)
+				bits |= U_COLORMAP;
+
+			if (ent->baseline.skin != ent->v.skin)
+				bits |= U_SKIN;
+
+			if (ent->baseline.frame != ent->v.frame)
+				bits |= U_FRAME;
+
+			if (ent->baseline.effects != ent->v.effects)
+				bits |= U_EFFECTS;
+
+			if (ent->baseline.modelindex != ent->v.modelindex)
+				bits |= U_MODEL;
+
+			//johnfitz -- alpha, updated by SV_UpdateSendableEdicts
+			//don't send invisible entities unless they have effects
+			if (ent->alpha == ENTALPHA_ZERO && !ent->v.effects)
+				continue;
+			//johnfitz
+
+			//johnfitz -- PROTOCOL_FITZQUAKE
+			if (sv.protocol != PROTOCOL_NETQUAKE)
 			{
-				Con_Printf ("Packet overflow!\n");
-				dev_overflows.packetsize = realtime;
+
+				if (ent->baseline.alpha != ent->alpha) bits |= U_ALPHA;
+				if (bits & U_FRAME && (int)ent->v.frame & 0xFF00) bits |= U_FRAME2;
+				if (bits & U_MODEL && (int)ent->v.modelindex & 0xFF00) bits |= U_MODEL2;
+				if (ent->sendinterval) bits |= U_LERPFINISH;
+				if (bits >= 65536) bits |= U_EXTEND1;
+				if (bits >= 16777216) bits |= U_EXTEND2;
 			}
-			goto stats;
+			//johnfitz
+
+			if (e >= 256)
+				bits |= U_LONGENTITY;
+
+			if (bits >= 256)
+				bits |= U_MOREBITS;
+
+		//
+		// write the message
+		//
+			MSG_WriteByte (msg, bits | U_SIGNAL);
+
+			if (bits & U_MOREBITS)
+				MSG_WriteByte (msg, bits>>8);
+
+			//johnfitz -- PROTOCOL_FITZQUAKE
+			if (bits & U_EXTEND1)
+				MSG_WriteByte(msg, bits>>16);
+			if (bits & U_EXTEND2)
+				MSG_WriteByte(msg, bits>>24);
+			//johnfitz
+
+			if (bits & U_LONGENTITY)
+				MSG_WriteShort (msg,e);
+			else
+				MSG_WriteByte (msg,e);
+
+			if (bits & U_MODEL)
+				MSG_WriteByte (msg,	ent->v.modelindex);
+			if (bits & U_FRAME)
+				MSG_WriteByte (msg, ent->v.frame);
+			if (bits & U_COLORMAP)
+				MSG_WriteByte (msg, ent->v.colormap);
+			if (bits & U_SKIN)
+				MSG_WriteByte (msg, ent->v.skin);
+			if (bits & U_EFFECTS)
+				MSG_WriteByte (msg, ent->v.effects);
+			if (bits & U_ORIGIN1)
+				MSG_WriteCoord (msg, ent->v.origin[0], sv.protocolflags);
+			if (bits & U_ANGLE1)
+				MSG_WriteAngle(msg, ent->v.angles[0], sv.protocolflags);
+			if (bits & U_ORIGIN2)
+				MSG_WriteCoord (msg, ent->v.origin[1], sv.protocolflags);
+			if (bits & U_ANGLE2)
+				MSG_WriteAngle(msg, ent->v.angles[1], sv.protocolflags);
+			if (bits & U_ORIGIN3)
+				MSG_WriteCoord (msg, ent->v.origin[2], sv.protocolflags);
+			if (bits & U_ANGLE3)
+				MSG_WriteAngle(msg, ent->v.angles[2], sv.protocolflags);
+
+			//johnfitz -- PROTOCOL_FITZQUAKE
+			if (bits & U_ALPHA)
+				MSG_WriteByte(msg, ent->alpha);
+			if (bits & U_FRAME2)
+				MSG_WriteByte(msg, (int)ent->v.frame >> 8);
+			if (bits & U_MODEL2)
+				MSG_WriteByte(msg, (int)ent->v.modelindex >> 8);
+			if (bits & U_LERPFINISH)
+				MSG_WriteByte(msg, (byte)(Q_rint((ent->v.nextthink-sv.time)*255)));
 			//johnfitz
 		}
+	}
 
-// send an update
-		bits = 0;
+	return false;
+}
 
-		for (i=0 ; i<3 ; i++)
+/*
+=============
+SV_BuildSnapshot
+
+Collects the current state of every entity clent can see
+=============
+*/
+static void SV_BuildSnapshot (edict_t *clent, unsigned int *visedicts, snapshot_t *snap)
+{
+	int		e, w, words, clentnum;
+	unsigned int	visbits;
+	edict_t	*ent;
+	snapshot_entity_t	*s;
+
+	snap->num_entities = 0;
+	clentnum = NUM_FOR_EDICT(clent);
+	words = (sv.num_edicts+31)>>5;
+	for (w=0 ; w<words ; w++)
+	{
+		visbits = visedicts[w];
+		if (w == clentnum>>5)
+			visbits |= 1u << (clentnum&31);	// clent is ALLWAYS sent
+
+		for (e = w<<5 ; visbits ; e++, visbits >>= 1)
 		{
-			miss = ent->v.origin[i] - ent->baseline.origin[i];
-			if ( miss < -0.1 || miss > 0.1 )
-				bits |= U_ORIGIN1<<i;
+			if (!(visbits & 1))
+				continue;
+			ent = EDICT_NUM(e);
+
+			//don't send invisible entities unless they have effects
+			if (ent->alpha == ENTALPHA_ZERO && !ent->v.effects)
+				continue;
+			//johnfitz
+
+			if (snap->num_entities == MAX_SNAPSHOT_ENTITIES)
+				return;
+
+			s = &snap->entities[snap->num_entities++];
+			s->number = e;
+			s->flags = 0;
+			s->lerpfinish = 0;
+			if (ent->v.movetype == MOVETYPE_STEP)
+				s->flags |= SNAPFL_STEP;	// don't mess up the step animation
+			if (ent->sendinterval)
+			{
+				s->flags |= SNAPFL_LERPFINISH;
+				s->lerpfinish = (byte)(Q_rint((ent->v.nextthink-sv.time)*255));
+			}
+			VectorCopy (ent->v.origin, s->state.origin);
+			VectorCopy (ent->v.angles, s->state.angles);
+			s->state.modelindex = ent->v.modelindex;
+			s->state.frame = ent->v.frame;
+			s->state.colormap = ent->v.colormap;
+			s->state.skin = ent->v.skin;
+			s->state.alpha = ent->alpha;
+			s->state.effects = (byte)ent->v.effects;
 		}
+	}
+}
 
-		if ( ent->v.angles[0] != ent->baseline.angles[0] )
-			bits |= U_ANGLE1;
+/*
+=============
+SV_WriteSnapshotEntity
 
-		if ( ent->v.angles[1] != ent->baseline.angles[1] )
-			bits |= U_ANGLE2;
+Writes the fields of to that differ from from.  Fields too close to be
+sent are reset in to, so that it matches what the client ends up with.
+Nothing is written if the client already has the right state, unless
+force is set.
+=============
+*/
+static void SV_WriteSnapshotEntity (sizebuf_t *msg, const snapshot_entity_t *from, snapshot_entity_t *to, qboolean force)
+{
+	int		bits, i;
+	float	miss;
 
-		if ( ent->v.angles[2] != ent->baseline.angles[2] )
-			bits |= U_ANGLE3;
+	bits = 0;
 
-		if (ent->v.movetype == MOVETYPE_STEP)
-			bits |= U_STEP;	// don't mess up the step animation
+	for (i=0 ; i<3 ; i++)
+	{
+		miss = to->state.origin[i] - from->state.origin[i];
+		if ( miss < -0.1 || miss > 0.1 )
+			bits |= U_ORIGIN1<<i;
+		else
+			to->state.origin[i] = from->state.origin[i];
+	}
 
-		if (ent->baseline.colormap != ent->v.colormap)
-			bits |= U_COLORMAP;
+	if (to->state.angles[0] != from->state.angles[0])
+		bits |= U_ANGLE1;
+	if (to->state.angles[1] != from->state.angles[1])
+		bits |= U_ANGLE2;
+	if (to->state.angles[2] != from->state.angles[2])
+		bits |= U_ANGLE3;
+
+	if (to->state.colormap != from->state.colormap)
+		bits |= U_COLORMAP;
+	if (to->state.skin != from->state.skin)
+		bits |= U_SKIN;
+	if (to->state.effects != from->state.effects)
+		bits |= U_EFFECTS;
+	if (to->state.alpha != from->state.alpha)
+		bits |= U_ALPHA;
+
+	if (to->state.frame != from->state.frame)
+	{
+		bits |= U_FRAME;
+		if (to->state.frame & 0xFF00)
+			bits |= U_FRAME2;
+	}
+	if (to->state.modelindex != from->state.modelindex)
+	{
+		bits |= U_MODEL;
+		if (to->state.modelindex & 0xFF00)
+			bits |= U_MODEL2;
+	}
 
-		if (ent->baseline.skin != ent->v.skin)
-			bits |= U_SKIN;
+	if (to->flags & SNAPFL_LERPFINISH)
+		bits |= U_LERPFINISH;
 
-		if (ent->baseline.frame != ent->v.frame)
-			bits |= U_FRAME;
+	if (!bits && !force && !((to->flags ^ from->flags) & SNAPFL_STEP))
+		return;
 
-		if (ent->baseline.effects != ent->v.effects)
-			bits |= U_EFFECTS;
+	if (to->flags & SNAPFL_STEP)
+		bits |= U_STEP;
+	if (bits >= 65536)
+		bits |= U_EXTEND1;
+	if (bits >= 16777216)
+		bits |= U_EXTEND2;
+	if (bits >= 256)
+		bits |= U_MOREBITS;
+
+	MSG_WriteShort (msg, to->number);
+	MSG_WriteByte (msg, bits & 255);
+	if (bits & U_MOREBITS)
+		MSG_WriteByte (msg, bits>>8);
+	if (bits & U_EXTEND1)
+		MSG_WriteByte (msg, bits>>16);
+	if (bits & U_EXTEND2)
+		MSG_WriteByte (msg, bits>>24);
+
+	if (bits & U_MODEL)
+		MSG_WriteByte (msg, to->state.modelindex);
+	if (bits & U_FRAME)
+		MSG_WriteByte (msg, to->state.frame);
+	if (bits & U_COLORMAP)
+		MSG_WriteByte (msg, to->state.colormap);
+	if (bits & U_SKIN)
+		MSG_WriteByte (msg, to->state.skin);
+	if (bits & U_EFFECTS)
+		MSG_WriteByte (msg, to->state.effects);
+	if (bits & U_ORIGIN1)
+		MSG_WriteCoord (msg, to->state.origin[0], sv.protocolflags);
+	if (bits & U_ANGLE1)
+		MSG_WriteAngle (msg, to->state.angles[0], sv.protocolflags);
+	if (bits & U_ORIGIN2)
+		MSG_WriteCoord (msg, to->state.origin[1], sv.protocolflags);
+	if (bits & U_ANGLE2)
+		MSG_WriteAngle (msg, to->state.angles[1], sv.protocolflags);
+	if (bits & U_ORIGIN3)
+		MSG_WriteCoord (msg, to->state.origin[2], sv.protocolflags);
+	if (bits & U_ANGLE3)
+		MSG_WriteAngle (msg, to->state.angles[2], sv.protocolflags);
+	if (bits & U_ALPHA)
+		MSG_WriteByte (msg, to->state.alpha);
+	if (bits & U_FRAME2)
+		MSG_WriteByte (msg, to->state.frame >> 8);
+	if (bits & U_MODEL2)
+		MSG_WriteByte (msg, to->state.modelindex >> 8);
+	if (bits & U_LERPFINISH)
+		MSG_WriteByte (msg, to->lerpfinish);
+}
 
-		if (ent->baseline.modelindex != ent->v.modelindex)
-			bits |= U_MODEL;
+/*
+=============
+SV_KeepSnapshotEntity
 
-		//johnfitz -- alpha
-		if (pr_alpha_supported)
-		{
-			// TODO: find a cleaner place to put this code
-			eval_t	*val;
-			val = GetEdictFieldValue(ent, "alpha");
-			if (val)
-				ent->alpha = ENTALPHA_ENCODE(val->_float);
-		}
+Carries an entity the client already has over to the new snapshot
+=============
+*/
+static void SV_KeepSnapshotEntity (snapshot_t *frame, const snapshot_entity_t *old)
+{
+	snapshot_entity_t	*s;
 
-		//don't send invisible entities unless they have effects
-		if (ent->alpha == ENTALPHA_ZERO && !ent->v.effects)
-			continue;
-		//johnfitz
+	s = &frame->entities[frame->num_entities++];
+	*s = *old;
+	s->flags &= ~SNAPFL_LERPFINISH;
+}
 
-		//johnfitz -- PROTOCOL_FITZQUAKE
-		if (sv.protocol != PROTOCOL_NETQUAKE)
-		{
+#define	SNAPSHOT_MAX_RECORD		40	// worst case size of one entity record with 32-bit coords
 
-			if (ent->baseline.alpha != ent->alpha) bits |= U_ALPHA;
-			if (bits & U_FRAME && (int)ent->v.frame & 0xFF00) bits |= U_FRAME2;
-			if (bits & U_MODEL && (int)ent->v.modelindex & 0xFF00) bits |= U_MODEL2;
-			if (ent->sendinterval) bits |= U_LERPFINISH;
-			if (bits >= 65536) bits |= U_EXTEND1;
-			if (bits >= 16777216) bits |= U_EXTEND2;
-		}
-		//johnfitz
+/*
+=============
+SV_WriteSnapshotToClient
+
+PROTOCOL_DELTA replacement for SV_WriteEntitiesToClient.  The visible
+entities are delta-compressed against the last snapshot the client has
+acknowledged (or against their baselines if there is none), so unchanged
+entities cost nothing.  The snapshot is remembered exactly as the client
+will reconstruct it, including anything left out because the packet was
+full, so it can serve as a delta reference later.
+Returns true if some entities didn't fit in the message.
+=============
+*/
+static qboolean SV_WriteSnapshotToClient (client_t *client, unsigned int *visedicts, sizebuf_t *msg)
+{
+	snapshot_t	current, *frame, *from;
+	snapshot_entity_t	baseline, *cur, *old;
+	int		sequence, ack, newindex, oldindex, newnum, oldnum;
+	qboolean	overflow;
 
-		if (e >= 256)
-			bits |= U_LONGENTITY;
+	SV_BuildSnapshot (client->edict, visedicts, &current);
 
-		if (bits >= 256)
-			bits |= U_MOREBITS;
+	sequence = ++client->snapshot_sequence;
+	frame = &client->snapshots[sequence & UPDATE_MASK];
 
-	//
-	// write the message
-	//
-		MSG_WriteByte (msg, bits | U_SIGNAL);
+	ack = client->snapshot_ack;
+	if (ack > 0 && sequence - ack < UPDATE_BACKUP && client->snapshots[ack & UPDATE_MASK].sequence == ack)
+		from = &client->snapshots[ack & UPDATE_MASK];
+	else
+	{
+		from = NULL;	// delta from the baselines
+		ack = 0;
+	}
 
-		if (bits & U_MOREBITS)
-			MSG_WriteByte (msg, bits>>8);
+	MSG_WriteByte (msg, svc_snapshot);
+	MSG_WriteLong (msg, sequence);
+	MSG_WriteLong (msg, ack);
 
-		//johnfitz -- PROTOCOL_FITZQUAKE
-		if (bits & U_EXTEND1)
-			MSG_WriteByte(msg, bits>>16);
-		if (bits & U_EXTEND2)
-			MSG_WriteByte(msg, bits>>24);
-		//johnfitz
+	frame->sequence = sequence;
+	frame->num_entities = 0;
 
-		if (bits & U_LONGENTITY)
-			MSG_WriteShort (msg,e);
+	overflow = false;
+	newindex = oldindex = 0;
+	while (newindex < current.num_entities || (from && oldindex < from->num_entities))
+	{
+		newnum = (newindex < current.num_entities) ? current.entities[newindex].number : MAX_EDICTS;
+		oldnum = (from && oldindex < from->num_entities) ? from->entities[oldindex].number : MAX_EDICTS;
+
+		if (msg->cursize + SNAPSHOT_MAX_RECORD + 2 > msg->maxsize)
+			overflow = true;
+
+		if (newnum == oldnum)
+		{	// delta from the acknowledged state
+			old = &from->entities[oldindex++];
+			cur = &current.entities[newindex++];
+			if (overflow)
+				SV_KeepSnapshotEntity (frame, old);
+			else
+			{
+				SV_WriteSnapshotEntity (msg, old, cur, false);
+				frame->entities[frame->num_entities++] = *cur;
+			}
+		}
+		else if (newnum < oldnum)
+		{	// entering the view, delta from the baseline
+			cur = &current.entities[newindex++];
+			if (overflow || frame->num_entities + (from ? from->num_entities - oldindex : 0) >= MAX_SNAPSHOT_ENTITIES)
+				continue;	// will be sent once there is room
+			baseline.number = newnum;
+			baseline.flags = 0;
+			baseline.lerpfinish = 0;
+			baseline.state = EDICT_NUM(newnum)->baseline;
+			SV_WriteSnapshotEntity (msg, &baseline, cur, true);
+			frame->entities[frame->num_entities++] = *cur;
+		}
 		else
-			MSG_WriteByte (msg,e);
-
-		if (bits & U_MODEL)
-			MSG_WriteByte (msg,	ent->v.modelindex);
-		if (bits & U_FRAME)
-			MSG_WriteByte (msg, ent->v.frame);
-		if (bits & U_COLORMAP)
-			MSG_WriteByte (msg, ent->v.colormap);
-		if (bits & U_SKIN)
-			MSG_WriteByte (msg, ent->v.skin);
-		if (bits & U_EFFECTS)
-			MSG_WriteByte (msg, ent->v.effects);
-		if (bits & U_ORIGIN1)
-			MSG_WriteCoord (msg, ent->v.origin[0], sv.protocolflags);
-		if (bits & U_ANGLE1)
-			MSG_WriteAngle(msg, ent->v.angles[0], sv.protocolflags);
-		if (bits & U_ORIGIN2)
-			MSG_WriteCoord (msg, ent->v.origin[1], sv.protocolflags);
-		if (bits & U_ANGLE2)
-			MSG_WriteAngle(msg, ent->v.angles[1], sv.protocolflags);
-		if (bits & U_ORIGIN3)
-			MSG_WriteCoord (msg, ent->v.origin[2], sv.protocolflags);
-		if (bits & U_ANGLE3)
-			MSG_WriteAngle(msg, ent->v.angles[2], sv.protocolflags);
-
-		//johnfitz -- PROTOCOL_FITZQUAKE
-		if (bits & U_ALPHA)
-			MSG_WriteByte(msg, ent->alpha);
-		if (bits & U_FRAME2)
-			MSG_WriteByte(msg, (int)ent->v.frame >> 8);
-		if (bits & U_MODEL2)
-			MSG_WriteByte(msg, (int)ent->v.modelindex >> 8);
-		if (bits & U_LERPFINISH)
-			MSG_WriteByte(msg, (byte)(Q_rint((ent->v.nextthink-sv.time)*255)));
-		//johnfitz
+		{	// left the view
+			old = &from->entities[oldindex++];
+			if (overflow)
+				SV_KeepSnapshotEntity (frame, old);
+			else
+				MSG_WriteShort (msg, oldnum | SNAP_REMOVE);
+		}
 	}
 
-	//johnfitz -- devstats
-stats:
-	if (msg->cursize > 1024 && dev_peakstats.packetsize <= 1024)
-		Con_DWarning ("%i byte packet exceeds standard limit of 1024.\n", msg->cursize);
-	dev_stats.packetsize = msg->cursize;
-	dev_peakstats.packetsize = q_max(msg->cursize, dev_peakstats.packetsize);
-	//johnfitz
+	MSG_WriteShort (msg, 0);
+
+	return overflow;
 }
 
 /*
@@ -757,11 +1301,13 @@ void SV_CleanupEnts (void)
 
 /*
 ==================
-SV_WriteClientdataToMessage
+SV_WriteClientdata
 
+Doesn't touch anything but ent and msg, so it can run on a worker thread
+as long as the "items2" field lookup is cached
 ==================
 */
-void SV_WriteClientdataToMessage (edict_t *ent, sizebuf_t *msg)
+static void SV_WriteClientdata (edict_t *ent, sizebuf_t *msg)
 {
 	int		bits;
 	int		i;
@@ -785,11 +1331,6 @@ void SV_WriteClientdataToMessage (edict_t *ent, sizebuf_t *msg)
 		ent->v.dmg_save = 0;
 	}
 
-//
-// send the current viewpos offset from the view entity
-//
-	SV_SetIdealPitch ();		// how much to look up / down ideally
-
 // a fixangle might get lost in a dropped packet.  Oh well.
 	if ( ent->v.fixangle )
 	{
@@ -938,38 +1479,149 @@ void SV_WriteClientdataToMessage (edict_t *ent, sizebuf_t *msg)
 }
 
 /*
-=======================
-SV_SendClientDatagram
-=======================
+==================
+SV_WriteClientdataToMessage
+
+==================
 */
-qboolean SV_SendClientDatagram (client_t *client)
+void SV_WriteClientdataToMessage (edict_t *ent, sizebuf_t *msg)
 {
-	byte		buf[MAX_DATAGRAM];
+//
+// send the current viewpos offset from the view entity
+//
+	SV_SetIdealPitch ();		// how much to look up / down ideally
+
+	SV_WriteClientdata (ent, msg);
+}
+
+/*
+=============================================================================
+
+CLIENT DATAGRAMS
+
+Building a datagram only reads the shared edict state, so the datagrams
+of all clients are built in parallel on the worker threads, each into its
+own buffer.  Anything that isn't thread safe (the fat PVS cache, field
+lookups, SV_SetIdealPitch, console output) is done on the main thread,
+before or after.  The datagrams are then sent in client order.
+
+=============================================================================
+*/
+
+typedef struct
+{
+	client_t	*client;
+	unsigned int	*visedicts;
+	unsigned int	visedicts_scratch[EDICT_BITS_WORDS];
 	sizebuf_t	msg;
+	byte		buf[MAX_DATAGRAM];
+	int			entitiessize;	// for devstats
+	qboolean	overflowed;
+} client_datagram_t;
 
-	msg.data = buf;
-	msg.maxsize = sizeof(buf);
-	msg.cursize = 0;
+static client_datagram_t	sv_client_datagrams[MAX_SCOREBOARD];
+static int					sv_num_client_datagrams;
 
-	//johnfitz -- if client is nonlocal, use smaller max size so packets aren't fragmented
-	if (Q_strcmp(NET_QSocketGetAddressString(client->netconnection), "LOCAL") != 0)
-		msg.maxsize = DATAGRAM_MTU;
-	//johnfitz
+/*
+=======================
+SV_BuildClientDatagram
+
+Runs on a worker thread
+=======================
+*/
+static void SV_BuildClientDatagram (int index, void *data)
+{
+	client_datagram_t	*dg = (client_datagram_t *) data + index;
+	client_t	*client = dg->client;
+	sizebuf_t	*msg = &dg->msg;
 
-	MSG_WriteByte (&msg, svc_time);
-	MSG_WriteFloat (&msg, sv.time);
+	MSG_WriteByte (msg, svc_time);
+	MSG_WriteFloat (msg, sv.time);
 
 // add the client specific data to the datagram
-	SV_WriteClientdataToMessage (client->edict, &msg);
+	SV_WriteClientdata (client->edict, msg);
 
-	SV_WriteEntitiesToClient (client->edict, &msg);
+	if (sv.protocol == PROTOCOL_DELTA)
+		dg->overflowed = SV_WriteSnapshotToClient (client, dg->visedicts, msg);
+	else
+		dg->overflowed = SV_WriteEntitiesToClient (client->edict, dg->visedicts, msg);
+	dg->entitiessize = msg->cursize;
 
 // copy the server datagram if there is space
-	if (msg.cursize + sv.datagram.cursize < msg.maxsize)
-		SZ_Write (&msg, sv.datagram.data, sv.datagram.cursize);
+	if (msg->cursize + sv.datagram.cursize < msg->maxsize)
+		SZ_Write (msg, sv.datagram.data, sv.datagram.cursize);
+}
+
+/*
+=======================
+SV_BuildClientDatagrams
+=======================
+*/
+static void SV_BuildClientDatagrams (void)
+{
+	int			i;
+	client_t	*client;
+	client_datagram_t	*dg;
+
+	SV_UpdateSendableEdicts ();
+
+	// the workers may only hit the field cache, never update it
+	GetEdictFieldValue (sv.edicts, "items2");
+
+	sv_num_client_datagrams = 0;
+	for (i=0, client = svs.clients ; i<svs.maxclients ; i++, client++)
+	{
+		if (!client->active || !client->spawned)
+			continue;
+
+		dg = &sv_client_datagrams[sv_num_client_datagrams++];
+		dg->client = client;
+		dg->overflowed = false;
+		dg->entitiessize = 0;
+
+		dg->msg.data = dg->buf;
+		dg->msg.maxsize = sizeof(dg->buf);
+		dg->msg.cursize = 0;
+		dg->msg.allowoverflow = false;
+		dg->msg.overflowed = false;
+
+		//johnfitz -- if client is nonlocal, use smaller max size so packets aren't fragmented
+		if (Q_strcmp(NET_QSocketGetAddressString(client->netconnection), "LOCAL") != 0)
+			dg->msg.maxsize = DATAGRAM_MTU;
+		//johnfitz
+
+		SV_SetIdealPitch ();		// how much to look up / down ideally
+
+		// at most MAX_SCOREBOARD lookups per frame, so none of them can
+		// evict the fat PVS cache entry of another client
+		dg->visedicts = SV_VisibleEdicts (client->edict, dg->visedicts_scratch);
+	}
+
+	Tasks_ParallelFor (SV_BuildClientDatagram, sv_client_datagrams, sv_num_client_datagrams);
+}
+
+/*
+=======================
+SV_SendClientDatagram
+
+Sends the datagram built by SV_BuildClientDatagrams
+=======================
+*/
+qboolean SV_SendClientDatagram (client_t *client)
+{
+	int		i;
+	client_datagram_t	*dg;
+
+	for (i=0, dg = sv_client_datagrams ; i<sv_num_client_datagrams ; i++, dg++)
+		if (dg->client == client)
+			break;
+	if (i == sv_num_client_datagrams)
+		return true;	// spawned after the datagrams were built
+
+	SV_PacketStats (dg->entitiessize, dg->overflowed);
 
 // send the datagram
-	if (NET_SendUnreliableMessage (client->netconnection, &msg) == -1)
+	if (NET_SendUnreliableMessage (client->netconnection, &dg->msg) == -1)
 	{
 		SV_DropClient (true);// if the message couldn't send, kick off
 		return false;
@@ -1053,6 +1705,12 @@ void SV_SendClientMessages (void)
 // update frags, names, etc
 	SV_UpdateToReliableMessages ();
 
+// entity visibility bitsets are rebuilt once per frame
+	sv_fatpvs_frame++;
+
+// build the datagrams of all spawned clients
+	SV_BuildClientDatagrams ();
+
 // build individual updates
 	for (i=0, host_client = svs.clients ; i<svs.maxclients ; i++, host_client++)
 	{
@@ -1111,6 +1769,8 @@ void SV_SendClientMessages (void)
 		}
 	}
 
+// push out anything the net drivers batched up
+	NET_Flush ();
 
 // clear muzzle flashes
 	SV_CleanupEnts ();
@@ -1357,7 +2017,7 @@ void SV_SpawnServer (const char *server)
 
 	sv.protocol = sv_protocol; // johnfitz
 	
-	if (sv.protocol == PROTOCOL_RMQ)
+	if (sv.protocol == PROTOCOL_RMQ || sv.protocol == PROTOCOL_DELTA)
 	{
 		// set up the protocol flags used by this server
 		// (note - these could be cvar-ised so that server admins could choose the protocol features used by their servers)
@@ -1409,6 +2069,7 @@ void SV_SpawnServer (const char *server)
 		return;
 	}
 	sv.models[1] = sv.worldmodel;
+	SV_ClearFatPVSCache ();
 
 //
 // clear world interaction links
@@ -470,6 +470,14 @@ void SV_ReadClientMove (usercmd_t *move)
 	i = MSG_ReadByte ();
 	if (i)
 		host_client->edict->v.impulse = i;
+
+// read the last snapshot the client received intact, 0 asks for a full update
+	if (sv.protocol == PROTOCOL_DELTA)
+	{
+		i = MSG_ReadLong ();
+		if (host_client->spawned && i >= 0 && i <= host_client->snapshot_sequence)
+			host_client->snapshot_ack = i;
+	}
 }
 
 /*
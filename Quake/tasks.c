@@ -0,0 +1,171 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+Copyright (C) 2010-2014 QuakeSpasm developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// tasks.c -- worker thread pool
+
+#include "quakedef.h"
+
+static SDL_Thread	*task_workers[MAX_TASK_WORKERS];
+static int			task_numworkers;
+
+static SDL_sem		*task_work_sem;		// posted once per worker that should join a job
+static SDL_sem		*task_done_sem;		// posted by each worker when it runs out of work
+static SDL_atomic_t	task_quit;
+
+static task_func_t	task_func;
+static void			*task_data;
+static int			task_count;
+static SDL_atomic_t	task_next;
+
+/*
+=================
+Tasks_RunJob
+
+Picks indices of the current job until there are none left
+=================
+*/
+static void Tasks_RunJob (void)
+{
+	int		i;
+
+	while ((i = SDL_AtomicAdd (&task_next, 1)) < task_count)
+		task_func (i, task_data);
+}
+
+/*
+=================
+Tasks_Worker
+=================
+*/
+static int Tasks_Worker (void *unused)
+{
+	while (1)
+	{
+		SDL_SemWait (task_work_sem);
+		if (SDL_AtomicGet (&task_quit))
+			break;
+		Tasks_RunJob ();
+		SDL_SemPost (task_done_sem);
+	}
+	return 0;
+}
+
+/*
+=================
+Tasks_Init
+
+"-threads <n>" sets the number of worker threads, 0 runs everything on
+the main thread
+=================
+*/
+void Tasks_Init (void)
+{
+	int		i, numworkers;
+	char	name[16];
+
+	i = COM_CheckParm ("-threads");
+	if (i && i < com_argc - 1)
+		numworkers = Q_atoi (com_argv[i + 1]);
+	else
+		numworkers = SDL_GetCPUCount () - 1;
+	numworkers = CLAMP (0, numworkers, MAX_TASK_WORKERS);
+
+	task_work_sem = SDL_CreateSemaphore (0);
+	task_done_sem = SDL_CreateSemaphore (0);
+	if (!task_work_sem || !task_done_sem)
+		Sys_Error ("Tasks_Init: couldn't create semaphores: %s", SDL_GetError ());
+
+	SDL_AtomicSet (&task_quit, 0);
+	for (i = 0; i < numworkers; i++)
+	{
+		q_snprintf (name, sizeof(name), "worker%i", i);
+		task_workers[i] = SDL_CreateThread (Tasks_Worker, name, NULL);
+		if (!task_workers[i])
+		{
+			Con_Warning ("Tasks_Init: couldn't create thread: %s\n", SDL_GetError ());
+			break;
+		}
+	}
+	task_numworkers = i;
+
+	Con_Printf ("%i worker threads\n", task_numworkers);
+}
+
+/*
+=================
+Tasks_Shutdown
+=================
+*/
+void Tasks_Shutdown (void)
+{
+	int		i;
+
+	SDL_AtomicSet (&task_quit, 1);
+	for (i = 0; i < task_numworkers; i++)
+		SDL_SemPost (task_work_sem);
+	for (i = 0; i < task_numworkers; i++)
+		SDL_WaitThread (task_workers[i], NULL);
+	task_numworkers = 0;
+}
+
+/*
+=================
+Tasks_NumWorkers
+=================
+*/
+int Tasks_NumWorkers (void)
+{
+	return task_numworkers;
+}
+
+/*
+=================
+Tasks_ParallelFor
+=================
+*/
+void Tasks_ParallelFor (task_func_t func, void *data, int count)
+{
+	int		i, numwoken;
+
+	if (count <= 0)
+		return;
+
+	numwoken = q_min (task_numworkers, count - 1);
+	if (!numwoken)
+	{
+		for (i = 0; i < count; i++)
+			func (i, data);
+		return;
+	}
+
+	task_func = func;
+	task_data = data;
+	task_count = count;
+	SDL_AtomicSet (&task_next, 0);
+
+	for (i = 0; i < numwoken; i++)
+		SDL_SemPost (task_work_sem);
+
+	Tasks_RunJob ();
+
+	for (i = 0; i < numwoken; i++)
+		SDL_SemWait (task_done_sem);
+}
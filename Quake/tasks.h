@@ -0,0 +1,45 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+Copyright (C) 2010-2014 QuakeSpasm developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#ifndef _QUAKE_TASKS_H
+#define _QUAKE_TASKS_H
+
+// tasks.h -- worker thread pool
+
+#define	MAX_TASK_WORKERS	16
+
+typedef void (*task_func_t) (int index, void *data);
+
+void Tasks_Init (void);
+void Tasks_Shutdown (void);
+
+int Tasks_NumWorkers (void);
+// number of worker threads, not counting the main thread
+
+void Tasks_ParallelFor (task_func_t func, void *data, int count);
+// calls func (i, data) for every i in [0, count) on the worker threads
+// and the calling thread, and returns when all of them are done.
+// must only be called from the main thread, and func must not call
+// anything that isn't thread safe (Con_Printf, Hunk/Cache allocation,
+// most of the progs and cvar code...)
+
+#endif	/* _QUAKE_TASKS_H */
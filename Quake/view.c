@@ -551,6 +551,7 @@ void V_PolyBlend (void)
 
 	vkCmdBindVertexBuffers(vulkan_globals.command_buffer, 0, 1, &vertex_buffer, &vertex_buffer_offset);
 	vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.basic_poly_blend_pipeline);
+	R_BindLatch(vulkan_globals.basic_pipeline_layout, 1, true);
 
 	vkCmdDraw(vulkan_globals.command_buffer, 4, 1, 0, 0);
 }
@@ -984,8 +985,8 @@ void V_RenderView (void)
 	if (con_forcedup)
 	{
 		render_warp = false;
-		render_pass_index = 0;
-		vkCmdBeginRenderPass(vulkan_globals.command_buffer, &vulkan_globals.main_render_pass_begin_infos[0], VK_SUBPASS_CONTENTS_INLINE);
+		foveation_mask = false;
+		R_BeginMainRenderPass(0);
 		return;
 	}
 
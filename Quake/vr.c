@@ -36,6 +36,36 @@ static VrSystem		vr_hmd;
 static VrSystem		vr_context_system;
 static VrCompositor	vr_context_compositor;
 
+static VkBuffer			hidden_area_buffer;
+static VkDeviceMemory	hidden_area_memory;
+
+typedef struct
+{
+	int			frames;
+	uint32_t	dropped;
+	uint32_t	late;
+	float		app_gpu_ms;
+	float		compositor_gpu_ms;
+	float		compositor_cpu_ms;
+	float		interval_ms;
+	float		wait_ms;
+} vrpacingstats_t;
+
+// frame pacing, see VR_PacingThread.  The main thread only touches what the
+// pacing thread also uses while no frame is pending
+static SDL_Thread		*pacing_thread;
+static SDL_sem			*pacing_submit_sem;		// posted by the main thread when both eyes are on the queue
+static SDL_sem			*pacing_start_sem;		// posted by the pacing thread when the next frame should start
+static SDL_atomic_t		pacing_quit;
+static VrCompositor		pacing_compositor;
+static VRTextureBounds_t	pacing_bounds[NUM_VR_EYES];
+static double			pacing_display_time;
+static uint32_t			pacing_frame_index;
+static vrpacingstats_t	pacing_stats;
+static qboolean			pacing_frame;			// main thread only, the eyes of this frame go to the pacing thread
+static qboolean			pacing_pending;			// main thread only, a frame was handed over and not waited for yet
+static double			pacing_log_time;
+
 static void			VR_Context_Clear();
 static void			VR_Context_CheckClear();
 static VrSystem		VR_System();
@@ -48,6 +78,8 @@ static int			VR_GetKeyForAxisState(float x, float y);
 
 cvar_t vr_lefthanded = { "vr_lefthanded", "0", CVAR_NONE };
 cvar_t vr_gunangle = { "vr_gunangle", "32", CVAR_NONE };
+cvar_t vr_pacing = { "vr_pacing", "1", CVAR_ARCHIVE };			// frames start when the compositor says so, instead of host_maxfps
+cvar_t vr_pacingstats = { "vr_pacingstats", "0", CVAR_NONE };	// once a second console log of the compositor frame timing
 
 /*
 ===================
@@ -330,21 +362,100 @@ void VR_GetOrientation(TrackedDevicePose_t pose, float *pitch, float *yaw, float
 
 /*
 ===================
-VR_UpdatePose
+VR_SecondsToPhotons -- when a frame started now reaches the display
 ===================
 */
-void VR_UpdatePose(void)
+static float VR_SecondsToPhotons(void)
 {
-	float seconds_since_vsync, display_frequency, frame_duration, vsync_to_photons, predicted_seconds_from_now;
+	float seconds_since_vsync, frame_duration, vsync_to_photons;
 
 	vr_hmd->GetTimeSinceLastVsync(&seconds_since_vsync, NULL);
 
-	display_frequency = vr_hmd->GetFloatTrackedDeviceProperty(k_unTrackedDeviceIndex_Hmd, ETrackedDeviceProperty_Prop_DisplayFrequency_Float, NULL);
-	frame_duration = 1.f / display_frequency;
+	frame_duration = 1.f / VR_GetDisplayFrequency();
 	vsync_to_photons = vr_hmd->GetFloatTrackedDeviceProperty(k_unTrackedDeviceIndex_Hmd, ETrackedDeviceProperty_Prop_SecondsFromVsyncToPhotons_Float, NULL);
-	predicted_seconds_from_now = frame_duration - seconds_since_vsync + vsync_to_photons;
 
-	vr_hmd->GetDeviceToAbsoluteTrackingPose(ETrackingUniverseOrigin_TrackingUniverseStanding, predicted_seconds_from_now, vr.pose, MAX_VR_TRACKED_DEVICE_POSES);
+	return frame_duration - seconds_since_vsync + vsync_to_photons;
+}
+
+/*
+===================
+VR_PredictedSecondsFromNow -- when the frame that is being rendered reaches the display
+===================
+*/
+static float VR_PredictedSecondsFromNow(void)
+{
+	if (vr.display_time > 0.0)
+		return q_max(0.0f, (float)(vr.display_time - Sys_DoubleTime()));
+
+	return VR_SecondsToPhotons();
+}
+
+/*
+===================
+VR_GetDisplayFrequency
+===================
+*/
+float VR_GetDisplayFrequency(void)
+{
+	float display_frequency = vr_hmd->GetFloatTrackedDeviceProperty(k_unTrackedDeviceIndex_Hmd, ETrackedDeviceProperty_Prop_DisplayFrequency_Float, NULL);
+
+	return (display_frequency > 0.0f) ? display_frequency : 90.0f;
+}
+
+/*
+===================
+VR_UpdatePose
+===================
+*/
+void VR_UpdatePose(void)
+{
+	vr_hmd->GetDeviceToAbsoluteTrackingPose(ETrackingUniverseOrigin_TrackingUniverseStanding, VR_PredictedSecondsFromNow(), vr.pose, MAX_VR_TRACKED_DEVICE_POSES);
+}
+
+/*
+===================
+VR_GetLatePose
+
+A fresh prediction of the HMD pose only, for late latching right before submit.
+The HMD is always device 0, so asking for one pose is enough. Doesn't touch
+vr.pose, the game has already used that for this frame
+===================
+*/
+qboolean VR_GetLatePose(TrackedDevicePose_t *hmd_pose)
+{
+	vr_hmd->GetDeviceToAbsoluteTrackingPose(ETrackingUniverseOrigin_TrackingUniverseStanding, VR_PredictedSecondsFromNow(), hmd_pose, 1);
+
+	return hmd_pose->bPoseIsValid;
+}
+
+/*
+===================
+VR_SetSubmitPose
+
+The HMD pose the current eye was rendered with, the late latched one if it was
+latched, so the compositor reprojects from where the image really is.  NULL if
+there is none, the eye is submitted without a pose then
+===================
+*/
+void VR_SetSubmitPose(const HmdMatrix34_t *hmd_pose)
+{
+	vreye_t *eye = &vr.eye[vr.current_eye];
+
+	eye->texture_has_pose = (hmd_pose != NULL);
+	if (hmd_pose)
+		eye->texture.device_to_absolute_tracking = *hmd_pose;
+}
+
+/*
+===================
+VR_SubmitEye
+===================
+*/
+static void VR_SubmitEye(VrCompositor compositor, uint32_t eye, VRTextureBounds_t *bounds)
+{
+	EVRSubmitFlags flags = vr.eye[eye].texture_has_pose ? (EVRSubmitFlags)VR_SUBMIT_TEXTURE_WITH_POSE : EVRSubmitFlags_Submit_Default;
+
+	compositor->Submit(vr.eye[eye].vreye, &vr.eye[eye].texture.base, bounds, flags);
 }
 
 /*
@@ -402,12 +513,156 @@ VR_Submit
 */
 void VR_Submit(uint32_t eye, VkImage color_buffer)
 {
+	VRTextureBounds_t bounds;
+
 	vr.eye[eye].texture_data.m_nImage = (uint64_t)color_buffer;
-	
-	VR_Compositor()->Submit(vr.eye[eye].vreye, &vr.eye[eye].texture, NULL, EVRSubmitFlags_Submit_Default);
+
+	// only the rendered part, smaller than the image when the resolution is scaled down
+	bounds.uMin = 0.0f;
+	bounds.vMin = 0.0f;
+	bounds.uMax = (float)vr.render_width / (float)vr.width;
+	bounds.vMax = (float)vr.render_height / (float)vr.height;
+
+	// both eyes of a frame take the same path, vr_pacing may change in between
+	if (eye == VR_EYE_LEFT)
+		pacing_frame = pacing_thread && vr_pacing.value;
+
+	if (pacing_frame)
+	{
+		pacing_bounds[eye] = bounds;
+		if (eye == VR_EYE_RIGHT)
+		{
+			pacing_pending = true;
+			SDL_SemPost(pacing_submit_sem);
+		}
+		return;
+	}
+
+	GL_LockQueue();
+	VR_SubmitEye(VR_Compositor(), eye, &bounds);
+	GL_UnlockQueue();
 
 	if (eye == VR_EYE_RIGHT)
+	{
 		VR_Compositor()->WaitGetPoses(NULL, 0, NULL, 0);
+		vr.display_time = 0.0;
+	}
+}
+
+/*
+===================
+VR_PacingThread
+
+Takes the compositor calls off the main thread.  Once both eyes of a frame are
+on the queue they are submitted here, then WaitGetPoses blocks until the next
+frame should start, which is what the main thread waits for before rendering.
+The queue is only held for the submits, the main thread keeps submitting its
+own work while WaitGetPoses blocks.
+===================
+*/
+static int VR_PacingThread(void *unused)
+{
+	Compositor_FrameTiming timing;
+	double wait_start, wait_end;
+	uint32_t i;
+
+	SDL_SetThreadPriority(SDL_THREAD_PRIORITY_HIGH);
+
+	while (1)
+	{
+		SDL_SemWait(pacing_submit_sem);
+		if (SDL_AtomicGet(&pacing_quit))
+			break;
+
+		GL_LockQueue();
+		for (i = 0; i < NUM_VR_EYES; ++i)
+			VR_SubmitEye(pacing_compositor, i, &pacing_bounds[i]);
+		GL_UnlockQueue();
+
+		wait_start = Sys_DoubleTime();
+		pacing_compositor->WaitGetPoses(NULL, 0, NULL, 0);
+		wait_end = Sys_DoubleTime();
+
+		pacing_display_time = wait_end + VR_SecondsToPhotons();
+
+		pacing_stats.frames++;
+		pacing_stats.wait_ms += (float)((wait_end - wait_start) * 1000.0);
+
+		// the same compositor frame shows up again when we run faster than the display
+		memset(&timing, 0, sizeof(timing));
+		timing.m_nSize = sizeof(timing);
+		if (pacing_compositor->GetFrameTiming(&timing, 0) && timing.m_nFrameIndex != pacing_frame_index)
+		{
+			pacing_frame_index = timing.m_nFrameIndex;
+			pacing_stats.dropped += timing.m_nNumDroppedFrames;
+			pacing_stats.late += timing.m_nNumMisPresented;
+			pacing_stats.app_gpu_ms += timing.m_flTotalRenderGpuMs;
+			pacing_stats.compositor_gpu_ms += timing.m_flCompositorRenderGpuMs;
+			pacing_stats.compositor_cpu_ms += timing.m_flCompositorRenderCpuMs;
+			pacing_stats.interval_ms += timing.m_flClientFrameIntervalMs;
+		}
+
+		SDL_SemPost(pacing_start_sem);
+	}
+
+	return 0;
+}
+
+/*
+===================
+VR_LogPacing -- once a second, averaged over the frames since the last print
+===================
+*/
+static void VR_LogPacing(void)
+{
+	vrpacingstats_t *s = &pacing_stats;
+
+	if (!vr_pacingstats.value || realtime - pacing_log_time < 1.0)
+		return;
+
+	pacing_log_time = realtime;
+
+	if (s->frames)
+		Con_Printf("vr frames %i dropped %u late %u | app gpu %.2f compositor gpu %.2f cpu %.2f | interval %.2f wait %.2f ms\n",
+			s->frames, s->dropped, s->late, s->app_gpu_ms / s->frames, s->compositor_gpu_ms / s->frames,
+			s->compositor_cpu_ms / s->frames, s->interval_ms / s->frames, s->wait_ms / s->frames);
+
+	memset(s, 0, sizeof(*s));
+}
+
+/*
+===================
+VR_FramePending -- a frame is with the pacing thread and the next one hasn't been allowed to start
+===================
+*/
+qboolean VR_FramePending(void)
+{
+	return pacing_pending;
+}
+
+/*
+===================
+VR_WaitForFrameStart
+
+Returns false if the compositor takes unusually long, the frame isn't rendered
+then and the main loop keeps going round.  Otherwise sets vr.display_time for
+the new frame.  Returns true right away if no frame is pending
+===================
+*/
+qboolean VR_WaitForFrameStart(void)
+{
+	if (!pacing_pending)
+		return true;
+
+	if (SDL_SemWaitTimeout(pacing_start_sem, 100) != 0)
+		return false;
+
+	pacing_pending = false;
+	vr.display_time = pacing_display_time;
+
+	VR_LogPacing();
+
+	return true;
 }
 
 /*
@@ -417,12 +672,134 @@ VR_UpdateHiddenAreaMesh
 */
 static void VR_UpdateHiddenAreaMesh(void)
 {
-	uint32_t i;
+	uint32_t i, j;
+	HiddenAreaMesh_t outline;
+	float *bounds;
 
 	for (i = 0; i < NUM_VR_EYES; ++i)
 	{
 		vr.eye[i].hidden_area_mesh = vr_hmd->GetHiddenAreaMesh(vr.eye[i].vreye, EHiddenAreaMeshType_k_eHiddenAreaMesh_Standard);
+
+		// the line loop runs around the visible part, unTriangleCount is its vertex count
+		// v goes up the screen, see CANVAS_HIDDENAREAMESH
+		outline = vr_hmd->GetHiddenAreaMesh(vr.eye[i].vreye, EHiddenAreaMeshType_k_eHiddenAreaMesh_LineLoop);
+		bounds = vr.eye[i].visible_bounds;
+		if (!outline.unTriangleCount)
+		{
+			bounds[0] = bounds[1] = -1.0f;
+			bounds[2] = bounds[3] = 1.0f;
+			continue;
+		}
+
+		bounds[0] = bounds[1] = 1.0f;
+		bounds[2] = bounds[3] = -1.0f;
+		for (j = 0; j < outline.unTriangleCount; ++j)
+		{
+			float x = outline.pVertexData[j].v[0] * 2.0f - 1.0f;
+			float y = 1.0f - outline.pVertexData[j].v[1] * 2.0f;
+			bounds[0] = q_min(bounds[0], x);
+			bounds[1] = q_min(bounds[1], y);
+			bounds[2] = q_max(bounds[2], x);
+			bounds[3] = q_max(bounds[3], y);
+		}
+	}
+}
+
+/*
+=============
+VR_DestroyHiddenAreaMeshBuffer
+=============
+*/
+void VR_DestroyHiddenAreaMeshBuffer(void)
+{
+	if (hidden_area_buffer == VK_NULL_HANDLE)
+		return;
+
+	GL_WaitForDeviceIdle();
+
+	vkDestroyBuffer(vulkan_globals.device, hidden_area_buffer, NULL);
+	num_vulkan_misc_allocations -= 1;
+	vkFreeMemory(vulkan_globals.device, hidden_area_memory, NULL);
+
+	hidden_area_buffer = VK_NULL_HANDLE;
+	hidden_area_memory = VK_NULL_HANDLE;
+}
+
+/*
+=============
+VR_CreateHiddenAreaMeshBuffer -- both eyes, the mesh never changes
+=============
+*/
+void VR_CreateHiddenAreaMeshBuffer(void)
+{
+	uint32_t i, j, num_vertices;
+	basicvertex_t *vertices;
+	VkResult err;
+
+	VR_DestroyHiddenAreaMeshBuffer();
+
+	num_vertices = 0;
+	for (i = 0; i < NUM_VR_EYES; ++i)
+	{
+		vr.eye[i].hidden_area_first_vertex = num_vertices;
+		num_vertices += vr.eye[i].hidden_area_mesh.unTriangleCount * 3;
 	}
+
+	if (!num_vertices)
+		return;
+
+	VkBufferCreateInfo buffer_create_info;
+	memset(&buffer_create_info, 0, sizeof(buffer_create_info));
+	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_create_info.size = num_vertices * sizeof(basicvertex_t);
+	buffer_create_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	err = vkCreateBuffer(vulkan_globals.device, &buffer_create_info, NULL, &hidden_area_buffer);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkCreateBuffer failed");
+
+	GL_SetObjectName((uint64_t)hidden_area_buffer, VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Hidden Area Mesh Buffer");
+
+	VkMemoryRequirements memory_requirements;
+	vkGetBufferMemoryRequirements(vulkan_globals.device, hidden_area_buffer, &memory_requirements);
+
+	VkMemoryAllocateInfo memory_allocate_info;
+	memset(&memory_allocate_info, 0, sizeof(memory_allocate_info));
+	memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memory_allocate_info.allocationSize = memory_requirements.size;
+	memory_allocate_info.memoryTypeIndex = GL_MemoryTypeFromProperties(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0);
+
+	num_vulkan_misc_allocations += 1;
+	err = vkAllocateMemory(vulkan_globals.device, &memory_allocate_info, NULL, &hidden_area_memory);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkAllocateMemory failed");
+
+	err = vkBindBufferMemory(vulkan_globals.device, hidden_area_buffer, hidden_area_memory, 0);
+	if (err != VK_SUCCESS)
+		Sys_Error("vkBindBufferMemory failed");
+
+	VkBuffer staging_buffer;
+	VkCommandBuffer command_buffer;
+	int staging_offset;
+	vertices = (basicvertex_t *)R_StagingAllocate(num_vertices * sizeof(basicvertex_t), 4, &command_buffer, &staging_buffer, &staging_offset);
+
+	// depth 0 with the CANVAS_HIDDENAREAMESH matrix, nothing of the scene passes the depth test behind it
+	memset(vertices, 0, num_vertices * sizeof(basicvertex_t));
+	for (i = 0; i < NUM_VR_EYES; ++i)
+	{
+		basicvertex_t *eye_vertices = vertices + vr.eye[i].hidden_area_first_vertex;
+		for (j = 0; j < vr.eye[i].hidden_area_mesh.unTriangleCount * 3; ++j)
+		{
+			eye_vertices[j].position[0] = vr.eye[i].hidden_area_mesh.pVertexData[j].v[0];
+			eye_vertices[j].position[1] = vr.eye[i].hidden_area_mesh.pVertexData[j].v[1];
+			eye_vertices[j].color[3] = 255;
+		}
+	}
+
+	VkBufferCopy region;
+	region.srcOffset = staging_offset;
+	region.dstOffset = 0;
+	region.size = num_vertices * sizeof(basicvertex_t);
+	vkCmdCopyBuffer(command_buffer, staging_buffer, hidden_area_buffer, 1, &region);
 }
 
 /*
@@ -433,33 +810,17 @@ VR_DrawHiddenAreaMesh
 void VR_DrawHiddenAreaMesh(void)
 {
 	int vertex_count = vr.eye[vr.current_eye].hidden_area_mesh.unTriangleCount * 3;
+	VkDeviceSize buffer_offset = 0;
 	
-	if (!vertex_count)
+	if (!vertex_count || hidden_area_buffer == VK_NULL_HANDLE)
 		return;
 
 	GL_SetCanvas(CANVAS_HIDDENAREAMESH);
 
-	int i;
-	VkBuffer buffer;
-	VkDeviceSize buffer_offset;
-	basicvertex_t * vertices = (basicvertex_t*)R_VertexAllocate(vertex_count * sizeof(basicvertex_t), &buffer, &buffer_offset);
-
-	for (i = 0; i < vertex_count; ++i)
-	{
-		vertices[i].position[0] = vr.eye[vr.current_eye].hidden_area_mesh.pVertexData[i].v[0];
-		vertices[i].position[1] = vr.eye[vr.current_eye].hidden_area_mesh.pVertexData[i].v[1];
-		vertices[i].position[2] = 0.0f;
-		vertices[i].texcoord[0] = 0.0f;
-		vertices[i].texcoord[1] = 0.0f;
-		vertices[i].color[0] = 0;
-		vertices[i].color[1] = 0;
-		vertices[i].color[2] = 0;
-		vertices[i].color[3] = 255;
-	}
-
-	vkCmdBindVertexBuffers(vulkan_globals.command_buffer, 0, 1, &buffer, &buffer_offset);
+	vkCmdBindVertexBuffers(vulkan_globals.command_buffer, 0, 1, &hidden_area_buffer, &buffer_offset);
 	vkCmdBindPipeline(vulkan_globals.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vulkan_globals.hidden_area_mesh_pipeline);
-	vkCmdDraw(vulkan_globals.command_buffer, vertex_count, 1, 0, 0);
+	R_BindLatch(vulkan_globals.basic_pipeline_layout, 1, true); // the mesh is fixed to the lens
+	vkCmdDraw(vulkan_globals.command_buffer, vertex_count, 1, vr.eye[vr.current_eye].hidden_area_first_vertex, 0);
 }
 
 /*
@@ -533,12 +894,14 @@ void VR_Init(void)
 
 	vr_hmd->GetRecommendedRenderTargetSize(&vr.width, &vr.height);
 	Con_Printf("Render target size: %u x %u\n", vr.width, vr.height);
+	vr.render_width = vr.width;
+	vr.render_height = vr.height;
 
 	for (i = 0; i < NUM_VR_EYES; ++i)
 	{
-		vr.eye[i].texture.handle = &vr.eye[i].texture_data;
-		vr.eye[i].texture.eColorSpace = EColorSpace_ColorSpace_Auto;
-		vr.eye[i].texture.eType = ETextureType_TextureType_Vulkan;
+		vr.eye[i].texture.base.handle = &vr.eye[i].texture_data;
+		vr.eye[i].texture.base.eColorSpace = EColorSpace_ColorSpace_Auto;
+		vr.eye[i].texture.base.eType = ETextureType_TextureType_Vulkan;
 
 		if (i == VR_EYE_LEFT)
 			vr.eye[i].vreye = EVREye_Eye_Left;
@@ -554,6 +917,19 @@ void VR_Init(void)
 
 	Cvar_RegisterVariable(&vr_lefthanded);
 	Cvar_RegisterVariable(&vr_gunangle);
+	Cvar_RegisterVariable(&vr_pacing);
+	Cvar_RegisterVariable(&vr_pacingstats);
+
+	pacing_compositor = VR_Compositor();
+	pacing_submit_sem = SDL_CreateSemaphore(0);
+	pacing_start_sem = SDL_CreateSemaphore(0);
+	if (!pacing_submit_sem || !pacing_start_sem)
+		Sys_Error("VR_Init: couldn't create semaphores: %s", SDL_GetError());
+
+	SDL_AtomicSet(&pacing_quit, 0);
+	pacing_thread = SDL_CreateThread(VR_PacingThread, "vrpacing", NULL);
+	if (!pacing_thread)
+		Con_Warning("VR_Init: couldn't create pacing thread: %s\n", SDL_GetError());
 }
 
 /*
@@ -563,6 +939,16 @@ VR_Shutdown
 */
 void VR_Shutdown (void)
 {
+	if (pacing_thread)
+	{
+		SDL_AtomicSet(&pacing_quit, 1);
+		SDL_SemPost(pacing_submit_sem);
+		SDL_WaitThread(pacing_thread, NULL);
+		pacing_thread = NULL;
+	}
+
+	VR_DestroyHiddenAreaMeshBuffer();
+
 	if (vr_hmd)
 	{
 		VR_ShutdownInternal();
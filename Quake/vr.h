@@ -28,12 +28,25 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define VR_EYE_RIGHT	1
 #define NUM_VR_EYES		2
 
+// EVRSubmitFlags_Submit_TextureWithPose and VRTextureWithPose_t of newer OpenVR
+// headers, the bundled one predates them
+#define VR_SUBMIT_TEXTURE_WITH_POSE	0x08
+
+typedef struct
+{
+	Texture_t				base;
+	HmdMatrix34_t			device_to_absolute_tracking;	// the HMD pose the eye was rendered with
+} vrtexturewithpose_t;
+
 typedef struct
 {
 	EVREye					vreye;
-	Texture_t				texture;
+	vrtexturewithpose_t		texture;
+	qboolean				texture_has_pose;
 	VRVulkanTextureData_t	texture_data;
 	HiddenAreaMesh_t		hidden_area_mesh;
+	uint32_t				hidden_area_first_vertex;	// in the static buffer of both eyes
+	float					visible_bounds[4];			// clip space x/y min, x/y max of what the mesh leaves uncovered
 	float					eye_to_head_transform[16];
 	float					projection[16];
 } vreye_t;
@@ -53,8 +66,11 @@ typedef struct
 	uint32_t		current_eye;
 	uint32_t		width;
 	uint32_t		height;
+	uint32_t		render_width;	// top left part of the eye buffers that is rendered to, see vid_dynres
+	uint32_t		render_height;
 	float			fov_x;
 	float			fov_y;
+	double			display_time;	// Sys_DoubleTime when the frame being rendered is displayed, 0 if not known
 } vrdef_t;
 
 extern	vrdef_t vr;				// global vr state
@@ -69,7 +85,14 @@ TrackedDevicePose_t* VR_GetControllerPosition(ETrackedControllerRole role, float
 void		VR_GetVelocity(TrackedDevicePose_t pose, float *x, float *y, float *z);
 void		VR_GetOrientation(TrackedDevicePose_t pose, float *pitch, float *yaw, float *roll);
 void		VR_UpdatePose(void);
+qboolean	VR_GetLatePose(TrackedDevicePose_t *hmd_pose);
+void		VR_SetSubmitPose(const HmdMatrix34_t *hmd_pose);
 void		VR_Submit(uint32_t eye, VkImage color_buffer);
+qboolean	VR_FramePending(void);
+qboolean	VR_WaitForFrameStart(void);
+float		VR_GetDisplayFrequency(void);
+void		VR_CreateHiddenAreaMeshBuffer(void);
+void		VR_DestroyHiddenAreaMeshBuffer(void);
 void		VR_DrawHiddenAreaMesh(void);
 uint32_t	VR_GetVulkanInstanceExtensionsRequired(char *extension_names, uint32_t buffer_size);
 uint32_t	VR_GetVulkanDeviceExtensionsRequired(struct VkPhysicalDevice_T *physical_device, char *extension_names, uint32_t buffer_size);
@@ -12,31 +12,43 @@ layout(push_constant) uniform PushConsts {
 layout(set = 0, binding = 0) uniform sampler2D diffuse_tex;
 layout(set = 1, binding = 0) uniform sampler2D fullbright_tex;
 
-layout (set = 2, binding = 0) uniform UBO
+struct InstanceData
 {
 	mat4 model_matrix;
 	vec3 shade_vector;
 	float blend_factor;
 	vec3 light_color;
-	bool use_fullbright;
+	uint use_fullbright;
 	float entalpha;
-} ubo;
+	uint diffuse_index;
+	uint fullbright_index;
+	uint pose1_offset;
+	uint pose2_offset;
+};
+
+layout (std430, set = 2, binding = 0) readonly buffer Instances
+{
+	InstanceData instances[];
+};
 
 layout (location = 0) in vec2 in_texcoord;
 layout (location = 1) in vec4 in_color;
 layout (location = 2) in float in_fog_frag_coord;
+layout (location = 3) flat in uint in_instance_index;
 
 layout (location = 0) out vec4 out_frag_color;
 
 void main()
 {
+	InstanceData instance = instances[in_instance_index];
+
 	vec4 result = texture(diffuse_tex, in_texcoord.xy);
 	result *= in_color;
 
-	if (ubo.use_fullbright)
+	if (instance.use_fullbright != 0)
 		result += texture(fullbright_tex, in_texcoord.xy);
 
-	result.a = ubo.entalpha;
+	result.a = instance.entalpha;
 
 	float fog = exp(-push_constants.fog_density * push_constants.fog_density * in_fog_frag_coord * in_fog_frag_coord);
 	fog = clamp(fog, 0.0, 1.0);
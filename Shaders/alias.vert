@@ -9,33 +9,51 @@ layout(push_constant) uniform PushConsts {
 	float fog_density;
 } push_constants;
 
-layout (set = 2, binding = 0) uniform UBO
+struct InstanceData
 {
 	mat4 model_matrix;
 	vec3 shade_vector;
 	float blend_factor;
 	vec3 light_color;
-	bool use_fullbright;
+	uint use_fullbright;
 	float entalpha;
-} ubo;
+	uint diffuse_index;
+	uint fullbright_index;
+	uint pose1_offset;
+	uint pose2_offset;
+};
+
+layout (std430, set = 2, binding = 0) readonly buffer Instances
+{
+	InstanceData instances[];
+};
+
+// every pose of the model, numverts_vbo packed vertices per pose: x, y, z, normal index
+layout (std430, set = 3, binding = 0) readonly buffer Poses
+{
+	uint poses[];
+};
+
+#include "anorms.glsl"
+
+layout(set = 4, binding = 0) uniform Latch {
+	mat4 correction;
+} latch;
 
 layout (location = 0) in vec2 in_texcoord;
-layout (location = 1) in vec4 in_pose1_position;
-layout (location = 2) in vec3 in_pose1_normal;
-layout (location = 3) in vec4 in_pose2_position;
-layout (location = 4) in vec3 in_pose2_normal;
 
 layout (location = 0) out vec2 out_texcoord;
 layout (location = 1) out vec4 out_color;
 layout (location = 2) out float out_fog_frag_coord;
+layout (location = 3) flat out uint out_instance_index;
 
 out gl_PerVertex {
 	vec4 gl_Position;
 };
 
-float r_avertexnormal_dot(vec3 vertexnormal) // from MH 
+float r_avertexnormal_dot(vec3 vertexnormal, vec3 shade_vector) // from MH 
 {
-	float dot = dot(vertexnormal, ubo.shade_vector);
+	float dot = dot(vertexnormal, shade_vector);
 	// wtf - this reproduces anorm_dots within as reasonable a degree of tolerance as the >= 0 case
 	if (dot < 0.0)
 		return 1.0 + dot * (13.0 / 44.0);
@@ -45,15 +63,24 @@ float r_avertexnormal_dot(vec3 vertexnormal) // from MH
 
 void main()
 {
+	InstanceData instance = instances[gl_InstanceIndex];
+	uint pose1 = poses[instance.pose1_offset + uint(gl_VertexIndex)];
+	uint pose2 = poses[instance.pose2_offset + uint(gl_VertexIndex)];
+	vec4 in_pose1_position = vec4(pose1 & 0xFF, (pose1 >> 8) & 0xFF, (pose1 >> 16) & 0xFF, 1.0);
+	vec4 in_pose2_position = vec4(pose2 & 0xFF, (pose2 >> 8) & 0xFF, (pose2 >> 16) & 0xFF, 1.0);
+	vec3 in_pose1_normal = anorms[pose1 >> 24];
+	vec3 in_pose2_normal = anorms[pose2 >> 24];
+
 	out_texcoord = in_texcoord;
+	out_instance_index = uint(gl_InstanceIndex);
 
-	vec4 lerped_position = mix(in_pose1_position, in_pose2_position, ubo.blend_factor);
-	vec4 model_space_position = ubo.model_matrix * lerped_position;
-	gl_Position = push_constants.view_projection_matrix * model_space_position;
+	vec4 lerped_position = mix(in_pose1_position, in_pose2_position, instance.blend_factor);
+	vec4 model_space_position = instance.model_matrix * lerped_position;
+	gl_Position = latch.correction * (push_constants.view_projection_matrix * model_space_position);
 
-	float dot1 = r_avertexnormal_dot(in_pose1_normal);
-	float dot2 = r_avertexnormal_dot(in_pose2_normal);
-	out_color = vec4(ubo.light_color * mix(dot1, dot2, ubo.blend_factor), 1.0);
+	float dot1 = r_avertexnormal_dot(in_pose1_normal, instance.shade_vector);
+	float dot2 = r_avertexnormal_dot(in_pose2_normal, instance.shade_vector);
+	out_color = vec4(instance.light_color * mix(dot1, dot2, instance.blend_factor), 1.0);
 
 	out_fog_frag_coord = gl_Position.w;
-}
\ No newline at end of file
+}
@@ -0,0 +1,58 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+#extension GL_GOOGLE_include_directive : enable
+#extension GL_EXT_nonuniform_qualifier : enable
+
+layout(push_constant) uniform PushConsts {
+	mat4 mvp;
+	vec3 fog_color;
+	float fog_density;
+} push_constants;
+
+layout(set = 0, binding = 0) uniform sampler2D textures[];
+
+struct InstanceData
+{
+	mat4 model_matrix;
+	vec3 shade_vector;
+	float blend_factor;
+	vec3 light_color;
+	uint use_fullbright;
+	float entalpha;
+	uint diffuse_index;
+	uint fullbright_index;
+	uint pose1_offset;
+	uint pose2_offset;
+};
+
+layout (std430, set = 2, binding = 0) readonly buffer Instances
+{
+	InstanceData instances[];
+};
+
+layout (location = 0) in vec2 in_texcoord;
+layout (location = 1) in vec4 in_color;
+layout (location = 2) in float in_fog_frag_coord;
+layout (location = 3) flat in uint in_instance_index;
+
+layout (location = 0) out vec4 out_frag_color;
+
+void main()
+{
+	InstanceData instance = instances[in_instance_index];
+
+	vec4 result = texture(textures[nonuniformEXT(instance.diffuse_index)], in_texcoord.xy);
+	result *= in_color;
+
+	if (instance.use_fullbright != 0)
+		result += texture(textures[nonuniformEXT(instance.fullbright_index)], in_texcoord.xy);
+
+	result.a = instance.entalpha;
+
+	float fog = exp(-push_constants.fog_density * push_constants.fog_density * in_fog_frag_coord * in_fog_frag_coord);
+	fog = clamp(fog, 0.0, 1.0);
+	result.rgb = mix(push_constants.fog_color, result.rgb, fog);
+
+	out_frag_color = result;
+}
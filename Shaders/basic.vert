@@ -8,6 +8,11 @@ layout(push_constant) uniform PushConsts {
 	float fog_density;
 } push_constants;
 
+// clip space correction from the head pose sampled right before submit
+layout(set = 1, binding = 0) uniform Latch {
+	mat4 correction;
+} latch;
+
 layout (location = 0) in vec3 in_position;
 layout (location = 1) in vec2 in_texcoord;
 layout (location = 2) in vec4 in_color;
@@ -22,7 +27,7 @@ out gl_PerVertex {
 
 void main() 
 {
-	gl_Position = push_constants.mvp * vec4(in_position, 1.0f);
+	gl_Position = latch.correction * (push_constants.mvp * vec4(in_position, 1.0f));
 	out_texcoord = vec4(in_texcoord.xy, 0.0f, 0.0f);
 	out_color = in_color;
 	out_fog_frag_coord = gl_Position.w;
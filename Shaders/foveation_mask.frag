@@ -0,0 +1,24 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+layout(push_constant) uniform PushConsts {
+	vec2 lens_center;
+	float inner_radius;
+	float outer_radius;
+} push_constants;
+
+// Drawn with postprocess.vert at depth 0 before the scene: every pixel that isn't
+// the top left of its coarse block keeps the scene out, foveation_fill.comp copies
+// the block's color over it afterwards. The rate is picked per 4x4 tile so a block
+// never straddles two rates.
+void main()
+{
+	const uvec2 pixel = uvec2(gl_FragCoord.xy);
+	const vec2 tile_center = vec2((pixel >> 2) * 4 + 2);
+	const float dist = distance(tile_center, push_constants.lens_center);
+	const uint block_mask = (dist < push_constants.inner_radius) ? 0 : (dist < push_constants.outer_radius) ? 1 : 3;
+
+	if (((pixel.x | pixel.y) & block_mask) == 0)
+		discard;
+}
@@ -0,0 +1,89 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+layout(push_constant) uniform PushConsts {
+	mat4 mvp;
+	vec3 fog_color;
+	float fog_density;
+} push_constants;
+
+struct Particle
+{
+	vec3 org;
+	float color;
+	vec3 vel;
+	float ramp;
+	float die;
+	uint type;
+	float padding[2];
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer Particles
+{
+	uint palette[256];
+	Particle particles[];
+};
+
+layout(set = 2, binding = 0) uniform UBO
+{
+	vec4 origin_scale;	// r_origin, texturescalefactor
+	vec4 forward;
+	vec4 up;			// already scaled by 1.5
+	vec4 right;
+} ubo;
+
+layout(set = 3, binding = 0) uniform Latch {
+	mat4 correction;
+} latch;
+
+layout (location = 0) out vec4 out_texcoord;
+layout (location = 1) out vec4 out_color;
+layout (location = 2) out float out_fog_frag_coord;
+
+out gl_PerVertex {
+	vec4 gl_Position;
+};
+
+const uint PT_DEAD = 0xFFFFFFFFu;
+
+void main() 
+{
+	Particle particle = particles[gl_InstanceIndex];
+
+	if (particle.type == PT_DEAD)
+	{
+		// outside of the clip volume, the whole triangle gets dropped
+		gl_Position = vec4(0.0f, 0.0f, 2.0f, 1.0f);
+		out_texcoord = vec4(0.0f);
+		out_color = vec4(0.0f);
+		out_fog_frag_coord = 0.0f;
+		return;
+	}
+
+	// hack a scale up to keep particles from disapearing
+	float scale = dot(particle.org - ubo.origin_scale.xyz, ubo.forward.xyz);
+	if (scale < 20.0f)
+		scale = 1.0f + 0.08f;
+	else
+		scale = 1.0f + scale * 0.004f;
+	scale *= ubo.origin_scale.w;
+
+	vec3 position = particle.org;
+	vec2 texcoord = vec2(0.0f, 0.0f);
+	if (gl_VertexIndex == 1)
+	{
+		position += ubo.up.xyz * scale;
+		texcoord = vec2(1.0f, 0.0f);
+	}
+	else if (gl_VertexIndex == 2)
+	{
+		position += ubo.right.xyz * scale;
+		texcoord = vec2(0.0f, 1.0f);
+	}
+
+	gl_Position = latch.correction * (push_constants.mvp * vec4(position, 1.0f));
+	out_texcoord = vec4(texcoord, 0.0f, 0.0f);
+	out_color = vec4(unpackUnorm4x8(palette[uint(particle.color) & 255u]).rgb, 1.0f);
+	out_fog_frag_coord = gl_Position.w;
+}
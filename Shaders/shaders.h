@@ -33,10 +33,16 @@ extern unsigned char world_vert_spv[];
 extern int world_vert_spv_size;
 extern unsigned char world_frag_spv[];
 extern int world_frag_spv_size;
+extern unsigned char world_bindless_frag_spv[];
+extern int world_bindless_frag_spv_size;
 extern unsigned char alias_vert_spv[];
 extern int alias_vert_spv_size;
 extern unsigned char alias_frag_spv[];
 extern int alias_frag_spv_size;
+extern unsigned char alias_bindless_frag_spv[];
+extern int alias_bindless_frag_spv_size;
+extern unsigned char sky_box_frag_spv[];
+extern int sky_box_frag_spv_size;
 extern unsigned char sky_layer_vert_spv[];
 extern int sky_layer_vert_spv_size;
 extern unsigned char sky_layer_frag_spv[];
@@ -51,6 +57,14 @@ extern unsigned char swapchain_frag_spv[];
 extern int swapchain_frag_spv_size;
 extern unsigned char screen_warp_comp_spv[];
 extern int  screen_warp_comp_spv_size;
+extern unsigned char particle_vert_spv[];
+extern int particle_vert_spv_size;
+extern unsigned char particle_simulate_comp_spv[];
+extern int particle_simulate_comp_spv_size;
+extern unsigned char foveation_mask_frag_spv[];
+extern int foveation_mask_frag_spv_size;
+extern unsigned char foveation_fill_comp_spv[];
+extern int foveation_fill_comp_spv_size;
 
 
 #endif
@@ -0,0 +1,66 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+// rt, bk, lf, ft, up, dn in the order of the major axis +x, -x, +y, -y, +z, -z
+layout(set = 0, binding = 0) uniform sampler2D face_tex[6];
+
+layout(set = 2, binding = 0) uniform UBO {
+	mat4 model_matrix;
+	vec4 eye_position;
+	vec4 fog_color;
+	vec4 scroll;
+} ubo;
+
+layout (location = 0) in vec3 in_direction;
+
+layout (location = 0) out vec4 out_frag_color;
+
+vec4 SampleFace(sampler2D tex, vec2 st)
+{
+	// [-1,1] to [0,1], avoiding the bilerp seam at the edges
+	vec2 size = vec2(textureSize(tex, 0));
+	st = (st * 0.5f + 0.5f) * (size - 1.0f) / size + 0.5f / size;
+	st.y = 1.0f - st.y;
+	return textureLod(tex, st, 0.0f);
+}
+
+void main() 
+{
+	// r_fastsky or fully fogged sky, skip the texture lookups
+	if (ubo.fog_color.a >= 1.0f)
+	{
+		out_frag_color = vec4(ubo.fog_color.rgb, 1.0f);
+		return;
+	}
+
+	vec3 v = in_direction;
+	vec3 av = abs(v);
+	vec4 color;
+
+	// the projection Sky_ProjectPoly used to do on the CPU, per fragment. The
+	// face textures have no mips, so sampling inside the branches is fine
+	if (av.x >= av.y && av.x >= av.z)
+	{
+		if (v.x >= 0.0f)
+			color = SampleFace(face_tex[0], vec2(-v.y, v.z) / v.x);
+		else
+			color = SampleFace(face_tex[1], vec2(v.y, v.z) / -v.x);
+	}
+	else if (av.y >= av.z)
+	{
+		if (v.y >= 0.0f)
+			color = SampleFace(face_tex[2], vec2(v.x, v.z) / v.y);
+		else
+			color = SampleFace(face_tex[3], vec2(-v.x, v.z) / -v.y);
+	}
+	else
+	{
+		if (v.z >= 0.0f)
+			color = SampleFace(face_tex[4], vec2(-v.y, -v.x) / v.z);
+		else
+			color = SampleFace(face_tex[5], vec2(-v.y, v.x) / -v.z);
+	}
+
+	out_frag_color = vec4(mix(color.rgb, ubo.fog_color.rgb, ubo.fog_color.a), 1.0f);
+}
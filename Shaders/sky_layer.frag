@@ -5,16 +5,34 @@
 layout(set = 0, binding = 0) uniform sampler2D solid_tex;
 layout(set = 1, binding = 0) uniform sampler2D alpha_tex;
 
-layout (location = 0) in vec4 in_texcoord1;
-layout (location = 1) in vec4 in_texcoord2;
-layout (location = 2) in vec4 in_color;
+layout(set = 2, binding = 0) uniform UBO {
+	mat4 model_matrix;
+	vec4 eye_position;
+	vec4 fog_color;
+	vec4 scroll;
+} ubo;
+
+layout (location = 0) in vec3 in_direction;
 
 layout (location = 0) out vec4 out_frag_color;
 
 void main() 
 {
-	vec4 solid_layer = texture(solid_tex, in_texcoord1.xy);
-	vec4 alpha_layer = texture(alpha_tex, in_texcoord2.xy);
+	// r_fastsky or fully fogged sky, skip the texture lookups
+	if (ubo.fog_color.a >= 1.0f)
+	{
+		out_frag_color = vec4(ubo.fog_color.rgb, ubo.scroll.z);
+		return;
+	}
+
+	// flatten the sphere
+	vec3 dir = in_direction;
+	dir.z *= 3.0f;
+	vec2 st = dir.xy * ((6.0f * 63.0f / 128.0f) / length(dir));
+
+	vec4 solid_layer = texture(solid_tex, st + ubo.scroll.xx);
+	vec4 alpha_layer = texture(alpha_tex, st + ubo.scroll.yy);
 
-	out_frag_color = vec4((solid_layer.rgb * (1.0f - alpha_layer.a) + alpha_layer.rgb * alpha_layer.a), in_color.a);
+	vec3 color = solid_layer.rgb * (1.0f - alpha_layer.a) + alpha_layer.rgb * alpha_layer.a;
+	out_frag_color = vec4(mix(color, ubo.fog_color.rgb, ubo.fog_color.a), ubo.scroll.z);
 }
@@ -6,14 +6,21 @@ layout(push_constant) uniform PushConsts {
 	mat4 mvp;
 } push_constants;
 
+layout(set = 2, binding = 0) uniform UBO {
+	mat4 model_matrix;
+	vec4 eye_position;
+	vec4 fog_color;
+	vec4 scroll;
+} ubo;
+
+// World vertex layout, only the position is used
+layout(set = 3, binding = 0) uniform Latch {
+	mat4 correction;
+} latch;
+
 layout (location = 0) in vec3 in_position;
-layout (location = 1) in vec2 in_texcoord1;
-layout (location = 2) in vec2 in_texcoord2;
-layout (location = 3) in vec4 in_color;
 
-layout (location = 0) out vec4 out_texcoord1;
-layout (location = 1) out vec4 out_texcoord2;
-layout (location = 2) out vec4 out_color;
+layout (location = 0) out vec3 out_direction;
 
 out gl_PerVertex {
 	vec4 gl_Position;
@@ -21,8 +28,6 @@ out gl_PerVertex {
 
 void main() 
 {
-	gl_Position = push_constants.mvp * vec4(in_position, 1.0f);
-	out_texcoord1 = vec4(in_texcoord1.xy, 0.0f, 0.0f);
-	out_texcoord2 = vec4(in_texcoord2.xy, 0.0f, 0.0f);
-	out_color = in_color;
+	gl_Position = latch.correction * (push_constants.mvp * vec4(in_position, 1.0f));
+	out_direction = (ubo.model_matrix * vec4(in_position, 1.0f)).xyz - ubo.eye_position.xyz;
 }
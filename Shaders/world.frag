@@ -7,6 +7,7 @@ layout(push_constant) uniform PushConsts {
 	vec3 fog_color;
 	float fog_density;
 	float alpha;
+	float time;
 } push_constants;
 
 layout(set = 0, binding = 0) uniform sampler2D diffuse_tex;
@@ -21,12 +22,24 @@ layout (location = 0) out vec4 out_frag_color;
 layout (constant_id = 0) const bool use_fullbright = false;
 layout (constant_id = 1) const bool use_alpha_test = false;
 layout (constant_id = 2) const bool use_alpha_blend = false;
+layout (constant_id = 3) const bool use_water_warp = false;
 
 void main() 
 {
-	vec4 diffuse = texture(diffuse_tex, in_texcoords.xy);
-	vec4 light = texture(lightmap_tex, in_texcoords.zw) * 2.0f;
-	out_frag_color = diffuse * light;
+	if (use_water_warp)
+	{
+		// turbulent surfs have no lightmap and texcoords of 1/128 per world unit. Same warp
+		// the old per frame warp images had: (s + 8 * sin(t * PI / 64 + time)) / 64
+		const float PI = 3.14159265f;
+		vec2 uv = in_texcoords.xy * 2.0f + 0.125f * sin(in_texcoords.yx * (2.0f * PI) + push_constants.time);
+		out_frag_color = texture(diffuse_tex, uv);
+	}
+	else
+	{
+		vec4 diffuse = texture(diffuse_tex, in_texcoords.xy);
+		vec4 light = texture(lightmap_tex, in_texcoords.zw) * 2.0f;
+		out_frag_color = diffuse * light;
+	}
 
 	if (use_alpha_blend)
 		out_frag_color.a *= push_constants.alpha;
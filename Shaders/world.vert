@@ -8,6 +8,10 @@ layout(push_constant) uniform PushConsts {
 	float fog_density;
 } push_constants;
 
+layout(set = 3, binding = 0) uniform Latch {
+	mat4 correction;
+} latch;
+
 layout (location = 0) in vec3 in_position;
 layout (location = 1) in vec2 in_texcoord1;
 layout (location = 2) in vec2 in_texcoord2;
@@ -23,7 +27,7 @@ void main()
 {
 	out_texcoords.xy = in_texcoord1.xy;
 	out_texcoords.zw = in_texcoord2.xy;
-	gl_Position = push_constants.mvp * vec4(in_position, 1.0f);
+	gl_Position = latch.correction * (push_constants.mvp * vec4(in_position, 1.0f));
 
 	out_fog_frag_coord = gl_Position.w;
 }